@@ -0,0 +1,15 @@
+// Decoding the attributes of meshes quantized with mesh::quantize_mesh, with the VAO format given by
+// vao_format_from_mesh_data. The position needs no decoding here, being read as a normalized vec4 with w = 1 and
+// mapped to model space by mesh::position_dequantize_matrix, which is multiplied into the model's transform.
+
+// Same as math::decode_octahedral_snorm16, the snorm16s having been normalized to [-1, 1] by GL
+vec3 decode_octahedral(vec2 e) {
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    const float t = max(-n.z, 0.0);
+    n.x -= t * (n.x >= 0.0 ? 1.0 : -1.0);
+    n.y -= t * (n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+// The tangent and its handedness, as the xyz and w of an unquantized tangent
+vec4 decode_quantized_tangent(vec4 t) { return vec4(decode_octahedral(t.xy), t.z); }
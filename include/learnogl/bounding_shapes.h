@@ -17,6 +17,13 @@ struct PrincipalAxis {
 
 PrincipalAxis calculate_principal_axis(const fo::Vector3 *points, uint32_t num_points);
 
+// Same as above, for points `stride` bytes apart, so positions can be read straight out of an interleaved vertex
+// buffer. The mean and covariance are summed up in double over chunks of points. With `multithreaded` the chunks
+// are spread over the parallel_for workers, but they are combined in the same order either way, so the result
+// doesn't change.
+PrincipalAxis
+calculate_principal_axis(const fo::Vector3 *points, uint32_t stride, uint32_t num_points, bool multithreaded = false);
+
 // A bounding 3D rectangle is first calculated as a collection of 6 planes
 struct BoundingRect {
     // The plane equations in <N, D> form. The normals of the plane point 'outwards' from the box.
@@ -47,8 +54,24 @@ create_bounding_sphere(const PrincipalAxis &pa, const fo::Vector3 *positions, ui
 BoundingSphere
 create_bounding_sphere_iterative(const PrincipalAxis &pa, fo::Vector3 *positions, uint32_t num_points);
 
+// The smallest sphere containing all the points. Doesn't modify them. Starts from the exact sphere of the extreme
+// points along 7 directions (EPOS-14) and repeatedly adds the point farthest outside it, recomputing the exact
+// sphere of the points gathered so far with Welzl's move-to-front algorithm, until nothing is outside. Usually
+// a few passes over the points, each of which is SIMD, and spread over the parallel_for workers with
+// `multithreaded` without changing the result.
+BoundingSphere create_minimal_bounding_sphere(const fo::Vector3 *positions, uint32_t num_points);
+
+BoundingSphere create_minimal_bounding_sphere(const fo::Vector3 *positions,
+                                              uint32_t stride,
+                                              uint32_t num_points,
+                                              bool multithreaded = false);
+
 // AABB is already defined in scaffold/math_types.h. This is just a function for creating one from a list of
 // positions.
 fo::AABB calculate_AABB(const fo::Vector3 *positions, uint32_t num_points);
 
+// Strided version of the above. As with calculate_principal_axis, `multithreaded` doesn't change the result.
+fo::AABB
+calculate_AABB(const fo::Vector3 *positions, uint32_t stride, uint32_t num_points, bool multithreaded = false);
+
 } // namespace eng
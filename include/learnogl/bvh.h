@@ -0,0 +1,96 @@
+// Bounding volume hierarchy over triangles or boxes, built top-down with the binned surface area heuristic, for
+// nearest-hit ray queries like mouse picking.
+#pragma once
+
+#include <learnogl/math_ops.h>
+#include <learnogl/mesh.h>
+#include <scaffold/array.h>
+#include <scaffold/math_types.h>
+
+namespace eng {
+
+// The nodes are stored in depth-first order, so the first child of an interior node is the node right after it.
+// Instead of child pointers each node has the index of the node that follows its subtree, which is where a
+// traversal goes when the ray misses the node (or after a leaf). That needs no stack, and two nodes fit in a
+// cache line.
+struct BVHNode {
+    fo::Vector3 min;
+    uint32_t skip_index;
+    fo::Vector3 max;
+    // 0 for interior nodes. For leaves, (first_primitive << 4) | num_primitives, where the primitives are
+    // BVH::primitive_indices[first_primitive, first_primitive + num_primitives).
+    uint32_t leaf;
+
+    bool is_leaf() const { return leaf != 0; }
+    uint32_t first_primitive() const { return leaf >> 4; }
+    uint32_t num_primitives() const { return leaf & 0xfu; }
+};
+
+static_assert(sizeof(BVHNode) == 32, "");
+
+constexpr uint32_t k_bvh_max_leaf_primitives = 15;
+constexpr uint32_t k_bvh_max_primitives = 1u << 28;
+
+struct BVHBuildOptions {
+    // Leaves with at most this many primitives are made whenever the SAH says splitting doesn't pay. Leaves
+    // never get more than k_bvh_max_leaf_primitives.
+    uint32_t max_leaf_primitives = 4;
+
+    // Cost of visiting a node relative to testing one primitive, for the SAH
+    float traversal_cost = 1.0f;
+
+    // Splits nodes near the root with the binning spread over the parallel_for workers, and builds the subtrees
+    // below them in parallel. Gives the same tree as a single-threaded build.
+    bool multithreaded = false;
+};
+
+struct BVH {
+    fo::Array<BVHNode> nodes;
+
+    // Indices of the primitives the BVH was built from, in the order the leaves refer to them
+    fo::Array<uint32_t> primitive_indices;
+
+    BVH(fo::Allocator &allocator = fo::memory_globals::default_allocator())
+        : nodes(allocator)
+        , primitive_indices(allocator) {}
+};
+
+// A BVH over triangles, with the triangles copied in leaf order as a vertex and two edges, so a leaf's triangles
+// are next to each other in memory.
+struct TriangleBVH {
+    BVH bvh;
+    fo::Array<fo::Vector3> triangles; // v0, v1 - v0, v2 - v0 of each triangle, in primitive_indices order
+
+    TriangleBVH(fo::Allocator &allocator = fo::memory_globals::default_allocator())
+        : bvh(allocator)
+        , triangles(allocator) {}
+};
+
+// Builds over the given boxes. With no boxes the BVH has no nodes.
+void build_bvh(BVH &bvh, const fo::AABB *boxes, uint32_t num_boxes, const BVHBuildOptions &options = {});
+
+// Builds over the triangles of the mesh, with `positions` `stride` bytes apart.
+void build_bvh(TriangleBVH &bvh,
+               const fo::Vector3 *positions,
+               uint32_t stride,
+               const uint32_t *indices,
+               uint32_t num_triangles,
+               const BVHBuildOptions &options = {});
+
+void build_bvh(TriangleBVH &bvh, const mesh::MeshData &mesh_data, const BVHBuildOptions &options = {});
+
+struct RayHit {
+    float t;            // Distance along the ray, in units of the length of its direction
+    uint32_t primitive; // Index of the triangle or box that was hit, as given to build_bvh
+    float u, v;         // Barycentric coordinates of the hit point wrt v1 and v2, for triangles
+};
+
+// Finds the nearest triangle the ray hits with 0 <= t <= t_max. Triangles are hit from either side. Returns false
+// and leaves `hit` alone if there's none. Pick with eng::ray_wrt_world(pixel_xy) transformed into the mesh's
+// space.
+bool raycast(const TriangleBVH &bvh, const math::Ray &ray, float t_max, RayHit &hit);
+
+// Same as above, for the boxes given to build_bvh. `t` is where the ray enters the box, 0 if it starts inside.
+bool raycast(const BVH &bvh, const fo::AABB *boxes, const math::Ray &ray, float t_max, RayHit &hit);
+
+} // namespace eng
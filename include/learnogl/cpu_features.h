@@ -0,0 +1,28 @@
+// Instruction set extensions of the host CPU, detected once with cpuid. The SIMD paths in math_ops use this to
+// pick a kernel at runtime, so the library itself only has to be compiled for the baseline (SSE4.1) target.
+#pragma once
+
+namespace eng {
+
+struct CpuFeatures {
+    bool sse41 = false;
+    bool sse42 = false;
+    bool avx = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool f16c = false;
+    bool avx512f = false;
+    bool avx512vl = false;
+};
+
+// Returns the detected features. The ymm and zmm extensions are only reported if the OS also saves those
+// registers (checked with xgetbv). Detection happens on the first call; this is thread-safe.
+//
+// Setting the environment variable LOGL_SIMD_LEVEL to "sse4.1" or "avx2" hides the extensions above that
+// level, which is how the benchmarks get numbers for each kernel on one machine.
+const CpuFeatures &cpu_features();
+
+// Short description like "sse4.1 sse4.2 avx avx2 fma f16c" for logging.
+const char *cpu_features_string();
+
+} // namespace eng
@@ -0,0 +1,169 @@
+// A dynamic AABB tree for broadphase collision and overlap queries among moving objects, updated incrementally
+// rather than rebuilt. Each object is a proxy, a leaf whose box is the object's box fattened by a margin, so
+// objects moving within their fat box don't touch the tree. The tree is kept balanced with rotations as leaves are
+// inserted and removed, like the one in Box2D.
+#pragma once
+
+#include <learnogl/intersection_test.h>
+#include <scaffold/array.h>
+#include <scaffold/math_types.h>
+
+namespace eng {
+
+constexpr uint32_t k_null_proxy = 0xffffffffu;
+
+struct DynamicAABBTreeNode {
+    fo::AABB box; // Fattened for leaves, the union of the children's boxes otherwise
+
+    uint64_t user_data;
+
+    // The next free node when this one is in the free list
+    uint32_t parent;
+
+    // Both k_null_proxy for leaves
+    uint32_t child_1;
+    uint32_t child_2;
+
+    // 0 for leaves, -1 for free nodes
+    int32_t height;
+
+    // Whether the proxy moved out of its fat box since the last update_pairs
+    bool moved;
+
+    bool is_leaf() const { return child_1 == k_null_proxy; }
+};
+
+struct DynamicAABBTree {
+    fo::Array<DynamicAABBTreeNode> nodes;
+    uint32_t root = k_null_proxy;
+    uint32_t free_list = k_null_proxy;
+    uint32_t num_proxies = 0;
+
+    // Leaf boxes are the object's box grown by `margin` on each side, and stretched along the displacement given
+    // when moving by `displacement_multiplier` times it.
+    float margin = 0.1f;
+    float displacement_multiplier = 4.0f;
+
+    // Proxies created or moved out of their fat boxes since the last update_pairs
+    fo::Array<uint32_t> move_buffer;
+
+    DynamicAABBTree(fo::Allocator &allocator = fo::memory_globals::default_allocator())
+        : nodes(allocator)
+        , move_buffer(allocator) {}
+};
+
+// Proxy ids are node indices. They stay the same as long as the proxy exists, and are reused after it's
+// destroyed.
+uint32_t create_proxy(DynamicAABBTree &tree, const fo::AABB &box, uint64_t user_data);
+
+void destroy_proxy(DynamicAABBTree &tree, uint32_t proxy);
+
+// Moves the proxy to `box`. If it's still inside the proxy's fat box, nothing changes and this returns false.
+// Otherwise the proxy is reinserted with a new fat box, extended along `displacement` (the object's expected
+// motion over the next frame, zero if unknown), and this returns true.
+bool move_proxy(DynamicAABBTree &tree, uint32_t proxy, const fo::AABB &box, const fo::Vector3 &displacement);
+
+// Batch forms of the above, for all of a frame's changes at once. Creating many proxies in an empty tree builds it
+// top-down instead of inserting them one by one, which gives a better tree. `displacements` can be null.
+void create_proxies(DynamicAABBTree &tree,
+                    const fo::AABB *boxes,
+                    const uint64_t *user_data,
+                    uint32_t count,
+                    uint32_t *proxies_out);
+
+void destroy_proxies(DynamicAABBTree &tree, const uint32_t *proxies, uint32_t count);
+
+// Returns the number of proxies that were reinserted
+uint32_t move_proxies(DynamicAABBTree &tree,
+                      const uint32_t *proxies,
+                      const fo::AABB *boxes,
+                      const fo::Vector3 *displacements,
+                      uint32_t count);
+
+// Rebuilds the whole tree top-down from its leaves, splitting at the median along the longest axis. The proxy
+// ids don't change. For when incremental updates have made the tree a lot worse than it could be.
+void rebuild(DynamicAABBTree &tree);
+
+inline const fo::AABB &fat_box(const DynamicAABBTree &tree, uint32_t proxy) { return tree.nodes[proxy].box; }
+
+inline uint64_t user_data(const DynamicAABBTree &tree, uint32_t proxy) { return tree.nodes[proxy].user_data; }
+
+// Height of the tree, 0 for an empty tree or a single leaf
+inline int32_t height(const DynamicAABBTree &tree) {
+    return tree.root == k_null_proxy ? 0 : tree.nodes[tree.root].height;
+}
+
+// Deepest a tree can get. The AVL-style balancing keeps it much lower.
+constexpr uint32_t k_dynamic_aabb_tree_max_height = 64;
+
+// Calls `fn(proxy)` for each proxy whose fat box overlaps `box`. Stops early if `fn` returns false.
+template <typename Fn> void query(const DynamicAABBTree &tree, const fo::AABB &box, Fn &&fn) {
+    if (tree.root == k_null_proxy) {
+        return;
+    }
+
+    uint32_t stack[2 * k_dynamic_aabb_tree_max_height];
+    uint32_t stack_size = 0;
+    stack[stack_size++] = tree.root;
+
+    while (stack_size != 0) {
+        const DynamicAABBTreeNode &node = tree.nodes[stack[--stack_size]];
+        if (!test_aabb_aabb(node.box, box)) {
+            continue;
+        }
+
+        if (node.is_leaf()) {
+            if (!fn(uint32_t(&node - fo::data(tree.nodes)))) {
+                return;
+            }
+        } else {
+            stack[stack_size++] = node.child_1;
+            stack[stack_size++] = node.child_2;
+        }
+    }
+}
+
+// Calls `fn(proxy, t_enter)` for each proxy whose fat box the ray enters at 0 <= t_enter <= t_max. `fn` returns
+// the t_max for the rest of the search, so returning the distance to an object it hits gives the nearest one,
+// and returning 0 stops the search.
+template <typename Fn> void raycast(const DynamicAABBTree &tree, const math::Ray &ray, float t_max, Fn &&fn) {
+    if (tree.root == k_null_proxy) {
+        return;
+    }
+
+    const PrecomputedRay r(ray);
+    uint32_t stack[2 * k_dynamic_aabb_tree_max_height];
+    uint32_t stack_size = 0;
+    stack[stack_size++] = tree.root;
+
+    while (stack_size != 0) {
+        const DynamicAABBTreeNode &node = tree.nodes[stack[--stack_size]];
+        float t_enter;
+        if (!test_ray_aabb(r, node.box, t_max, t_enter)) {
+            continue;
+        }
+
+        if (node.is_leaf()) {
+            t_max = fn(uint32_t(&node - fo::data(tree.nodes)), t_enter);
+            if (t_max <= 0.0f) {
+                return;
+            }
+        } else {
+            stack[stack_size++] = node.child_1;
+            stack[stack_size++] = node.child_2;
+        }
+    }
+}
+
+// A pair of proxies with overlapping fat boxes, with a < b
+struct ProxyPair {
+    uint32_t a;
+    uint32_t b;
+};
+
+// Finds the pairs of overlapping proxies where at least one of the two was created or moved out of its fat box
+// since the last call, sorted and without duplicates, and clears the moved flags. Pairs that overlapped before
+// and neither moved aren't reported again, so keep the previous frame's pairs to find the ones that ended.
+void update_pairs(DynamicAABBTree &tree, fo::Array<ProxyPair> &pairs_out);
+
+} // namespace eng
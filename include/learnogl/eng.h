@@ -156,12 +156,15 @@ struct GLApp {
     FixedStringBuffer fixed_string_buffer;
 
     SceneTree scene_tree;
+    // The scene tree's world matrices and visibility as of the last update, published at the end of the update
+    // with scene_tree.publish_snapshot, for rendering from another thread.
+    SceneSnapshots scene_snapshots;
 
     Vec2 window_size;
 
     Camera camera;
 
-    GLApp(u32 scene_tree_node_pool_size);
+    GLApp(u32 scene_tree_initial_capacity);
 };
 
 /// Returns ref to a global GLApp structure which gets initialized by start_gl by default
@@ -0,0 +1,75 @@
+// Culling against the viewing frustum. Bounding volumes are tested 8 at a time against the 6 planes, and the
+// result is a bit per object that can be turned into a list of the visible ones.
+#pragma once
+
+#include <learnogl/bounding_shapes.h>
+#include <scaffold/math_types.h>
+#include <scaffold/types.h>
+
+namespace eng {
+
+struct FrustumPlanes {
+    // The plane equations in <N, D> form, with unit normals pointing 'inwards'. A point p is inside the plane
+    // when dot(N, p) + D >= 0.
+    fo::Vector4 planes[6];
+
+    enum { LEFT = 0, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE };
+
+    // Extracts the planes from a clip-from-X matrix (Gribb and Hartmann). Pass the projection matrix to get
+    // view-space planes, or projection * view to get world-space ones. Expects the OpenGL clip volume, -w <= z
+    // <= w.
+    void init_from_projection_matrix(const fo::Matrix4x4 &clip_from_x);
+};
+
+// Bounding volumes with each coordinate in its own array, so they can be loaded straight into 8 lanes.
+struct BoundingSphereArrays {
+    const float *center[3];
+    const float *radius;
+};
+
+struct AABBArrays {
+    const float *min[3];
+    const float *max[3];
+};
+
+// Number of bytes in the visible_bits and plane_cache arrays for the given number of objects
+inline uint32_t cull_bytes_for(uint32_t num_objects) { return (num_objects + 7) / 8; }
+
+// Sets bit i % 8 of visible_bits[i / 8] if object i is inside or crosses the frustum, and clears it if it's
+// entirely outside one of the planes. Objects crossing the corners of the frustum can be kept even though they're
+// outside, as usual with plane tests.
+//
+// `plane_cache` is optional, cull_bytes_for(num_objects) bytes kept from one frame to the next and zeroed at
+// first. For each group of 8 objects it records the plane that culled all of them, which is tested first next
+// time. It doesn't change the result, only how many planes are tested.
+void frustum_cull(const FrustumPlanes &frustum,
+                  const BoundingSphere *spheres,
+                  uint32_t num_spheres,
+                  uint8_t *visible_bits,
+                  uint8_t *plane_cache = nullptr);
+
+// Boxes are tested with the corner farthest along each plane's normal, picked by the octant of the normal once
+// per plane rather than per box.
+void frustum_cull(const FrustumPlanes &frustum,
+                  const fo::AABB *boxes,
+                  uint32_t num_boxes,
+                  uint8_t *visible_bits,
+                  uint8_t *plane_cache = nullptr);
+
+void frustum_cull(const FrustumPlanes &frustum,
+                  const BoundingSphereArrays &spheres,
+                  uint32_t num_spheres,
+                  uint8_t *visible_bits,
+                  uint8_t *plane_cache = nullptr);
+
+void frustum_cull(const FrustumPlanes &frustum,
+                  const AABBArrays &boxes,
+                  uint32_t num_boxes,
+                  uint8_t *visible_bits,
+                  uint8_t *plane_cache = nullptr);
+
+// Writes the indices of the set bits to `indices_out` in increasing order and returns how many there are.
+// `indices_out` needs room for `num_objects` indices.
+uint32_t compact_visible_indices(const uint8_t *visible_bits, uint32_t num_objects, uint32_t *indices_out);
+
+} // namespace eng
@@ -586,7 +586,7 @@ inline bool operator==(const ShaderStorageBuffer &b1, const ShaderStorageBuffer
 // input slot, aka the vertex buffer binding point.
 struct VaoAttributeFormat {
     GLuint num_components;             // 1, 2, 3, or 4
-    GLenum component_type;             // GL_FLOAT, GL_UNSIGNED_BYTE, GL_UNSIGNED_INT
+    GLenum component_type;             // GL_FLOAT, GL_HALF_FLOAT, GL_(UNSIGNED_)BYTE, _SHORT or _INT
     GLboolean normalize;               // Normalize when access from vertex shader?
     GLboolean using_integer_in_shader; // Using uint, uvec, etc. in shader?
     GLuint relative_offset;            // Relative offset in vertex data struct
@@ -595,10 +595,10 @@ struct VaoAttributeFormat {
     GLuint vbo_binding_point;          // Only relevant if instances_before_advancing is not 0
 
     using num_components_mask = IntMask<0, 3>;
-    using component_type_mask = IntMask<3, 2>;
-    using normalize_mask = IntMask<5, 1>;
-    using using_integer_in_shader_mask = IntMask<6, 1>;
-    using vbo_binding_point_mask = IntMask<7, 4>;
+    using component_type_mask = IntMask<3, 3>;
+    using normalize_mask = IntMask<6, 1>;
+    using using_integer_in_shader_mask = IntMask<7, 1>;
+    using vbo_binding_point_mask = IntMask<8, 4>;
     using relative_offset_mask = IntMask<16, 16>;
     using instances_before_advancing_mask = IntMask<32, 32>;
 
@@ -624,11 +624,7 @@ struct VaoAttributeFormat {
     constexpr u64 get_compressed() const {
         u64 h = 0;
         h = num_components_mask::set(h, num_components);
-        h = component_type_mask::set(
-            h,
-            component_type == GL_FLOAT
-                ? 0
-                : component_type == GL_UNSIGNED_BYTE ? 1 : component_type == GL_UNSIGNED_INT ? 2 : 3);
+        h = component_type_mask::set(h, compress_component_type(component_type));
         h = normalize_mask::set(h, normalize == GL_TRUE ? 1 : 0);
         h = using_integer_in_shader_mask::set(h, using_integer_in_shader == GL_TRUE ? 1 : 0);
         h = vbo_binding_point_mask::set(h, vbo_binding_point);
@@ -640,12 +636,7 @@ struct VaoAttributeFormat {
     static constexpr VaoAttributeFormat uncompress(u64 h) {
         VaoAttributeFormat format = {};
         format.num_components = (u32)num_components_mask::extract(h);
-        u32 component_type = (u32)component_type_mask::extract(h);
-        format.component_type =
-            component_type == 0 ? GL_FLOAT
-                                : component_type == 1 ? GL_UNSIGNED_BYTE
-                                                      : component_type == 2 ? GL_UNSIGNED_INT
-                                                                            : GL_FLOAT; // Default is GL_FLOAT
+        format.component_type = uncompress_component_type((u32)component_type_mask::extract(h));
 
         format.normalize = (u32)normalize_mask::extract(h) ? GL_TRUE : GL_FALSE;
         format.using_integer_in_shader = (u32)using_integer_in_shader_mask::extract(h) ? GL_TRUE : GL_FALSE;
@@ -655,6 +646,34 @@ struct VaoAttributeFormat {
         return format;
     }
 
+    // GL_FLOAT is 0, so that the invalid format compresses to 0. Other types are taken as GL_FLOAT.
+    static constexpr u32 compress_component_type(GLenum type) {
+        switch (type) {
+        case GL_UNSIGNED_BYTE:
+            return 1;
+        case GL_UNSIGNED_INT:
+            return 2;
+        case GL_HALF_FLOAT:
+            return 3;
+        case GL_SHORT:
+            return 4;
+        case GL_UNSIGNED_SHORT:
+            return 5;
+        case GL_BYTE:
+            return 6;
+        case GL_INT:
+            return 7;
+        default:
+            return 0;
+        }
+    }
+
+    static constexpr GLenum uncompress_component_type(u32 compressed) {
+        constexpr GLenum types[] = { GL_FLOAT, GL_UNSIGNED_BYTE,  GL_UNSIGNED_INT, GL_HALF_FLOAT,
+                                     GL_SHORT, GL_UNSIGNED_SHORT, GL_BYTE,         GL_INT };
+        return types[compressed];
+    }
+
     // Gives a desc that denotes an invalid attribute format. We maintain the invariant that its compressed
     // u32 version equals 0.
     static constexpr VaoAttributeFormat invalid() {
@@ -3,6 +3,10 @@
 #include <learnogl/math_ops.h>
 #include <learnogl/kitchen_sink.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace eng {
 
 // Returns the closest point on given AABB from the given point p.
@@ -61,4 +65,245 @@ REALLY_INLINE bool test_sphere_obb(const fo::Vector3 &sphere_center, float radiu
     return radius * radius >= square_magnitude(sphere_center - closest);
 }
 
+// -- Ray packets. Boxes are tested with slabs, multiplying by the reciprocals of the ray directions instead of
+// dividing. The tests return a mask with bit i set if ray (or box, or sphere) i is hit at some 0 <= t <= t_max,
+// and store where each one is entered, 0 if the ray starts inside. The t of the lanes not hit is unspecified.
+
+// Reciprocal of a direction component. A zero component gets a huge but finite reciprocal of the same sign rather
+// than an infinity, so the slab distances are never 0 * inf = NaN. A ray parallel to a slab is inside it if it
+// starts between the planes, and outside if not. One lying exactly on one of the planes can go either way.
+REALLY_INLINE float safe_reciprocal(float d) {
+    return 1.0f / (d == 0.0f ? std::copysign(std::numeric_limits<float>::min(), d) : d);
+}
+
+// A ray with the reciprocal of its direction, for testing against many boxes.
+struct PrecomputedRay {
+    fo::Vector3 origin;
+    fo::Vector3 direction;
+    fo::Vector3 inv_direction;
+
+    PrecomputedRay() = default;
+
+    explicit PrecomputedRay(const math::Ray &ray)
+        : origin(ray.origin)
+        , direction(ray.direction)
+        , inv_direction{ safe_reciprocal(ray.direction.x),
+                         safe_reciprocal(ray.direction.y),
+                         safe_reciprocal(ray.direction.z) } {}
+};
+
+// Returns true if the two boxes overlap or touch.
+REALLY_INLINE bool test_aabb_aabb(const fo::AABB &a, const fo::AABB &b) {
+    return a.min.x <= b.max.x && b.min.x <= a.max.x && a.min.y <= b.max.y && b.min.y <= a.max.y &&
+           a.min.z <= b.max.z && b.min.z <= a.max.z;
+}
+
+// Slab test for a single ray and box. Returns true if the ray enters the box at some 0 <= t <= t_max, and stores
+// where in t_enter, 0 if it starts inside.
+REALLY_INLINE bool test_ray_aabb(const PrecomputedRay &ray, const fo::AABB &box, float t_max, float &t_enter) {
+    float t_near = 0.0f;
+    float t_far = t_max;
+    for (int axis = 0; axis < 3; ++axis) {
+        const float t0 = ((&box.min.x)[axis] - (&ray.origin.x)[axis]) * (&ray.inv_direction.x)[axis];
+        const float t1 = ((&box.max.x)[axis] - (&ray.origin.x)[axis]) * (&ray.inv_direction.x)[axis];
+        t_near = std::max(t_near, std::min(t0, t1));
+        t_far = std::min(t_far, std::max(t0, t1));
+    }
+    t_enter = t_near;
+    return t_near <= t_far;
+}
+
+// 4 or 8 rays, with each coordinate of their origins and directions in its own register.
+struct RayPacket4 {
+    simd::Vector4 origin[3];
+    simd::Vector4 direction[3];
+    simd::Vector4 inv_direction[3];
+};
+
+struct RayPacket8 {
+    simd::Vec3x8 origin;
+    simd::Vec3x8 direction;
+    simd::Vec3x8 inv_direction;
+};
+
+// 4 or 8 boxes, like the rays above
+struct AABBPacket4 {
+    simd::Vector4 min[3];
+    simd::Vector4 max[3];
+};
+
+struct AABBPacket8 {
+    simd::Vec3x8 min;
+    simd::Vec3x8 max;
+};
+
+// Packs rays[0, 4) or rays[0, 8). Repeat a ray to fill a packet with fewer.
+inline RayPacket4 make_ray_packet4(const math::Ray *rays) {
+    RayPacket4 packet;
+    for (int axis = 0; axis < 3; ++axis) {
+        const auto coord = [axis](const fo::Vector3 &v) { return (&v.x)[axis]; };
+        packet.origin[axis] = simd::Vector4(
+            _mm_setr_ps(coord(rays[0].origin), coord(rays[1].origin), coord(rays[2].origin), coord(rays[3].origin)));
+        packet.direction[axis] = simd::Vector4(_mm_setr_ps(
+            coord(rays[0].direction), coord(rays[1].direction), coord(rays[2].direction), coord(rays[3].direction)));
+        const __m128 is_zero = _mm_cmpeq_ps(packet.direction[axis], _mm_setzero_ps());
+        const __m128 smallest = _mm_set1_ps(std::numeric_limits<float>::min());
+        const __m128 d = _mm_blendv_ps(packet.direction[axis], _mm_or_ps(packet.direction[axis], smallest), is_zero);
+        packet.inv_direction[axis] = simd::Vector4(_mm_div_ps(_mm_set1_ps(1.0f), d));
+    }
+    return packet;
+}
+
+inline RayPacket8 make_ray_packet8(const math::Ray *rays) {
+    using namespace simd;
+
+    RayPacket8 packet;
+    packet.origin = load_vec3x8(&rays[0].origin, sizeof(math::Ray));
+    packet.direction = load_vec3x8(&rays[0].direction, sizeof(math::Ray));
+
+    const Float8 smallest = splat8(std::numeric_limits<float>::min());
+    const auto reciprocal = [smallest](Float8 d) {
+        return splat8(1.0f) / select(cmp_eq(d, zero8()), d | smallest, d);
+    };
+    packet.inv_direction =
+        Vec3x8{ reciprocal(packet.direction.x), reciprocal(packet.direction.y), reciprocal(packet.direction.z) };
+    return packet;
+}
+
+// Packs boxes[0, 4) or boxes[0, 8)
+inline AABBPacket4 make_aabb_packet4(const fo::AABB *boxes) {
+    AABBPacket4 packet;
+    for (int axis = 0; axis < 3; ++axis) {
+        const auto coord = [axis](const fo::Vector3 &v) { return (&v.x)[axis]; };
+        packet.min[axis] = simd::Vector4(
+            _mm_setr_ps(coord(boxes[0].min), coord(boxes[1].min), coord(boxes[2].min), coord(boxes[3].min)));
+        packet.max[axis] = simd::Vector4(
+            _mm_setr_ps(coord(boxes[0].max), coord(boxes[1].max), coord(boxes[2].max), coord(boxes[3].max)));
+    }
+    return packet;
+}
+
+inline AABBPacket8 make_aabb_packet8(const fo::AABB *boxes) {
+    return AABBPacket8{ simd::load_vec3x8(&boxes[0].min, sizeof(fo::AABB)),
+                        simd::load_vec3x8(&boxes[0].max, sizeof(fo::AABB)) };
+}
+
+// The slab test itself, on 4 or 8 lanes of rays and boxes. t_enter is the largest of the near distances and
+// t_exit the smallest of the far ones, starting from [0, t_max].
+REALLY_INLINE int ray_slabs4(const simd::Vector4 *origin,
+                             const simd::Vector4 *inv_direction,
+                             const simd::Vector4 *min,
+                             const simd::Vector4 *max,
+                             __m128 t_max,
+                             __m128 &t_enter) {
+    __m128 t_near = _mm_setzero_ps();
+    __m128 t_far = t_max;
+    for (int axis = 0; axis < 3; ++axis) {
+        const __m128 t0 = _mm_mul_ps(_mm_sub_ps(min[axis], origin[axis]), inv_direction[axis]);
+        const __m128 t1 = _mm_mul_ps(_mm_sub_ps(max[axis], origin[axis]), inv_direction[axis]);
+        t_near = _mm_max_ps(t_near, _mm_min_ps(t0, t1));
+        t_far = _mm_min_ps(t_far, _mm_max_ps(t0, t1));
+    }
+    t_enter = t_near;
+    return _mm_movemask_ps(_mm_cmple_ps(t_near, t_far));
+}
+
+REALLY_INLINE int ray_slabs8(const simd::Vec3x8 &origin,
+                             const simd::Vec3x8 &inv_direction,
+                             const simd::Vec3x8 &min,
+                             const simd::Vec3x8 &max,
+                             simd::Float8 t_max,
+                             simd::Float8 &t_enter) {
+    using namespace simd;
+
+    const Vec3x8 t0 = Vec3x8{ (min.x - origin.x) * inv_direction.x,
+                              (min.y - origin.y) * inv_direction.y,
+                              (min.z - origin.z) * inv_direction.z };
+    const Vec3x8 t1 = Vec3x8{ (max.x - origin.x) * inv_direction.x,
+                              (max.y - origin.y) * inv_direction.y,
+                              (max.z - origin.z) * inv_direction.z };
+
+    const Float8 t_near = simd::max(simd::max(simd::max(zero8(), simd::min(t0.x, t1.x)), simd::min(t0.y, t1.y)),
+                                    simd::min(t0.z, t1.z));
+    const Float8 t_far = simd::min(simd::min(simd::min(t_max, simd::max(t0.x, t1.x)), simd::max(t0.y, t1.y)),
+                                   simd::max(t0.z, t1.z));
+    t_enter = t_near;
+    return movemask(cmp_le(t_near, t_far));
+}
+
+// 4 or 8 rays against one box
+REALLY_INLINE int test_ray_packet_aabb(const RayPacket4 &rays, const fo::AABB &box, __m128 t_max, __m128 &t_enter) {
+    const simd::Vector4 min[3] = { simd::splat(box.min.x), simd::splat(box.min.y), simd::splat(box.min.z) };
+    const simd::Vector4 max[3] = { simd::splat(box.max.x), simd::splat(box.max.y), simd::splat(box.max.z) };
+    return ray_slabs4(rays.origin, rays.inv_direction, min, max, t_max, t_enter);
+}
+
+REALLY_INLINE int
+test_ray_packet_aabb(const RayPacket8 &rays, const fo::AABB &box, simd::Float8 t_max, simd::Float8 &t_enter) {
+    return ray_slabs8(
+        rays.origin, rays.inv_direction, simd::splat3x8(box.min), simd::splat3x8(box.max), t_max, t_enter);
+}
+
+// One ray against 4 or 8 boxes
+REALLY_INLINE int
+test_ray_aabb_packet(const PrecomputedRay &ray, const AABBPacket4 &boxes, float t_max, __m128 &t_enter) {
+    const simd::Vector4 origin[3] = { simd::splat(ray.origin.x),
+                                      simd::splat(ray.origin.y),
+                                      simd::splat(ray.origin.z) };
+    const simd::Vector4 inv_direction[3] = { simd::splat(ray.inv_direction.x),
+                                             simd::splat(ray.inv_direction.y),
+                                             simd::splat(ray.inv_direction.z) };
+    return ray_slabs4(origin, inv_direction, boxes.min, boxes.max, _mm_set1_ps(t_max), t_enter);
+}
+
+REALLY_INLINE int
+test_ray_aabb_packet(const PrecomputedRay &ray, const AABBPacket8 &boxes, float t_max, simd::Float8 &t_enter) {
+    return ray_slabs8(simd::splat3x8(ray.origin),
+                      simd::splat3x8(ray.inv_direction),
+                      boxes.min,
+                      boxes.max,
+                      simd::splat8(t_max),
+                      t_enter);
+}
+
+// 4 or 8 rays against one sphere. The directions don't need to be unit length. Solves |o + t d - c|^2 = r^2 for
+// the smaller t, or takes 0 if the ray starts inside.
+REALLY_INLINE int test_ray_packet_sphere(
+    const RayPacket4 &rays, const fo::Vector3 &center, float radius, __m128 t_max, __m128 &t_enter) {
+    const simd::Vector4 oc[3] = { rays.origin[0] - simd::splat(center.x),
+                                  rays.origin[1] - simd::splat(center.y),
+                                  rays.origin[2] - simd::splat(center.z) };
+    const simd::Vector4 *d = rays.direction;
+
+    const simd::Vector4 a = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+    const simd::Vector4 b = oc[0] * d[0] + oc[1] * d[1] + oc[2] * d[2];
+    const simd::Vector4 c = oc[0] * oc[0] + oc[1] * oc[1] + oc[2] * oc[2] - simd::splat(radius * radius);
+    const simd::Vector4 discriminant = b * b - a * c;
+
+    const __m128 t_outside = _mm_div_ps(_mm_sub_ps(simd::negate(b), _mm_sqrt_ps(discriminant)), a);
+    const __m128 inside = _mm_cmple_ps(c, _mm_setzero_ps());
+    t_enter = _mm_blendv_ps(t_outside, _mm_setzero_ps(), inside);
+
+    const __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(discriminant, _mm_setzero_ps()),
+                                             _mm_cmpge_ps(t_enter, _mm_setzero_ps())),
+                                  _mm_cmple_ps(t_enter, t_max));
+    return _mm_movemask_ps(hit);
+}
+
+REALLY_INLINE int test_ray_packet_sphere(
+    const RayPacket8 &rays, const fo::Vector3 &center, float radius, simd::Float8 t_max, simd::Float8 &t_enter) {
+    using namespace simd;
+
+    const Vec3x8 oc = rays.origin - splat3x8(center);
+    const Float8 a = dot(rays.direction, rays.direction);
+    const Float8 b = dot(oc, rays.direction);
+    const Float8 c = dot(oc, oc) - splat8(radius * radius);
+    const Float8 discriminant = b * b - a * c;
+
+    const Float8 t_outside = (negate(b) - simd::sqrt(discriminant)) / a;
+    t_enter = select(cmp_le(c, zero8()), zero8(), t_outside);
+
+    return movemask(cmp_ge(discriminant, zero8()) & cmp_ge(t_enter, zero8()) & cmp_le(t_enter, t_max));
+}
+
 } // namespace eng
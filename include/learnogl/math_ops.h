@@ -372,6 +372,87 @@ inline void normalize_update(fo::Vector3 &v) {
     v.z /= mag;
 }
 
+/// Returns the matrix that transforms normals, i.e the inverse-transpose of the upper-left 3x3 part of `m`.
+/// The translation column of the returned matrix is (0, 0, 0, 1).
+inline fo::Matrix4x4 normal_matrix(const fo::Matrix4x4 &m) {
+    const fo::Vector3 a(m.x);
+    const fo::Vector3 b(m.y);
+    const fo::Vector3 c(m.z);
+
+    // Rows of the inverse are the cross products divided by the determinant, so the columns of the
+    // inverse-transpose are.
+    const fo::Vector3 bc = cross(b, c);
+    const float inv_det = 1.0f / dot(a, bc);
+
+    return fo::Matrix4x4{ fo::Vector4(inv_det * bc, 0.0f),
+                          fo::Vector4(inv_det * cross(c, a), 0.0f),
+                          fo::Vector4(inv_det * cross(a, b), 0.0f),
+                          fo::Vector4{ 0.0f, 0.0f, 0.0f, 1.0f } };
+}
+
+// -- Batched transforms over arrays of Vector3. An array is given the same way StridedIterator walks over
+// the attribute packs of a MeshData - a pointer to the first element and the distance in bytes between
+// consecutive elements. Only the 12 bytes of each element are read or written, so `dst` can be the same
+// array as `src`. Uses the widest SIMD kernel available.
+
+/// Transforms `count` points (w = 1) by `m`.
+void transform_points(const fo::Matrix4x4 &m,
+                      const fo::Vector3 *src,
+                      uint32_t src_stride,
+                      fo::Vector3 *dst,
+                      uint32_t dst_stride,
+                      uint32_t count);
+
+/// Transforms `count` vectors (w = 0) by `m`.
+void transform_vectors(const fo::Matrix4x4 &m,
+                       const fo::Vector3 *src,
+                       uint32_t src_stride,
+                       fo::Vector3 *dst,
+                       uint32_t dst_stride,
+                       uint32_t count);
+
+/// Transforms `count` normals by the normal_matrix of `m`. The results are normalized.
+void transform_normals(const fo::Matrix4x4 &m,
+                       const fo::Vector3 *src,
+                       uint32_t src_stride,
+                       fo::Vector3 *dst,
+                       uint32_t dst_stride,
+                       uint32_t count);
+
+/// Same as above, for tightly packed arrays.
+inline void transform_points(const fo::Matrix4x4 &m, const fo::Vector3 *src, fo::Vector3 *dst, uint32_t count) {
+    transform_points(m, src, sizeof(fo::Vector3), dst, sizeof(fo::Vector3), count);
+}
+
+inline void transform_vectors(const fo::Matrix4x4 &m, const fo::Vector3 *src, fo::Vector3 *dst, uint32_t count) {
+    transform_vectors(m, src, sizeof(fo::Vector3), dst, sizeof(fo::Vector3), count);
+}
+
+inline void transform_normals(const fo::Matrix4x4 &m, const fo::Vector3 *src, fo::Vector3 *dst, uint32_t count) {
+    transform_normals(m, src, sizeof(fo::Vector3), dst, sizeof(fo::Vector3), count);
+}
+
+// -- Batched matrix functions. Same results as calling inverse, inverse_rotation_translation and mul_mat_mat
+// on each element of contiguous arrays, but several matrices are computed at a time with the widest SIMD
+// kernel available. `dst` can be the same array as a source. With `multithreaded`, large arrays are split
+// into chunks done on the parallel_for worker threads.
+
+/// dst[i] = inverse(src[i])
+void inverse_n(const fo::Matrix4x4 *src, fo::Matrix4x4 *dst, uint32_t count, bool multithreaded = false);
+
+/// dst[i] = inverse_rotation_translation(src[i])
+void inverse_rotation_translation_n(const fo::Matrix4x4 *src,
+                                    fo::Matrix4x4 *dst,
+                                    uint32_t count,
+                                    bool multithreaded = false);
+
+/// dst[i] = a[i] * b[i]
+void mul_mat_mat_n(const fo::Matrix4x4 *a,
+                   const fo::Matrix4x4 *b,
+                   fo::Matrix4x4 *dst,
+                   uint32_t count,
+                   bool multithreaded = false);
+
 // -- Don't forget Vector2 :)
 
 constexpr inline fo::Vector2 operator+(const fo::Vector2 &a, const fo::Vector2 &b) {
@@ -904,12 +985,33 @@ inline fo::Quaternion nlerp(const fo::Quaternion &a, const fo::Vector4 &b, float
     return fo::Quaternion{ l.x / mag, l.y / mag, l.z / mag, l.w / mag };
 }
 
-/// Performs spherical linear interpolation between the two given versors
-#if 0
+/// Performs spherical linear interpolation between the two given versors, along the shorter arc (b is negated
+/// if dot(a, b) < 0). Falls back to nlerp when they are nearly the same rotation.
 inline fo::Quaternion slerp(const fo::Quaternion &a, const fo::Quaternion &b, float alpha) {
+    float cos_theta = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    const float sign = cos_theta < 0.0f ? -1.0f : 1.0f;
+    cos_theta *= sign;
+
+    float wa = 1.0f - alpha;
+    float wb = alpha;
+
+    if (cos_theta < 0.9995f) {
+        const float theta = std::acos(cos_theta);
+        const float sin_theta = std::sin(theta);
+        wa = std::sin(wa * theta) / sin_theta;
+        wb = std::sin(wb * theta) / sin_theta;
+    }
 
+    wb *= sign;
+    // clang-format off
+    return normalize(fo::Quaternion{
+        wa * a.x + wb * b.x,
+        wa * a.y + wb * b.y,
+        wa * a.z + wb * b.z,
+        wa * a.w + wb * b.w
+    });
+    // clang-format on
 }
-#endif
 
 /// A plane in 3 dimensions represented by its normal N and signed distance D from origin. So the whole
 /// quantity can be stored in a single Vector4.
@@ -971,8 +1073,19 @@ struct SymmetricEigenSolver3x3_Result {
     fo::Matrix3x3 eigenvectors;
 };
 
+/// Eigenvalues are sorted in decreasing order, eigenvectors.x is the one for eigenvalues.x and so on. The
+/// eigenvectors form a right-handed orthonormal basis.
 void eigensolve_sym3x3(const fo::Matrix3x3 &symm, SymmetricEigenSolver3x3_Result &out);
 
+/// Same as calling eigensolve_sym3x3 on each matrix, with the same ordering and handedness of the results, but
+/// solves 8 matrices at a time with cyclic Jacobi rotations in SIMD lanes. The eigenvalues agree with the
+/// scalar solver to about 1e-6 times the largest element of the matrix. Eigenvectors of (nearly) repeated
+/// eigenvalues can differ, as any basis of their eigenspace is a valid answer.
+void eigensolve_sym3x3_n(const fo::Matrix3x3 *symm,
+                         SymmetricEigenSolver3x3_Result *out,
+                         uint32_t count,
+                         bool multithreaded = false);
+
 /// A full local transform that can be attached to any object that has a scale, position, orientation. The
 /// affine matrix this denotes is R * S + T.
 struct LocalTransform {
@@ -1020,6 +1133,146 @@ struct LocalTransform {
     static LocalTransform identity() { return LocalTransform{ one_3, identity_versor, fo::Vector3::zero() }; }
 };
 
+// -- Batched versor and LocalTransform functions, for things like evaluating the joints of many skeletons in
+// one go. Like the batched matrix functions above, these compute 8 elements at a time with the widest SIMD
+// kernel available, `dst` can be the same array as a source, and `multithreaded` splits large arrays across
+// the parallel_for workers.
+//
+// The interpolating functions take either one `alpha` for all elements or an array with one per element. They
+// always go along the shorter arc, i.e. b[i] is negated if dot(a[i], b[i]) < 0, which the scalar nlerp doesn't
+// do. slerp_n doesn't compute the exact slerp. It runs nlerp with alpha corrected by a polynomial in alpha and
+// dot(a[i], b[i]), which keeps the result within 1e-3 radians of slerp() for every pair of versors.
+
+/// dst[i] = normalize(src[i])
+void normalize_n(const fo::Quaternion *src, fo::Quaternion *dst, uint32_t count, bool multithreaded = false);
+
+/// dst[i] = nlerp(a[i], b[i], alpha) along the shorter arc
+void nlerp_n(const fo::Quaternion *a,
+             const fo::Quaternion *b,
+             float alpha,
+             fo::Quaternion *dst,
+             uint32_t count,
+             bool multithreaded = false);
+
+void nlerp_n(const fo::Quaternion *a,
+             const fo::Quaternion *b,
+             const float *alphas,
+             fo::Quaternion *dst,
+             uint32_t count,
+             bool multithreaded = false);
+
+/// dst[i] ~= slerp(a[i], b[i], alpha)
+void slerp_n(const fo::Quaternion *a,
+             const fo::Quaternion *b,
+             float alpha,
+             fo::Quaternion *dst,
+             uint32_t count,
+             bool multithreaded = false);
+
+void slerp_n(const fo::Quaternion *a,
+             const fo::Quaternion *b,
+             const float *alphas,
+             fo::Quaternion *dst,
+             uint32_t count,
+             bool multithreaded = false);
+
+/// dst[i] = matrix_from_versor(src[i])
+void matrix_from_versor_n(const fo::Quaternion *src,
+                          fo::Matrix4x4 *dst,
+                          uint32_t count,
+                          bool multithreaded = false);
+
+/// Blends two arrays of transforms, e.g. the poses at two keyframes. Scale and position are interpolated
+/// linearly, orientation like slerp_n.
+void slerp_n(const LocalTransform *a,
+             const LocalTransform *b,
+             float alpha,
+             LocalTransform *dst,
+             uint32_t count,
+             bool multithreaded = false);
+
+void slerp_n(const LocalTransform *a,
+             const LocalTransform *b,
+             const float *alphas,
+             LocalTransform *dst,
+             uint32_t count,
+             bool multithreaded = false);
+
+/// dst[i] = src[i].get_mat4()
+void matrix_from_local_transform_n(const LocalTransform *src,
+                                   fo::Matrix4x4 *dst,
+                                   uint32_t count,
+                                   bool multithreaded = false);
+
+// -- Packed attribute formats. Conversions between f32 and the smaller formats GL reads vertex attributes in:
+// half floats (GL_HALF_FLOAT), normalized integers (GL_SHORT and GL_UNSIGNED_BYTE with normalized = GL_TRUE) and
+// octahedral unit vectors in two snorm16s.
+//
+// The bulk versions take arrays like transform_points does, i.e. a pointer to the first element and the distance
+// in bytes between consecutive elements, with `components` (1 to 4) numbers per element. Only those numbers are
+// read or written, so the arrays can be interleaved with other attributes. Tightly packed arrays are converted in
+// one flat run. The half float conversions use F16C when the CPU has it, and give the same results either way.
+
+/// Rounds to the nearest half, ties to even. Too large values become infinity, NaN stays NaN.
+uint16_t f32_to_f16(float f);
+
+/// Exact, including subnormals, infinities and NaN.
+float f16_to_f32(uint16_t h);
+
+/// round(clamp(f, -1, 1) * 32767). NaN becomes -1. The inverse is GL's max(i / 32767, -1).
+int16_t f32_to_snorm16(float f);
+
+/// round(clamp(f, 0, 1) * 255). NaN becomes 0.
+uint8_t f32_to_unorm8(float f);
+
+void f32_to_f16(const float *src,
+                uint32_t src_stride,
+                uint16_t *dst,
+                uint32_t dst_stride,
+                uint32_t count,
+                uint32_t components);
+
+void f16_to_f32(const uint16_t *src,
+                uint32_t src_stride,
+                float *dst,
+                uint32_t dst_stride,
+                uint32_t count,
+                uint32_t components);
+
+void f32_to_snorm16(const float *src,
+                    uint32_t src_stride,
+                    int16_t *dst,
+                    uint32_t dst_stride,
+                    uint32_t count,
+                    uint32_t components);
+
+void f32_to_unorm8(const float *src,
+                   uint32_t src_stride,
+                   uint8_t *dst,
+                   uint32_t dst_stride,
+                   uint32_t count,
+                   uint32_t components);
+
+/// Octahedral encoding of a direction (Cigolle et al., "A Survey of Efficient Representations for Independent
+/// Unit Vectors") into two snorm16s, 4 bytes instead of 12. `n` need not be normalized; the zero vector
+/// encodes to +z. Decoding gives back a unit vector within 7e-5 radians (0.004 degrees) of the original.
+void encode_octahedral_snorm16(const fo::Vector3 &n, int16_t out[2]);
+
+fo::Vector3 decode_octahedral_snorm16(const int16_t in[2]);
+
+/// Bulk versions. Each element of `dst` (resp. `src`) of the octahedral arrays is two int16_t.
+void encode_octahedral_snorm16(const fo::Vector3 *src,
+                               uint32_t src_stride,
+                               int16_t *dst,
+                               uint32_t dst_stride,
+                               uint32_t count);
+
+void decode_octahedral_snorm16(const int16_t *src,
+                               uint32_t src_stride,
+                               fo::Vector3 *dst,
+                               uint32_t dst_stride,
+                               uint32_t count);
+
 } // namespace math
 
 } // namespace eng
@@ -7,19 +7,40 @@
 namespace eng {
 namespace mesh {
 
+// Meshes are indexed with u16 unless they have too many vertices for it, in which case they are either split,
+// see split_for_u16_indices, or indexed with u32. MeshDataOffsetsAndSizes::index_size tells which.
 using IndexType = u16;
+using WideIndexType = u32;
+
+// Index 0xffff is kept free for primitive restart
+constexpr u32 k_max_vertices_for_u16_indices = 0xffff;
 
 constexpr u32 ATTRIBUTE_NOT_PRESENT = std::numeric_limits<u32>::max();
 constexpr u32 MAX_BONES_AFFECTING_VERTEX = 5;
 constexpr i32 INVALID_BONE_ID = -1;
 
+// The formats of the attributes in a pack. With VERTEX_FORMAT_F32 they are all floats, the position being 3 (or 2
+// for 2D meshes), the normal 3, the uv 2 and the tangent 4 with the handedness in w. VERTEX_FORMAT_QUANTIZED, see
+// quantize_mesh, packs them into 24 bytes instead of 48:
+//
+// position - 4 x unorm16. xyz are the fractions of the way across the mesh's bounding box, see
+//            position_dequantize_matrix, and w is 1.
+// normal   - 2 x snorm16, octahedral (see math::encode_octahedral_snorm16)
+// uv       - 2 x half float
+// tangent  - 4 x snorm16, the octahedral direction in xy, the handedness in z and 0 in w
+enum VertexFormat : u32 {
+    VERTEX_FORMAT_F32 = 0,
+    VERTEX_FORMAT_QUANTIZED = 1,
+};
+
 // Given N = number of vertices, M = number of indices in mesh, the data is laid out like so:
 //
 // | pnut_0 | pnut_1 |...| pnut_{N-1} |
 // | index_0 | index_1 |...| index_{M-1} |
 // | afb_0 | afb_1 | ... | afb_{N-1} |
 //
-// "pnut" means position, normal, uv, tangent. The last 3 attributes are optional depending on the mesh.
+// "pnut" means position, normal, uv, tangent. The last 3 attributes are optional depending on the mesh. Each
+// index is `index_size` bytes.
 struct MeshDataOffsetsAndSizes {
     u32 num_vertices;     // Number of (unique) vertices in the mesh
     u32 num_faces;        // Number of faces (triangles really) in the mesh
@@ -31,8 +52,19 @@ struct MeshDataOffsetsAndSizes {
     u32 num_bones;        // Number of bones in the skinned mesh.
     u32 bone_data_offset; // Bone data offset(Not needed..? Place them after indices)
 
+    // sizeof(IndexType) or sizeof(WideIndexType)
+    u32 index_size = sizeof(IndexType);
+
+    u32 vertex_format = VERTEX_FORMAT_F32;
+
+    // The bounding box quantized positions are relative to
+    fo::Vector3 position_min = {};
+    fo::Vector3 position_extent = {};
+
     u32 get_vertices_size_in_bytes() const { return num_vertices * packed_attr_size; }
-    u32 get_indices_size_in_bytes() const { return num_faces * 3 * sizeof(u16); }
+    u32 get_indices_size_in_bytes() const { return num_faces * 3 * index_size; }
+    bool has_wide_indices() const { return index_size == sizeof(WideIndexType); }
+    bool is_quantized() const { return vertex_format == VERTEX_FORMAT_QUANTIZED; }
 
     // Returns the amount of bytes needed by the affecting bones list.
     inline u32 get_affecting_bones_size_in_bytes() const;
@@ -83,6 +115,7 @@ struct AffectingBones {
             if (bone_ids[i] == INVALID_BONE_ID) {
                 break;
             }
+            ++i;
         }
         return i;
     }
@@ -130,6 +163,11 @@ struct StrippedMeshData {
     u32 tex2d_offset;
     u32 tangent_offset;
     u32 bone_data_offset;
+    // Defaults for the ones filled in by hand: u16 indices, not quantized
+    u32 index_size = sizeof(IndexType);
+    u32 vertex_format = VERTEX_FORMAT_F32;
+    fo::Vector3 position_min = {};
+    fo::Vector3 position_extent = {};
     bool positions_are_2d;
 
     StrippedMeshData() = default;
@@ -143,11 +181,32 @@ struct StrippedMeshData {
         tex2d_offset = mdo.tex2d_offset;
         tangent_offset = mdo.tangent_offset;
         bone_data_offset = mdo.bone_data_offset;
+        index_size = mdo.index_size;
+        vertex_format = mdo.vertex_format;
+        position_min = mdo.position_min;
+        position_extent = mdo.position_extent;
 
         this->positions_are_2d = positions_are_2d;
     }
 };
 
+// Maps the position attribute of a quantized mesh, read as normalized unorm16s, to model space. Multiply it
+// into the model's transform for the positions, not the normals. Identity for meshes that aren't quantized.
+inline fo::Matrix4x4 position_dequantize_matrix(const StrippedMeshData &m) {
+    if (m.vertex_format != VERTEX_FORMAT_QUANTIZED) {
+        return fo::Matrix4x4{ { 1.0f, 0.0f, 0.0f, 0.0f },
+                              { 0.0f, 1.0f, 0.0f, 0.0f },
+                              { 0.0f, 0.0f, 1.0f, 0.0f },
+                              { 0.0f, 0.0f, 0.0f, 1.0f } };
+    }
+    const fo::Vector3 &e = m.position_extent;
+    return fo::Matrix4x4{ { e.x, 0.0f, 0.0f, 0.0f },
+                          { 0.0f, e.y, 0.0f, 0.0f },
+                          { 0.0f, 0.0f, e.z, 0.0f },
+                          { m.position_min.x, m.position_min.y, m.position_min.z, 1.0f } };
+}
+
+// The positions as Vector3s, only for meshes that aren't quantized. See read_positions for either kind.
 inline StridedIterator<fo::Vector3, false> positions_begin(MeshData &m) {
     return StridedIterator<fo::Vector3, false>(m.buffer, m.o.packed_attr_size);
 }
@@ -166,11 +225,23 @@ inline StridedIterator<fo::Vector3, true> positions_end(const MeshData &m) {
                                               m.o.packed_attr_size);
 }
 
-inline const uint16_t *indices_begin(MeshData &m) {
-    return reinterpret_cast<uint16_t *>(m.buffer + m.o.get_vertices_size_in_bytes());
+// The bytes of the index buffer, of either index size
+inline const u8 *indices_begin(const MeshData &m) { return m.buffer + m.o.get_indices_byte_offset(); }
+
+inline const u8 *indices_end(const MeshData &m) { return indices_begin(m) + m.o.get_indices_size_in_bytes(); }
+
+// Returns the i-th index
+inline u32 index_at(const MeshData &m, u32 i) {
+    return m.o.has_wide_indices() ? reinterpret_cast<const WideIndexType *>(indices_begin(m))[i]
+                                  : reinterpret_cast<const IndexType *>(indices_begin(m))[i];
 }
 
-inline const uint16_t *indices_end(MeshData &m) { return indices_begin(m) + m.o.num_faces * 3; }
+// Copies all the indices out widened to u32, and back in at the mesh's index size
+void read_indices(const MeshData &m, u32 *indices_out);
+void write_indices(MeshData &m, const u32 *indices);
+
+// Copies the positions out as floats, dequantized if the mesh is quantized. Positions must be 3D.
+void read_positions(const MeshData &m, fo::Vector3 *positions_out);
 
 constexpr u32 max_children_bones = 5;
 
@@ -189,6 +260,10 @@ struct Model {
     // Allocator used to allocate the MeshData for each model.
     fo::Allocator *_buffer_allocator = &fo::memory_globals::default_allocator();
 
+    // When loaded from a cooked file, the mesh buffers point into this mapping of the file instead
+    void *_mapped_file = nullptr;
+    size_t _mapped_size = 0;
+
     Model() = default;
 
     Model(fo::Allocator &mesh_info_allocator, fo::Allocator &mesh_buffer_allocator);
@@ -214,16 +289,24 @@ enum ModelLoadFlagBits : u32 {
     GEN_UV_COORDS = 1 << 3,
     FILL_CONST_UV = 1 << 4, // If model does not have uv coordinates, you can set its vertices to a given uv
     IGNORE_BONES = 1 << 5,
+    OPTIMIZE_VERTEX_ORDER = 1 << 6, // Reorder triangles and vertices for the GPU, see mesh_optimize.h
+    SPLIT_FOR_U16_INDICES = 1 << 7, // Split meshes with too many vertices for u16 indices instead of using u32
+    QUANTIZE_VERTICES = 1 << 8,     // Store the vertices in VERTEX_FORMAT_QUANTIZED, see quantize_mesh
 };
 
-// Loads the model specified in the given file into `m`, which must not be containing any model.
+// Loads the model specified in the given file into `m`, which must not be containing any model. Cooked files,
+// see below, are recognized and loaded with load_cooked, in which case the flags and fill_uv are the ones the
+// model was cooked with. Each mesh gets u16 indices if it has at most k_max_vertices_for_u16_indices vertices.
+// Larger ones get u32 indices, or with SPLIT_FOR_U16_INDICES are split into consecutive meshes with u16 indices,
+// so the meshes of the model don't map one to one to the meshes in the file then. Skinned meshes aren't split.
 bool load(Model &m,
           const char *file_name,
           fo::Vector2 fill_uv = {},
           u32 model_load_flags = ModelLoadFlagBits::TRIANGULATE | ModelLoadFlagBits::CALC_NORMALS);
 
 // Loads the model and transforms each position, normal and tangent (if present) with the given transform
-// matrix. The linear part of the transform must be an orthogonal matrix therefore.
+// matrix. The linear part of the transform must be an orthogonal matrix therefore. With QUANTIZE_VERTICES the
+// meshes are quantized after being transformed. Cooked models must not have been cooked quantized.
 bool load_then_transform(Model &m,
                          const char *file_name,
                          fo::Vector2 fill_uv,
@@ -233,6 +316,62 @@ bool load_then_transform(Model &m,
 // Frees all the mesh buffers of this model. Must not be free already.
 void free_mesh_buffers(Model &m);
 
+// Splits the triangles of a mesh, in order, into parts of at most `max_vertices` vertices each, with u16
+// indices. The parts are appended to `parts`, with buffers allocated from `buffer_allocator`, and their count
+// returned. The mesh must not be skinned.
+u32 split_for_u16_indices(const MeshData &md,
+                          fo::Allocator &buffer_allocator,
+                          fo::Array<MeshData> &parts,
+                          u32 max_vertices = k_max_vertices_for_u16_indices);
+
+// Converts the vertices of a mesh to VERTEX_FORMAT_QUANTIZED, into a new buffer allocated from
+// `buffer_allocator` that holds the indices and bone data too. Positions must be 3D, and the mesh not already
+// quantized. The positions lose less than 1/131070 of the bounding box's extent along each axis, the normals and
+// tangents less than 0.004 degrees, and the uvs are rounded to halves. The functions that read float positions
+// off the mesh - positions_begin, optimize_mesh, build_meshlets, and the BVH and occluder builders - must be
+// done with it before.
+void quantize_mesh(const MeshData &md, fo::Allocator &buffer_allocator, MeshData &quantized_out);
+
+// -- Cooked models. The meshes of a model as loaded, written to a file offline so that loading it at runtime is
+// mapping the file in memory, with each MeshData::buffer pointing straight into the mapping. The file is made
+// of a header, an entry per mesh and then the mesh buffers in the usual layout, each aligned to
+// k_cooked_buffer_alignment. Little-endian only.
+
+constexpr u32 k_cooked_model_magic = 0x4d474f4c; // "LOGM"
+constexpr u32 k_cooked_model_version = 3;
+constexpr u32 k_cooked_buffer_alignment = 64;
+
+struct CookedModelHeader {
+    u32 magic;
+    u32 version;
+    u32 num_meshes;
+    u32 model_load_flags; // The ModelLoadFlagBits the model was loaded with when cooked
+};
+
+struct CookedMeshEntry {
+    MeshDataOffsetsAndSizes o;
+    u32 positions_are_2d;
+    u64 buffer_offset; // From the start of the file
+    u64 buffer_size;
+};
+
+static_assert(sizeof(CookedModelHeader) == 16 && sizeof(CookedMeshEntry) == 88, "Cooked file layout changed");
+
+// Writes the loaded model to a cooked file. `model_load_flags` are recorded as the ones it was loaded with.
+bool write_cooked_model(const Model &m, const char *file_name, u32 model_load_flags = 0);
+
+// Returns true if the file starts with the cooked model header
+bool is_cooked_model_file(const char *file_name);
+
+// Maps the cooked file and sets up the meshes of `m` to point into it. The mapping is copy-on-write, so the
+// buffers can be modified without touching the file. Returns false, with `m` left empty, if the file can't be
+// read or was cooked with another version.
+bool load_cooked(Model &m, const char *file_name);
+
+// Unmaps the file of a model loaded with load_cooked. Called by free_mesh_buffers, which frees models whether
+// they were mapped or allocated.
+void unmap_cooked_model(Model &m);
+
 inline u32 num_meshes(const Model &m) { return fo::size(m._mesh_array); }
 
 // Return ith mesh's data in the model
@@ -253,7 +392,12 @@ static_assert(offsetof(ForTangentSpaceCalc, t_and_h) ==
                   offsetof(ForTangentSpaceCalc, st) + sizeof(fo::Vector2),
               "");
 
-void calculate_tangents(ForTangentSpaceCalc *vertices, u32 num_vertices, IndexType *indices, u32 num_indices);
+// Takes the indices at either index size
+void calculate_tangents(ForTangentSpaceCalc *vertices, u32 num_vertices, const IndexType *indices, u32 num_indices);
+void calculate_tangents(ForTangentSpaceCalc *vertices,
+                        u32 num_vertices,
+                        const WideIndexType *indices,
+                        u32 num_indices);
 
 } // namespace mesh
 
@@ -0,0 +1,54 @@
+// Reordering the triangles and vertices of a mesh for the GPU. The triangles are ordered for the post-transform
+// vertex cache with Tipsify (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced
+// Overdraw"), then the clusters Tipsify produces are sorted so the triangles facing out from the mesh's center
+// come first, which cuts overdraw from most directions. Finally the vertices are renumbered in the order the
+// triangles first use them, for locality of the vertex fetches.
+#pragma once
+
+#include <learnogl/mesh.h>
+
+namespace eng {
+
+namespace mesh {
+
+// How well an index buffer uses a FIFO post-transform cache of the given size. ACMR is the number of vertices
+// transformed per triangle, 0.5 at best on large regular meshes and 3 at worst. ATVR is per vertex of the mesh,
+// 1 at best.
+struct VertexCacheStats {
+    float acmr;
+    float atvr;
+};
+
+VertexCacheStats simulate_vertex_cache(const u32 *indices, u32 num_indices, u32 num_vertices, u32 cache_size);
+
+// Reorders the triangles of the index buffer for a cache of `cache_size` vertices. If `cluster_starts` is given,
+// the indices where Tipsify had to jump to a vertex outside the cache are written to it, starting with 0. Each
+// triangle's vertices stay in the same order, so the winding doesn't change.
+void optimize_vertex_cache(
+    u32 *indices, u32 num_indices, u32 num_vertices, u32 cache_size, fo::Array<u32> *cluster_starts = nullptr);
+
+// Sorts the clusters of triangles, as given by optimize_vertex_cache, so that the ones facing out from the center
+// of the mesh are drawn first. The order within each cluster is kept.
+void optimize_overdraw(u32 *indices,
+                       u32 num_indices,
+                       const fo::Vector3 *positions,
+                       u32 position_stride,
+                       const u32 *cluster_starts,
+                       u32 num_clusters);
+
+// Renumbers the vertices in the order the index buffer first refers to them and moves them in `vertices` to
+// match. The vertices not referred to are kept at the end.
+void optimize_vertex_fetch(u32 *indices, u32 num_indices, u8 *vertices, u32 num_vertices, u32 vertex_size);
+
+struct MeshOptimizeStats {
+    VertexCacheStats before;
+    VertexCacheStats after;
+};
+
+// Does all of the above on the mesh's buffer. The vertices of skinned meshes aren't moved, as the per-vertex bone
+// data would have to move with them.
+MeshOptimizeStats optimize_mesh(MeshData &md, u32 cache_size = 16);
+
+} // namespace mesh
+
+} // namespace eng
@@ -0,0 +1,124 @@
+// Splitting a mesh into meshlets, small clusters of triangles that are culled on their own, against the frustum,
+// by the cone of their normals when all of them face away from the camera, and against the occluders. The
+// meshlets, their bounds and their vertex and triangle lists are kept in one buffer in std430 layout, next to the
+// mesh's own buffer, so it can be uploaded as is and each part bound as a shader storage buffer range. See
+// occlusion_cull_shader.comp in test/defer_test for the culling on the GPU.
+#pragma once
+
+#include <learnogl/frustum.h>
+#include <learnogl/mesh.h>
+#include <learnogl/occlusion_culling.h>
+
+namespace eng {
+
+namespace mesh {
+
+// The largest meshlets that suit mesh shaders and compute culling with 64 wide groups. 124 triangles rather than
+// 128 keeps the packed triangle list of a meshlet a multiple of 16 bytes on the GPU.
+constexpr u32 k_meshlet_max_vertices = 64;
+constexpr u32 k_meshlet_max_triangles = 124;
+
+// Each part of the meshlet buffer starts at a multiple of this, the largest SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+// there is
+constexpr u32 k_meshlet_buffer_alignment = 256;
+
+// The cone cutoff of the meshlets whose triangles face in too many directions to be culled by the cone
+constexpr float k_meshlet_no_cone_cutoff = 2.0f;
+
+struct Meshlet {
+    u32 vertex_offset;   // Index of the first vertex index in the vertex indices
+    u32 triangle_offset; // Index of the first packed triangle in the triangles
+    u32 num_vertices;
+    u32 num_triangles;
+};
+
+// In the model's space. The meshlet faces away from a camera at p, and can be culled, when
+// dot(center - p, axis) >= cutoff * length(center - p) + radius. Triangles whose area is a millionth of the
+// square of the radius or less are left out of the cone.
+struct MeshletBounds {
+    fo::Vector4 sphere; // Center and radius
+    fo::Vector4 cone;   // Unit axis and the cutoff, the sine of the cone's half angle
+};
+
+static_assert(sizeof(Meshlet) == 16 && sizeof(MeshletBounds) == 32, "Not the std430 layout");
+
+// The buffer is laid out like so, each part starting at a multiple of k_meshlet_buffer_alignment:
+//
+// | meshlet_0 | meshlet_1 |...| meshlet_{K-1} |
+// | bounds_0 | bounds_1 |...| bounds_{K-1} |
+// | vertex_index_0 | vertex_index_1 |...| vertex_index_{V-1} |
+// | triangle_0 | triangle_1 |...| triangle_{T-1} |
+//
+// Vertex indices are u32 indices of the mesh's vertices. Each triangle is a u32 with the indices of its corners
+// into the meshlet's vertex indices in bits 0-7, 8-15 and 16-23.
+struct MeshletsOffsetsAndSizes {
+    u32 num_meshlets;
+    u32 num_vertex_indices;
+    u32 num_triangles;
+
+    u32 get_meshlets_byte_offset() const { return 0; }
+    u32 get_bounds_byte_offset() const { return aligned(num_meshlets * sizeof(Meshlet)); }
+    u32 get_vertex_indices_byte_offset() const {
+        return get_bounds_byte_offset() + aligned(num_meshlets * sizeof(MeshletBounds));
+    }
+    u32 get_triangles_byte_offset() const {
+        return get_vertex_indices_byte_offset() + aligned(num_vertex_indices * sizeof(u32));
+    }
+    u32 get_size_in_bytes() const { return get_triangles_byte_offset() + num_triangles * sizeof(u32); }
+
+    static u32 aligned(u32 size) {
+        return (size + k_meshlet_buffer_alignment - 1) / k_meshlet_buffer_alignment * k_meshlet_buffer_alignment;
+    }
+};
+
+struct MeshletData {
+    MeshletsOffsetsAndSizes o;
+    u8 *buffer;
+};
+
+inline Meshlet *meshlets_begin(const MeshletData &m) {
+    return reinterpret_cast<Meshlet *>(m.buffer + m.o.get_meshlets_byte_offset());
+}
+
+inline MeshletBounds *meshlet_bounds_begin(const MeshletData &m) {
+    return reinterpret_cast<MeshletBounds *>(m.buffer + m.o.get_bounds_byte_offset());
+}
+
+inline u32 *meshlet_vertex_indices_begin(const MeshletData &m) {
+    return reinterpret_cast<u32 *>(m.buffer + m.o.get_vertex_indices_byte_offset());
+}
+
+inline u32 *meshlet_triangles_begin(const MeshletData &m) {
+    return reinterpret_cast<u32 *>(m.buffer + m.o.get_triangles_byte_offset());
+}
+
+inline u32 meshlet_triangle_corner(u32 packed_triangle, u32 corner) {
+    return (packed_triangle >> (corner * 8)) & 0xff;
+}
+
+// Splits the mesh's triangles, in order, into meshlets of at most `max_vertices` vertices and `max_triangles`
+// triangles, and computes their bounds. The meshlets are more compact, and share fewer vertices, if the mesh went
+// through optimize_mesh first. The buffer is allocated from `allocator` and aligned to k_meshlet_buffer_alignment.
+// Positions must be 3D.
+void build_meshlets(const MeshData &md,
+                    fo::Allocator &allocator,
+                    MeshletData &meshlets_out,
+                    u32 max_vertices = k_meshlet_max_vertices,
+                    u32 max_triangles = k_meshlet_max_triangles);
+
+void free_meshlets(MeshletData &m, fo::Allocator &allocator);
+
+// Sets bit i % 8 of visible_bits[i / 8] if meshlet i of a mesh placed with `world_from_model` can be seen by a
+// camera at `camera_position`, and clears it if the meshlet is outside the world-space frustum, faces away from the
+// camera, or is hidden behind the rasterized occluders when `occlusion` is given. visible_bits needs
+// cull_bytes_for(num_meshlets) bytes. `world_from_model` can scale, but only uniformly, so the cones stay valid.
+void cull_meshlets(const MeshletData &m,
+                   const fo::Matrix4x4 &world_from_model,
+                   const FrustumPlanes &frustum,
+                   const fo::Vector3 &camera_position,
+                   const OcclusionBuffer *occlusion,
+                   u8 *visible_bits);
+
+} // namespace mesh
+
+} // namespace eng
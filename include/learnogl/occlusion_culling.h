@@ -0,0 +1,99 @@
+// Occlusion culling on the CPU. A few big occluder meshes are rasterized into a small depth buffer, and the
+// bounding boxes of the objects are tested against it, so the objects hidden behind the occluders are known before
+// anything is submitted to the GPU, without reading anything back. The rasterizer works 8 pixels at a time, and
+// the buffer keeps the farthest depth of each 8x4 tile so most boxes are tested a tile at a time.
+#pragma once
+
+#include <scaffold/array.h>
+#include <scaffold/math_types.h>
+#include <scaffold/types.h>
+
+namespace eng {
+
+namespace mesh {
+struct MeshData;
+}
+
+constexpr uint32_t k_occlusion_tile_width = 8;
+constexpr uint32_t k_occlusion_tile_height = 4;
+
+// Depth of the pixels no occluder covers
+constexpr float k_occlusion_empty_depth = 3.0e38f;
+
+// A screen space occluder triangle, as set up by add_occluder. A pixel's center (px, py) is inside the triangle
+// when edge_a[i] * px + edge_b[i] * py + edge_c[i] >= 0 for all three edges, and the triangle's NDC depth there
+// is depth_dx * px + depth_dy * py + depth_c. The pixel bounds are inclusive and already clamped to the screen.
+struct OccluderTriangle {
+    float edge_a[3];
+    float edge_b[3];
+    float edge_c[3];
+    float depth_dx;
+    float depth_dy;
+    float depth_c;
+    int32_t min_x;
+    int32_t min_y;
+    int32_t max_x;
+    int32_t max_y;
+};
+
+static_assert(sizeof(OccluderTriangle) == 64, "");
+
+// The depth is the NDC z, z / w, which varies linearly across the screen for perspective and orthographic
+// projections alike. Lower is nearer, and each pixel keeps the nearest occluder. Pixel (x, y) is at
+// depth[y * width + x] with row 0 at the bottom, like the viewport, and covers [x, x + 1) x [y, y + 1) on screen.
+struct OcclusionBuffer {
+    // Multiples of the tile size. A few hundred pixels across is plenty, as occluders are meant to be big.
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    fo::Matrix4x4 clip_from_world;
+
+    fo::Array<float> depth;
+
+    // Farthest depth of each tile, row-major like the pixels
+    fo::Array<float> tile_depth;
+
+    // Occluder triangles added this frame, waiting to be rasterized
+    fo::Array<OccluderTriangle> triangles;
+
+    OcclusionBuffer(fo::Allocator &allocator = fo::memory_globals::default_allocator())
+        : depth(allocator)
+        , tile_depth(allocator)
+        , triangles(allocator) {}
+};
+
+void init_occlusion_buffer(OcclusionBuffer &buffer, uint32_t width, uint32_t height);
+
+// Starts adding this frame's occluders, seen through `clip_from_world`, which is projection * view with the OpenGL
+// clip volume. The last frame's depth stays until rasterize_occluders.
+void begin_occlusion_frame(OcclusionBuffer &buffer, const fo::Matrix4x4 &clip_from_world);
+
+// Transforms the occluder's triangles to the screen, clipped against the near plane and a guard band around the
+// screen, and adds them to the buffer. Both sides of the triangles occlude. `positions` are `stride` bytes apart.
+void add_occluder(OcclusionBuffer &buffer,
+                  const fo::Vector3 *positions,
+                  uint32_t stride,
+                  const uint32_t *indices,
+                  uint32_t num_triangles,
+                  const fo::Matrix4x4 &world_from_model);
+
+void add_occluder(OcclusionBuffer &buffer, const mesh::MeshData &mesh_data, const fo::Matrix4x4 &world_from_model);
+
+// Clears the depth, rasterizes the added occluders and computes the tile depths. Multithreaded, the screen is split
+// into bands of tile rows, each rasterized on its own, which gives the same buffer as a single thread.
+void rasterize_occluders(OcclusionBuffer &buffer, bool multithreaded = false);
+
+// Returns false if the box is certainly hidden behind the rasterized occluders. Boxes crossing the near plane are
+// always visible, as are boxes entirely off the screen, which are for frustum culling to cull. The test is
+// conservative, the nearest depth of the box against the rectangle of pixels it covers on screen.
+bool test_occludee(const OcclusionBuffer &buffer, const fo::AABB &world_box);
+
+// Tests each box whose bit is set in `visible_bits` and clears the bit if the box is occluded, so it goes after
+// frustum_cull on the same bits. Boxes whose bit is already clear aren't tested.
+void occlusion_cull(const OcclusionBuffer &buffer,
+                    const fo::AABB *boxes,
+                    uint32_t num_boxes,
+                    uint8_t *visible_bits,
+                    bool multithreaded = false);
+
+} // namespace eng
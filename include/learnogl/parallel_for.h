@@ -0,0 +1,38 @@
+// A minimal fork-join helper for data-parallel loops. A fixed set of worker threads is started on first use.
+// The calling thread works on the range too, and the call returns only after every chunk is done.
+#pragma once
+
+#include <scaffold/types.h>
+
+#include <type_traits>
+#include <utility>
+
+namespace eng {
+
+// Number of threads that take part in a parallel_for, counting the caller. At least 1.
+u32 parallel_for_thread_count();
+
+// The type-erased form parallel_for forwards to. `fn(context, begin, end)` is called for each chunk.
+using ParallelRangeFn = void (*)(void *context, u32 begin, u32 end);
+
+void parallel_for_erased(u32 count, u32 chunk_size, ParallelRangeFn fn, void *context);
+
+// Splits [0, count) into chunks of `chunk_size` elements (the last one may be shorter) and calls `fn(begin, end)`
+// on each, spread over the worker threads. Which thread gets which chunk is unspecified, but the chunk boundaries
+// only depend on `count` and `chunk_size`, so per-chunk results can be combined deterministically.
+//
+// Runs everything on the calling thread when there's a single chunk, when called from inside another parallel_for
+// or when another thread's parallel_for already has the workers.
+template <typename Fn> void parallel_for(u32 count, u32 chunk_size, Fn &&fn) {
+    using FnType = std::remove_reference_t<Fn>;
+    parallel_for_erased(
+        count,
+        chunk_size,
+        [](void *context, u32 begin, u32 end) { (*static_cast<FnType *>(context))(begin, end); },
+        const_cast<void *>(static_cast<const void *>(&fn)));
+}
+
+// Number of chunks parallel_for will call `fn` with
+inline u32 parallel_for_chunk_count(u32 count, u32 chunk_size) { return (count + chunk_size - 1) / chunk_size; }
+
+} // namespace eng
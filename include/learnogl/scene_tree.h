@@ -1,40 +1,197 @@
+// A hierarchy of transforms. The nodes are kept in flat arrays, one per attribute, in which a node's parent always
+// comes before it, so the world matrices can be updated in a single pass from the front, or one root's subtree
+// per task on several threads. The results of each update can be published as a snapshot for a render thread.
 #pragma once
 
 #include <learnogl/math_ops.h>
-#include <scaffold/non_pods.h>
-#include <scaffold/pool_allocator.h>
+#include <learnogl/type_utils.h>
+#include <scaffold/array.h>
+
+#include <condition_variable>
+#include <mutex>
 
 namespace eng {
 
-class SceneTree {
+// Refers to a node for as long as it's alive, across compactions. The handle's slot is reused after the node is
+// removed, with the next generation, so a stale handle is detected rather than referring to the new node. The
+// zero handle refers to no node.
+struct SceneNodeHandle {
+    using Slot_Mask = Mask32<0, 24>;
+    using Generation_Mask = Mask32<24, 8>;
+
+    u32 bits = 0;
+
+    u32 slot() const { return Slot_Mask::extract(bits); }
+    u32 generation() const { return Generation_Mask::extract(bits); }
+    bool is_null() const { return bits == 0; }
+
+    friend bool operator==(SceneNodeHandle a, SceneNodeHandle b) { return a.bits == b.bits; }
+    friend bool operator!=(SceneNodeHandle a, SceneNodeHandle b) { return a.bits != b.bits; }
+};
+
+class SceneTree;
+
+// A copy of the world matrices and visibility of a scene tree's nodes as of one update, indexed like the tree's
+// arrays were then. Doesn't change while the render thread has it.
+struct SceneSnapshot {
+    // Counts the snapshots published, from 1
+    u64 frame = 0;
+
+    fo::Array<fo::Matrix4x4> world_matrices;
+    // The null handle for the removed nodes
+    fo::Array<SceneNodeHandle> handles;
+    // Bit i % 8 of visible_bits[i / 8] for node i, as with frustum_cull. Clear for the removed nodes.
+    fo::Array<u8> visible_bits;
+
+    // What the snapshot was copied from, to tell whether copying the matrices changed since will bring it up to
+    // date the next time it's written
+    const SceneTree *source = nullptr;
+    u64 source_layout_version = 0;
+    u64 source_update_count = 0;
+
+    SceneSnapshot(fo::Allocator &allocator = fo::memory_globals::default_allocator())
+        : world_matrices(allocator)
+        , handles(allocator)
+        , visible_bits(allocator) {}
+
+    u32 array_size() const { return fo::size(world_matrices); }
+    bool is_visible(u32 node) const { return (visible_bits[node / 8] & (1u << (node % 8))) != 0; }
+};
+
+// Double-buffered snapshots, to let a render thread draw one frame while the simulation updates the next. The
+// simulation writes the snapshot the render thread isn't reading and publishes it, and the render thread takes the
+// last one published. So the simulation runs at most one frame ahead, waiting in begin_write() for the render
+// thread to release the older snapshot.
+class SceneSnapshots {
+    SceneSnapshot _snapshots[2];
+    std::mutex _mutex;
+    std::condition_variable _released;
+
+    // Indices into _snapshots, or -1
+    int _published = -1;
+    int _writing = -1;
+    int _reading = -1;
+    u64 _num_published = 0;
+
   public:
-    struct Node {
-        math::LocalTransform transform = math::LocalTransform::identity();
-        fo::Array<Node *> children;
-        Node *parent = nullptr;
-        u32 scene_tree_id;
+    SceneSnapshots(fo::Allocator &allocator = fo::memory_globals::default_allocator());
 
-        Node() = delete;
+    // Simulation thread. Returns the snapshot to write, which isn't the last one published.
+    SceneSnapshot &begin_write();
+    void end_write();
+
+    // Render thread. Returns the last snapshot published, or nullptr before the first one. It stays unchanged
+    // until release().
+    const SceneSnapshot *acquire_latest();
+    void release();
+};
 
-        Node(u32 id)
-            : scene_tree_id(id) {}
+class SceneTree {
+  public:
+    // Internally, and to the systems going over the arrays, nodes are referred to by their index in the arrays. The
+    // index doesn't change while the node is alive, until the next compact().
+    static constexpr u32 k_no_parent = ~u32(0);
+
+    enum NodeFlags : u8 {
+        // The local transform changed since the last update
+        DIRTY = 1,
+        // The world matrix changed in the last update, because the local transform or one of the ancestors' did
+        WORLD_CHANGED = 2,
+        REMOVED = 4,
+        // The world matrix changed in the update before the last one
+        WORLD_CHANGED_BEFORE = 8,
     };
 
   private:
-    fo::Vector<fo::Matrix4x4> _matrices_by_id;
-    fo::Vector<Node *> _roots;
-    fo::Vector<Node *> _nodes_by_id;
+    fo::Array<u32> _parents;
+    fo::Array<math::LocalTransform> _local_transforms;
+    fo::Array<fo::Matrix4x4> _world_matrices;
+    fo::Array<u8> _flags;
+    // The root each node is under, itself for roots
+    fo::Array<u32> _roots;
+    // The handle slot referring to each node
+    fo::Array<u32> _handle_slots;
+
+    // Per handle slot, the index of the node it refers to, or the next free slot while it's free
+    fo::Array<u32> _slot_nodes;
+    fo::Array<u8> _slot_generations;
+    u32 _first_free_slot = k_no_parent;
+
+    u32 _num_removed = 0;
 
-    fo::PoolAllocator _pool_allocator;
+    // Bumped when nodes are added, removed or moved in the arrays, and on every update, for the snapshots
+    u64 _layout_version = 0;
+    u64 _update_count = 0;
 
-    u32 _next_id_counter = 0;
+    // Scratch space for the update, kept between frames
+    fo::Array<u32> _update_indices;
+    fo::Array<math::LocalTransform> _update_locals;
+    fo::Array<fo::Matrix4x4> _update_matrices;
+    // Where each task of the multithreaded update starts in _update_indices
+    fo::Array<u32> _task_starts;
 
   public:
-    SceneTree(u32 node_pool_size);
+    SceneTree(u32 initial_capacity = 0, fo::Allocator &allocator = fo::memory_globals::default_allocator());
+
+    // Adds a node under `parent`, or a root with the null handle. The new node goes at the end of the arrays and
+    // its world matrix is computed by the next update.
+    SceneNodeHandle add_node(SceneNodeHandle parent = {},
+                             const math::LocalTransform &local_transform = math::LocalTransform::identity());
+
+    // Removes the node along with all of its descendants, whose handles become invalid. Their elements in the
+    // arrays are left as holes until the next compact().
+    void remove_node(SceneNodeHandle node);
+
+    void set_local_transform(SceneNodeHandle node, const math::LocalTransform &local_transform);
+
+    // Moves the nodes alive to the front of the arrays, keeping their order, closing the holes left by the
+    // removed ones. Changes the nodes' indices but not their handles. To call after streaming out parts of the
+    // scene, as the holes are skipped over by every update.
+    void compact();
+
+    bool is_valid(SceneNodeHandle node) const {
+        const u32 slot = node.slot();
+        return !node.is_null() && slot < fo::size(_slot_generations) && _slot_generations[slot] == node.generation();
+    }
+
+    // The node's index in the arrays, which stays the same until the next compact()
+    u32 node_index(SceneNodeHandle node) const;
+    SceneNodeHandle handle(u32 node) const;
+
+    const math::LocalTransform &local_transform(SceneNodeHandle node) const {
+        return _local_transforms[node_index(node)];
+    }
+    const fo::Matrix4x4 &world_matrix(SceneNodeHandle node) const { return _world_matrices[node_index(node)]; }
+
+    // Computes the world matrix of each node whose local transform or whose ancestors' local transforms changed
+    // since the last update, skipping the rest. With `multithreaded` the subtrees of different roots are updated
+    // on the worker threads, so a scene made of many separate hierarchies gains the most. The matrices come out the
+    // same either way.
+    void update_world_matrices(bool multithreaded = false);
+
+    // Writes the world matrices from the last update to a snapshot and publishes it, at the end of the frame's
+    // update. `visible_bits` is the result of culling the nodes, as with frustum_cull, or nullptr to have every
+    // node visible. When the snapshot written was published after one of the two last updates and the nodes haven't
+    // been added, removed or moved since, only the matrices changed by those updates are copied.
+    void publish_snapshot(SceneSnapshots &snapshots, const u8 *visible_bits = nullptr) const;
+
+    // By node index
+
+    u32 parent(u32 node) const { return _parents[node]; }
+    u32 root(u32 node) const { return _roots[node]; }
+    const math::LocalTransform &local_transform(u32 node) const { return _local_transforms[node]; }
+    const fo::Matrix4x4 &world_matrix(u32 node) const { return _world_matrices[node]; }
+
+    bool is_alive(u32 node) const { return node < fo::size(_flags) && (_flags[node] & REMOVED) == 0; }
+    bool world_changed(u32 node) const { return (_flags[node] & WORLD_CHANGED) != 0; }
 
-    Node *allocate_node();
+    // Number of elements in the arrays, counting the removed nodes', and of the nodes alive
+    u32 array_size() const { return fo::size(_parents); }
+    u32 num_nodes() const { return fo::size(_parents) - _num_removed; }
 
-    void remove_node(Node *node);
+    // The arrays themselves, indexed by node
+    const u32 *parents() const { return fo::data(_parents); }
+    const fo::Matrix4x4 *world_matrices() const { return fo::data(_world_matrices); }
 };
 
 } // namespace eng
@@ -0,0 +1,184 @@
+// A uniform grid over points for finding the ones within some radius of each other, like particles interacting in
+// SPH or spheres colliding. The cells are hashed into a fixed number of buckets, so the grid covers all of space,
+// and the points are counting sorted by bucket, so the points of a bucket are next to each other in memory.
+#pragma once
+
+#include <learnogl/intersection_test.h>
+#include <learnogl/parallel_for.h>
+#include <scaffold/array.h>
+#include <scaffold/debug.h>
+#include <scaffold/math_types.h>
+
+#include <cmath>
+
+namespace eng {
+
+struct SpatialHashGrid {
+    float cell_size = 1.0f;
+    float inv_cell_size = 1.0f;
+
+    // Always a power of 2
+    uint32_t num_buckets = 0;
+
+    // The points of bucket b are sorted_*[bucket_starts[b], bucket_starts[b + 1])
+    fo::Array<uint32_t> bucket_starts;
+
+    // Indices of the points, as given to build, and copies of their positions, sorted by bucket
+    fo::Array<uint32_t> sorted_indices;
+    fo::Array<fo::Vector3> sorted_positions;
+
+    // Sorted bucket of each point, and space for the sort, kept between builds
+    fo::Array<uint32_t> sorted_buckets;
+    fo::Array<uint32_t> scratch;
+
+    SpatialHashGrid(fo::Allocator &allocator = fo::memory_globals::default_allocator())
+        : bucket_starts(allocator)
+        , sorted_indices(allocator)
+        , sorted_positions(allocator)
+        , sorted_buckets(allocator)
+        , scratch(allocator) {}
+};
+
+// Most buckets a grid gets. Grids over more points than this have more than one point per bucket on average.
+constexpr uint32_t k_spatial_hash_grid_max_buckets = 1u << 22;
+
+// Builds the grid over the points, `stride` bytes apart. Queries look at the cells within `radius` of a point,
+// which is 8 cells when `cell_size` is at least twice the radius and 27 when it's just the radius. The radius
+// can't be larger than the cell size. The grid is the same whether built multithreaded or not.
+void build_spatial_hash_grid(SpatialHashGrid &grid,
+                             const fo::Vector3 *positions,
+                             uint32_t stride,
+                             uint32_t num_points,
+                             float cell_size,
+                             bool multithreaded = false);
+
+// Bucket of the cell with the given integer coordinates, and of the cell the point is in
+inline uint32_t spatial_hash_bucket(const SpatialHashGrid &grid, int32_t x, int32_t y, int32_t z) {
+    const uint32_t h = (uint32_t(x) * 73856093u) ^ (uint32_t(y) * 19349663u) ^ (uint32_t(z) * 83492791u);
+    return h & (grid.num_buckets - 1);
+}
+
+inline uint32_t spatial_hash_bucket(const SpatialHashGrid &grid, const fo::Vector3 &p) {
+    return spatial_hash_bucket(grid,
+                               int32_t(std::floor(p.x * grid.inv_cell_size)),
+                               int32_t(std::floor(p.y * grid.inv_cell_size)),
+                               int32_t(std::floor(p.z * grid.inv_cell_size)));
+}
+
+inline float spatial_hash_distance_squared(const fo::Vector3 &a, const fo::Vector3 &b) {
+    const float dx = a.x - b.x;
+    const float dy = a.y - b.y;
+    const float dz = a.z - b.z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// Calls `fn(sorted_index)` for each point in the cells within `radius` of `p`, each point once. That includes the
+// points of other cells that share a bucket with one of them. `sorted_index` is where the point is in the grid's
+// sorted arrays.
+template <typename Fn>
+void for_each_point_near(const SpatialHashGrid &grid, const fo::Vector3 &p, float radius, Fn &&fn) {
+    CHECK_F(radius <= grid.cell_size, "Radius %f larger than the cell size %f", radius, grid.cell_size);
+    if (grid.num_buckets == 0) {
+        return;
+    }
+
+    int32_t lo[3];
+    int32_t hi[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        lo[axis] = int32_t(std::floor(((&p.x)[axis] - radius) * grid.inv_cell_size));
+        hi[axis] = int32_t(std::floor(((&p.x)[axis] + radius) * grid.inv_cell_size));
+    }
+
+    // Two cells in range can hash to the same bucket. With radius == cell_size the two floors can round 4 cells
+    // apart on an axis, so there are up to 4 * 4 * 4 of them.
+    uint32_t visited[64];
+    uint32_t num_visited = 0;
+
+    for (int32_t z = lo[2]; z <= hi[2]; ++z) {
+        for (int32_t y = lo[1]; y <= hi[1]; ++y) {
+            for (int32_t x = lo[0]; x <= hi[0]; ++x) {
+                const uint32_t bucket = spatial_hash_bucket(grid, x, y, z);
+                bool seen = false;
+                for (uint32_t i = 0; i < num_visited; ++i) {
+                    seen |= visited[i] == bucket;
+                }
+                if (seen) {
+                    continue;
+                }
+                visited[num_visited++] = bucket;
+
+                const uint32_t end = grid.bucket_starts[bucket + 1];
+                for (uint32_t i = grid.bucket_starts[bucket]; i < end; ++i) {
+                    fn(i);
+                }
+            }
+        }
+    }
+}
+
+// Calls `fn(index, distance_squared)` for each point within `radius` of `p`, with the point's index as given to
+// build, in no particular order.
+template <typename Fn>
+void for_each_neighbour(const SpatialHashGrid &grid, const fo::Vector3 &p, float radius, Fn &&fn) {
+    const float radius_squared = radius * radius;
+    for_each_point_near(grid, p, radius, [&](uint32_t i) {
+        const float distance_squared = spatial_hash_distance_squared(grid.sorted_positions[i], p);
+        if (distance_squared <= radius_squared) {
+            fn(grid.sorted_indices[i], distance_squared);
+        }
+    });
+}
+
+// Calls `fn(index, neighbour, distance_squared)` for each point of the grid and each other point within `radius`
+// of it, so each pair twice, once each way round. With `multithreaded`, `fn` gets called from several threads at
+// once, but all the calls for one point are made from the same thread one after another, so summing up something
+// per point like an SPH density needs no synchronization.
+template <typename Fn>
+void for_each_neighbour_of_each_point(const SpatialHashGrid &grid,
+                                      float radius,
+                                      Fn &&fn,
+                                      bool multithreaded = false) {
+    const float radius_squared = radius * radius;
+
+    const auto do_range = [&](uint32_t begin, uint32_t end) {
+        for (uint32_t s = begin; s < end; ++s) {
+            const fo::Vector3 p = grid.sorted_positions[s];
+            const uint32_t index = grid.sorted_indices[s];
+            for_each_point_near(grid, p, radius, [&](uint32_t i) {
+                const float distance_squared = spatial_hash_distance_squared(grid.sorted_positions[i], p);
+                if (i != s && distance_squared <= radius_squared) {
+                    fn(index, grid.sorted_indices[i], distance_squared);
+                }
+            });
+        }
+    };
+
+    const uint32_t num_points = fo::size(grid.sorted_indices);
+    if (multithreaded) {
+        parallel_for(num_points, 1024, do_range);
+    } else {
+        do_range(0, num_points);
+    }
+}
+
+// Two points, by their indices as given to build, with a < b
+struct PointPair {
+    uint32_t a;
+    uint32_t b;
+};
+
+// Finds each pair of points within `radius` of each other once. The pairs come in the grid's order, which is the
+// same whether found multithreaded or not.
+void find_neighbour_pairs(const SpatialHashGrid &grid,
+                          float radius,
+                          fo::Array<PointPair> &pairs_out,
+                          bool multithreaded = false);
+
+// Finds each pair of overlapping spheres once, with the spheres' centers being the grid's points and radii[i] the
+// radius of sphere i. The cell size must be at least twice the largest radius.
+void find_overlapping_spheres(const SpatialHashGrid &grid,
+                              const float *radii,
+                              fo::Array<PointPair> &pairs_out,
+                              bool multithreaded = false);
+
+} // namespace eng
@@ -1010,7 +1010,15 @@ struct VBO_EBO_RenderableObject : RenderableObject {
 
 // Miscellaneous pure helpers
 
-// Create a VAO format description from the given mesh data.
+// Create a VAO format description from the given mesh data. Quantized meshes get their own formats, so they
+// don't share VAOs with float ones, and their positions need mesh::position_dequantize_matrix in the model's
+// transform.
 VaoFormatDesc vao_format_from_mesh_data(const mesh::StrippedMeshData &m);
 
+// The `type` to give DrawElements for the mesh's indices. The VAO format doesn't depend on it, so meshes with
+// either index size can share a VAO.
+inline GLenum gl_index_type(const mesh::StrippedMeshData &m) {
+    return m.index_size == sizeof(mesh::WideIndexType) ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+}
+
 } // namespace eng
@@ -294,4 +294,474 @@ REALLY_INLINE Vector4 cross3(Vector4 u, Vector4 v) {
     return swizzle<Z_, X_, Y_, W_>(r);
 }
 
+// -- 8-wide structure-of-arrays packs. A Float8 holds one float from each of 8 entities, a Vec3x8 holds 8
+// Vector3s as separate x, y, z Float8s. Uses the 256 bit registers when compiling for AVX, otherwise a pair
+// of xmm registers. Comparisons return a mask with all bits of a lane set or cleared, same as the SSE
+// intrinsics, which `select` and `movemask` take.
+
+#if defined(__AVX__)
+#    define LOGL_SIMD_FLOAT8_AVX 1
+#else
+#    define LOGL_SIMD_FLOAT8_AVX 0
+#endif
+
+// The packs have a different layout depending on the target, and some of our files are compiled for AVX2 while
+// the rest aren't. The inline namespace keeps the two versions from being merged at link time.
+#if LOGL_SIMD_FLOAT8_AVX
+inline namespace float8_avx {
+#else
+inline namespace float8_sse {
+#endif
+
+struct Float8 {
+#if LOGL_SIMD_FLOAT8_AVX
+    __m256 m;
+
+    Float8() = default;
+
+    Float8(__m256 m)
+        : m(m) {}
+#else
+    __m128 lo; // Lanes 0-3
+    __m128 hi; // Lanes 4-7
+
+    Float8() = default;
+
+    Float8(__m128 lo, __m128 hi)
+        : lo(lo)
+        , hi(hi) {}
+#endif
+};
+
+// Applies the given SSE intrinsic on both halves, or the AVX intrinsic on the whole register.
+#if LOGL_SIMD_FLOAT8_AVX
+#    define LOGL_FLOAT8_BINARY(avx_fn, sse_fn, a, b) Float8(avx_fn((a).m, (b).m))
+#else
+#    define LOGL_FLOAT8_BINARY(avx_fn, sse_fn, a, b) Float8(sse_fn((a).lo, (b).lo), sse_fn((a).hi, (b).hi))
+#endif
+
+REALLY_INLINE Float8 splat8(float f) {
+#if LOGL_SIMD_FLOAT8_AVX
+    return Float8(_mm256_set1_ps(f));
+#else
+    return Float8(_mm_set1_ps(f), _mm_set1_ps(f));
+#endif
+}
+
+REALLY_INLINE Float8 zero8() { return splat8(0.0f); }
+
+// Loads 8 consecutive floats. No alignment needed.
+REALLY_INLINE Float8 load8(const float *p) {
+#if LOGL_SIMD_FLOAT8_AVX
+    return Float8(_mm256_loadu_ps(p));
+#else
+    return Float8(_mm_loadu_ps(p), _mm_loadu_ps(p + 4));
+#endif
+}
+
+REALLY_INLINE void store8(float *p, Float8 v) {
+#if LOGL_SIMD_FLOAT8_AVX
+    _mm256_storeu_ps(p, v.m);
+#else
+    _mm_storeu_ps(p, v.lo);
+    _mm_storeu_ps(p + 4, v.hi);
+#endif
+}
+
+// Lane i is given in the i-th argument.
+REALLY_INLINE Float8 from_lanes(float f0, float f1, float f2, float f3, float f4, float f5, float f6, float f7) {
+#if LOGL_SIMD_FLOAT8_AVX
+    return Float8(_mm256_setr_ps(f0, f1, f2, f3, f4, f5, f6, f7));
+#else
+    return Float8(_mm_setr_ps(f0, f1, f2, f3), _mm_setr_ps(f4, f5, f6, f7));
+#endif
+}
+
+REALLY_INLINE Float8 add(Float8 a, Float8 b) { return LOGL_FLOAT8_BINARY(_mm256_add_ps, _mm_add_ps, a, b); }
+REALLY_INLINE Float8 sub(Float8 a, Float8 b) { return LOGL_FLOAT8_BINARY(_mm256_sub_ps, _mm_sub_ps, a, b); }
+REALLY_INLINE Float8 mul(Float8 a, Float8 b) { return LOGL_FLOAT8_BINARY(_mm256_mul_ps, _mm_mul_ps, a, b); }
+REALLY_INLINE Float8 div(Float8 a, Float8 b) { return LOGL_FLOAT8_BINARY(_mm256_div_ps, _mm_div_ps, a, b); }
+REALLY_INLINE Float8 min(Float8 a, Float8 b) { return LOGL_FLOAT8_BINARY(_mm256_min_ps, _mm_min_ps, a, b); }
+REALLY_INLINE Float8 max(Float8 a, Float8 b) { return LOGL_FLOAT8_BINARY(_mm256_max_ps, _mm_max_ps, a, b); }
+
+// Bitwise ops, mostly for combining masks
+REALLY_INLINE Float8 and8(Float8 a, Float8 b) { return LOGL_FLOAT8_BINARY(_mm256_and_ps, _mm_and_ps, a, b); }
+REALLY_INLINE Float8 or8(Float8 a, Float8 b) { return LOGL_FLOAT8_BINARY(_mm256_or_ps, _mm_or_ps, a, b); }
+REALLY_INLINE Float8 xor8(Float8 a, Float8 b) { return LOGL_FLOAT8_BINARY(_mm256_xor_ps, _mm_xor_ps, a, b); }
+
+// ~a & b
+REALLY_INLINE Float8 andnot8(Float8 a, Float8 b) {
+    return LOGL_FLOAT8_BINARY(_mm256_andnot_ps, _mm_andnot_ps, a, b);
+}
+
+// a * b + c. Fused when compiling with FMA.
+REALLY_INLINE Float8 mul_add(Float8 a, Float8 b, Float8 c) {
+#if LOGL_SIMD_FLOAT8_AVX && defined(__FMA__)
+    return Float8(_mm256_fmadd_ps(a.m, b.m, c.m));
+#else
+    return add(mul(a, b), c);
+#endif
+}
+
+REALLY_INLINE Float8 sqrt(Float8 a) {
+#if LOGL_SIMD_FLOAT8_AVX
+    return Float8(_mm256_sqrt_ps(a.m));
+#else
+    return Float8(_mm_sqrt_ps(a.lo), _mm_sqrt_ps(a.hi));
+#endif
+}
+
+REALLY_INLINE Float8 negate(Float8 a) { return xor8(a, splat8(-0.0f)); }
+
+REALLY_INLINE Float8 abs(Float8 a) { return andnot8(splat8(-0.0f), a); }
+
+// -- Comparisons, returning lane masks
+
+#if LOGL_SIMD_FLOAT8_AVX
+#    define LOGL_FLOAT8_CMP(avx_pred, sse_fn, a, b) Float8(_mm256_cmp_ps((a).m, (b).m, avx_pred))
+#else
+#    define LOGL_FLOAT8_CMP(avx_pred, sse_fn, a, b) Float8(sse_fn((a).lo, (b).lo), sse_fn((a).hi, (b).hi))
+#endif
+
+REALLY_INLINE Float8 cmp_lt(Float8 a, Float8 b) { return LOGL_FLOAT8_CMP(_CMP_LT_OQ, _mm_cmplt_ps, a, b); }
+REALLY_INLINE Float8 cmp_le(Float8 a, Float8 b) { return LOGL_FLOAT8_CMP(_CMP_LE_OQ, _mm_cmple_ps, a, b); }
+REALLY_INLINE Float8 cmp_gt(Float8 a, Float8 b) { return LOGL_FLOAT8_CMP(_CMP_GT_OQ, _mm_cmpgt_ps, a, b); }
+REALLY_INLINE Float8 cmp_ge(Float8 a, Float8 b) { return LOGL_FLOAT8_CMP(_CMP_GE_OQ, _mm_cmpge_ps, a, b); }
+REALLY_INLINE Float8 cmp_eq(Float8 a, Float8 b) { return LOGL_FLOAT8_CMP(_CMP_EQ_OQ, _mm_cmpeq_ps, a, b); }
+
+#undef LOGL_FLOAT8_CMP
+#undef LOGL_FLOAT8_BINARY
+
+// Per lane `mask ? a : b`. The mask must come from a comparison (or be all ones/zeros per lane).
+REALLY_INLINE Float8 select(Float8 mask, Float8 a, Float8 b) {
+#if LOGL_SIMD_FLOAT8_AVX
+    return Float8(_mm256_blendv_ps(b.m, a.m, mask.m));
+#else
+    return or8(and8(mask, a), andnot8(mask, b));
+#endif
+}
+
+// Bit i of the result is the sign bit of lane i.
+REALLY_INLINE int movemask(Float8 mask) {
+#if LOGL_SIMD_FLOAT8_AVX
+    return _mm256_movemask_ps(mask.m);
+#else
+    return _mm_movemask_ps(mask.lo) | (_mm_movemask_ps(mask.hi) << 4);
+#endif
+}
+
+REALLY_INLINE bool any(Float8 mask) { return movemask(mask) != 0; }
+REALLY_INLINE bool all(Float8 mask) { return movemask(mask) == 0xff; }
+
+// Returns lane i of the pack. Slow, for debugging and tails.
+REALLY_INLINE float lane(Float8 v, int i) {
+    alignas(32) float f[8];
+    store8(f, v);
+    return f[i];
+}
+
+REALLY_INLINE Float8 operator+(Float8 a, Float8 b) { return add(a, b); }
+REALLY_INLINE Float8 operator-(Float8 a, Float8 b) { return sub(a, b); }
+REALLY_INLINE Float8 operator*(Float8 a, Float8 b) { return mul(a, b); }
+REALLY_INLINE Float8 operator/(Float8 a, Float8 b) { return div(a, b); }
+REALLY_INLINE Float8 operator-(Float8 a) { return negate(a); }
+REALLY_INLINE Float8 operator&(Float8 a, Float8 b) { return and8(a, b); }
+REALLY_INLINE Float8 operator|(Float8 a, Float8 b) { return or8(a, b); }
+
+REALLY_INLINE Float8 operator*(Float8 a, float k) { return mul(a, splat8(k)); }
+REALLY_INLINE Float8 operator*(float k, Float8 a) { return mul(a, splat8(k)); }
+
+// 8 Vector3s
+struct Vec3x8 {
+    Float8 x, y, z;
+};
+
+// 8 Vector4s
+struct Vec4x8 {
+    Float8 x, y, z, w;
+};
+
+REALLY_INLINE Vec3x8 splat3x8(const fo::Vector3 &v) { return Vec3x8{ splat8(v.x), splat8(v.y), splat8(v.z) }; }
+
+REALLY_INLINE Vec4x8 splat4x8(const fo::Vector4 &v) {
+    return Vec4x8{ splat8(v.x), splat8(v.y), splat8(v.z), splat8(v.w) };
+}
+
+// -- AoS <-> SoA. The `count` versions read and write only the first `count` (<= 8) elements and set the
+// unused lanes to zero, for the tail end of an array.
+
+// Loads 8 tightly packed Vector3s.
+REALLY_INLINE Vec3x8 load_vec3x8(const fo::Vector3 *p) {
+    const float *f = reinterpret_cast<const float *>(p);
+#if LOGL_SIMD_FLOAT8_AVX
+    __m256 m03 = _mm256_castps128_ps256(_mm_loadu_ps(f + 0));
+    __m256 m14 = _mm256_castps128_ps256(_mm_loadu_ps(f + 4));
+    __m256 m25 = _mm256_castps128_ps256(_mm_loadu_ps(f + 8));
+    m03 = _mm256_insertf128_ps(m03, _mm_loadu_ps(f + 12), 1);
+    m14 = _mm256_insertf128_ps(m14, _mm_loadu_ps(f + 16), 1);
+    m25 = _mm256_insertf128_ps(m25, _mm_loadu_ps(f + 20), 1);
+
+    const __m256 xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+    const __m256 yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+    return Vec3x8{ Float8(_mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0))),
+                   Float8(_mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0))),
+                   Float8(_mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1))) };
+#else
+    return Vec3x8{ from_lanes(f[0], f[3], f[6], f[9], f[12], f[15], f[18], f[21]),
+                   from_lanes(f[1], f[4], f[7], f[10], f[13], f[16], f[19], f[22]),
+                   from_lanes(f[2], f[5], f[8], f[11], f[14], f[17], f[20], f[23]) };
+#endif
+}
+
+// Stores 8 Vector3s tightly packed.
+REALLY_INLINE void store_vec3x8(fo::Vector3 *p, const Vec3x8 &v) {
+    float *f = reinterpret_cast<float *>(p);
+#if LOGL_SIMD_FLOAT8_AVX
+    const __m256 rxy = _mm256_shuffle_ps(v.x.m, v.y.m, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m256 ryz = _mm256_shuffle_ps(v.y.m, v.z.m, _MM_SHUFFLE(3, 1, 3, 1));
+    const __m256 rzx = _mm256_shuffle_ps(v.z.m, v.x.m, _MM_SHUFFLE(3, 1, 2, 0));
+
+    const __m256 r03 = _mm256_shuffle_ps(rxy, rzx, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m256 r14 = _mm256_shuffle_ps(ryz, rxy, _MM_SHUFFLE(3, 1, 2, 0));
+    const __m256 r25 = _mm256_shuffle_ps(rzx, ryz, _MM_SHUFFLE(3, 1, 3, 1));
+
+    _mm_storeu_ps(f + 0, _mm256_castps256_ps128(r03));
+    _mm_storeu_ps(f + 4, _mm256_castps256_ps128(r14));
+    _mm_storeu_ps(f + 8, _mm256_castps256_ps128(r25));
+    _mm_storeu_ps(f + 12, _mm256_extractf128_ps(r03, 1));
+    _mm_storeu_ps(f + 16, _mm256_extractf128_ps(r14, 1));
+    _mm_storeu_ps(f + 20, _mm256_extractf128_ps(r25, 1));
+#else
+    alignas(16) float xs[8], ys[8], zs[8];
+    store8(xs, v.x);
+    store8(ys, v.y);
+    store8(zs, v.z);
+    for (int i = 0; i < 8; ++i) {
+        f[3 * i] = xs[i];
+        f[3 * i + 1] = ys[i];
+        f[3 * i + 2] = zs[i];
+    }
+#endif
+}
+
+// Builds a pack from lanes 0-3 and lanes 4-7, and the other way around.
+REALLY_INLINE Float8 from_halves(__m128 lo, __m128 hi) {
+#if LOGL_SIMD_FLOAT8_AVX
+    return Float8(_mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1));
+#else
+    return Float8(lo, hi);
+#endif
+}
+
+REALLY_INLINE __m128 low_half(Float8 v) {
+#if LOGL_SIMD_FLOAT8_AVX
+    return _mm256_castps256_ps128(v.m);
+#else
+    return v.lo;
+#endif
+}
+
+REALLY_INLINE __m128 high_half(Float8 v) {
+#if LOGL_SIMD_FLOAT8_AVX
+    return _mm256_extractf128_ps(v.m, 1);
+#else
+    return v.hi;
+#endif
+}
+
+// Loads 8 Vector3s that are `stride` bytes apart. Reads only the 12 bytes of each, then transposes 4x4 blocks.
+REALLY_INLINE Vec3x8 load_vec3x8(const fo::Vector3 *p, uint32_t stride) {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(p);
+    auto row = [bytes, stride](uint32_t i) {
+        const float *f = reinterpret_cast<const float *>(bytes + i * stride);
+        return _mm_movelh_ps(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double *>(f))), _mm_load_ss(f + 2));
+    };
+
+    __m128 a0 = row(0), b0 = row(1), c0 = row(2), d0 = row(3);
+    __m128 a1 = row(4), b1 = row(5), c1 = row(6), d1 = row(7);
+    _MM_TRANSPOSE4_PS(a0, b0, c0, d0);
+    _MM_TRANSPOSE4_PS(a1, b1, c1, d1);
+    return Vec3x8{ from_halves(a0, a1), from_halves(b0, b1), from_halves(c0, c1) };
+}
+
+// Stores 8 Vector3s `stride` bytes apart, without touching the bytes in between.
+REALLY_INLINE void store_vec3x8(fo::Vector3 *p, uint32_t stride, const Vec3x8 &v) {
+    __m128 a0 = low_half(v.x), a1 = high_half(v.x);
+    __m128 b0 = low_half(v.y), b1 = high_half(v.y);
+    __m128 c0 = low_half(v.z), c1 = high_half(v.z);
+    __m128 d0 = _mm_setzero_ps(), d1 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(a0, b0, c0, d0);
+    _MM_TRANSPOSE4_PS(a1, b1, c1, d1);
+
+    uint8_t *bytes = reinterpret_cast<uint8_t *>(p);
+    auto row = [bytes, stride](uint32_t i, __m128 r) {
+        float *f = reinterpret_cast<float *>(bytes + i * stride);
+        _mm_storel_pi(reinterpret_cast<__m64 *>(f), r);
+        _mm_store_ss(f + 2, _mm_movehl_ps(r, r));
+    };
+    row(0, a0);
+    row(1, b0);
+    row(2, c0);
+    row(3, d0);
+    row(4, a1);
+    row(5, b1);
+    row(6, c1);
+    row(7, d1);
+}
+
+// Loads `count` Vector3s that are `stride` bytes apart, like the attributes in a mesh vertex pack.
+REALLY_INLINE Vec3x8 load_vec3x8(const fo::Vector3 *p, uint32_t stride, uint32_t count) {
+    alignas(32) float xs[8] = {};
+    alignas(32) float ys[8] = {};
+    alignas(32) float zs[8] = {};
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(p);
+    for (uint32_t i = 0; i < count && i < 8; ++i) {
+        const fo::Vector3 *v = reinterpret_cast<const fo::Vector3 *>(bytes + i * stride);
+        xs[i] = v->x;
+        ys[i] = v->y;
+        zs[i] = v->z;
+    }
+    return Vec3x8{ load8(xs), load8(ys), load8(zs) };
+}
+
+REALLY_INLINE void store_vec3x8(fo::Vector3 *p, uint32_t stride, uint32_t count, const Vec3x8 &v) {
+    alignas(32) float xs[8], ys[8], zs[8];
+    store8(xs, v.x);
+    store8(ys, v.y);
+    store8(zs, v.z);
+    uint8_t *bytes = reinterpret_cast<uint8_t *>(p);
+    for (uint32_t i = 0; i < count && i < 8; ++i) {
+        fo::Vector3 *d = reinterpret_cast<fo::Vector3 *>(bytes + i * stride);
+        d->x = xs[i];
+        d->y = ys[i];
+        d->z = zs[i];
+    }
+}
+
+// Loads 8 Vector4s that are `stride` bytes apart. Transposes 4x4 blocks.
+REALLY_INLINE Vec4x8 load_vec4x8(const fo::Vector4 *p, uint32_t stride) {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(p);
+    auto row = [bytes, stride](uint32_t i) { return _mm_loadu_ps(reinterpret_cast<const float *>(bytes + i * stride)); };
+
+    __m128 a0 = row(0), b0 = row(1), c0 = row(2), d0 = row(3);
+    __m128 a1 = row(4), b1 = row(5), c1 = row(6), d1 = row(7);
+    _MM_TRANSPOSE4_PS(a0, b0, c0, d0);
+    _MM_TRANSPOSE4_PS(a1, b1, c1, d1);
+#if LOGL_SIMD_FLOAT8_AVX
+    return Vec4x8{ Float8(_mm256_insertf128_ps(_mm256_castps128_ps256(a0), a1, 1)),
+                   Float8(_mm256_insertf128_ps(_mm256_castps128_ps256(b0), b1, 1)),
+                   Float8(_mm256_insertf128_ps(_mm256_castps128_ps256(c0), c1, 1)),
+                   Float8(_mm256_insertf128_ps(_mm256_castps128_ps256(d0), d1, 1)) };
+#else
+    return Vec4x8{ Float8(a0, a1), Float8(b0, b1), Float8(c0, c1), Float8(d0, d1) };
+#endif
+}
+
+REALLY_INLINE void store_vec4x8(fo::Vector4 *p, uint32_t stride, const Vec4x8 &v) {
+#if LOGL_SIMD_FLOAT8_AVX
+    __m128 a0 = _mm256_castps256_ps128(v.x.m), a1 = _mm256_extractf128_ps(v.x.m, 1);
+    __m128 b0 = _mm256_castps256_ps128(v.y.m), b1 = _mm256_extractf128_ps(v.y.m, 1);
+    __m128 c0 = _mm256_castps256_ps128(v.z.m), c1 = _mm256_extractf128_ps(v.z.m, 1);
+    __m128 d0 = _mm256_castps256_ps128(v.w.m), d1 = _mm256_extractf128_ps(v.w.m, 1);
+#else
+    __m128 a0 = v.x.lo, a1 = v.x.hi, b0 = v.y.lo, b1 = v.y.hi;
+    __m128 c0 = v.z.lo, c1 = v.z.hi, d0 = v.w.lo, d1 = v.w.hi;
+#endif
+    _MM_TRANSPOSE4_PS(a0, b0, c0, d0);
+    _MM_TRANSPOSE4_PS(a1, b1, c1, d1);
+
+    uint8_t *bytes = reinterpret_cast<uint8_t *>(p);
+    auto row = [bytes, stride](uint32_t i) { return reinterpret_cast<float *>(bytes + i * stride); };
+    _mm_storeu_ps(row(0), a0);
+    _mm_storeu_ps(row(1), b0);
+    _mm_storeu_ps(row(2), c0);
+    _mm_storeu_ps(row(3), d0);
+    _mm_storeu_ps(row(4), a1);
+    _mm_storeu_ps(row(5), b1);
+    _mm_storeu_ps(row(6), c1);
+    _mm_storeu_ps(row(7), d1);
+}
+
+// Loads 8 consecutive Vector4s.
+REALLY_INLINE Vec4x8 load_vec4x8(const fo::Vector4 *p) { return load_vec4x8(p, sizeof(fo::Vector4)); }
+
+REALLY_INLINE void store_vec4x8(fo::Vector4 *p, const Vec4x8 &v) { store_vec4x8(p, sizeof(fo::Vector4), v); }
+
+// 8 Matrix4x4s, column by column like fo::Matrix4x4.
+struct Mat4x8 {
+    Vec4x8 x, y, z, t;
+};
+
+// Loads 8 consecutive matrices.
+REALLY_INLINE Mat4x8 load_mat4x8(const fo::Matrix4x4 *p) {
+    constexpr uint32_t stride = sizeof(fo::Matrix4x4);
+    return Mat4x8{ load_vec4x8(&p->x, stride), load_vec4x8(&p->y, stride), load_vec4x8(&p->z, stride),
+                   load_vec4x8(&p->t, stride) };
+}
+
+REALLY_INLINE void store_mat4x8(fo::Matrix4x4 *p, const Mat4x8 &m) {
+    constexpr uint32_t stride = sizeof(fo::Matrix4x4);
+    store_vec4x8(&p->x, stride, m.x);
+    store_vec4x8(&p->y, stride, m.y);
+    store_vec4x8(&p->z, stride, m.z);
+    store_vec4x8(&p->t, stride, m.t);
+}
+
+// Returns the i-th element of the pack
+REALLY_INLINE fo::Vector3 get_vec3(const Vec3x8 &v, int i) { return fo::Vector3{ lane(v.x, i), lane(v.y, i), lane(v.z, i) }; }
+
+// -- Arithmetic on packs
+
+REALLY_INLINE Vec3x8 operator+(const Vec3x8 &a, const Vec3x8 &b) { return Vec3x8{ a.x + b.x, a.y + b.y, a.z + b.z }; }
+REALLY_INLINE Vec3x8 operator-(const Vec3x8 &a, const Vec3x8 &b) { return Vec3x8{ a.x - b.x, a.y - b.y, a.z - b.z }; }
+REALLY_INLINE Vec3x8 operator*(const Vec3x8 &a, Float8 k) { return Vec3x8{ a.x * k, a.y * k, a.z * k }; }
+REALLY_INLINE Vec3x8 operator*(Float8 k, const Vec3x8 &a) { return a * k; }
+
+REALLY_INLINE Vec4x8 operator+(const Vec4x8 &a, const Vec4x8 &b) {
+    return Vec4x8{ a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w };
+}
+REALLY_INLINE Vec4x8 operator-(const Vec4x8 &a, const Vec4x8 &b) {
+    return Vec4x8{ a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w };
+}
+REALLY_INLINE Vec4x8 operator*(const Vec4x8 &a, Float8 k) { return Vec4x8{ a.x * k, a.y * k, a.z * k, a.w * k }; }
+REALLY_INLINE Vec4x8 operator*(Float8 k, const Vec4x8 &a) { return a * k; }
+
+REALLY_INLINE Float8 dot(const Vec3x8 &a, const Vec3x8 &b) { return mul_add(a.x, b.x, mul_add(a.y, b.y, a.z * b.z)); }
+
+REALLY_INLINE Float8 dot(const Vec4x8 &a, const Vec4x8 &b) {
+    return mul_add(a.x, b.x, mul_add(a.y, b.y, mul_add(a.z, b.z, a.w * b.w)));
+}
+
+REALLY_INLINE Float8 sq_mag(const Vec3x8 &a) { return dot(a, a); }
+
+REALLY_INLINE Float8 mag(const Vec3x8 &a) { return sqrt(dot(a, a)); }
+
+REALLY_INLINE Vec3x8 cross3(const Vec3x8 &u, const Vec3x8 &v) {
+    return Vec3x8{ u.y * v.z - u.z * v.y, u.z * v.x - u.x * v.z, u.x * v.y - u.y * v.x };
+}
+
+// Zero length vectors become NaN, same as math::normalize.
+REALLY_INLINE Vec3x8 normalize(const Vec3x8 &v) {
+    const Float8 inv_len = splat8(1.0f) / mag(v);
+    return v * inv_len;
+}
+
+REALLY_INLINE Vec4x8 normalize(const Vec4x8 &v) {
+    const Float8 inv_len = splat8(1.0f) / sqrt(dot(v, v));
+    return v * inv_len;
+}
+
+REALLY_INLINE Vec3x8 min(const Vec3x8 &a, const Vec3x8 &b) { return Vec3x8{ min(a.x, b.x), min(a.y, b.y), min(a.z, b.z) }; }
+REALLY_INLINE Vec3x8 max(const Vec3x8 &a, const Vec3x8 &b) { return Vec3x8{ max(a.x, b.x), max(a.y, b.y), max(a.z, b.z) }; }
+
+REALLY_INLINE Vec3x8 select(Float8 mask, const Vec3x8 &a, const Vec3x8 &b) {
+    return Vec3x8{ select(mask, a.x, b.x), select(mask, a.y, b.y), select(mask, a.z, b.z) };
+}
+
+REALLY_INLINE Vec4x8 select(Float8 mask, const Vec4x8 &a, const Vec4x8 &b) {
+    return Vec4x8{ select(mask, a.x, b.x), select(mask, a.y, b.y), select(mask, a.z, b.z), select(mask, a.w, b.w) };
+}
+
+} // inline namespace float8_avx/float8_sse
+
 } // namespace simd
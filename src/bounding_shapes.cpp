@@ -1,14 +1,18 @@
 #include <learnogl/essential_headers.h>
 
+#include "math_kernels.h"
+
 #include <learnogl/bounding_shapes.h>
 #include <learnogl/kitchen_sink.h>
 #include <learnogl/math_ops.h>
+#include <learnogl/parallel_for.h>
 #include <learnogl/rng.h>
 #include <scaffold/array.h>
 #include <scaffold/debug.h>
 
 #include <algorithm>
 #include <iostream>
+#include <limits>
 #include <numeric>
 #include <stdlib.h>
 #include <unordered_set>
@@ -18,11 +22,85 @@ using namespace eng::math;
 
 namespace eng {
 
-static inline Matrix3x3 make_covariance_matrix(const Vector3 *points, uint32_t num_points, Vector3 &mean_out);
+// Points per chunk of the reductions. Each chunk is reduced on its own, and the per-chunk results are combined in
+// chunk order afterwards, so the result doesn't depend on whether the chunks ran on one thread or many.
+static constexpr u32 k_points_per_chunk = 1u << 16;
+
+template <typename Partial, typename ChunkFn>
+static void reduce_point_chunks(u32 num_points, bool multithreaded, Array<Partial> &partials, ChunkFn &&fn) {
+    resize(partials, parallel_for_chunk_count(num_points, k_points_per_chunk));
+
+    const auto do_chunk = [&](u32 begin, u32 end) { fn(begin, end, partials[begin / k_points_per_chunk]); };
+
+    if (multithreaded) {
+        parallel_for(num_points, k_points_per_chunk, do_chunk);
+        return;
+    }
+
+    for (u32 begin = 0; begin < num_points; begin += k_points_per_chunk) {
+        do_chunk(begin, std::min(begin + k_points_per_chunk, num_points));
+    }
+}
+
+struct PointSums {
+    double sums[6];
+};
+
+static Matrix3x3
+make_covariance_matrix(const Vector3 *points, u32 stride, u32 num_points, bool multithreaded, Vector3 &mean_out) {
+    const auto &reductions = kernels::point_kernels();
+    Array<PointSums> partials(memory_globals::default_allocator());
+
+    const auto chunk_start = [points, stride](u32 begin) {
+        return kernels::advance_bytes(points, size_t(begin) * stride);
+    };
+
+    // The mean first, then the sums of the products of the differences from it. Doing it in two passes costs
+    // another read of the points but keeps the sums from cancelling when the points are far from the origin.
+    reduce_point_chunks(num_points, multithreaded, partials, [&](u32 begin, u32 end, PointSums &partial) {
+        reductions.sum(chunk_start(begin), stride, end - begin, partial.sums);
+    });
+
+    double mean[3] = { 0.0, 0.0, 0.0 };
+    for (const PointSums &partial : partials) {
+        for (u32 i = 0; i < 3; ++i) {
+            mean[i] += partial.sums[i];
+        }
+    }
+
+    mean_out = Vector3{ float(mean[0] / num_points), float(mean[1] / num_points), float(mean[2] / num_points) };
+
+    reduce_point_chunks(num_points, multithreaded, partials, [&](u32 begin, u32 end, PointSums &partial) {
+        reductions.covariance(chunk_start(begin), stride, end - begin, mean_out, partial.sums);
+    });
+
+    double cov[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    for (const PointSums &partial : partials) {
+        for (u32 i = 0; i < 6; ++i) {
+            cov[i] += partial.sums[i];
+        }
+    }
+
+    const float xx = float(cov[0] / num_points);
+    const float yy = float(cov[1] / num_points);
+    const float zz = float(cov[2] / num_points);
+    const float xy = float(cov[3] / num_points);
+    const float xz = float(cov[4] / num_points);
+    const float yz = float(cov[5] / num_points);
+
+    return Matrix3x3{ Vector3{ xx, xy, xz }, Vector3{ xy, yy, yz }, Vector3{ xz, yz, zz } };
+}
 
 PrincipalAxis calculate_principal_axis(const Vector3 *points, uint32_t num_points) {
+    return calculate_principal_axis(points, sizeof(Vector3), num_points);
+}
+
+PrincipalAxis
+calculate_principal_axis(const Vector3 *points, uint32_t stride, uint32_t num_points, bool multithreaded) {
+    assert(num_points != 0);
+
     Vector3 mean;
-    auto cov = make_covariance_matrix(points, num_points, mean);
+    auto cov = make_covariance_matrix(points, stride, num_points, multithreaded, mean);
 
     // The solver calculates a right-handed eigenbasis. So a rotation transformation from original basis is
     // possible
@@ -75,73 +153,6 @@ PrincipalAxis calculate_principal_axis(const Vector3 *points, uint32_t num_point
     return pa;
 }
 
-Matrix3x3 make_covariance_matrix(const Vector3 *points, uint32_t num_points, Vector3 &mean_out) {
-    Matrix3x3 cov;
-    float *covp = reinterpret_cast<float *>(&cov);
-    Vector3 zero{ 0.f, 0.f, 0.f };
-
-    const Vector3 *points_end = points + num_points;
-
-    const Vector3 mean =
-        std::accumulate(points, points_end, zero, [](const Vector3 &a, const Vector3 &b) { return a + b; }) /
-        float(num_points);
-
-    mean_out = Vector3{ mean.x, mean.y, mean.z };
-
-    // Keeping the intermediate calculated products in this array before calculating the mean.
-    Array<float> scratch(memory_globals::default_allocator(), num_points);
-    std::fill(begin(scratch), end(scratch), 0.f);
-
-    auto minus_1 = [&mean](int coord) {
-        return [&mean, coord](const Vector3 &point) -> float {
-            const float *p = reinterpret_cast<const float *>(&point);
-            const float *m = reinterpret_cast<const float *>(&mean);
-            const float d = p[coord] - m[coord];
-            return d * d;
-        };
-    };
-
-    auto minus_2 = [&mean](int coord1, int coord2) {
-        return [&mean, coord1, coord2](const Vector3 &point) -> float {
-            const float *p = reinterpret_cast<const float *>(&point);
-            const float *m = reinterpret_cast<const float *>(&mean);
-            return (p[coord1] - m[coord1]) * (p[coord2] - m[coord2]);
-        };
-    };
-
-    auto mean_scratch = [&scratch]() {
-        return std::accumulate(begin(scratch), scratch.end(), 0.0f) / float(size(scratch));
-    };
-
-    Index2D<int32_t> idx{ 3 };
-
-    std::transform(points, points_end, begin(scratch), minus_1(0));
-    covp[idx(0, 0)] = mean_scratch();
-
-    std::transform(points, points_end, begin(scratch), minus_1(1));
-    covp[idx(1, 1)] = mean_scratch();
-
-    std::transform(points, points_end, begin(scratch), minus_1(2));
-    covp[idx(2, 2)] = mean_scratch();
-
-    std::transform(points, points_end, begin(scratch), minus_2(0, 1));
-    float cov_01 = mean_scratch();
-
-    std::transform(points, points_end, begin(scratch), minus_2(0, 2));
-    float cov_02 = mean_scratch();
-
-    std::transform(points, points_end, begin(scratch), minus_2(1, 2));
-    float cov_12 = mean_scratch();
-
-    covp[idx(0, 1)] = cov_01;
-    covp[idx(1, 0)] = cov_01;
-    covp[idx(0, 2)] = cov_02;
-    covp[idx(2, 0)] = cov_02;
-    covp[idx(1, 2)] = cov_12;
-    covp[idx(2, 1)] = cov_12;
-
-    return cov;
-}
 
 BoundingRect create_bounding_rect(const PrincipalAxis &pa, const Vector3 *points, uint32_t num_points) {
     const Vector3 r_axis = pa.axes[PrincipalAxis::R];
@@ -275,39 +286,31 @@ create_bounding_sphere(const PrincipalAxis &pa, const Vector3 *positions, uint32
 }
 
 AABB calculate_AABB(const fo::Vector3 *positions, uint32_t num_points) {
-    assert(num_points != 0);
-
-    Vector3 min = positions[0];
-    Vector3 max = positions[0];
-
-    for (uint32_t i = 1; i < num_points; ++i) {
-        const Vector3 &p = positions[i];
-
-        if (max.x < p.x) {
-            max.x = p.x;
-        }
-
-        if (max.y < p.y) {
-            max.y = p.y;
-        }
-
-        if (max.z < p.z) {
-            max.z = p.z;
-        }
-
-        if (min.x > p.x) {
-            min.x = p.x;
-        }
+    return calculate_AABB(positions, sizeof(Vector3), num_points);
+}
 
-        if (min.y > p.y) {
-            min.y = p.y;
-        }
+AABB calculate_AABB(const fo::Vector3 *positions, uint32_t stride, uint32_t num_points, bool multithreaded) {
+    assert(num_points != 0);
 
-        if (min.z > p.z) {
-            min.z = p.z;
-        }
+    const auto bounds = kernels::point_kernels().bounds;
+    Array<AABB> partials(memory_globals::default_allocator());
+
+    reduce_point_chunks(num_points, multithreaded, partials, [&](u32 begin, u32 end, AABB &partial) {
+        const Vector3 *chunk = kernels::advance_bytes(positions, size_t(begin) * stride);
+        bounds(chunk, stride, end - begin, partial.min, partial.max);
+    });
+
+    AABB aabb = partials[0];
+    for (const AABB &partial : partials) {
+        aabb.min = Vector3{ std::min(aabb.min.x, partial.min.x),
+                            std::min(aabb.min.y, partial.min.y),
+                            std::min(aabb.min.z, partial.min.z) };
+        aabb.max = Vector3{ std::max(aabb.max.x, partial.max.x),
+                            std::max(aabb.max.y, partial.max.y),
+                            std::max(aabb.max.z, partial.max.z) };
     }
-    return AABB{ min, max };
+
+    return aabb;
 }
 
 BoundingSphere
@@ -324,7 +327,7 @@ create_bounding_sphere_iterative(const PrincipalAxis &pa, Vector3 *positions, ui
 
         for (u32 i = 0; i < num_points; ++i) {
             // Choose a random point, and bound it if not already
-            u32 point = (u32)rng::random(i + 1, num_points);
+            u32 point = (u32)rng::random(i, num_points);
             std::swap(positions[i], positions[point]);
             bs2 = sphere_of_sphere_and_point(bs2, positions[i]);
         }
@@ -338,4 +341,242 @@ create_bounding_sphere_iterative(const PrincipalAxis &pa, Vector3 *positions, ui
     return bs;
 }
 
+// -- Minimal bounding sphere
+
+namespace {
+
+struct Point3d {
+    double v[3];
+};
+
+Point3d to_point3d(const Vector3 &p) { return Point3d{ { p.x, p.y, p.z } }; }
+
+double dist2(const double *a, const double *b) {
+    const double dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// The smallest sphere with up to 4 given points on its boundary, built one point at a time. This is the basis
+// of Gaertner's "Fast and Robust Smallest Enclosing Balls" (1999). Pushing a point that is affinely dependent on
+// the ones already pushed fails rather than producing a huge sphere, which is what makes it work on the coplanar
+// and cocircular points meshes are full of.
+struct MinimalSphereBasis {
+    static constexpr double k_eps = 1e-14;
+
+    u32 size = 0;
+    double q0[3];
+    double z[4];
+    double v[4][3];
+    double c[4][3];
+    double sqr_r[4];
+
+    // The sphere of the last successful push. Stays put on pop.
+    double center[3] = { 0.0, 0.0, 0.0 };
+    double radius2 = -1.0;
+
+    double excess(const Point3d &p) const { return dist2(p.v, center) - radius2; }
+
+    bool push(const Point3d &p) {
+        const u32 m = size;
+        if (m == 0) {
+            for (u32 i = 0; i < 3; ++i) {
+                q0[i] = c[0][i] = p.v[i];
+            }
+            sqr_r[0] = 0.0;
+        } else {
+            double *vm = v[m];
+            for (u32 i = 0; i < 3; ++i) {
+                vm[i] = p.v[i] - q0[i];
+            }
+
+            // Make v[m] orthogonal to the earlier ones
+            double a[4];
+            for (u32 j = 1; j < m; ++j) {
+                a[j] = 2.0 * (v[j][0] * vm[0] + v[j][1] * vm[1] + v[j][2] * vm[2]) / z[j];
+            }
+            for (u32 j = 1; j < m; ++j) {
+                for (u32 i = 0; i < 3; ++i) {
+                    vm[i] -= a[j] * v[j][i];
+                }
+            }
+
+            z[m] = 2.0 * (vm[0] * vm[0] + vm[1] * vm[1] + vm[2] * vm[2]);
+            if (z[m] < k_eps * radius2) {
+                return false;
+            }
+
+            const double e = dist2(p.v, c[m - 1]) - sqr_r[m - 1];
+            const double f = e / z[m];
+            for (u32 i = 0; i < 3; ++i) {
+                c[m][i] = c[m - 1][i] + f * vm[i];
+            }
+            sqr_r[m] = sqr_r[m - 1] + e * f / 2.0;
+        }
+
+        for (u32 i = 0; i < 3; ++i) {
+            center[i] = c[m][i];
+        }
+        radius2 = sqr_r[m];
+        ++size;
+        return true;
+    }
+
+    void pop() { --size; }
+};
+
+// Welzl's algorithm with the move-to-front heuristic. Leaves the smallest sphere containing points[0, end) with
+// the pushed points on its boundary in the basis, and moves the points that ended up mattering to the front.
+void move_to_front_sphere(MinimalSphereBasis &basis, Point3d *points, u32 end) {
+    if (basis.size == 4) {
+        return;
+    }
+
+    for (u32 k = 0; k < end; ++k) {
+        if (basis.excess(points[k]) > 0.0 && basis.push(points[k])) {
+            move_to_front_sphere(basis, points, k);
+            basis.pop();
+            std::rotate(points, points + k, points + k + 1);
+        }
+    }
+}
+
+// Directions to find the extreme points along. Axes and cube diagonals, Larsson's EPOS-14.
+const Vector3 k_epos14_directions[] = { { 1.0f, 0.0f, 0.0f },  { 0.0f, 1.0f, 0.0f },  { 0.0f, 0.0f, 1.0f },
+                                        { 1.0f, 1.0f, 1.0f },  { 1.0f, 1.0f, -1.0f }, { 1.0f, -1.0f, 1.0f },
+                                        { 1.0f, -1.0f, -1.0f } };
+
+constexpr u32 k_num_epos_directions = u32(sizeof(k_epos14_directions) / sizeof(k_epos14_directions[0]));
+
+struct ExtremePoints {
+    u32 min_indices[k_num_epos_directions];
+    u32 max_indices[k_num_epos_directions];
+};
+
+struct FarthestPoint {
+    u32 index;
+    float dist2;
+};
+
+// Gives up on getting closer after this many passes over the points. Never needed in practice.
+constexpr u32 k_max_sphere_passes = 64;
+
+} // namespace
+
+static const Vector3 &point_at(const Vector3 *positions, u32 stride, u32 i) {
+    return *kernels::advance_bytes(positions, size_t(i) * stride);
+}
+
+static FarthestPoint
+find_farthest_point(const Vector3 *positions, u32 stride, u32 num_points, bool multithreaded, const Vector3 &from) {
+    const auto farthest_point = kernels::point_kernels().farthest_point;
+    Array<FarthestPoint> partials(memory_globals::default_allocator());
+
+    reduce_point_chunks(num_points, multithreaded, partials, [&](u32 begin, u32 end, FarthestPoint &partial) {
+        farthest_point(&point_at(positions, stride, begin), stride, end - begin, from, partial.index, partial.dist2);
+        partial.index += begin;
+    });
+
+    FarthestPoint farthest = partials[0];
+    for (const FarthestPoint &partial : partials) {
+        if (partial.dist2 > farthest.dist2) {
+            farthest = partial;
+        }
+    }
+    return farthest;
+}
+
+static void find_extreme_points(
+    const Vector3 *positions, u32 stride, u32 num_points, bool multithreaded, Array<Point3d> &extremes_out) {
+    const auto extreme_points = kernels::point_kernels().extreme_points;
+    Array<ExtremePoints> partials(memory_globals::default_allocator());
+
+    reduce_point_chunks(num_points, multithreaded, partials, [&](u32 begin, u32 end, ExtremePoints &partial) {
+        extreme_points(&point_at(positions, stride, begin),
+                       stride,
+                       end - begin,
+                       k_epos14_directions,
+                       k_num_epos_directions,
+                       partial.min_indices,
+                       partial.max_indices);
+        for (u32 d = 0; d < k_num_epos_directions; ++d) {
+            partial.min_indices[d] += begin;
+            partial.max_indices[d] += begin;
+        }
+    });
+
+    ExtremePoints extremes = partials[0];
+    for (const ExtremePoints &partial : partials) {
+        for (u32 d = 0; d < k_num_epos_directions; ++d) {
+            const Vector3 &dir = k_epos14_directions[d];
+            if (dot(point_at(positions, stride, partial.min_indices[d]), dir) <
+                dot(point_at(positions, stride, extremes.min_indices[d]), dir)) {
+                extremes.min_indices[d] = partial.min_indices[d];
+            }
+            if (dot(point_at(positions, stride, partial.max_indices[d]), dir) >
+                dot(point_at(positions, stride, extremes.max_indices[d]), dir)) {
+                extremes.max_indices[d] = partial.max_indices[d];
+            }
+        }
+    }
+
+    u32 indices[2 * k_num_epos_directions];
+    std::copy(extremes.min_indices, extremes.min_indices + k_num_epos_directions, indices);
+    std::copy(extremes.max_indices, extremes.max_indices + k_num_epos_directions, indices + k_num_epos_directions);
+    std::sort(indices, indices + 2 * k_num_epos_directions);
+    const u32 *indices_end = std::unique(indices, indices + 2 * k_num_epos_directions);
+
+    clear(extremes_out);
+    for (const u32 *i = indices; i != indices_end; ++i) {
+        push_back(extremes_out, to_point3d(point_at(positions, stride, *i)));
+    }
+}
+
+BoundingSphere create_minimal_bounding_sphere(const Vector3 *positions, uint32_t num_points) {
+    return create_minimal_bounding_sphere(positions, sizeof(Vector3), num_points);
+}
+
+BoundingSphere
+create_minimal_bounding_sphere(const Vector3 *positions, uint32_t stride, uint32_t num_points, bool multithreaded) {
+    assert(num_points != 0);
+
+    // The points that have determined the sphere so far, in double. Only these get moved around.
+    Array<Point3d> support(memory_globals::default_allocator());
+    find_extreme_points(positions, stride, num_points, multithreaded, support);
+
+    MinimalSphereBasis basis;
+    move_to_front_sphere(basis, data(support), size(support));
+
+    // Pivot on the point farthest outside until none are. Adding a point outside always grows the sphere, so this
+    // stops once float rounding is all that's left.
+    Vector3 center;
+    FarthestPoint farthest;
+    for (u32 pass = 0;; ++pass) {
+        center = Vector3{ float(basis.center[0]), float(basis.center[1]), float(basis.center[2]) };
+        farthest = find_farthest_point(positions, stride, num_points, multithreaded, center);
+
+        const Point3d pivot = to_point3d(point_at(positions, stride, farthest.index));
+        if (pass == k_max_sphere_passes || basis.excess(pivot) <= 1e-7 * basis.radius2) {
+            break;
+        }
+
+        const double old_radius2 = basis.radius2;
+        basis.push(pivot);
+        move_to_front_sphere(basis, data(support), size(support));
+        basis.pop();
+
+        push_back(support, pivot);
+        std::rotate(begin(support), end(support) - 1, end(support));
+
+        if (basis.radius2 <= old_radius2) {
+            center = Vector3{ float(basis.center[0]), float(basis.center[1]), float(basis.center[2]) };
+            farthest = find_farthest_point(positions, stride, num_points, multithreaded, center);
+            break;
+        }
+    }
+
+    // The radius is taken from the float distances to the float center so that every point is inside the sphere
+    // we return, not just the one in double
+    return BoundingSphere{ center, std::sqrt(farthest.dist2) * (1.0f + std::numeric_limits<float>::epsilon()) };
+}
+
 } // namespace eng
@@ -0,0 +1,600 @@
+#include <learnogl/bvh.h>
+#include <learnogl/intersection_test.h>
+#include <learnogl/parallel_for.h>
+#include <scaffold/debug.h>
+
+#include <limits>
+#include <utility>
+
+using namespace fo;
+using namespace eng::math;
+
+namespace eng {
+
+namespace {
+
+constexpr u32 k_num_bins = 16;
+
+// Nodes with more primitives than this are split by the top level of the build, with the bounds and bins summed
+// up over chunks of primitives spread over the workers. The subtrees below are built on their own, one per worker
+// at a time. The split doesn't depend on which of the two does it, so neither does the tree.
+constexpr u32 k_subtree_max_primitives = 1u << 15;
+constexpr u32 k_primitives_per_chunk = 1u << 14;
+
+constexpr float k_inf = std::numeric_limits<float>::infinity();
+
+inline float min_float(float a, float b) { return a < b ? a : b; }
+inline float max_float(float a, float b) { return a > b ? a : b; }
+
+inline AABB empty_aabb() { return AABB{ Vector3{ k_inf, k_inf, k_inf }, Vector3{ -k_inf, -k_inf, -k_inf } }; }
+
+inline void grow(AABB &box, const Vector3 &p) {
+    box.min = Vector3{ min_float(box.min.x, p.x), min_float(box.min.y, p.y), min_float(box.min.z, p.z) };
+    box.max = Vector3{ max_float(box.max.x, p.x), max_float(box.max.y, p.y), max_float(box.max.z, p.z) };
+}
+
+inline void grow(AABB &box, const AABB &other) {
+    grow(box, other.min);
+    grow(box, other.max);
+}
+
+// Half the surface area, which is all the SAH needs. 0 for an empty box.
+inline float half_area(const AABB &box) {
+    const Vector3 d = box.max - box.min;
+    if (d.x < 0.0f || d.y < 0.0f || d.z < 0.0f) {
+        return 0.0f;
+    }
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+inline float component(const Vector3 &v, u32 axis) { return (&v.x)[axis]; }
+
+struct RangeBounds {
+    AABB bounds;
+    AABB centroid_bounds;
+};
+
+struct Bin {
+    AABB bounds;
+    u32 count;
+};
+
+struct Bins {
+    Bin bins[3][k_num_bins];
+};
+
+// Maps centroids to bins along each axis. An axis with no extent has scale 0, and everything goes into bin 0.
+struct BinMapping {
+    Vector3 min;
+    Vector3 scale;
+
+    BinMapping(const AABB &centroid_bounds) {
+        min = centroid_bounds.min;
+        for (u32 axis = 0; axis < 3; ++axis) {
+            const float extent = component(centroid_bounds.max, axis) - component(centroid_bounds.min, axis);
+            (&scale.x)[axis] = extent > 0.0f ? float(k_num_bins) * (1.0f - 1e-6f) / extent : 0.0f;
+        }
+    }
+
+    u32 bin_of(const Vector3 &centroid, u32 axis) const {
+        const float f = (component(centroid, axis) - component(min, axis)) * component(scale, axis);
+        const u32 bin = u32(max_float(f, 0.0f));
+        return bin < k_num_bins ? bin : k_num_bins - 1;
+    }
+};
+
+struct Split {
+    u32 axis;
+    u32 bin; // Primitives in bins [0, bin) go left
+    float cost;
+};
+
+struct Builder {
+    const AABB *primitive_bounds;
+    const Vector3 *centroids;
+    u32 *indices;
+    BVHBuildOptions options;
+
+    RangeBounds bounds_of(u32 begin, u32 end) const {
+        RangeBounds r{ empty_aabb(), empty_aabb() };
+        for (u32 i = begin; i < end; ++i) {
+            grow(r.bounds, primitive_bounds[indices[i]]);
+            grow(r.centroid_bounds, centroids[indices[i]]);
+        }
+        return r;
+    }
+
+    void bin(u32 begin, u32 end, const BinMapping &mapping, Bins &out) const {
+        for (u32 axis = 0; axis < 3; ++axis) {
+            for (Bin &b : out.bins[axis]) {
+                b = Bin{ empty_aabb(), 0 };
+            }
+        }
+
+        for (u32 i = begin; i < end; ++i) {
+            const u32 primitive = indices[i];
+            for (u32 axis = 0; axis < 3; ++axis) {
+                Bin &b = out.bins[axis][mapping.bin_of(centroids[primitive], axis)];
+                grow(b.bounds, primitive_bounds[primitive]);
+                ++b.count;
+            }
+        }
+    }
+
+    // The cheapest split between bins, with the cost relative to testing every primitive of the node. Returns
+    // false if all the centroids are in one bin along every axis.
+    bool find_split(const Bins &bins, const AABB &bounds, Split &best) const {
+        const float area = half_area(bounds);
+        const float inv_area = area > 0.0f ? 1.0f / area : 0.0f;
+        best = Split{ 0, 0, k_inf };
+
+        for (u32 axis = 0; axis < 3; ++axis) {
+            const Bin *b = bins.bins[axis];
+
+            // Sweep from the right to get the cost of everything right of each split, then from the left
+            float right_cost[k_num_bins];
+            u32 right_count[k_num_bins];
+            AABB right = empty_aabb();
+            u32 count = 0;
+            for (u32 i = k_num_bins - 1; i > 0; --i) {
+                grow(right, b[i].bounds);
+                count += b[i].count;
+                right_cost[i] = half_area(right) * float(count);
+                right_count[i] = count;
+            }
+
+            AABB left = empty_aabb();
+            count = 0;
+            for (u32 i = 1; i < k_num_bins; ++i) {
+                grow(left, b[i - 1].bounds);
+                count += b[i - 1].count;
+                if (count == 0 || right_count[i] == 0) {
+                    continue;
+                }
+
+                const float cost =
+                    options.traversal_cost + (half_area(left) * float(count) + right_cost[i]) * inv_area;
+                if (cost < best.cost) {
+                    best = Split{ axis, i, cost };
+                }
+            }
+        }
+        return best.cost < k_inf;
+    }
+
+    // Moves the primitives going left to the front of the range, and returns where the right ones start
+    u32 partition(u32 begin, u32 end, const BinMapping &mapping, const Split &split) const {
+        u32 *first = indices + begin;
+        u32 *last = indices + end;
+        while (first != last) {
+            if (mapping.bin_of(centroids[*first], split.axis) < split.bin) {
+                ++first;
+            } else {
+                --last;
+                std::swap(*first, *last);
+            }
+        }
+        return u32(first - indices);
+    }
+
+    // Decides whether [begin, end) becomes a leaf, and where it's split if not. Returns end for a leaf.
+    u32 choose_split(u32 begin, u32 end, const RangeBounds &r, const Bins &bins, const BinMapping &mapping) const {
+        const u32 count = end - begin;
+
+        Split split;
+        if (!find_split(bins, r.bounds, split)) {
+            // Every centroid is in the same place. Splitting doesn't help, but leaves are limited.
+            return count <= k_bvh_max_leaf_primitives ? end : begin + count / 2;
+        }
+
+        if (count <= k_bvh_max_leaf_primitives && (count <= 1 || (count <= options.max_leaf_primitives &&
+                                                                   float(count) <= split.cost))) {
+            return end;
+        }
+
+        return partition(begin, end, mapping, split);
+    }
+
+    // Builds the subtree of [begin, end) in depth-first order, appending to `nodes`, which has room for the at
+    // most 2 * (end - begin) - 1 nodes.
+    void build_subtree(BVHNode *nodes, u32 &num_nodes, u32 begin, u32 end, const RangeBounds &r) const {
+        Bins bins;
+        const BinMapping mapping(r.centroid_bounds);
+        bin(begin, end, mapping, bins);
+
+        const u32 mid = choose_split(begin, end, r, bins, mapping);
+        const u32 node_index = num_nodes++;
+        BVHNode &node = nodes[node_index];
+        node.min = r.bounds.min;
+        node.max = r.bounds.max;
+
+        if (mid == end) {
+            node.skip_index = num_nodes;
+            node.leaf = (begin << 4) | (end - begin);
+            return;
+        }
+
+        node.leaf = 0;
+        build_subtree(nodes, num_nodes, begin, mid, bounds_of(begin, mid));
+        build_subtree(nodes, num_nodes, mid, end, bounds_of(mid, end));
+        nodes[node_index].skip_index = num_nodes;
+    }
+};
+
+// The top of the tree is built into these, with the subtrees left for later
+struct TopNode {
+    AABB bounds;
+    u32 begin, end;
+    u32 left, right; // Indices of the children in the top nodes. Both 0 if the subtree is built separately.
+    u32 subtree;     // Index of the separately built subtree
+};
+
+struct Subtree {
+    u32 begin, end;
+    RangeBounds bounds;
+    u32 num_nodes;
+};
+
+template <typename Partial, typename ChunkFn>
+static void
+reduce_primitive_chunks(u32 begin, u32 end, bool multithreaded, Array<Partial> &partials, ChunkFn &&fn) {
+    const u32 count = end - begin;
+    resize(partials, parallel_for_chunk_count(count, k_primitives_per_chunk));
+
+    const auto do_chunk = [&](u32 b, u32 e) { fn(begin + b, begin + e, partials[b / k_primitives_per_chunk]); };
+
+    if (multithreaded) {
+        parallel_for(count, k_primitives_per_chunk, do_chunk);
+        return;
+    }
+
+    for (u32 b = 0; b < count; b += k_primitives_per_chunk) {
+        do_chunk(b, b + k_primitives_per_chunk < count ? b + k_primitives_per_chunk : count);
+    }
+}
+
+struct TopLevelBuild {
+    const Builder &builder;
+    Array<TopNode> top_nodes{ memory_globals::default_allocator() };
+    Array<Subtree> subtrees{ memory_globals::default_allocator() };
+    Array<RangeBounds> bounds_partials{ memory_globals::default_allocator() };
+    Array<Bins> bin_partials{ memory_globals::default_allocator() };
+
+    TopLevelBuild(const Builder &builder)
+        : builder(builder) {}
+
+    RangeBounds bounds_of(u32 begin, u32 end) {
+        if (end - begin <= k_subtree_max_primitives) {
+            return builder.bounds_of(begin, end);
+        }
+
+        reduce_primitive_chunks(
+            begin, end, builder.options.multithreaded, bounds_partials, [&](u32 b, u32 e, RangeBounds &partial) {
+                partial = builder.bounds_of(b, e);
+            });
+
+        RangeBounds r{ empty_aabb(), empty_aabb() };
+        for (const RangeBounds &partial : bounds_partials) {
+            grow(r.bounds, partial.bounds);
+            grow(r.centroid_bounds, partial.centroid_bounds);
+        }
+        return r;
+    }
+
+    // Returns the index of the top node for [begin, end)
+    u32 build(u32 begin, u32 end, const RangeBounds &r) {
+        const u32 node_index = size(top_nodes);
+        push_back(top_nodes, TopNode{ r.bounds, begin, end, 0, 0, 0 });
+
+        if (end - begin <= k_subtree_max_primitives) {
+            top_nodes[node_index].subtree = size(subtrees);
+            push_back(subtrees, Subtree{ begin, end, r, 0 });
+            return node_index;
+        }
+
+        const BinMapping mapping(r.centroid_bounds);
+        reduce_primitive_chunks(
+            begin, end, builder.options.multithreaded, bin_partials, [&](u32 b, u32 e, Bins &partial) {
+                builder.bin(b, e, mapping, partial);
+            });
+
+        Bins bins = bin_partials[0];
+        for (u32 i = 1; i < size(bin_partials); ++i) {
+            for (u32 axis = 0; axis < 3; ++axis) {
+                for (u32 k = 0; k < k_num_bins; ++k) {
+                    grow(bins.bins[axis][k].bounds, bin_partials[i].bins[axis][k].bounds);
+                    bins.bins[axis][k].count += bin_partials[i].bins[axis][k].count;
+                }
+            }
+        }
+
+        // Too many primitives to become a leaf, so this always splits
+        const u32 mid = builder.choose_split(begin, end, r, bins, mapping);
+        const u32 left = build(begin, mid, bounds_of(begin, mid));
+        const u32 right = build(mid, end, bounds_of(mid, end));
+        top_nodes[node_index].left = left;
+        top_nodes[node_index].right = right;
+        return node_index;
+    }
+
+    // Appends the nodes of the top node and everything under it to `nodes`. The subtree of primitives [begin,
+    // end) was built into subtree_nodes[2 * begin, 2 * end), with its node indices starting from 0.
+    void flatten(u32 top_index, const BVHNode *subtree_nodes, Array<BVHNode> &nodes) const {
+        const TopNode &top = top_nodes[top_index];
+
+        if (top.left == 0) {
+            const Subtree &s = subtrees[top.subtree];
+            const u32 base = size(nodes);
+            for (u32 i = 0; i < s.num_nodes; ++i) {
+                push_back(nodes, subtree_nodes[2 * s.begin + i]);
+                back(nodes).skip_index += base;
+            }
+            return;
+        }
+
+        const u32 node_index = size(nodes);
+        BVHNode node;
+        node.min = top.bounds.min;
+        node.max = top.bounds.max;
+        node.leaf = 0;
+        push_back(nodes, node);
+
+        flatten(top.left, subtree_nodes, nodes);
+        flatten(top.right, subtree_nodes, nodes);
+        nodes[node_index].skip_index = size(nodes);
+    }
+};
+
+void build_bvh_from_primitives(BVH &bvh,
+                               const AABB *primitive_bounds,
+                               const Vector3 *centroids,
+                               u32 num_primitives,
+                               const BVHBuildOptions &options) {
+    CHECK_F(num_primitives <= k_bvh_max_primitives, "Can't build a BVH over %u primitives", num_primitives);
+    CHECK_F(options.max_leaf_primitives >= 1 && options.max_leaf_primitives <= k_bvh_max_leaf_primitives,
+            "max_leaf_primitives = %u",
+            options.max_leaf_primitives);
+
+    // No nodes, which no ray hits
+    if (num_primitives == 0) {
+        clear(bvh.nodes);
+        clear(bvh.primitive_indices);
+        return;
+    }
+
+    resize(bvh.primitive_indices, num_primitives);
+    for (u32 i = 0; i < num_primitives; ++i) {
+        bvh.primitive_indices[i] = i;
+    }
+
+    Builder builder{ primitive_bounds, centroids, data(bvh.primitive_indices), options };
+    TopLevelBuild top(builder);
+    top.build(0, num_primitives, top.bounds_of(0, num_primitives));
+
+    // Each subtree is built on its own into a part of this, with its nodes numbered from 0
+    Array<BVHNode> subtree_nodes(memory_globals::default_allocator());
+    resize(subtree_nodes, 2 * num_primitives);
+
+    const auto build_subtrees = [&](u32 begin, u32 end) {
+        for (u32 i = begin; i < end; ++i) {
+            Subtree &s = top.subtrees[i];
+            builder.build_subtree(&subtree_nodes[2 * s.begin], s.num_nodes, s.begin, s.end, s.bounds);
+        }
+    };
+
+    if (options.multithreaded) {
+        parallel_for(size(top.subtrees), 1, build_subtrees);
+    } else {
+        build_subtrees(0, size(top.subtrees));
+    }
+
+    clear(bvh.nodes);
+    reserve(bvh.nodes, 2 * num_primitives);
+    top.flatten(0, data(subtree_nodes), bvh.nodes);
+}
+
+// -- Traversal
+
+// Slab test. Returns the distance where the ray enters the box (0 if it starts inside), or infinity if it misses
+// the box or enters it after t_max.
+inline float ray_box_entry(const PrecomputedRay &r, const Vector3 &min, const Vector3 &max, float t_max) {
+    const float tx0 = (min.x - r.origin.x) * r.inv_direction.x;
+    const float tx1 = (max.x - r.origin.x) * r.inv_direction.x;
+    const float ty0 = (min.y - r.origin.y) * r.inv_direction.y;
+    const float ty1 = (max.y - r.origin.y) * r.inv_direction.y;
+    const float tz0 = (min.z - r.origin.z) * r.inv_direction.z;
+    const float tz1 = (max.z - r.origin.z) * r.inv_direction.z;
+
+    float t_enter = 0.0f;
+    float t_exit = t_max;
+    t_enter = max_float(min_float(tx0, tx1), t_enter);
+    t_enter = max_float(min_float(ty0, ty1), t_enter);
+    t_enter = max_float(min_float(tz0, tz1), t_enter);
+    t_exit = min_float(max_float(tx0, tx1), t_exit);
+    t_exit = min_float(max_float(ty0, ty1), t_exit);
+    t_exit = min_float(max_float(tz0, tz1), t_exit);
+    return t_enter <= t_exit ? t_enter : k_inf;
+}
+
+// Visits the nodes the ray enters before the nearest hit so far, calling `test_leaf(node, t_nearest)` on the
+// leaves, which shrinks t_nearest when it finds a nearer hit.
+template <typename LeafFn>
+inline void traverse(const BVH &bvh, const PrecomputedRay &r, float &t_nearest, LeafFn &&test_leaf) {
+    const BVHNode *nodes = data(bvh.nodes);
+    const u32 num_nodes = size(bvh.nodes);
+
+    u32 i = 0;
+    while (i < num_nodes) {
+        const BVHNode &node = nodes[i];
+        if (ray_box_entry(r, node.min, node.max, t_nearest) == k_inf) {
+            i = node.skip_index;
+            continue;
+        }
+
+        if (node.is_leaf()) {
+            test_leaf(node, t_nearest);
+        }
+        ++i;
+    }
+}
+
+} // namespace
+
+void build_bvh(BVH &bvh, const AABB *boxes, u32 num_boxes, const BVHBuildOptions &options) {
+    Array<Vector3> centroids(memory_globals::default_allocator());
+    resize(centroids, num_boxes);
+    for (u32 i = 0; i < num_boxes; ++i) {
+        centroids[i] = (boxes[i].min + boxes[i].max) * 0.5f;
+    }
+    build_bvh_from_primitives(bvh, boxes, data(centroids), num_boxes, options);
+}
+
+template <typename IndexType>
+static void build_triangle_bvh(TriangleBVH &bvh,
+                               const Vector3 *positions,
+                               u32 stride,
+                               const IndexType *indices,
+                               u32 num_triangles,
+                               const BVHBuildOptions &options) {
+    const auto vertex = [&](u32 triangle, u32 corner) -> const Vector3 & {
+        return *reinterpret_cast<const Vector3 *>(reinterpret_cast<const u8 *>(positions) +
+                                                  size_t(indices[triangle * 3 + corner]) * stride);
+    };
+
+    Array<AABB> bounds(memory_globals::default_allocator());
+    Array<Vector3> centroids(memory_globals::default_allocator());
+    resize(bounds, num_triangles);
+    resize(centroids, num_triangles);
+
+    const auto compute_bounds = [&](u32 begin, u32 end) {
+        for (u32 i = begin; i < end; ++i) {
+            AABB box = empty_aabb();
+            grow(box, vertex(i, 0));
+            grow(box, vertex(i, 1));
+            grow(box, vertex(i, 2));
+            bounds[i] = box;
+            centroids[i] = (box.min + box.max) * 0.5f;
+        }
+    };
+
+    if (options.multithreaded) {
+        parallel_for(num_triangles, k_primitives_per_chunk, compute_bounds);
+    } else {
+        compute_bounds(0, num_triangles);
+    }
+
+    build_bvh_from_primitives(bvh.bvh, data(bounds), data(centroids), num_triangles, options);
+
+    resize(bvh.triangles, num_triangles * 3);
+    for (u32 i = 0; i < num_triangles; ++i) {
+        const u32 triangle = bvh.bvh.primitive_indices[i];
+        const Vector3 &v0 = vertex(triangle, 0);
+        bvh.triangles[i * 3] = v0;
+        bvh.triangles[i * 3 + 1] = vertex(triangle, 1) - v0;
+        bvh.triangles[i * 3 + 2] = vertex(triangle, 2) - v0;
+    }
+}
+
+void build_bvh(TriangleBVH &bvh,
+               const Vector3 *positions,
+               u32 stride,
+               const u32 *indices,
+               u32 num_triangles,
+               const BVHBuildOptions &options) {
+    build_triangle_bvh(bvh, positions, stride, indices, num_triangles, options);
+}
+
+void build_bvh(TriangleBVH &bvh, const mesh::MeshData &mesh_data, const BVHBuildOptions &options) {
+    CHECK_F(!mesh_data.o.is_quantized(), "Build the BVH before quantizing the mesh");
+    const auto *positions = reinterpret_cast<const Vector3 *>(mesh_data.buffer + mesh_data.o.position_offset);
+    const u32 stride = mesh_data.o.packed_attr_size;
+    const u8 *indices = mesh::indices_begin(mesh_data);
+    if (mesh_data.o.has_wide_indices()) {
+        build_triangle_bvh(
+            bvh, positions, stride, (const mesh::WideIndexType *)indices, mesh_data.o.num_faces, options);
+    } else {
+        build_triangle_bvh(bvh, positions, stride, (const mesh::IndexType *)indices, mesh_data.o.num_faces, options);
+    }
+}
+
+bool raycast(const TriangleBVH &bvh, const Ray &ray, float t_max, RayHit &hit) {
+    const PrecomputedRay r(ray);
+    const Vector3 *triangles = data(bvh.triangles);
+
+    float t_nearest = t_max;
+    u32 nearest = k_bvh_max_primitives;
+    float nearest_u = 0.0f;
+    float nearest_v = 0.0f;
+
+    // Möller-Trumbore, with the edges stored
+    traverse(bvh.bvh, r, t_nearest, [&](const BVHNode &leaf, float &t_nearest) {
+        const u32 end = leaf.first_primitive() + leaf.num_primitives();
+        for (u32 i = leaf.first_primitive(); i < end; ++i) {
+            const Vector3 &v0 = triangles[i * 3];
+            const Vector3 &e1 = triangles[i * 3 + 1];
+            const Vector3 &e2 = triangles[i * 3 + 2];
+
+            const Vector3 p = cross(r.direction, e2);
+            const float det = dot(e1, p);
+            if (det == 0.0f) {
+                continue;
+            }
+            const float inv_det = 1.0f / det;
+
+            const Vector3 s = r.origin - v0;
+            const float u = dot(s, p) * inv_det;
+            if (u < 0.0f || u > 1.0f) {
+                continue;
+            }
+
+            const Vector3 q = cross(s, e1);
+            const float v = dot(r.direction, q) * inv_det;
+            if (v < 0.0f || u + v > 1.0f) {
+                continue;
+            }
+
+            const float t = dot(e2, q) * inv_det;
+            if (t >= 0.0f && (t < t_nearest || (t == t_nearest && nearest == k_bvh_max_primitives))) {
+                t_nearest = t;
+                nearest = i;
+                nearest_u = u;
+                nearest_v = v;
+            }
+        }
+    });
+
+    if (nearest == k_bvh_max_primitives) {
+        return false;
+    }
+
+    hit = RayHit{ t_nearest, bvh.bvh.primitive_indices[nearest], nearest_u, nearest_v };
+    return true;
+}
+
+bool raycast(const BVH &bvh, const AABB *boxes, const Ray &ray, float t_max, RayHit &hit) {
+    const PrecomputedRay r(ray);
+
+    float t_nearest = t_max;
+    u32 nearest = k_bvh_max_primitives;
+
+    traverse(bvh, r, t_nearest, [&](const BVHNode &leaf, float &t_nearest) {
+        const u32 end = leaf.first_primitive() + leaf.num_primitives();
+        for (u32 i = leaf.first_primitive(); i < end; ++i) {
+            const u32 box = bvh.primitive_indices[i];
+            const float t = ray_box_entry(r, boxes[box].min, boxes[box].max, t_nearest);
+            if (t != k_inf && (t < t_nearest || nearest == k_bvh_max_primitives)) {
+                t_nearest = t;
+                nearest = box;
+            }
+        }
+    });
+
+    if (nearest == k_bvh_max_primitives) {
+        return false;
+    }
+
+    hit = RayHit{ t_nearest, nearest, 0.0f, 0.0f };
+    return true;
+}
+
+} // namespace eng
@@ -0,0 +1,191 @@
+// Writing and mapping cooked model files. See mesh.h for the layout.
+
+#include <learnogl/mesh.h>
+#include <loguru.hpp>
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(WIN32)
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+using namespace fo;
+
+namespace eng {
+
+namespace mesh {
+
+static u64 align_up(u64 offset, u64 alignment) { return (offset + alignment - 1) / alignment * alignment; }
+
+static u64 mesh_buffer_size(const MeshDataOffsetsAndSizes &o) {
+    return u64(o.get_vertices_size_in_bytes()) + o.get_indices_size_in_bytes() + o.get_bone_data_size_in_bytes();
+}
+
+bool write_cooked_model(const Model &m, const char *file_name, u32 model_load_flags) {
+    FILE *f = fopen(file_name, "wb");
+    if (f == nullptr) {
+        LOG_F(ERROR, "Could not create cooked model file %s", file_name);
+        return false;
+    }
+
+    const u32 num_meshes = mesh::num_meshes(m);
+    const CookedModelHeader header{ k_cooked_model_magic, k_cooked_model_version, num_meshes, model_load_flags };
+
+    Array<CookedMeshEntry> entries(memory_globals::default_allocator(), num_meshes);
+    const u64 entries_end = sizeof(CookedModelHeader) + num_meshes * sizeof(CookedMeshEntry);
+    u64 offset = align_up(entries_end, k_cooked_buffer_alignment);
+    for (u32 i = 0; i < num_meshes; ++i) {
+        const MeshData &md = mesh_data(m, i);
+        entries[i].o = md.o;
+        entries[i].positions_are_2d = md.positions_are_2d ? 1 : 0;
+        entries[i].buffer_offset = offset;
+        entries[i].buffer_size = mesh_buffer_size(md.o);
+        offset = align_up(offset + entries[i].buffer_size, k_cooked_buffer_alignment);
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    ok = ok && (num_meshes == 0 || fwrite(data(entries), sizeof(CookedMeshEntry), num_meshes, f) == num_meshes);
+
+    // Zeroes up to each buffer's aligned offset
+    const u8 padding[k_cooked_buffer_alignment] = {};
+    u64 written = entries_end;
+    for (u32 i = 0; ok && i < num_meshes; ++i) {
+        const u64 padding_size = entries[i].buffer_offset - written;
+        ok = padding_size == 0 || fwrite(padding, 1, padding_size, f) == padding_size;
+        ok = ok && fwrite(mesh_data(m, i).buffer, 1, entries[i].buffer_size, f) == entries[i].buffer_size;
+        written = entries[i].buffer_offset + entries[i].buffer_size;
+    }
+
+    ok = fclose(f) == 0 && ok;
+    if (!ok) {
+        LOG_F(ERROR, "Failed to write cooked model file %s", file_name);
+    }
+    return ok;
+}
+
+bool is_cooked_model_file(const char *file_name) {
+    FILE *f = fopen(file_name, "rb");
+    if (f == nullptr) {
+        return false;
+    }
+    u32 magic = 0;
+    const bool have_magic = fread(&magic, sizeof(magic), 1, f) == 1 && magic == k_cooked_model_magic;
+    fclose(f);
+    return have_magic;
+}
+
+// Maps the whole file copy-on-write. Returns nullptr on failure.
+static void *map_file(const char *file_name, size_t &size_out) {
+#if defined(WIN32)
+    HANDLE file = CreateFileA(
+        file_name, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    LARGE_INTEGER size;
+    void *address = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart != 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (mapping != nullptr) {
+            address = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        size_out = size_t(size.QuadPart);
+    }
+    CloseHandle(file);
+    return address;
+#else
+    const int fd = open(file_name, O_RDONLY);
+    if (fd == -1) {
+        return nullptr;
+    }
+    struct stat st;
+    void *address = nullptr;
+    if (fstat(fd, &st) == 0 && st.st_size != 0) {
+        address = mmap(nullptr, size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            address = nullptr;
+        } else {
+            // Start reading it all in now, the meshes are going to be uploaded right after
+            madvise(address, size_t(st.st_size), MADV_WILLNEED);
+        }
+        size_out = size_t(st.st_size);
+    }
+    close(fd);
+    return address;
+#endif
+}
+
+static void unmap_file(void *address, size_t size) {
+#if defined(WIN32)
+    (void)size;
+    UnmapViewOfFile(address);
+#else
+    munmap(address, size);
+#endif
+}
+
+void unmap_cooked_model(Model &m) {
+    for (MeshData &md : m._mesh_array) {
+        md.buffer = nullptr;
+    }
+    unmap_file(m._mapped_file, m._mapped_size);
+    m._mapped_file = nullptr;
+    m._mapped_size = 0;
+}
+
+bool load_cooked(Model &m, const char *file_name) {
+    CHECK_F(num_meshes(m) == 0 && m._mapped_file == nullptr, "Model already loaded");
+
+    size_t file_size = 0;
+    u8 *file = (u8 *)map_file(file_name, file_size);
+    if (file == nullptr) {
+        LOG_F(ERROR, "Could not map cooked model file %s", file_name);
+        return false;
+    }
+
+    CookedModelHeader header;
+    memcpy(&header, file, std::min(sizeof(header), file_size));
+    if (file_size < sizeof(header) || header.magic != k_cooked_model_magic ||
+        header.version != k_cooked_model_version) {
+        LOG_F(ERROR, "%s is not a cooked model file of version %u", file_name, k_cooked_model_version);
+        unmap_file(file, file_size);
+        return false;
+    }
+
+    const CookedMeshEntry *entries = (const CookedMeshEntry *)(file + sizeof(CookedModelHeader));
+    bool ok = sizeof(CookedModelHeader) + u64(header.num_meshes) * sizeof(CookedMeshEntry) <= file_size;
+    for (u32 i = 0; ok && i < header.num_meshes; ++i) {
+        ok = entries[i].buffer_offset % k_cooked_buffer_alignment == 0 &&
+             entries[i].buffer_size == mesh_buffer_size(entries[i].o) &&
+             entries[i].buffer_offset + entries[i].buffer_size <= file_size;
+    }
+    if (!ok) {
+        LOG_F(ERROR, "Cooked model file %s is truncated or corrupt", file_name);
+        unmap_file(file, file_size);
+        return false;
+    }
+
+    resize(m._mesh_array, header.num_meshes);
+    for (u32 i = 0; i < header.num_meshes; ++i) {
+        MeshData &md = m._mesh_array[i];
+        md.o = entries[i].o;
+        md.buffer = file + entries[i].buffer_offset;
+        md.positions_are_2d = entries[i].positions_are_2d != 0;
+    }
+    m._mapped_file = file;
+    m._mapped_size = file_size;
+
+    LOG_F(INFO, "Cooked model file mapped: %s, meshes=%u", file_name, header.num_meshes);
+    return true;
+}
+
+} // namespace mesh
+
+} // namespace eng
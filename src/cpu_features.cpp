@@ -0,0 +1,139 @@
+#include <learnogl/cpu_features.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <utility>
+
+#if defined(_MSC_VER)
+#    include <immintrin.h>
+#    include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#    include <cpuid.h>
+#endif
+
+namespace eng {
+
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#    if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, (int)leaf, (int)subleaf);
+    memcpy(regs, r, sizeof(r));
+#    else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#    endif
+}
+
+// Reads XCR0, the set of register states the OS saves on context switches.
+static uint64_t read_xcr0() {
+#    if defined(_MSC_VER)
+    return _xgetbv(0);
+#    else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+#    endif
+}
+
+static CpuFeatures detect_cpu_features() {
+    CpuFeatures f;
+
+    uint32_t regs[4]; // eax, ebx, ecx, edx
+    cpuid(0, 0, regs);
+    const uint32_t max_leaf = regs[0];
+
+    if (max_leaf < 1) {
+        return f;
+    }
+
+    cpuid(1, 0, regs);
+    const uint32_t ecx1 = regs[2];
+
+    f.sse41 = ecx1 & (1u << 19);
+    f.sse42 = ecx1 & (1u << 20);
+
+    // AVX and the extensions that use ymm registers are only usable if the OS has enabled xsave and saves the
+    // xmm and ymm state.
+    const bool osxsave = ecx1 & (1u << 27);
+    const uint64_t xcr0 = osxsave ? read_xcr0() : 0;
+    const bool ymm_state = (xcr0 & 0x6) == 0x6;
+    const bool zmm_state = (xcr0 & 0xe6) == 0xe6;
+
+    if (!ymm_state) {
+        return f;
+    }
+
+    f.avx = ecx1 & (1u << 28);
+    f.fma = f.avx && (ecx1 & (1u << 12));
+    f.f16c = f.avx && (ecx1 & (1u << 29));
+
+    if (max_leaf >= 7) {
+        cpuid(7, 0, regs);
+        const uint32_t ebx7 = regs[1];
+        f.avx2 = f.avx && (ebx7 & (1u << 5));
+        f.avx512f = zmm_state && (ebx7 & (1u << 16));
+        f.avx512vl = f.avx512f && (ebx7 & (1u << 31));
+    }
+
+    return f;
+}
+
+#else
+
+static CpuFeatures detect_cpu_features() { return CpuFeatures{}; }
+
+#endif
+
+// Turns off everything above the level named by LOGL_SIMD_LEVEL, so the slower kernels can be tested and
+// benchmarked on a machine that has the faster ones.
+static CpuFeatures apply_simd_level_cap(CpuFeatures f) {
+    const char *level = getenv("LOGL_SIMD_LEVEL");
+    if (!level) {
+        return f;
+    }
+
+    if (strcmp(level, "sse4.1") == 0) {
+        f.sse42 = f.avx = f.avx2 = f.fma = f.f16c = false;
+        f.avx512f = f.avx512vl = false;
+    } else if (strcmp(level, "avx2") == 0) {
+        f.avx512f = f.avx512vl = false;
+    }
+    return f;
+}
+
+const CpuFeatures &cpu_features() {
+    static const CpuFeatures features = apply_simd_level_cap(detect_cpu_features());
+    return features;
+}
+
+const char *cpu_features_string() {
+    static const auto description = [] {
+        struct {
+            char buffer[128] = {};
+        } d;
+
+        const CpuFeatures &f = cpu_features();
+        const std::pair<bool, const char *> names[] = {
+            { f.sse41, "sse4.1" }, { f.sse42, "sse4.2" },   { f.avx, "avx" },
+            { f.avx2, "avx2" },    { f.fma, "fma" },        { f.f16c, "f16c" },
+            { f.avx512f, "avx512f" }, { f.avx512vl, "avx512vl" },
+        };
+
+        for (const auto &name : names) {
+            if (!name.first) {
+                continue;
+            }
+            if (d.buffer[0] != '\0') {
+                strcat(d.buffer, " ");
+            }
+            strcat(d.buffer, name.second);
+        }
+        return d;
+    }();
+
+    return description.buffer;
+}
+
+} // namespace eng
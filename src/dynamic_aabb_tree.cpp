@@ -0,0 +1,443 @@
+#include <learnogl/dynamic_aabb_tree.h>
+#include <scaffold/debug.h>
+
+#include <algorithm>
+
+using namespace fo;
+using namespace eng::math;
+
+namespace eng {
+
+namespace {
+
+// move_proxies rebuilds the tree instead of reinserting the proxies that left their fat boxes when more than
+// 1 / k_rebuild_moved_fraction of all the proxies did.
+constexpr u32 k_rebuild_moved_fraction = 2;
+
+// A fat box is made again when the object's box has shrunk so that the fat box is bigger than the object's box
+// grown by this many margins, so that the fat box of an object that stopped after moving fast doesn't stay large.
+constexpr float k_huge_margins = 4.0f;
+
+inline AABB union_of(const AABB &a, const AABB &b) {
+    return AABB{ Vector3{ std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z) },
+                 Vector3{ std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z) } };
+}
+
+inline bool contains(const AABB &outer, const AABB &inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+           inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+}
+
+inline AABB grown(const AABB &box, float by) {
+    return AABB{ box.min - Vector3{ by, by, by }, box.max + Vector3{ by, by, by } };
+}
+
+// Half the surface area. What inserting a leaf minimizes.
+inline float half_area(const AABB &box) {
+    const Vector3 d = box.max - box.min;
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+inline AABB fattened(const DynamicAABBTree &tree, const AABB &box, const Vector3 &displacement) {
+    AABB fat = grown(box, tree.margin);
+    const Vector3 d = displacement * tree.displacement_multiplier;
+    fat.min = fat.min + Vector3{ std::min(d.x, 0.0f), std::min(d.y, 0.0f), std::min(d.z, 0.0f) };
+    fat.max = fat.max + Vector3{ std::max(d.x, 0.0f), std::max(d.y, 0.0f), std::max(d.z, 0.0f) };
+    return fat;
+}
+
+u32 allocate_node(DynamicAABBTree &tree) {
+    u32 id;
+    if (tree.free_list != k_null_proxy) {
+        id = tree.free_list;
+        tree.free_list = tree.nodes[id].parent;
+    } else {
+        id = size(tree.nodes);
+        push_back(tree.nodes, DynamicAABBTreeNode{});
+    }
+
+    DynamicAABBTreeNode &node = tree.nodes[id];
+    node.user_data = 0;
+    node.parent = k_null_proxy;
+    node.child_1 = k_null_proxy;
+    node.child_2 = k_null_proxy;
+    node.height = 0;
+    node.moved = false;
+    return id;
+}
+
+void free_node(DynamicAABBTree &tree, u32 id) {
+    DynamicAABBTreeNode &node = tree.nodes[id];
+    node.parent = tree.free_list;
+    node.height = -1;
+    node.moved = false;
+    tree.free_list = id;
+}
+
+void refit(DynamicAABBTree &tree, u32 id) {
+    DynamicAABBTreeNode &node = tree.nodes[id];
+    const DynamicAABBTreeNode &child_1 = tree.nodes[node.child_1];
+    const DynamicAABBTreeNode &child_2 = tree.nodes[node.child_2];
+    node.box = union_of(child_1.box, child_2.box);
+    node.height = 1 + std::max(child_1.height, child_2.height);
+}
+
+// If either child of node A is taller than the other by more than 1, rotates the taller one, C, up into A's place
+// and A down under it. A keeps its other child B, and gets the shorter of C's children in place of C:
+//
+//     A(B, C(F, G))  =>  C(A(B, G), F), with F the taller of F and G
+//
+// Returns the node now in A's place.
+u32 balance(DynamicAABBTree &tree, u32 a) {
+    DynamicAABBTreeNode &node_a = tree.nodes[a];
+    if (node_a.is_leaf() || node_a.height < 2) {
+        return a;
+    }
+
+    const int32_t imbalance = tree.nodes[node_a.child_2].height - tree.nodes[node_a.child_1].height;
+    if (imbalance >= -1 && imbalance <= 1) {
+        return a;
+    }
+
+    // Which child of A gets rotated up
+    uint32_t &a_to_c = imbalance > 0 ? node_a.child_2 : node_a.child_1;
+    const u32 c = a_to_c;
+    DynamicAABBTreeNode &node_c = tree.nodes[c];
+
+    // Swap A and C
+    node_c.parent = node_a.parent;
+    node_a.parent = c;
+    if (node_c.parent == k_null_proxy) {
+        tree.root = c;
+    } else {
+        DynamicAABBTreeNode &parent = tree.nodes[node_c.parent];
+        (parent.child_1 == a ? parent.child_1 : parent.child_2) = c;
+    }
+
+    // The taller of C's children stays with C, the other goes to A
+    u32 f = node_c.child_1;
+    u32 g = node_c.child_2;
+    if (tree.nodes[f].height < tree.nodes[g].height) {
+        std::swap(f, g);
+    }
+    node_c.child_1 = a;
+    node_c.child_2 = f;
+    a_to_c = g;
+    tree.nodes[g].parent = a;
+
+    refit(tree, a);
+    refit(tree, c);
+    return c;
+}
+
+// Refits and balances the nodes from `id` up to the root
+void fix_upwards(DynamicAABBTree &tree, u32 id) {
+    while (id != k_null_proxy) {
+        id = balance(tree, id);
+        refit(tree, id);
+        id = tree.nodes[id].parent;
+    }
+}
+
+// Finds where to put the leaf by going down from the root towards the sibling that adds the least area to the
+// tree, counting what making the new parent grows each ancestor by. Stops at a node when pairing the leaf with it
+// costs less than the least that going further down could.
+u32 find_sibling(const DynamicAABBTree &tree, const AABB &leaf_box) {
+    const float leaf_area = half_area(leaf_box);
+    u32 id = tree.root;
+
+    while (!tree.nodes[id].is_leaf()) {
+        const DynamicAABBTreeNode &node = tree.nodes[id];
+        const float area = half_area(node.box);
+        const float combined_area = half_area(union_of(node.box, leaf_box));
+
+        // Cost of a new parent of this node and the leaf, and the cost the ancestors of the children below get
+        // from growing this node.
+        const float cost = 2.0f * combined_area;
+        const float inherited_cost = 2.0f * (combined_area - area);
+
+        const auto descend_cost = [&](u32 child_id) {
+            const DynamicAABBTreeNode &child = tree.nodes[child_id];
+            const float new_area = half_area(union_of(child.box, leaf_box));
+            if (child.is_leaf()) {
+                return new_area + inherited_cost;
+            }
+            // Lower bound on the cost under an interior child
+            return std::max(new_area - half_area(child.box), leaf_area) + inherited_cost;
+        };
+
+        const float cost_1 = descend_cost(node.child_1);
+        const float cost_2 = descend_cost(node.child_2);
+        if (cost < cost_1 && cost < cost_2) {
+            break;
+        }
+        id = cost_1 <= cost_2 ? node.child_1 : node.child_2;
+    }
+    return id;
+}
+
+void insert_leaf(DynamicAABBTree &tree, u32 leaf) {
+    if (tree.root == k_null_proxy) {
+        tree.root = leaf;
+        tree.nodes[leaf].parent = k_null_proxy;
+        return;
+    }
+
+    const u32 sibling = find_sibling(tree, tree.nodes[leaf].box);
+    const u32 old_parent = tree.nodes[sibling].parent;
+    const u32 new_parent = allocate_node(tree);
+
+    DynamicAABBTreeNode &parent = tree.nodes[new_parent];
+    parent.parent = old_parent;
+    parent.child_1 = sibling;
+    parent.child_2 = leaf;
+    tree.nodes[sibling].parent = new_parent;
+    tree.nodes[leaf].parent = new_parent;
+
+    if (old_parent == k_null_proxy) {
+        tree.root = new_parent;
+    } else {
+        DynamicAABBTreeNode &grandparent = tree.nodes[old_parent];
+        (grandparent.child_1 == sibling ? grandparent.child_1 : grandparent.child_2) = new_parent;
+    }
+
+    fix_upwards(tree, new_parent);
+    CHECK_F(height(tree) < (int32_t)k_dynamic_aabb_tree_max_height, "Dynamic AABB tree too deep");
+}
+
+// Takes the leaf out of the tree, replacing its parent with its sibling
+void remove_leaf(DynamicAABBTree &tree, u32 leaf) {
+    if (leaf == tree.root) {
+        tree.root = k_null_proxy;
+        return;
+    }
+
+    const u32 parent = tree.nodes[leaf].parent;
+    const u32 grandparent = tree.nodes[parent].parent;
+    const u32 sibling =
+        tree.nodes[parent].child_1 == leaf ? tree.nodes[parent].child_2 : tree.nodes[parent].child_1;
+
+    tree.nodes[sibling].parent = grandparent;
+    free_node(tree, parent);
+
+    if (grandparent == k_null_proxy) {
+        tree.root = sibling;
+    } else {
+        DynamicAABBTreeNode &node = tree.nodes[grandparent];
+        (node.child_1 == parent ? node.child_1 : node.child_2) = sibling;
+        fix_upwards(tree, grandparent);
+    }
+}
+
+void mark_moved(DynamicAABBTree &tree, u32 proxy) {
+    if (!tree.nodes[proxy].moved) {
+        tree.nodes[proxy].moved = true;
+        push_back(tree.move_buffer, proxy);
+    }
+}
+
+inline Vector3 center(const AABB &box) { return (box.min + box.max) * 0.5f; }
+
+// Builds a subtree over leaves[0, count) by splitting them in halves at the median center along the longest axis
+// of the centers' bounds. Returns its root.
+u32 build_top_down(DynamicAABBTree &tree, u32 *leaves, u32 count) {
+    if (count == 1) {
+        return leaves[0];
+    }
+
+    AABB center_bounds{ center(tree.nodes[leaves[0]].box), center(tree.nodes[leaves[0]].box) };
+    for (u32 i = 1; i < count; ++i) {
+        const Vector3 c = center(tree.nodes[leaves[i]].box);
+        center_bounds = union_of(center_bounds, AABB{ c, c });
+    }
+    const Vector3 extent = center_bounds.max - center_bounds.min;
+    const u32 axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+    const u32 half = count / 2;
+    std::nth_element(leaves, leaves + half, leaves + count, [&tree, axis](u32 a, u32 b) {
+        const AABB &box_a = tree.nodes[a].box;
+        const AABB &box_b = tree.nodes[b].box;
+        return (&box_a.min.x)[axis] + (&box_a.max.x)[axis] < (&box_b.min.x)[axis] + (&box_b.max.x)[axis];
+    });
+
+    const u32 child_1 = build_top_down(tree, leaves, half);
+    const u32 child_2 = build_top_down(tree, leaves + half, count - half);
+
+    const u32 id = allocate_node(tree);
+    DynamicAABBTreeNode &node = tree.nodes[id];
+    node.child_1 = child_1;
+    node.child_2 = child_2;
+    tree.nodes[child_1].parent = id;
+    tree.nodes[child_2].parent = id;
+    refit(tree, id);
+    return id;
+}
+
+} // namespace
+
+uint32_t create_proxy(DynamicAABBTree &tree, const AABB &box, uint64_t user_data) {
+    const u32 proxy = allocate_node(tree);
+    tree.nodes[proxy].box = grown(box, tree.margin);
+    tree.nodes[proxy].user_data = user_data;
+    insert_leaf(tree, proxy);
+    mark_moved(tree, proxy);
+    ++tree.num_proxies;
+    return proxy;
+}
+
+void destroy_proxy(DynamicAABBTree &tree, uint32_t proxy) {
+    DCHECK_F(proxy < size(tree.nodes) && tree.nodes[proxy].is_leaf() && tree.nodes[proxy].height == 0,
+             "Not a proxy: %u",
+             proxy);
+    remove_leaf(tree, proxy);
+    free_node(tree, proxy);
+    --tree.num_proxies;
+}
+
+bool move_proxy(DynamicAABBTree &tree, uint32_t proxy, const AABB &box, const Vector3 &displacement) {
+    DCHECK_F(proxy < size(tree.nodes) && tree.nodes[proxy].is_leaf() && tree.nodes[proxy].height == 0,
+             "Not a proxy: %u",
+             proxy);
+
+    const AABB &old_fat_box = tree.nodes[proxy].box;
+    const AABB fat_box = fattened(tree, box, displacement);
+    if (contains(old_fat_box, box) && contains(grown(fat_box, k_huge_margins * tree.margin), old_fat_box)) {
+        return false;
+    }
+
+    remove_leaf(tree, proxy);
+    tree.nodes[proxy].box = fat_box;
+    insert_leaf(tree, proxy);
+    mark_moved(tree, proxy);
+    return true;
+}
+
+void create_proxies(
+    DynamicAABBTree &tree, const AABB *boxes, const uint64_t *user_data, uint32_t count, uint32_t *proxies_out) {
+    if (tree.root != k_null_proxy || count < 2) {
+        for (u32 i = 0; i < count; ++i) {
+            proxies_out[i] = create_proxy(tree, boxes[i], user_data[i]);
+        }
+        return;
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        const u32 proxy = allocate_node(tree);
+        tree.nodes[proxy].box = grown(boxes[i], tree.margin);
+        tree.nodes[proxy].user_data = user_data[i];
+        mark_moved(tree, proxy);
+        proxies_out[i] = proxy;
+    }
+    tree.num_proxies = count;
+
+    Array<u32> leaves(memory_globals::default_allocator());
+    resize(leaves, count);
+    std::copy(proxies_out, proxies_out + count, data(leaves));
+    tree.root = build_top_down(tree, data(leaves), count);
+    tree.nodes[tree.root].parent = k_null_proxy;
+}
+
+void destroy_proxies(DynamicAABBTree &tree, const uint32_t *proxies, uint32_t count) {
+    for (u32 i = 0; i < count; ++i) {
+        destroy_proxy(tree, proxies[i]);
+    }
+}
+
+uint32_t move_proxies(DynamicAABBTree &tree,
+                      const uint32_t *proxies,
+                      const AABB *boxes,
+                      const Vector3 *displacements,
+                      uint32_t count) {
+    // Find the ones that need a new fat box first. If that's most of the tree, rebuilding it is cheaper than
+    // reinserting them, and gives a better tree.
+    Array<u32> reinserted(memory_globals::default_allocator());
+    Array<AABB> fat_boxes(memory_globals::default_allocator());
+    reserve(reinserted, count);
+    reserve(fat_boxes, count);
+    for (u32 i = 0; i < count; ++i) {
+        const AABB &old_fat_box = tree.nodes[proxies[i]].box;
+        const AABB fat_box =
+            fattened(tree, boxes[i], displacements ? displacements[i] : Vector3{ 0.0f, 0.0f, 0.0f });
+        if (!contains(old_fat_box, boxes[i]) ||
+            !contains(grown(fat_box, k_huge_margins * tree.margin), old_fat_box)) {
+            push_back(reinserted, proxies[i]);
+            push_back(fat_boxes, fat_box);
+        }
+    }
+
+    const u32 num_reinserted = size(reinserted);
+    const bool rebuilding = num_reinserted * k_rebuild_moved_fraction > tree.num_proxies;
+
+    for (u32 i = 0; i < num_reinserted; ++i) {
+        const u32 proxy = reinserted[i];
+        if (rebuilding) {
+            tree.nodes[proxy].box = fat_boxes[i];
+        } else {
+            remove_leaf(tree, proxy);
+            tree.nodes[proxy].box = fat_boxes[i];
+            insert_leaf(tree, proxy);
+        }
+        mark_moved(tree, proxy);
+    }
+
+    if (rebuilding) {
+        rebuild(tree);
+    }
+    return num_reinserted;
+}
+
+void rebuild(DynamicAABBTree &tree) {
+    if (tree.num_proxies < 2) {
+        return;
+    }
+
+    // Free the interior nodes, keep the leaves
+    Array<u32> leaves(memory_globals::default_allocator());
+    reserve(leaves, tree.num_proxies);
+    for (u32 id = 0; id < size(tree.nodes); ++id) {
+        DynamicAABBTreeNode &node = tree.nodes[id];
+        if (node.height < 0) {
+            continue;
+        }
+        if (node.is_leaf()) {
+            push_back(leaves, id);
+        } else {
+            free_node(tree, id);
+        }
+    }
+
+    tree.root = build_top_down(tree, data(leaves), size(leaves));
+    tree.nodes[tree.root].parent = k_null_proxy;
+}
+
+void update_pairs(DynamicAABBTree &tree, Array<ProxyPair> &pairs_out) {
+    clear(pairs_out);
+
+    for (const u32 proxy : tree.move_buffer) {
+        // Destroyed since it moved
+        if (!tree.nodes[proxy].moved) {
+            continue;
+        }
+
+        query(tree, tree.nodes[proxy].box, [&](u32 other) {
+            // Pairs of two proxies that moved are found from both sides, keep the one from the lower id
+            if (other == proxy || (tree.nodes[other].moved && other < proxy)) {
+                return true;
+            }
+            push_back(pairs_out, ProxyPair{ std::min(proxy, other), std::max(proxy, other) });
+            return true;
+        });
+    }
+
+    for (const u32 proxy : tree.move_buffer) {
+        tree.nodes[proxy].moved = false;
+    }
+    clear(tree.move_buffer);
+
+    const auto less = [](const ProxyPair &x, const ProxyPair &y) { return x.a < y.a || (x.a == y.a && x.b < y.b); };
+    const auto equal = [](const ProxyPair &x, const ProxyPair &y) { return x.a == y.a && x.b == y.b; };
+    std::sort(begin(pairs_out), end(pairs_out), less);
+    resize(pairs_out, u32(std::unique(begin(pairs_out), end(pairs_out), equal) - begin(pairs_out)));
+}
+
+} // namespace eng
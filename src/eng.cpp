@@ -101,8 +101,8 @@ static void init_caps() {
 
 namespace eng {
 
-GLApp::GLApp(u32 scene_tree_node_pool_size)
-    : scene_tree(scene_tree_node_pool_size) {}
+GLApp::GLApp(u32 scene_tree_initial_capacity)
+    : scene_tree(scene_tree_initial_capacity) {}
 
 std::aligned_storage_t<sizeof(GLApp)> _gl_storage[1];
 
@@ -568,6 +568,9 @@ bool handle_eye_input_from_callback(GLFWwindow *window,
     return moved;
 }
 
+// The shape meshes copy par_shapes' triangles as they are, as u16 indices
+static_assert(sizeof(PAR_SHAPES_T) == sizeof(mesh::IndexType), "par_shapes index type");
+
 static inline void shift_par_cube(par_shapes_mesh *cube) {
     for (int i = 0; i < cube->npoints; ++i) {
         cube->points[i * 3] -= 0.5f;
@@ -675,7 +678,7 @@ void load_cube_mesh(mesh::Model &m,
         }
     }
 
-    memcpy((void *)mesh::indices_begin(md), (void *)p->triangles, md.o.num_faces * 3 * sizeof(u16));
+    memcpy(md.buffer + md.o.get_indices_byte_offset(), p->triangles, md.o.get_indices_size_in_bytes());
 }
 
 void load_sphere_mesh(mesh::Model &m, int slices, int stacks, const fo::Matrix4x4 &transform) {
@@ -729,7 +732,7 @@ void load_sphere_mesh(mesh::Model &m, int slices, int stacks, const fo::Matrix4x
         attr->st.y = p->tcoords[i * 2 + 1];
     }
 
-    memcpy((void *)mesh::indices_begin(md), p->triangles, md.o.num_faces * 3 * sizeof(u16));
+    memcpy(md.buffer + md.o.get_indices_byte_offset(), p->triangles, md.o.get_indices_size_in_bytes());
 }
 
 void load_plane_mesh(mesh::Model &m, const fo::Matrix4x4 &transform) {
@@ -1,33 +1,87 @@
-// Culling against the viewing frustum
+#include "math_kernels.h"
 
+#include <learnogl/frustum.h>
 #include <learnogl/math_ops.h>
 
-struct FrustumPlanes {
-    Vector4 front; // Near
-    Vector4 back;  // Far
-    Vector4 right;
-    Vector4 left;
-    Vector4 top;
-    Vector4 bottom;
+using namespace fo;
+using namespace eng::math;
 
-    void init_from_projection_matrix(const fo::Matrix4x4 &proj_mat);
-};
+namespace eng {
 
+// The kernels take spheres as <center, radius> Vector4s
+static_assert(sizeof(BoundingSphere) == sizeof(Vector4), "");
 
-// Implementation
+void FrustumPlanes::init_from_projection_matrix(const Matrix4x4 &clip_from_x) {
+    const auto row_0 = mat4_row(clip_from_x, 0);
+    const auto row_1 = mat4_row(clip_from_x, 1);
+    const auto row_2 = mat4_row(clip_from_x, 2);
+    const auto row_3 = mat4_row(clip_from_x, 3);
 
-using namespace fo;
+    planes[LEFT] = row_3 + row_0;
+    planes[RIGHT] = row_3 - row_0;
+    planes[BOTTOM] = row_3 + row_1;
+    planes[TOP] = row_3 - row_1;
+    planes[NEAR_PLANE] = row_3 + row_2;
+    planes[FAR_PLANE] = row_3 - row_2;
+
+    // Unit normals, so the plane equation gives distances to compare radii with
+    for (Vector4 &plane : planes) {
+        plane = plane / magnitude(Vector3(plane));
+    }
+}
+
+void frustum_cull(const FrustumPlanes &frustum,
+                  const BoundingSphere *spheres,
+                  uint32_t num_spheres,
+                  uint8_t *visible_bits,
+                  uint8_t *plane_cache) {
+    kernels::cull_kernels().spheres(
+        frustum.planes, reinterpret_cast<const Vector4 *>(spheres), num_spheres, visible_bits, plane_cache);
+}
+
+void frustum_cull(const FrustumPlanes &frustum,
+                  const AABB *boxes,
+                  uint32_t num_boxes,
+                  uint8_t *visible_bits,
+                  uint8_t *plane_cache) {
+    kernels::cull_kernels().aabbs(frustum.planes, boxes, num_boxes, visible_bits, plane_cache);
+}
+
+void frustum_cull(const FrustumPlanes &frustum,
+                  const BoundingSphereArrays &spheres,
+                  uint32_t num_spheres,
+                  uint8_t *visible_bits,
+                  uint8_t *plane_cache) {
+    kernels::cull_kernels().sphere_arrays(
+        frustum.planes, spheres.center, spheres.radius, num_spheres, visible_bits, plane_cache);
+}
 
-FrustumPlanes::init_from_projection_matrix(const Matrix4x4 &proj_mat) {
-    const auto row_0 = mat4_row(proj_mat, 0);
-    const auto row_1 = mat4_row(proj_mat, 1);
-    const auto row_2 = mat4_row(proj_mat, 2);
-    const auto row_3 = mat4_row(proj_mat, 3);
-
-    front = row_3 + row_2;
-    back = row_3 - row_2;
-    left = row_3 + row_0;
-    right = row_3 - row_0;
-    bottom = row_3 + row_1;
-    top = row_3 - row_1;
+void frustum_cull(const FrustumPlanes &frustum,
+                  const AABBArrays &boxes,
+                  uint32_t num_boxes,
+                  uint8_t *visible_bits,
+                  uint8_t *plane_cache) {
+    kernels::cull_kernels().aabb_arrays(frustum.planes, boxes.min, boxes.max, num_boxes, visible_bits, plane_cache);
 }
+
+uint32_t compact_visible_indices(const uint8_t *visible_bits, uint32_t num_objects, uint32_t *indices_out) {
+    // Most of a big scene is usually culled, so whole bytes of zeros are skipped. Within a byte every index is
+    // stored and only the visible ones are kept, which doesn't branch on the bits. The store is at num_visible <= i,
+    // so it stays within the array.
+    uint32_t num_visible = 0;
+    for (uint32_t i = 0; i < num_objects; i += 8) {
+        const uint32_t bits = visible_bits[i / 8];
+        if (bits == 0) {
+            continue;
+        }
+
+        const uint32_t n = num_objects - i < 8 ? num_objects - i : 8;
+        for (uint32_t k = 0; k < n; ++k) {
+            indices_out[num_visible] = i + k;
+            num_visible += (bits >> k) & 1u;
+        }
+    }
+    return num_visible;
+}
+
+} // namespace eng
@@ -0,0 +1,800 @@
+// Implementations of the kernels declared in math_kernels.h
+
+#include "math_kernels.h"
+
+#include <learnogl/cpu_features.h>
+
+#include <algorithm>
+
+using namespace fo;
+
+namespace eng {
+namespace math {
+namespace kernels {
+
+#include "math_kernels_soa.inc.h"
+
+// -- Scalar
+
+void transform_points_scalar(
+    const Matrix4x4 &m, const Vector3 *src, u32 src_stride, Vector3 *dst, u32 dst_stride, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        *dst = transform_point(m, *src);
+        src = advance_bytes(src, src_stride);
+        dst = advance_bytes(dst, dst_stride);
+    }
+}
+
+void transform_vectors_scalar(
+    const Matrix4x4 &m, const Vector3 *src, u32 src_stride, Vector3 *dst, u32 dst_stride, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        *dst = transform_vector(m, *src);
+        src = advance_bytes(src, src_stride);
+        dst = advance_bytes(dst, dst_stride);
+    }
+}
+
+void transform_normals_scalar(
+    const Matrix4x4 &normal_mat, const Vector3 *src, u32 src_stride, Vector3 *dst, u32 dst_stride, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        *dst = normalize(transform_vector(normal_mat, *src));
+        src = advance_bytes(src, src_stride);
+        dst = advance_bytes(dst, dst_stride);
+    }
+}
+
+void inverse_n_scalar(const Matrix4x4 *src, Matrix4x4 *dst, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        dst[i] = inverse(src[i]);
+    }
+}
+
+void inverse_rotation_translation_n_scalar(const Matrix4x4 *src, Matrix4x4 *dst, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        dst[i] = inverse_rotation_translation(src[i]);
+    }
+}
+
+void mul_mat_mat_n_scalar(const Matrix4x4 *a, const Matrix4x4 *b, Matrix4x4 *dst, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        dst[i] = mul_mat_mat(a[i], b[i]);
+    }
+}
+
+void eigensolve_sym3x3_n_scalar(const Matrix3x3 *symm, SymmetricEigenSolver3x3_Result *out, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        eigensolve_sym3x3(symm[i], out[i]);
+    }
+}
+
+void normalize_n_scalar(const Quaternion *src, Quaternion *dst, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        dst[i] = normalize(src[i]);
+    }
+}
+
+void nlerp_n_scalar(
+    const Quaternion *a, const Quaternion *b, const float *alphas, u32 alpha_step, Quaternion *dst, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        const Quaternion &q = b[i];
+        const float sign = a[i].x * q.x + a[i].y * q.y + a[i].z * q.z + a[i].w * q.w < 0.0f ? -1.0f : 1.0f;
+        dst[i] = nlerp(a[i], Vector4{ sign * q.x, sign * q.y, sign * q.z, sign * q.w }, alphas[i * alpha_step]);
+    }
+}
+
+void slerp_n_scalar(
+    const Quaternion *a, const Quaternion *b, const float *alphas, u32 alpha_step, Quaternion *dst, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        dst[i] = slerp(a[i], b[i], alphas[i * alpha_step]);
+    }
+}
+
+void matrix_from_versor_n_scalar(const Quaternion *src, Matrix4x4 *dst, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        dst[i] = matrix_from_versor(src[i]);
+    }
+}
+
+void slerp_local_transforms_scalar(const LocalTransform *a,
+                                   const LocalTransform *b,
+                                   const float *alphas,
+                                   u32 alpha_step,
+                                   LocalTransform *dst,
+                                   u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        const float alpha = alphas[i * alpha_step];
+        dst[i] = LocalTransform(lerp(a[i].scale, b[i].scale, alpha),
+                                slerp(a[i].orientation, b[i].orientation, alpha),
+                                lerp(a[i].position, b[i].position, alpha));
+    }
+}
+
+void matrix_from_local_transform_n_scalar(const LocalTransform *src, Matrix4x4 *dst, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        dst[i] = src[i].get_mat4();
+    }
+}
+
+// Calls convert(number) on the components of each element
+template <typename Src, typename Dst, typename Convert>
+static void convert_attributes_scalar(
+    const Src *src, u32 src_stride, Dst *dst, u32 dst_stride, u32 count, u32 components, Convert convert) {
+    for (u32 i = 0; i < count; ++i) {
+        for (u32 c = 0; c < components; ++c) {
+            dst[c] = convert(src[c]);
+        }
+        src = advance_bytes(src, src_stride);
+        dst = advance_bytes(dst, dst_stride);
+    }
+}
+
+void f32_to_f16_scalar(const float *src, u32 src_stride, u16 *dst, u32 dst_stride, u32 count, u32 components) {
+    convert_attributes_scalar(
+        src, src_stride, dst, dst_stride, count, components, [](float f) { return f32_to_f16(f); });
+}
+
+void f16_to_f32_scalar(const u16 *src, u32 src_stride, float *dst, u32 dst_stride, u32 count, u32 components) {
+    convert_attributes_scalar(
+        src, src_stride, dst, dst_stride, count, components, [](u16 h) { return f16_to_f32(h); });
+}
+
+void f32_to_snorm16_scalar(const float *src, u32 src_stride, i16 *dst, u32 dst_stride, u32 count, u32 components) {
+    convert_attributes_scalar(
+        src, src_stride, dst, dst_stride, count, components, [](float f) { return f32_to_snorm16(f); });
+}
+
+void f32_to_unorm8_scalar(const float *src, u32 src_stride, u8 *dst, u32 dst_stride, u32 count, u32 components) {
+    convert_attributes_scalar(
+        src, src_stride, dst, dst_stride, count, components, [](float f) { return f32_to_unorm8(f); });
+}
+
+void encode_octahedral_scalar(const Vector3 *src, u32 src_stride, i16 *dst, u32 dst_stride, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        encode_octahedral_snorm16(*src, dst);
+        src = advance_bytes(src, src_stride);
+        dst = advance_bytes(dst, dst_stride);
+    }
+}
+
+void decode_octahedral_scalar(const i16 *src, u32 src_stride, Vector3 *dst, u32 dst_stride, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        *dst = decode_octahedral_snorm16(src);
+        src = advance_bytes(src, src_stride);
+        dst = advance_bytes(dst, dst_stride);
+    }
+}
+
+void bounds_scalar(const Vector3 *points, u32 stride, u32 count, Vector3 &min_out, Vector3 &max_out) {
+    Vector3 mn = *points;
+    Vector3 mx = *points;
+    for (u32 i = 1; i < count; ++i) {
+        points = advance_bytes(points, stride);
+        mn = Vector3{ std::min(mn.x, points->x), std::min(mn.y, points->y), std::min(mn.z, points->z) };
+        mx = Vector3{ std::max(mx.x, points->x), std::max(mx.y, points->y), std::max(mx.z, points->z) };
+    }
+    min_out = mn;
+    max_out = mx;
+}
+
+void sum_scalar(const Vector3 *points, u32 stride, u32 count, double sum_out[3]) {
+    double total[3] = { 0.0, 0.0, 0.0 };
+    for (u32 i = 0; i < count; ++i) {
+        total[0] += points->x;
+        total[1] += points->y;
+        total[2] += points->z;
+        points = advance_bytes(points, stride);
+    }
+    std::copy(total, total + 3, sum_out);
+}
+
+void covariance_scalar(const Vector3 *points, u32 stride, u32 count, const Vector3 &mean, double sums_out[6]) {
+    double total[6] = {};
+    for (u32 i = 0; i < count; ++i) {
+        const double dx = points->x - mean.x;
+        const double dy = points->y - mean.y;
+        const double dz = points->z - mean.z;
+        total[0] += dx * dx;
+        total[1] += dy * dy;
+        total[2] += dz * dz;
+        total[3] += dx * dy;
+        total[4] += dx * dz;
+        total[5] += dy * dz;
+        points = advance_bytes(points, stride);
+    }
+    std::copy(total, total + 6, sums_out);
+}
+
+void extreme_points_scalar(const Vector3 *points,
+                           u32 stride,
+                           u32 count,
+                           const Vector3 *directions,
+                           u32 num_directions,
+                           u32 *min_indices_out,
+                           u32 *max_indices_out) {
+    for (u32 d = 0; d < num_directions; ++d) {
+        const Vector3 &dir = directions[d];
+        const Vector3 *p = points;
+        float max_dot = -INFINITY, min_dot = INFINITY;
+        u32 max_index = 0, min_index = 0;
+        for (u32 i = 0; i < count; ++i) {
+            const float dot = p->x * dir.x + p->y * dir.y + p->z * dir.z;
+            if (dot > max_dot) {
+                max_dot = dot;
+                max_index = i;
+            }
+            if (dot < min_dot) {
+                min_dot = dot;
+                min_index = i;
+            }
+            p = advance_bytes(p, stride);
+        }
+        max_indices_out[d] = max_index;
+        min_indices_out[d] = min_index;
+    }
+}
+
+void farthest_point_scalar(
+    const Vector3 *points, u32 stride, u32 count, const Vector3 &from, u32 &index_out, float &dist2_out) {
+    float max_dist2 = -1.0f;
+    u32 max_index = 0;
+    for (u32 i = 0; i < count; ++i) {
+        const Vector3 d = *points - from;
+        const float dist2 = d.x * d.x + d.y * d.y + d.z * d.z;
+        if (dist2 > max_dist2) {
+            max_dist2 = dist2;
+            max_index = i;
+        }
+        points = advance_bytes(points, stride);
+    }
+    index_out = max_index;
+    dist2_out = max_dist2;
+}
+
+// Sets the bit of each object `visible(i)` is true for, and clears the rest of the bytes
+template <typename VisibleFn> static void store_visible_bits(u32 count, u8 *visible_bits, VisibleFn &&visible) {
+    memset(visible_bits, 0, (count + 7) / 8);
+    for (u32 i = 0; i < count; ++i) {
+        if (visible(i)) {
+            visible_bits[i / 8] |= u8(1u << (i % 8));
+        }
+    }
+}
+
+static bool sphere_visible(const Vector4 *planes, const Vector3 &center, float radius) {
+    for (u32 p = 0; p < 6; ++p) {
+        const Vector4 &plane = planes[p];
+        if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool aabb_visible(const Vector4 *planes, const Vector3 &min, const Vector3 &max) {
+    for (u32 p = 0; p < 6; ++p) {
+        const Vector4 &plane = planes[p];
+        const Vector3 corner{ plane.x > 0.0f ? max.x : min.x,
+                              plane.y > 0.0f ? max.y : min.y,
+                              plane.z > 0.0f ? max.z : min.z };
+        if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void cull_spheres_scalar(const Vector4 *planes, const Vector4 *spheres, u32 count, u8 *visible_bits, u8 *) {
+    store_visible_bits(count, visible_bits, [&](u32 i) {
+        const Vector4 &s = spheres[i];
+        return sphere_visible(planes, Vector3{ s.x, s.y, s.z }, s.w);
+    });
+}
+
+void cull_aabbs_scalar(const Vector4 *planes, const AABB *boxes, u32 count, u8 *visible_bits, u8 *) {
+    store_visible_bits(
+        count, visible_bits, [&](u32 i) { return aabb_visible(planes, boxes[i].min, boxes[i].max); });
+}
+
+void cull_sphere_arrays_scalar(const Vector4 *planes,
+                               const float *const center[3],
+                               const float *radius,
+                               u32 count,
+                               u8 *visible_bits,
+                               u8 *) {
+    store_visible_bits(count, visible_bits, [&](u32 i) {
+        return sphere_visible(planes, Vector3{ center[0][i], center[1][i], center[2][i] }, radius[i]);
+    });
+}
+
+void cull_aabb_arrays_scalar(const Vector4 *planes,
+                             const float *const min[3],
+                             const float *const max[3],
+                             u32 count,
+                             u8 *visible_bits,
+                             u8 *) {
+    store_visible_bits(count, visible_bits, [&](u32 i) {
+        return aabb_visible(
+            planes, Vector3{ min[0][i], min[1][i], min[2][i] }, Vector3{ max[0][i], max[1][i], max[2][i] });
+    });
+}
+
+void rasterize_occluders_scalar(
+    const OccluderTriangle *triangles, u32 count, float *depth, u32 width, u32 row_begin, u32 row_end) {
+    for (u32 t = 0; t < count; ++t) {
+        const OccluderTriangle &tri = triangles[t];
+        const i32 y_begin = std::max(tri.min_y, i32(row_begin));
+        const i32 y_end = std::min(tri.max_y + 1, i32(row_end));
+
+        for (i32 y = y_begin; y < y_end; ++y) {
+            const float py = float(y) + 0.5f;
+            float row_edges[3];
+            for (u32 e = 0; e < 3; ++e) {
+                row_edges[e] = tri.edge_b[e] * py + tri.edge_c[e];
+            }
+            const float row_z = tri.depth_dy * py + tri.depth_c;
+            float *row = depth + size_t(y) * width;
+
+            for (i32 x = tri.min_x; x <= tri.max_x; ++x) {
+                const float px = float(x) + 0.5f;
+                if (tri.edge_a[0] * px + row_edges[0] >= 0.0f && tri.edge_a[1] * px + row_edges[1] >= 0.0f &&
+                    tri.edge_a[2] * px + row_edges[2] >= 0.0f) {
+                    row[x] = std::min(row[x], tri.depth_dx * px + row_z);
+                }
+            }
+        }
+    }
+}
+
+// -- SSE
+
+// The 3x3 part of the matrix and the translation splatted into separate registers. The translation is zero
+// when transforming vectors.
+struct SplattedMatrix {
+    __m128 m00, m01, m02; // Row 0
+    __m128 m10, m11, m12; // Row 1
+    __m128 m20, m21, m22; // Row 2
+    __m128 t0, t1, t2;
+};
+
+template <bool with_translation> REALLY_INLINE SplattedMatrix splat_matrix_sse(const Matrix4x4 &m) {
+    SplattedMatrix s;
+    s.m00 = _mm_set1_ps(m.x.x);
+    s.m01 = _mm_set1_ps(m.y.x);
+    s.m02 = _mm_set1_ps(m.z.x);
+    s.m10 = _mm_set1_ps(m.x.y);
+    s.m11 = _mm_set1_ps(m.y.y);
+    s.m12 = _mm_set1_ps(m.z.y);
+    s.m20 = _mm_set1_ps(m.x.z);
+    s.m21 = _mm_set1_ps(m.y.z);
+    s.m22 = _mm_set1_ps(m.z.z);
+    s.t0 = with_translation ? _mm_set1_ps(m.t.x) : _mm_setzero_ps();
+    s.t1 = with_translation ? _mm_set1_ps(m.t.y) : _mm_setzero_ps();
+    s.t2 = with_translation ? _mm_set1_ps(m.t.z) : _mm_setzero_ps();
+    return s;
+}
+
+template <bool with_translation, bool normalize_result>
+static void transform_sse(
+    const Matrix4x4 &m, const Vector3 *src, u32 src_stride, Vector3 *dst, u32 dst_stride, u32 count) {
+    const auto s = splat_matrix_sse<with_translation>(m);
+
+    for (u32 i = 0; i < count; i += 4) {
+        const u32 n = std::min(count - i, 4u);
+
+        // Transpose up to 4 (x, y, z, 0) into xs, ys, zs. Missing elements are zero.
+        __m128 x = n > 0 ? load_vec3(src) : _mm_setzero_ps();
+        __m128 y = n > 1 ? load_vec3(advance_bytes(src, src_stride)) : _mm_setzero_ps();
+        __m128 z = n > 2 ? load_vec3(advance_bytes(src, 2 * src_stride)) : _mm_setzero_ps();
+        __m128 w = n > 3 ? load_vec3(advance_bytes(src, 3 * src_stride)) : _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+
+        __m128 rx = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(s.m00, x), _mm_mul_ps(s.m01, y)), _mm_add_ps(_mm_mul_ps(s.m02, z), s.t0));
+        __m128 ry = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(s.m10, x), _mm_mul_ps(s.m11, y)), _mm_add_ps(_mm_mul_ps(s.m12, z), s.t1));
+        __m128 rz = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(s.m20, x), _mm_mul_ps(s.m21, y)), _mm_add_ps(_mm_mul_ps(s.m22, z), s.t2));
+
+        if (normalize_result) {
+            __m128 len =
+                _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_mul_ps(rz, rz)));
+            rx = _mm_div_ps(rx, len);
+            ry = _mm_div_ps(ry, len);
+            rz = _mm_div_ps(rz, len);
+        }
+
+        __m128 rw = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(rx, ry, rz, rw);
+
+        store_vec3(dst, rx);
+        if (n > 1) {
+            store_vec3(advance_bytes(dst, dst_stride), ry);
+        }
+        if (n > 2) {
+            store_vec3(advance_bytes(dst, 2 * dst_stride), rz);
+        }
+        if (n > 3) {
+            store_vec3(advance_bytes(dst, 3 * dst_stride), rw);
+        }
+
+        src = advance_bytes(src, 4 * src_stride);
+        dst = advance_bytes(dst, 4 * dst_stride);
+    }
+}
+
+void transform_points_sse(
+    const Matrix4x4 &m, const Vector3 *src, u32 src_stride, Vector3 *dst, u32 dst_stride, u32 count) {
+    transform_sse<true, false>(m, src, src_stride, dst, dst_stride, count);
+}
+
+void transform_vectors_sse(
+    const Matrix4x4 &m, const Vector3 *src, u32 src_stride, Vector3 *dst, u32 dst_stride, u32 count) {
+    transform_sse<false, false>(m, src, src_stride, dst, dst_stride, count);
+}
+
+void transform_normals_sse(
+    const Matrix4x4 &normal_mat, const Vector3 *src, u32 src_stride, Vector3 *dst, u32 dst_stride, u32 count) {
+    transform_sse<false, true>(normal_mat, src, src_stride, dst, dst_stride, count);
+}
+
+void inverse_n_sse(const Matrix4x4 *src, Matrix4x4 *dst, u32 count) {
+    map_matrices_soa<inverse_soa>(src, dst, count);
+}
+
+void inverse_rotation_translation_n_sse(const Matrix4x4 *src, Matrix4x4 *dst, u32 count) {
+    const __m128 w_one = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+
+    for (u32 i = 0; i < count; ++i) {
+        __m128 x = _mm_loadu_ps(&src[i].x.x);
+        __m128 y = _mm_loadu_ps(&src[i].y.x);
+        __m128 z = _mm_loadu_ps(&src[i].z.x);
+        const __m128 t = _mm_loadu_ps(&src[i].t.x);
+
+        // Transpose the rotation. Zero in w makes the fourth row of the result zero.
+        __m128 w = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+
+        const __m128 rt = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_shuffle_ps(t, t, 0x00)),
+                                                _mm_mul_ps(y, _mm_shuffle_ps(t, t, 0x55))),
+                                     _mm_mul_ps(z, _mm_shuffle_ps(t, t, 0xaa)));
+
+        _mm_storeu_ps(&dst[i].x.x, x);
+        _mm_storeu_ps(&dst[i].y.x, y);
+        _mm_storeu_ps(&dst[i].z.x, z);
+        _mm_storeu_ps(&dst[i].t.x, _mm_sub_ps(w_one, rt));
+    }
+}
+
+void mul_mat_mat_n_sse(const Matrix4x4 *a, const Matrix4x4 *b, Matrix4x4 *dst, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        const __m128 a0 = _mm_loadu_ps(&a[i].x.x);
+        const __m128 a1 = _mm_loadu_ps(&a[i].y.x);
+        const __m128 a2 = _mm_loadu_ps(&a[i].z.x);
+        const __m128 a3 = _mm_loadu_ps(&a[i].t.x);
+
+        const auto column = [&](const Vector4 &bc) {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(bc.x)), _mm_mul_ps(a1, _mm_set1_ps(bc.y))),
+                              _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(bc.z)), _mm_mul_ps(a3, _mm_set1_ps(bc.w))));
+        };
+
+        // Compute all four columns before storing, dst might be b
+        const __m128 c0 = column(b[i].x);
+        const __m128 c1 = column(b[i].y);
+        const __m128 c2 = column(b[i].z);
+        const __m128 c3 = column(b[i].t);
+
+        _mm_storeu_ps(&dst[i].x.x, c0);
+        _mm_storeu_ps(&dst[i].y.x, c1);
+        _mm_storeu_ps(&dst[i].z.x, c2);
+        _mm_storeu_ps(&dst[i].t.x, c3);
+    }
+}
+
+void eigensolve_sym3x3_n_sse(const Matrix3x3 *symm, SymmetricEigenSolver3x3_Result *out, u32 count) {
+    eigensolve_sym3x3_soa(symm, out, count);
+}
+
+void normalize_n_sse(const Quaternion *src, Quaternion *dst, u32 count) { normalize_versors_soa(src, dst, count); }
+
+void nlerp_n_sse(
+    const Quaternion *a, const Quaternion *b, const float *alphas, u32 alpha_step, Quaternion *dst, u32 count) {
+    blend_versors_n_soa<false>(a, b, alphas, alpha_step, dst, count);
+}
+
+void slerp_n_sse(
+    const Quaternion *a, const Quaternion *b, const float *alphas, u32 alpha_step, Quaternion *dst, u32 count) {
+    blend_versors_n_soa<true>(a, b, alphas, alpha_step, dst, count);
+}
+
+void matrix_from_versor_n_sse(const Quaternion *src, Matrix4x4 *dst, u32 count) {
+    matrix_from_versors_soa(src, dst, count);
+}
+
+void slerp_local_transforms_sse(const LocalTransform *a,
+                                const LocalTransform *b,
+                                const float *alphas,
+                                u32 alpha_step,
+                                LocalTransform *dst,
+                                u32 count) {
+    blend_local_transforms_soa(a, b, alphas, alpha_step, dst, count);
+}
+
+void matrix_from_local_transform_n_sse(const LocalTransform *src, Matrix4x4 *dst, u32 count) {
+    matrix_from_local_transforms_soa(src, dst, count);
+}
+
+// float_to_half_fast3_rtne from https://gist.github.com/rygorous/2156668, 4 lanes at a time. The halves end up
+// in the low 64 bits.
+static inline __m128i f32_to_f16_lanes(__m128 f) {
+    const __m128i f16_max = _mm_set1_epi32((127 + 16) << 23); // Everything from here on is infinity or NaN
+    const __m128i min_normal = _mm_set1_epi32((127 - 14) << 23);
+    const __m128i subnormal_magic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    const __m128i normal_bias = _mm_set1_epi32(0xfff - ((127 - 15) << 23)); // Rebias exponent, round mantissa
+
+    const __m128 sign = _mm_and_ps(f, _mm_castsi128_ps(_mm_set1_epi32(0x80000000)));
+    const __m128 abs_f = _mm_xor_ps(f, sign);
+    const __m128i abs_bits = _mm_castps_si128(abs_f);
+
+    const __m128i is_nan = _mm_castps_si128(_mm_cmpunord_ps(abs_f, abs_f));
+    const __m128i is_regular = _mm_cmpgt_epi32(f16_max, abs_bits);
+    const __m128i inf_or_nan = _mm_or_si128(_mm_and_si128(is_nan, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7c00));
+
+    // Subnormal results. Adding the magic number makes the FPU round the mantissa for us.
+    const __m128i is_subnormal = _mm_cmpgt_epi32(min_normal, abs_bits);
+    const __m128i subnormal = _mm_sub_epi32(
+        _mm_castps_si128(_mm_add_ps(abs_f, _mm_castsi128_ps(subnormal_magic))), subnormal_magic);
+
+    // Normal results. Adding 1 more when the resulting mantissa is odd rounds ties to even.
+    const __m128i mantissa_odd = _mm_srai_epi32(_mm_slli_epi32(abs_bits, 31 - 13), 31);
+    const __m128i normal =
+        _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(abs_bits, normal_bias), mantissa_odd), 13);
+
+    const __m128i finite =
+        _mm_or_si128(_mm_and_si128(is_subnormal, subnormal), _mm_andnot_si128(is_subnormal, normal));
+    const __m128i magnitude =
+        _mm_or_si128(_mm_and_si128(is_regular, finite), _mm_andnot_si128(is_regular, inf_or_nan));
+
+    // The sign makes negative results negative 32 bit numbers, which packs_epi32 keeps as they are
+    const __m128i halves = _mm_or_si128(magnitude, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+    return _mm_packs_epi32(halves, halves);
+}
+
+// half_to_float_fast5 from the same place. Expects the halves in the low 64 bits.
+static inline __m128 f16_to_f32_lanes(__m128i h) {
+    const __m128i halves = _mm_unpacklo_epi16(h, _mm_setzero_si128());
+    const __m128i exp_mantissa = _mm_and_si128(halves, _mm_set1_epi32(0x7fff));
+    const __m128i sign = _mm_slli_epi32(_mm_xor_si128(halves, exp_mantissa), 16);
+
+    // Shift into place and rebias the exponent with a multiply, which also normalizes subnormals
+    const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+    const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(exp_mantissa, 13)), magic);
+
+    const __m128i was_inf_or_nan = _mm_cmpgt_epi32(exp_mantissa, _mm_set1_epi32(0x7bff));
+    const __m128 inf_nan_exp =
+        _mm_and_ps(_mm_castsi128_ps(was_inf_or_nan), _mm_castsi128_ps(_mm_set1_epi32(255 << 23)));
+    return _mm_or_ps(scaled, _mm_or_ps(_mm_castsi128_ps(sign), inf_nan_exp));
+}
+
+void f32_to_f16_sse(const float *src, u32 src_stride, u16 *dst, u32 dst_stride, u32 count, u32 components) {
+    convert_attributes(src, src_stride, dst, dst_stride, count, components, f32_to_f16_lanes);
+}
+
+void f16_to_f32_sse(const u16 *src, u32 src_stride, float *dst, u32 dst_stride, u32 count, u32 components) {
+    convert_attributes(src, src_stride, dst, dst_stride, count, components, f16_to_f32_lanes);
+}
+
+void f32_to_snorm16_sse(const float *src, u32 src_stride, i16 *dst, u32 dst_stride, u32 count, u32 components) {
+    convert_attributes(src, src_stride, dst, dst_stride, count, components, [](__m128 f) {
+        const __m128i i = snorm16_lanes(f);
+        return _mm_packs_epi32(i, i);
+    });
+}
+
+void f32_to_unorm8_sse(const float *src, u32 src_stride, u8 *dst, u32 dst_stride, u32 count, u32 components) {
+    convert_attributes(src, src_stride, dst, dst_stride, count, components, [](__m128 f) {
+        const __m128i i = unorm8_lanes(f);
+        const __m128i words = _mm_packs_epi32(i, i);
+        return _mm_packus_epi16(words, words);
+    });
+}
+
+void encode_octahedral_sse(const Vector3 *src, u32 src_stride, i16 *dst, u32 dst_stride, u32 count) {
+    encode_octahedral_soa(src, src_stride, dst, dst_stride, count);
+}
+
+void decode_octahedral_sse(const i16 *src, u32 src_stride, Vector3 *dst, u32 dst_stride, u32 count) {
+    decode_octahedral_soa(src, src_stride, dst, dst_stride, count);
+}
+
+void bounds_sse(const Vector3 *points, u32 stride, u32 count, Vector3 &min_out, Vector3 &max_out) {
+    bounds_soa(points, stride, count, min_out, max_out);
+}
+
+void sum_sse(const Vector3 *points, u32 stride, u32 count, double sum_out[3]) {
+    sum_soa(points, stride, count, sum_out);
+}
+
+void covariance_sse(const Vector3 *points, u32 stride, u32 count, const Vector3 &mean, double sums_out[6]) {
+    covariance_soa(points, stride, count, mean, sums_out);
+}
+
+void extreme_points_sse(const Vector3 *points,
+                        u32 stride,
+                        u32 count,
+                        const Vector3 *directions,
+                        u32 num_directions,
+                        u32 *min_indices_out,
+                        u32 *max_indices_out) {
+    extreme_points_soa(points, stride, count, directions, num_directions, min_indices_out, max_indices_out);
+}
+
+void farthest_point_sse(
+    const Vector3 *points, u32 stride, u32 count, const Vector3 &from, u32 &index_out, float &dist2_out) {
+    farthest_point_soa(points, stride, count, from, index_out, dist2_out);
+}
+
+void cull_spheres_sse(const Vector4 *planes, const Vector4 *spheres, u32 count, u8 *visible_bits, u8 *plane_cache) {
+    cull_spheres_soa(planes, spheres, count, visible_bits, plane_cache);
+}
+
+void cull_aabbs_sse(const Vector4 *planes, const AABB *boxes, u32 count, u8 *visible_bits, u8 *plane_cache) {
+    cull_aabbs_soa(planes, boxes, count, visible_bits, plane_cache);
+}
+
+void cull_sphere_arrays_sse(const Vector4 *planes,
+                            const float *const center[3],
+                            const float *radius,
+                            u32 count,
+                            u8 *visible_bits,
+                            u8 *plane_cache) {
+    cull_sphere_arrays_soa(planes, center, radius, count, visible_bits, plane_cache);
+}
+
+void cull_aabb_arrays_sse(const Vector4 *planes,
+                          const float *const min[3],
+                          const float *const max[3],
+                          u32 count,
+                          u8 *visible_bits,
+                          u8 *plane_cache) {
+    cull_aabb_arrays_soa(planes, min, max, count, visible_bits, plane_cache);
+}
+
+void rasterize_occluders_sse(
+    const OccluderTriangle *triangles, u32 count, float *depth, u32 width, u32 row_begin, u32 row_end) {
+    rasterize_occluders_soa(triangles, count, depth, width, row_begin, row_end);
+}
+
+// -- Dispatch
+
+static TransformKernels select_transform_kernels() {
+#if LOGL_HAVE_AVX2_KERNELS
+    const CpuFeatures &cpu = cpu_features();
+    if (cpu.avx2 && cpu.fma) {
+        return TransformKernels{ transform_points_avx2, transform_vectors_avx2, transform_normals_avx2 };
+    }
+#endif
+    return TransformKernels{ transform_points_sse, transform_vectors_sse, transform_normals_sse };
+}
+
+const TransformKernels &transform_kernels() {
+    static const TransformKernels kernels = select_transform_kernels();
+    return kernels;
+}
+
+static MatrixKernels select_matrix_kernels() {
+#if LOGL_HAVE_AVX2_KERNELS
+    const CpuFeatures &cpu = cpu_features();
+    if (cpu.avx2 && cpu.fma) {
+        return MatrixKernels{
+            inverse_n_avx2, inverse_rotation_translation_n_avx2, mul_mat_mat_n_avx2, eigensolve_sym3x3_n_avx2
+        };
+    }
+#endif
+    return MatrixKernels{
+        inverse_n_sse, inverse_rotation_translation_n_sse, mul_mat_mat_n_sse, eigensolve_sym3x3_n_sse
+    };
+}
+
+const MatrixKernels &matrix_kernels() {
+    static const MatrixKernels kernels = select_matrix_kernels();
+    return kernels;
+}
+
+static VersorKernels select_versor_kernels() {
+#if LOGL_HAVE_AVX2_KERNELS
+    const CpuFeatures &cpu = cpu_features();
+    if (cpu.avx2 && cpu.fma) {
+        return VersorKernels{ normalize_n_avx2,
+                              nlerp_n_avx2,
+                              slerp_n_avx2,
+                              matrix_from_versor_n_avx2,
+                              slerp_local_transforms_avx2,
+                              matrix_from_local_transform_n_avx2 };
+    }
+#endif
+    return VersorKernels{ normalize_n_sse,
+                          nlerp_n_sse,
+                          slerp_n_sse,
+                          matrix_from_versor_n_sse,
+                          slerp_local_transforms_sse,
+                          matrix_from_local_transform_n_sse };
+}
+
+const VersorKernels &versor_kernels() {
+    static const VersorKernels kernels = select_versor_kernels();
+    return kernels;
+}
+
+static PackKernels select_pack_kernels() {
+#if LOGL_HAVE_AVX2_KERNELS
+    const CpuFeatures &cpu = cpu_features();
+    if (cpu.avx2 && cpu.fma && cpu.f16c) {
+        return PackKernels{ f32_to_f16_avx2,
+                            f16_to_f32_avx2,
+                            f32_to_snorm16_sse,
+                            f32_to_unorm8_sse,
+                            encode_octahedral_avx2,
+                            decode_octahedral_avx2 };
+    }
+#endif
+    return PackKernels{ f32_to_f16_sse,
+                        f16_to_f32_sse,
+                        f32_to_snorm16_sse,
+                        f32_to_unorm8_sse,
+                        encode_octahedral_sse,
+                        decode_octahedral_sse };
+}
+
+const PackKernels &pack_kernels() {
+    static const PackKernels kernels = select_pack_kernels();
+    return kernels;
+}
+
+static PointKernels select_point_kernels() {
+#if LOGL_HAVE_AVX2_KERNELS
+    const CpuFeatures &cpu = cpu_features();
+    if (cpu.avx2 && cpu.fma) {
+        return PointKernels{ bounds_avx2, sum_avx2, covariance_avx2, extreme_points_avx2, farthest_point_avx2 };
+    }
+#endif
+    return PointKernels{ bounds_sse, sum_sse, covariance_sse, extreme_points_sse, farthest_point_sse };
+}
+
+const PointKernels &point_kernels() {
+    static const PointKernels kernels = select_point_kernels();
+    return kernels;
+}
+
+static CullKernels select_cull_kernels() {
+#if LOGL_HAVE_AVX2_KERNELS
+    const CpuFeatures &cpu = cpu_features();
+    if (cpu.avx2 && cpu.fma) {
+        return CullKernels{ cull_spheres_avx2, cull_aabbs_avx2, cull_sphere_arrays_avx2, cull_aabb_arrays_avx2 };
+    }
+#endif
+    return CullKernels{ cull_spheres_sse, cull_aabbs_sse, cull_sphere_arrays_sse, cull_aabb_arrays_sse };
+}
+
+const CullKernels &cull_kernels() {
+    static const CullKernels kernels = select_cull_kernels();
+    return kernels;
+}
+
+static OcclusionKernels select_occlusion_kernels() {
+#if LOGL_HAVE_AVX2_KERNELS
+    const CpuFeatures &cpu = cpu_features();
+    if (cpu.avx2 && cpu.fma) {
+        return OcclusionKernels{ rasterize_occluders_avx2 };
+    }
+#endif
+    return OcclusionKernels{ rasterize_occluders_sse };
+}
+
+const OcclusionKernels &occlusion_kernels() {
+    static const OcclusionKernels kernels = select_occlusion_kernels();
+    return kernels;
+}
+
+} // namespace kernels
+} // namespace math
+} // namespace eng
@@ -0,0 +1,498 @@
+// Private header. The per-instruction-set kernels behind the batched functions of math_ops.h. The public
+// functions pick one of these at runtime based on cpu_features(), the benchmarks in test/math_test call them
+// directly to compare.
+#pragma once
+
+#include <learnogl/math_ops.h>
+#include <learnogl/occlusion_culling.h>
+
+#include <emmintrin.h>
+#include <string.h>
+#include <type_traits>
+
+// The AVX2 kernels live in math_kernels_avx2.cpp, which is compiled with AVX2 and FMA enabled regardless of
+// the target of the rest of the library. Only x86 compilers we build with can do that.
+#if defined(__x86_64__) || defined(_M_X64)
+#    define LOGL_HAVE_AVX2_KERNELS 1
+#else
+#    define LOGL_HAVE_AVX2_KERNELS 0
+#endif
+
+namespace eng {
+namespace math {
+namespace kernels {
+
+// Every kernel takes the arrays as (pointer to first element, stride in bytes). Only the first 12 bytes of
+// each element are read and written.
+
+using TransformKernel = void (*)(const fo::Matrix4x4 &m,
+                                 const fo::Vector3 *src,
+                                 u32 src_stride,
+                                 fo::Vector3 *dst,
+                                 u32 dst_stride,
+                                 u32 count);
+
+// The kernels for the host CPU. Chosen on first call.
+struct TransformKernels {
+    TransformKernel points;
+    TransformKernel vectors;
+    TransformKernel normals;
+};
+
+const TransformKernels &transform_kernels();
+
+// Kernels over contiguous matrix arrays. `dst` can be the same array as a source.
+using MatrixMapKernel = void (*)(const fo::Matrix4x4 *src, fo::Matrix4x4 *dst, u32 count);
+using MatrixMulKernel = void (*)(const fo::Matrix4x4 *a, const fo::Matrix4x4 *b, fo::Matrix4x4 *dst, u32 count);
+using EigensolveKernel = void (*)(const fo::Matrix3x3 *symm, SymmetricEigenSolver3x3_Result *out, u32 count);
+
+struct MatrixKernels {
+    MatrixMapKernel inverse;
+    MatrixMapKernel inverse_rotation_translation;
+    MatrixMulKernel mul_mat_mat;
+    EigensolveKernel eigensolve_sym3x3;
+};
+
+const MatrixKernels &matrix_kernels();
+
+// Kernels over contiguous versor and LocalTransform arrays. The blending ones read alphas[i * alpha_step], so an
+// alpha_step of 0 uses alphas[0] for every element.
+using VersorMapKernel = void (*)(const fo::Quaternion *src, fo::Quaternion *dst, u32 count);
+using VersorBlendKernel = void (*)(const fo::Quaternion *a,
+                                   const fo::Quaternion *b,
+                                   const float *alphas,
+                                   u32 alpha_step,
+                                   fo::Quaternion *dst,
+                                   u32 count);
+using VersorMatrixKernel = void (*)(const fo::Quaternion *src, fo::Matrix4x4 *dst, u32 count);
+using LocalTransformBlendKernel = void (*)(const LocalTransform *a,
+                                           const LocalTransform *b,
+                                           const float *alphas,
+                                           u32 alpha_step,
+                                           LocalTransform *dst,
+                                           u32 count);
+using LocalTransformMatrixKernel = void (*)(const LocalTransform *src, fo::Matrix4x4 *dst, u32 count);
+
+struct VersorKernels {
+    VersorMapKernel normalize;
+    VersorBlendKernel nlerp;
+    VersorBlendKernel slerp;
+    VersorMatrixKernel matrix_from_versor;
+    LocalTransformBlendKernel slerp_local_transforms;
+    LocalTransformMatrixKernel matrix_from_local_transform;
+};
+
+const VersorKernels &versor_kernels();
+
+// Kernels converting to and from the packed attribute formats. Arrays are given as for the transform kernels,
+// with `components` (1 to 4) numbers per element.
+using F32ToF16Kernel =
+    void (*)(const float *src, u32 src_stride, u16 *dst, u32 dst_stride, u32 count, u32 components);
+using F16ToF32Kernel =
+    void (*)(const u16 *src, u32 src_stride, float *dst, u32 dst_stride, u32 count, u32 components);
+using F32ToSnorm16Kernel =
+    void (*)(const float *src, u32 src_stride, i16 *dst, u32 dst_stride, u32 count, u32 components);
+using F32ToUnorm8Kernel =
+    void (*)(const float *src, u32 src_stride, u8 *dst, u32 dst_stride, u32 count, u32 components);
+using OctahedralEncodeKernel =
+    void (*)(const fo::Vector3 *src, u32 src_stride, i16 *dst, u32 dst_stride, u32 count);
+using OctahedralDecodeKernel =
+    void (*)(const i16 *src, u32 src_stride, fo::Vector3 *dst, u32 dst_stride, u32 count);
+
+struct PackKernels {
+    F32ToF16Kernel f32_to_f16;
+    F16ToF32Kernel f16_to_f32;
+    F32ToSnorm16Kernel f32_to_snorm16;
+    F32ToUnorm8Kernel f32_to_unorm8;
+    OctahedralEncodeKernel encode_octahedral;
+    OctahedralDecodeKernel decode_octahedral;
+};
+
+const PackKernels &pack_kernels();
+
+// Reductions over a strided array of points, for bounding volumes. `count` is at least 1. The sums are returned
+// in doubles so that the partial results of many chunks of a large point set can be added up without losing
+// much. Covariance sums are of (p - mean)_i * (p - mean)_j in the order xx, yy, zz, xy, xz, yz.
+using BoundsKernel =
+    void (*)(const fo::Vector3 *points, u32 stride, u32 count, fo::Vector3 &min_out, fo::Vector3 &max_out);
+using SumKernel = void (*)(const fo::Vector3 *points, u32 stride, u32 count, double sum_out[3]);
+using CovarianceKernel =
+    void (*)(const fo::Vector3 *points, u32 stride, u32 count, const fo::Vector3 &mean, double sums_out[6]);
+
+// For each of the `num_directions` (at most 8) directions, the indices of the points with the smallest and the
+// largest dot product with it. Farthest point finds the point farthest from `from` and its squared distance. Ties go
+// to the lowest index. The SIMD kernels keep indices in float lanes, so `count` must be less than 2^24.
+using ExtremePointsKernel = void (*)(const fo::Vector3 *points,
+                                     u32 stride,
+                                     u32 count,
+                                     const fo::Vector3 *directions,
+                                     u32 num_directions,
+                                     u32 *min_indices_out,
+                                     u32 *max_indices_out);
+using FarthestPointKernel = void (*)(
+    const fo::Vector3 *points, u32 stride, u32 count, const fo::Vector3 &from, u32 &index_out, float &dist2_out);
+
+constexpr u32 k_max_extreme_directions = 8;
+
+struct PointKernels {
+    BoundsKernel bounds;
+    SumKernel sum;
+    CovarianceKernel covariance;
+    ExtremePointsKernel extreme_points;
+    FarthestPointKernel farthest_point;
+};
+
+const PointKernels &point_kernels();
+
+// Frustum culling. `planes` are the 6 planes as <N, D> with the normals pointing inside. Sets bit i % 8 of
+// visible_bits[i / 8] if object i is not entirely outside one of the planes and clears it otherwise, along with
+// the bits past `count` in the last byte. `plane_cache` is null or holds a byte per group of 8 objects, the plane
+// that culled the group last time, which gets tested first. The scalar kernels ignore it. Spheres are <center,
+// radius> Vector4s. The _arrays versions take each coordinate in its own array.
+using CullSpheresKernel =
+    void (*)(const fo::Vector4 *planes, const fo::Vector4 *spheres, u32 count, u8 *visible_bits, u8 *plane_cache);
+using CullAABBsKernel =
+    void (*)(const fo::Vector4 *planes, const fo::AABB *boxes, u32 count, u8 *visible_bits, u8 *plane_cache);
+using CullSphereArraysKernel = void (*)(const fo::Vector4 *planes,
+                                        const float *const center[3],
+                                        const float *radius,
+                                        u32 count,
+                                        u8 *visible_bits,
+                                        u8 *plane_cache);
+using CullAABBArraysKernel = void (*)(const fo::Vector4 *planes,
+                                      const float *const min[3],
+                                      const float *const max[3],
+                                      u32 count,
+                                      u8 *visible_bits,
+                                      u8 *plane_cache);
+
+struct CullKernels {
+    CullSpheresKernel spheres;
+    CullAABBsKernel aabbs;
+    CullSphereArraysKernel sphere_arrays;
+    CullAABBArraysKernel aabb_arrays;
+};
+
+const CullKernels &cull_kernels();
+
+// Occlusion rasterization. Rasterizes the triangles into the rows [row_begin, row_end) of the depth buffer, which
+// is `width` floats per row, keeping the nearest depth in each pixel. Rows outside the range aren't touched, so
+// threads can do different bands of the same buffer.
+using RasterizeOccludersKernel = void (*)(
+    const OccluderTriangle *triangles, u32 count, float *depth, u32 width, u32 row_begin, u32 row_end);
+
+struct OcclusionKernels {
+    RasterizeOccludersKernel rasterize;
+};
+
+const OcclusionKernels &occlusion_kernels();
+
+// -- Helpers shared by the kernels. Always inlined, so they're safe to use from the AVX2 file too.
+
+template <typename T> REALLY_INLINE T *advance_bytes(T *p, size_t num_bytes) {
+    using BytePtr = std::conditional_t<std::is_const<T>::value, const u8 *, u8 *>;
+    return reinterpret_cast<T *>(reinterpret_cast<BytePtr>(p) + num_bytes);
+}
+
+// Loads x, y, z into the low three words, w = 0. Doesn't touch memory past the Vector3.
+REALLY_INLINE __m128 load_vec3(const fo::Vector3 *p) {
+    __m128 xy = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double *>(p)));
+    __m128 z = _mm_load_ss(&p->z);
+    return _mm_movelh_ps(xy, z);
+}
+
+// Stores the low three words. Again, doesn't touch memory past the Vector3.
+REALLY_INLINE void store_vec3(fo::Vector3 *p, __m128 v) {
+    _mm_storel_pi(reinterpret_cast<__m64 *>(p), v);
+    _mm_store_ss(&p->z, _mm_movehl_ps(v, v));
+}
+
+// -- Scalar. Same as calling transform_point/transform_vector once per element.
+
+void transform_points_scalar(const fo::Matrix4x4 &m,
+                             const fo::Vector3 *src,
+                             u32 src_stride,
+                             fo::Vector3 *dst,
+                             u32 dst_stride,
+                             u32 count);
+
+void transform_vectors_scalar(const fo::Matrix4x4 &m,
+                              const fo::Vector3 *src,
+                              u32 src_stride,
+                              fo::Vector3 *dst,
+                              u32 dst_stride,
+                              u32 count);
+
+// `normal_mat` is already the inverse-transpose. Results are normalized.
+void transform_normals_scalar(const fo::Matrix4x4 &normal_mat,
+                              const fo::Vector3 *src,
+                              u32 src_stride,
+                              fo::Vector3 *dst,
+                              u32 dst_stride,
+                              u32 count);
+
+// Calls math::inverse etc. once per matrix.
+void inverse_n_scalar(const fo::Matrix4x4 *src, fo::Matrix4x4 *dst, u32 count);
+void inverse_rotation_translation_n_scalar(const fo::Matrix4x4 *src, fo::Matrix4x4 *dst, u32 count);
+void mul_mat_mat_n_scalar(const fo::Matrix4x4 *a, const fo::Matrix4x4 *b, fo::Matrix4x4 *dst, u32 count);
+void eigensolve_sym3x3_n_scalar(const fo::Matrix3x3 *symm, SymmetricEigenSolver3x3_Result *out, u32 count);
+
+// One element at a time too, but slerp_n_scalar and slerp_local_transforms_scalar compute the exact slerp, so
+// they are the reference for the error of the others.
+void normalize_n_scalar(const fo::Quaternion *src, fo::Quaternion *dst, u32 count);
+void nlerp_n_scalar(const fo::Quaternion *a,
+                    const fo::Quaternion *b,
+                    const float *alphas,
+                    u32 alpha_step,
+                    fo::Quaternion *dst,
+                    u32 count);
+void slerp_n_scalar(const fo::Quaternion *a,
+                    const fo::Quaternion *b,
+                    const float *alphas,
+                    u32 alpha_step,
+                    fo::Quaternion *dst,
+                    u32 count);
+void matrix_from_versor_n_scalar(const fo::Quaternion *src, fo::Matrix4x4 *dst, u32 count);
+void slerp_local_transforms_scalar(const LocalTransform *a,
+                                   const LocalTransform *b,
+                                   const float *alphas,
+                                   u32 alpha_step,
+                                   LocalTransform *dst,
+                                   u32 count);
+void matrix_from_local_transform_n_scalar(const LocalTransform *src, fo::Matrix4x4 *dst, u32 count);
+
+// Call the single value functions of math_ops.h once per number.
+void f32_to_f16_scalar(const float *src, u32 src_stride, u16 *dst, u32 dst_stride, u32 count, u32 components);
+void f16_to_f32_scalar(const u16 *src, u32 src_stride, float *dst, u32 dst_stride, u32 count, u32 components);
+void f32_to_snorm16_scalar(const float *src, u32 src_stride, i16 *dst, u32 dst_stride, u32 count, u32 components);
+void f32_to_unorm8_scalar(const float *src, u32 src_stride, u8 *dst, u32 dst_stride, u32 count, u32 components);
+void encode_octahedral_scalar(const fo::Vector3 *src, u32 src_stride, i16 *dst, u32 dst_stride, u32 count);
+void decode_octahedral_scalar(const i16 *src, u32 src_stride, fo::Vector3 *dst, u32 dst_stride, u32 count);
+
+// Accumulate in double one point at a time.
+void bounds_scalar(const fo::Vector3 *points, u32 stride, u32 count, fo::Vector3 &min_out, fo::Vector3 &max_out);
+void sum_scalar(const fo::Vector3 *points, u32 stride, u32 count, double sum_out[3]);
+void covariance_scalar(
+    const fo::Vector3 *points, u32 stride, u32 count, const fo::Vector3 &mean, double sums_out[6]);
+void extreme_points_scalar(const fo::Vector3 *points,
+                           u32 stride,
+                           u32 count,
+                           const fo::Vector3 *directions,
+                           u32 num_directions,
+                           u32 *min_indices_out,
+                           u32 *max_indices_out);
+void farthest_point_scalar(
+    const fo::Vector3 *points, u32 stride, u32 count, const fo::Vector3 &from, u32 &index_out, float &dist2_out);
+void cull_spheres_scalar(
+    const fo::Vector4 *planes, const fo::Vector4 *spheres, u32 count, u8 *visible_bits, u8 *plane_cache);
+void cull_aabbs_scalar(
+    const fo::Vector4 *planes, const fo::AABB *boxes, u32 count, u8 *visible_bits, u8 *plane_cache);
+void cull_sphere_arrays_scalar(const fo::Vector4 *planes,
+                               const float *const center[3],
+                               const float *radius,
+                               u32 count,
+                               u8 *visible_bits,
+                               u8 *plane_cache);
+void cull_aabb_arrays_scalar(const fo::Vector4 *planes,
+                             const float *const min[3],
+                             const float *const max[3],
+                             u32 count,
+                             u8 *visible_bits,
+                             u8 *plane_cache);
+void rasterize_occluders_scalar(
+    const OccluderTriangle *triangles, u32 count, float *depth, u32 width, u32 row_begin, u32 row_end);
+
+// -- SSE. 4 elements per iteration, transposed into x, y, z registers.
+
+void transform_points_sse(const fo::Matrix4x4 &m,
+                          const fo::Vector3 *src,
+                          u32 src_stride,
+                          fo::Vector3 *dst,
+                          u32 dst_stride,
+                          u32 count);
+
+void transform_vectors_sse(const fo::Matrix4x4 &m,
+                           const fo::Vector3 *src,
+                           u32 src_stride,
+                           fo::Vector3 *dst,
+                           u32 dst_stride,
+                           u32 count);
+
+void transform_normals_sse(const fo::Matrix4x4 &normal_mat,
+                           const fo::Vector3 *src,
+                           u32 src_stride,
+                           fo::Vector3 *dst,
+                           u32 dst_stride,
+                           u32 count);
+
+// inverse_n works on 8 matrices at a time transposed into Float8 packs (two xmm registers each here). The other
+// two do one matrix at a time, broadcasting elements with shuffles.
+void inverse_n_sse(const fo::Matrix4x4 *src, fo::Matrix4x4 *dst, u32 count);
+void inverse_rotation_translation_n_sse(const fo::Matrix4x4 *src, fo::Matrix4x4 *dst, u32 count);
+void mul_mat_mat_n_sse(const fo::Matrix4x4 *a, const fo::Matrix4x4 *b, fo::Matrix4x4 *dst, u32 count);
+
+// Jacobi eigensolver, 8 matrices at a time in Float8 packs.
+void eigensolve_sym3x3_n_sse(const fo::Matrix3x3 *symm, SymmetricEigenSolver3x3_Result *out, u32 count);
+
+// The versor kernels all work on 8 elements at a time in Float8 packs.
+void normalize_n_sse(const fo::Quaternion *src, fo::Quaternion *dst, u32 count);
+void nlerp_n_sse(const fo::Quaternion *a,
+                 const fo::Quaternion *b,
+                 const float *alphas,
+                 u32 alpha_step,
+                 fo::Quaternion *dst,
+                 u32 count);
+void slerp_n_sse(const fo::Quaternion *a,
+                 const fo::Quaternion *b,
+                 const float *alphas,
+                 u32 alpha_step,
+                 fo::Quaternion *dst,
+                 u32 count);
+void matrix_from_versor_n_sse(const fo::Quaternion *src, fo::Matrix4x4 *dst, u32 count);
+void slerp_local_transforms_sse(const LocalTransform *a,
+                                const LocalTransform *b,
+                                const float *alphas,
+                                u32 alpha_step,
+                                LocalTransform *dst,
+                                u32 count);
+void matrix_from_local_transform_n_sse(const LocalTransform *src, fo::Matrix4x4 *dst, u32 count);
+
+// Four numbers per instruction. The half float conversions are done with integer ops (after F. Giesen's
+// float_to_half_fast3_rtne and half_to_float_fast5), so they don't need F16C. The octahedral ones do 8 vectors at
+// a time in Float8 packs.
+void f32_to_f16_sse(const float *src, u32 src_stride, u16 *dst, u32 dst_stride, u32 count, u32 components);
+void f16_to_f32_sse(const u16 *src, u32 src_stride, float *dst, u32 dst_stride, u32 count, u32 components);
+void f32_to_snorm16_sse(const float *src, u32 src_stride, i16 *dst, u32 dst_stride, u32 count, u32 components);
+void f32_to_unorm8_sse(const float *src, u32 src_stride, u8 *dst, u32 dst_stride, u32 count, u32 components);
+void encode_octahedral_sse(const fo::Vector3 *src, u32 src_stride, i16 *dst, u32 dst_stride, u32 count);
+void decode_octahedral_sse(const i16 *src, u32 src_stride, fo::Vector3 *dst, u32 dst_stride, u32 count);
+
+// 8 points at a time in Float8 packs. The sums are kept in floats for blocks of 1024 points, then added to the
+// double totals.
+void bounds_sse(const fo::Vector3 *points, u32 stride, u32 count, fo::Vector3 &min_out, fo::Vector3 &max_out);
+void sum_sse(const fo::Vector3 *points, u32 stride, u32 count, double sum_out[3]);
+void covariance_sse(const fo::Vector3 *points, u32 stride, u32 count, const fo::Vector3 &mean, double sums_out[6]);
+void extreme_points_sse(const fo::Vector3 *points,
+                        u32 stride,
+                        u32 count,
+                        const fo::Vector3 *directions,
+                        u32 num_directions,
+                        u32 *min_indices_out,
+                        u32 *max_indices_out);
+void farthest_point_sse(
+    const fo::Vector3 *points, u32 stride, u32 count, const fo::Vector3 &from, u32 &index_out, float &dist2_out);
+void cull_spheres_sse(
+    const fo::Vector4 *planes, const fo::Vector4 *spheres, u32 count, u8 *visible_bits, u8 *plane_cache);
+void cull_aabbs_sse(const fo::Vector4 *planes, const fo::AABB *boxes, u32 count, u8 *visible_bits, u8 *plane_cache);
+void cull_sphere_arrays_sse(const fo::Vector4 *planes,
+                            const float *const center[3],
+                            const float *radius,
+                            u32 count,
+                            u8 *visible_bits,
+                            u8 *plane_cache);
+void cull_aabb_arrays_sse(const fo::Vector4 *planes,
+                          const float *const min[3],
+                          const float *const max[3],
+                          u32 count,
+                          u8 *visible_bits,
+                          u8 *plane_cache);
+void rasterize_occluders_sse(
+    const OccluderTriangle *triangles, u32 count, float *depth, u32 width, u32 row_begin, u32 row_end);
+
+// -- AVX2 + FMA. 8 elements per iteration. Tightly packed arrays are shuffled in and out, other strides are
+// gathered. Only call these if cpu_features() reports avx2 and fma.
+
+#if LOGL_HAVE_AVX2_KERNELS
+
+void transform_points_avx2(const fo::Matrix4x4 &m,
+                           const fo::Vector3 *src,
+                           u32 src_stride,
+                           fo::Vector3 *dst,
+                           u32 dst_stride,
+                           u32 count);
+
+void transform_vectors_avx2(const fo::Matrix4x4 &m,
+                            const fo::Vector3 *src,
+                            u32 src_stride,
+                            fo::Vector3 *dst,
+                            u32 dst_stride,
+                            u32 count);
+
+void transform_normals_avx2(const fo::Matrix4x4 &normal_mat,
+                            const fo::Vector3 *src,
+                            u32 src_stride,
+                            fo::Vector3 *dst,
+                            u32 dst_stride,
+                            u32 count);
+
+// inverse_n is the same code as the SSE one but with one ymm register per Float8. The other two do two matrices
+// at a time, one in each 128 bit lane.
+void inverse_n_avx2(const fo::Matrix4x4 *src, fo::Matrix4x4 *dst, u32 count);
+void inverse_rotation_translation_n_avx2(const fo::Matrix4x4 *src, fo::Matrix4x4 *dst, u32 count);
+void mul_mat_mat_n_avx2(const fo::Matrix4x4 *a, const fo::Matrix4x4 *b, fo::Matrix4x4 *dst, u32 count);
+void eigensolve_sym3x3_n_avx2(const fo::Matrix3x3 *symm, SymmetricEigenSolver3x3_Result *out, u32 count);
+
+void normalize_n_avx2(const fo::Quaternion *src, fo::Quaternion *dst, u32 count);
+void nlerp_n_avx2(const fo::Quaternion *a,
+                  const fo::Quaternion *b,
+                  const float *alphas,
+                  u32 alpha_step,
+                  fo::Quaternion *dst,
+                  u32 count);
+void slerp_n_avx2(const fo::Quaternion *a,
+                  const fo::Quaternion *b,
+                  const float *alphas,
+                  u32 alpha_step,
+                  fo::Quaternion *dst,
+                  u32 count);
+void matrix_from_versor_n_avx2(const fo::Quaternion *src, fo::Matrix4x4 *dst, u32 count);
+void slerp_local_transforms_avx2(const LocalTransform *a,
+                                 const LocalTransform *b,
+                                 const float *alphas,
+                                 u32 alpha_step,
+                                 LocalTransform *dst,
+                                 u32 count);
+void matrix_from_local_transform_n_avx2(const LocalTransform *src, fo::Matrix4x4 *dst, u32 count);
+
+// The half float conversions use F16C, so these also need cpu_features().f16c. The snorm16 and unorm8 ones gain
+// nothing from AVX2 and are left to the SSE kernels.
+void f32_to_f16_avx2(const float *src, u32 src_stride, u16 *dst, u32 dst_stride, u32 count, u32 components);
+void f16_to_f32_avx2(const u16 *src, u32 src_stride, float *dst, u32 dst_stride, u32 count, u32 components);
+void encode_octahedral_avx2(const fo::Vector3 *src, u32 src_stride, i16 *dst, u32 dst_stride, u32 count);
+void decode_octahedral_avx2(const i16 *src, u32 src_stride, fo::Vector3 *dst, u32 dst_stride, u32 count);
+
+void bounds_avx2(const fo::Vector3 *points, u32 stride, u32 count, fo::Vector3 &min_out, fo::Vector3 &max_out);
+void sum_avx2(const fo::Vector3 *points, u32 stride, u32 count, double sum_out[3]);
+void covariance_avx2(const fo::Vector3 *points, u32 stride, u32 count, const fo::Vector3 &mean, double sums_out[6]);
+void extreme_points_avx2(const fo::Vector3 *points,
+                         u32 stride,
+                         u32 count,
+                         const fo::Vector3 *directions,
+                         u32 num_directions,
+                         u32 *min_indices_out,
+                         u32 *max_indices_out);
+void farthest_point_avx2(
+    const fo::Vector3 *points, u32 stride, u32 count, const fo::Vector3 &from, u32 &index_out, float &dist2_out);
+void cull_spheres_avx2(
+    const fo::Vector4 *planes, const fo::Vector4 *spheres, u32 count, u8 *visible_bits, u8 *plane_cache);
+void cull_aabbs_avx2(const fo::Vector4 *planes, const fo::AABB *boxes, u32 count, u8 *visible_bits, u8 *plane_cache);
+void cull_sphere_arrays_avx2(const fo::Vector4 *planes,
+                             const float *const center[3],
+                             const float *radius,
+                             u32 count,
+                             u8 *visible_bits,
+                             u8 *plane_cache);
+void cull_aabb_arrays_avx2(const fo::Vector4 *planes,
+                           const float *const min[3],
+                           const float *const max[3],
+                           u32 count,
+                           u8 *visible_bits,
+                           u8 *plane_cache);
+void rasterize_occluders_avx2(
+    const OccluderTriangle *triangles, u32 count, float *depth, u32 width, u32 row_begin, u32 row_end);
+
+#endif
+
+} // namespace kernels
+} // namespace math
+} // namespace eng
@@ -0,0 +1,329 @@
+// The AVX2 + FMA kernels declared in math_kernels.h. This file alone is compiled with -mavx2 -mfma -mf16c (see
+// src/CMakeLists.txt), everything else targets the baseline, and math_ops only calls into here after checking
+// cpu_features().
+//
+// Careful with what gets called from here. A non-inlined header function used in this file would be emitted with
+// AVX encodings, and the linker is free to keep that copy for the whole program. The vmath.h packs are all
+// REALLY_INLINE so they're fine.
+
+#include "math_kernels.h"
+
+#if LOGL_HAVE_AVX2_KERNELS
+
+#    if !defined(__AVX2__) || (defined(__GNUC__) && !defined(__F16C__))
+#        error "math_kernels_avx2.cpp must be compiled with AVX2, FMA and F16C enabled"
+#    endif
+
+#    include <immintrin.h>
+
+using namespace fo;
+
+namespace eng {
+namespace math {
+namespace kernels {
+
+#    include "math_kernels_soa.inc.h"
+
+// Writes 8 (x, y, z) lanes back into a strided array.
+REALLY_INLINE void store_strided_soa8(Vector3 *dst, u32 dst_stride, __m256 x, __m256 y, __m256 z) {
+    for (int half = 0; half < 2; ++half) {
+        __m128 a = half == 0 ? _mm256_castps256_ps128(x) : _mm256_extractf128_ps(x, 1);
+        __m128 b = half == 0 ? _mm256_castps256_ps128(y) : _mm256_extractf128_ps(y, 1);
+        __m128 c = half == 0 ? _mm256_castps256_ps128(z) : _mm256_extractf128_ps(z, 1);
+        __m128 d = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+
+        store_vec3(dst, a);
+        store_vec3(advance_bytes(dst, dst_stride), b);
+        store_vec3(advance_bytes(dst, 2 * dst_stride), c);
+        store_vec3(advance_bytes(dst, 3 * dst_stride), d);
+        dst = advance_bytes(dst, 4 * dst_stride);
+    }
+}
+
+// The SSE kernel handles the 0-7 elements left over
+using TailKernel = void (*)(const Matrix4x4 &, const Vector3 *, u32, Vector3 *, u32, u32);
+
+template <bool with_translation, bool normalize_result, TailKernel tail_kernel>
+static void transform_avx2(
+    const Matrix4x4 &m, const Vector3 *src, u32 src_stride, Vector3 *dst, u32 dst_stride, u32 count) {
+    const __m256 m00 = _mm256_set1_ps(m.x.x);
+    const __m256 m01 = _mm256_set1_ps(m.y.x);
+    const __m256 m02 = _mm256_set1_ps(m.z.x);
+    const __m256 m10 = _mm256_set1_ps(m.x.y);
+    const __m256 m11 = _mm256_set1_ps(m.y.y);
+    const __m256 m12 = _mm256_set1_ps(m.z.y);
+    const __m256 m20 = _mm256_set1_ps(m.x.z);
+    const __m256 m21 = _mm256_set1_ps(m.y.z);
+    const __m256 m22 = _mm256_set1_ps(m.z.z);
+    const __m256 t0 = with_translation ? _mm256_set1_ps(m.t.x) : _mm256_setzero_ps();
+    const __m256 t1 = with_translation ? _mm256_set1_ps(m.t.y) : _mm256_setzero_ps();
+    const __m256 t2 = with_translation ? _mm256_set1_ps(m.t.z) : _mm256_setzero_ps();
+
+    const bool packed_src = src_stride == sizeof(Vector3);
+    const bool packed_dst = dst_stride == sizeof(Vector3);
+
+    const __m256i gather_offsets =
+        _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32((int)src_stride));
+
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x, y, z;
+
+        const float *s = reinterpret_cast<const float *>(src);
+        if (packed_src) {
+            const simd::Vec3x8 v = simd::load_vec3x8(src);
+            x = v.x.m;
+            y = v.y.m;
+            z = v.z.m;
+        } else {
+            x = _mm256_i32gather_ps(s + 0, gather_offsets, 1);
+            y = _mm256_i32gather_ps(s + 1, gather_offsets, 1);
+            z = _mm256_i32gather_ps(s + 2, gather_offsets, 1);
+        }
+
+        __m256 rx = _mm256_fmadd_ps(m00, x, _mm256_fmadd_ps(m01, y, _mm256_fmadd_ps(m02, z, t0)));
+        __m256 ry = _mm256_fmadd_ps(m10, x, _mm256_fmadd_ps(m11, y, _mm256_fmadd_ps(m12, z, t1)));
+        __m256 rz = _mm256_fmadd_ps(m20, x, _mm256_fmadd_ps(m21, y, _mm256_fmadd_ps(m22, z, t2)));
+
+        if (normalize_result) {
+            const __m256 len =
+                _mm256_sqrt_ps(_mm256_fmadd_ps(rx, rx, _mm256_fmadd_ps(ry, ry, _mm256_mul_ps(rz, rz))));
+            rx = _mm256_div_ps(rx, len);
+            ry = _mm256_div_ps(ry, len);
+            rz = _mm256_div_ps(rz, len);
+        }
+
+        if (packed_dst) {
+            simd::store_vec3x8(dst, simd::Vec3x8{ rx, ry, rz });
+        } else {
+            store_strided_soa8(dst, dst_stride, rx, ry, rz);
+        }
+
+        src = advance_bytes(src, 8 * src_stride);
+        dst = advance_bytes(dst, 8 * dst_stride);
+    }
+
+    // Remaining 0-7 elements
+    tail_kernel(m, src, src_stride, dst, dst_stride, count - i);
+}
+
+void transform_points_avx2(
+    const Matrix4x4 &m, const Vector3 *src, u32 src_stride, Vector3 *dst, u32 dst_stride, u32 count) {
+    transform_avx2<true, false, transform_points_sse>(m, src, src_stride, dst, dst_stride, count);
+}
+
+void transform_vectors_avx2(
+    const Matrix4x4 &m, const Vector3 *src, u32 src_stride, Vector3 *dst, u32 dst_stride, u32 count) {
+    transform_avx2<false, false, transform_vectors_sse>(m, src, src_stride, dst, dst_stride, count);
+}
+
+void transform_normals_avx2(
+    const Matrix4x4 &normal_mat, const Vector3 *src, u32 src_stride, Vector3 *dst, u32 dst_stride, u32 count) {
+    transform_avx2<false, true, transform_normals_sse>(normal_mat, src, src_stride, dst, dst_stride, count);
+}
+
+void inverse_n_avx2(const Matrix4x4 *src, Matrix4x4 *dst, u32 count) {
+    map_matrices_soa<inverse_soa>(src, dst, count);
+}
+
+// Loads the same column of two consecutive matrices into the low and high lanes
+REALLY_INLINE __m256 load_column_pair(const Vector4 *column_of_first) {
+    const float *p = &column_of_first->x;
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p)), _mm_loadu_ps(p + 16), 1);
+}
+
+REALLY_INLINE void store_column_pair(Vector4 *column_of_first, __m256 v) {
+    float *p = &column_of_first->x;
+    _mm_storeu_ps(p, _mm256_castps256_ps128(v));
+    _mm_storeu_ps(p + 16, _mm256_extractf128_ps(v, 1));
+}
+
+// Two matrices at a time, one per 128 bit lane, otherwise same as the SSE version. Transposing into Float8 packs
+// costs more than the few multiplies this needs.
+void inverse_rotation_translation_n_avx2(const Matrix4x4 *src, Matrix4x4 *dst, u32 count) {
+    const __m256 w_one = _mm256_setr_ps(0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+
+    u32 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m256 x = load_column_pair(&src[i].x);
+        const __m256 y = load_column_pair(&src[i].y);
+        const __m256 z = load_column_pair(&src[i].z);
+        const __m256 t = load_column_pair(&src[i].t);
+
+        // In-lane transpose of (x, y, z, 0)
+        const __m256 xy_lo = _mm256_unpacklo_ps(x, y);
+        const __m256 xy_hi = _mm256_unpackhi_ps(x, y);
+        const __m256 z0_lo = _mm256_unpacklo_ps(z, zero);
+        const __m256 z0_hi = _mm256_unpackhi_ps(z, zero);
+
+        const __m256 rx = _mm256_shuffle_ps(xy_lo, z0_lo, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 ry = _mm256_shuffle_ps(xy_lo, z0_lo, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m256 rz = _mm256_shuffle_ps(xy_hi, z0_hi, _MM_SHUFFLE(1, 0, 1, 0));
+
+        const __m256 rt = _mm256_fmadd_ps(
+            rx,
+            _mm256_permute_ps(t, 0x00),
+            _mm256_fmadd_ps(ry, _mm256_permute_ps(t, 0x55), _mm256_mul_ps(rz, _mm256_permute_ps(t, 0xaa))));
+
+        store_column_pair(&dst[i].x, rx);
+        store_column_pair(&dst[i].y, ry);
+        store_column_pair(&dst[i].z, rz);
+        store_column_pair(&dst[i].t, _mm256_sub_ps(w_one, rt));
+    }
+
+    inverse_rotation_translation_n_sse(src + i, dst + i, count - i);
+}
+
+void mul_mat_mat_n_avx2(const Matrix4x4 *a, const Matrix4x4 *b, Matrix4x4 *dst, u32 count) {
+    u32 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m256 a0 = load_column_pair(&a[i].x);
+        const __m256 a1 = load_column_pair(&a[i].y);
+        const __m256 a2 = load_column_pair(&a[i].z);
+        const __m256 a3 = load_column_pair(&a[i].t);
+
+        // permute_ps broadcasts within each 128 bit lane, so each matrix gets its own b elements
+        const auto column = [&](__m256 bc) {
+            return _mm256_fmadd_ps(
+                a0,
+                _mm256_permute_ps(bc, 0x00),
+                _mm256_fmadd_ps(a1,
+                                _mm256_permute_ps(bc, 0x55),
+                                _mm256_fmadd_ps(a2,
+                                                _mm256_permute_ps(bc, 0xaa),
+                                                _mm256_mul_ps(a3, _mm256_permute_ps(bc, 0xff)))));
+        };
+
+        // Compute all four columns before storing, dst might be b
+        const __m256 c0 = column(load_column_pair(&b[i].x));
+        const __m256 c1 = column(load_column_pair(&b[i].y));
+        const __m256 c2 = column(load_column_pair(&b[i].z));
+        const __m256 c3 = column(load_column_pair(&b[i].t));
+
+        store_column_pair(&dst[i].x, c0);
+        store_column_pair(&dst[i].y, c1);
+        store_column_pair(&dst[i].z, c2);
+        store_column_pair(&dst[i].t, c3);
+    }
+
+    mul_mat_mat_n_sse(a + i, b + i, dst + i, count - i);
+}
+
+void eigensolve_sym3x3_n_avx2(const Matrix3x3 *symm, SymmetricEigenSolver3x3_Result *out, u32 count) {
+    eigensolve_sym3x3_soa(symm, out, count);
+}
+
+void normalize_n_avx2(const Quaternion *src, Quaternion *dst, u32 count) { normalize_versors_soa(src, dst, count); }
+
+void nlerp_n_avx2(
+    const Quaternion *a, const Quaternion *b, const float *alphas, u32 alpha_step, Quaternion *dst, u32 count) {
+    blend_versors_n_soa<false>(a, b, alphas, alpha_step, dst, count);
+}
+
+void slerp_n_avx2(
+    const Quaternion *a, const Quaternion *b, const float *alphas, u32 alpha_step, Quaternion *dst, u32 count) {
+    blend_versors_n_soa<true>(a, b, alphas, alpha_step, dst, count);
+}
+
+void matrix_from_versor_n_avx2(const Quaternion *src, Matrix4x4 *dst, u32 count) {
+    matrix_from_versors_soa(src, dst, count);
+}
+
+void slerp_local_transforms_avx2(const LocalTransform *a,
+                                 const LocalTransform *b,
+                                 const float *alphas,
+                                 u32 alpha_step,
+                                 LocalTransform *dst,
+                                 u32 count) {
+    blend_local_transforms_soa(a, b, alphas, alpha_step, dst, count);
+}
+
+void matrix_from_local_transform_n_avx2(const LocalTransform *src, Matrix4x4 *dst, u32 count) {
+    matrix_from_local_transforms_soa(src, dst, count);
+}
+
+// The F16C conversions work on 4 lanes here, which is already as fast as the loads and stores around them
+void f32_to_f16_avx2(const float *src, u32 src_stride, u16 *dst, u32 dst_stride, u32 count, u32 components) {
+    convert_attributes(src, src_stride, dst, dst_stride, count, components, [](__m128 f) {
+        return _mm_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT);
+    });
+}
+
+void f16_to_f32_avx2(const u16 *src, u32 src_stride, float *dst, u32 dst_stride, u32 count, u32 components) {
+    convert_attributes(
+        src, src_stride, dst, dst_stride, count, components, [](__m128i h) { return _mm_cvtph_ps(h); });
+}
+
+void encode_octahedral_avx2(const Vector3 *src, u32 src_stride, i16 *dst, u32 dst_stride, u32 count) {
+    encode_octahedral_soa(src, src_stride, dst, dst_stride, count);
+}
+
+void decode_octahedral_avx2(const i16 *src, u32 src_stride, Vector3 *dst, u32 dst_stride, u32 count) {
+    decode_octahedral_soa(src, src_stride, dst, dst_stride, count);
+}
+
+void bounds_avx2(const Vector3 *points, u32 stride, u32 count, Vector3 &min_out, Vector3 &max_out) {
+    bounds_soa(points, stride, count, min_out, max_out);
+}
+
+void sum_avx2(const Vector3 *points, u32 stride, u32 count, double sum_out[3]) {
+    sum_soa(points, stride, count, sum_out);
+}
+
+void covariance_avx2(const Vector3 *points, u32 stride, u32 count, const Vector3 &mean, double sums_out[6]) {
+    covariance_soa(points, stride, count, mean, sums_out);
+}
+
+void extreme_points_avx2(const Vector3 *points,
+                         u32 stride,
+                         u32 count,
+                         const Vector3 *directions,
+                         u32 num_directions,
+                         u32 *min_indices_out,
+                         u32 *max_indices_out) {
+    extreme_points_soa(points, stride, count, directions, num_directions, min_indices_out, max_indices_out);
+}
+
+void farthest_point_avx2(
+    const Vector3 *points, u32 stride, u32 count, const Vector3 &from, u32 &index_out, float &dist2_out) {
+    farthest_point_soa(points, stride, count, from, index_out, dist2_out);
+}
+
+void cull_spheres_avx2(const Vector4 *planes, const Vector4 *spheres, u32 count, u8 *visible_bits, u8 *plane_cache) {
+    cull_spheres_soa(planes, spheres, count, visible_bits, plane_cache);
+}
+
+void cull_aabbs_avx2(const Vector4 *planes, const AABB *boxes, u32 count, u8 *visible_bits, u8 *plane_cache) {
+    cull_aabbs_soa(planes, boxes, count, visible_bits, plane_cache);
+}
+
+void cull_sphere_arrays_avx2(const Vector4 *planes,
+                             const float *const center[3],
+                             const float *radius,
+                             u32 count,
+                             u8 *visible_bits,
+                             u8 *plane_cache) {
+    cull_sphere_arrays_soa(planes, center, radius, count, visible_bits, plane_cache);
+}
+
+void cull_aabb_arrays_avx2(const Vector4 *planes,
+                           const float *const min[3],
+                           const float *const max[3],
+                           u32 count,
+                           u8 *visible_bits,
+                           u8 *plane_cache) {
+    cull_aabb_arrays_soa(planes, min, max, count, visible_bits, plane_cache);
+}
+
+void rasterize_occluders_avx2(
+    const OccluderTriangle *triangles, u32 count, float *depth, u32 width, u32 row_begin, u32 row_end) {
+    rasterize_occluders_soa(triangles, count, depth, width, row_begin, row_end);
+}
+
+} // namespace kernels
+} // namespace math
+} // namespace eng
+
+#endif
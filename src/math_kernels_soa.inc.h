@@ -0,0 +1,1178 @@
+// Kernels written against the simd::Float8 packs of vmath.h. Included by both math_kernels.cpp and
+// math_kernels_avx2.cpp, so the same code compiles to a pair of xmm registers per Float8 in the former and a single
+// ymm register in the latter. Everything in here has internal linkage, so the two copies don't collide. For the same
+// reason, don't call out-of-line templates (std::copy and such) from here.
+
+namespace {
+
+using simd::Float8;
+using simd::Mat4x8;
+using simd::Vec3x8;
+using simd::Vec4x8;
+
+// Element at (row, col) of the 8 matrices
+struct Mat4x8Elements {
+    Float8 e[4][4];
+
+    REALLY_INLINE Mat4x8Elements(const Mat4x8 &m) {
+        const Vec4x8 *cols[4] = { &m.x, &m.y, &m.z, &m.t };
+        for (int c = 0; c < 4; ++c) {
+            e[0][c] = cols[c]->x;
+            e[1][c] = cols[c]->y;
+            e[2][c] = cols[c]->z;
+            e[3][c] = cols[c]->w;
+        }
+    }
+
+    REALLY_INLINE Mat4x8Elements() = default;
+
+    REALLY_INLINE Mat4x8 to_mat() const {
+        Mat4x8 m;
+        Vec4x8 *cols[4] = { &m.x, &m.y, &m.z, &m.t };
+        for (int c = 0; c < 4; ++c) {
+            cols[c]->x = e[0][c];
+            cols[c]->y = e[1][c];
+            cols[c]->z = e[2][c];
+            cols[c]->w = e[3][c];
+        }
+        return m;
+    }
+};
+
+// General inverse via the 2x2 sub-determinants of the top two and bottom two rows (Laplace expansion). Like
+// math::inverse, doesn't check for singular matrices.
+REALLY_INLINE Mat4x8 inverse_soa(const Mat4x8 &mat) {
+    const Mat4x8Elements m(mat);
+    const auto &a = m.e;
+
+    const Float8 s0 = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+    const Float8 s1 = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+    const Float8 s2 = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+    const Float8 s3 = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+    const Float8 s4 = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+    const Float8 s5 = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+
+    const Float8 c5 = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+    const Float8 c4 = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+    const Float8 c3 = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+    const Float8 c2 = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+    const Float8 c1 = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+    const Float8 c0 = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+
+    const Float8 det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    const Float8 inv_det = simd::splat8(1.0f) / det;
+
+    Mat4x8Elements r;
+    auto &b = r.e;
+
+    b[0][0] = (a[1][1] * c5 - a[1][2] * c4 + a[1][3] * c3) * inv_det;
+    b[0][1] = (a[0][2] * c4 - a[0][1] * c5 - a[0][3] * c3) * inv_det;
+    b[0][2] = (a[3][1] * s5 - a[3][2] * s4 + a[3][3] * s3) * inv_det;
+    b[0][3] = (a[2][2] * s4 - a[2][1] * s5 - a[2][3] * s3) * inv_det;
+
+    b[1][0] = (a[1][2] * c2 - a[1][0] * c5 - a[1][3] * c1) * inv_det;
+    b[1][1] = (a[0][0] * c5 - a[0][2] * c2 + a[0][3] * c1) * inv_det;
+    b[1][2] = (a[3][2] * s2 - a[3][0] * s5 - a[3][3] * s1) * inv_det;
+    b[1][3] = (a[2][0] * s5 - a[2][2] * s2 + a[2][3] * s1) * inv_det;
+
+    b[2][0] = (a[1][0] * c4 - a[1][1] * c2 + a[1][3] * c0) * inv_det;
+    b[2][1] = (a[0][1] * c2 - a[0][0] * c4 - a[0][3] * c0) * inv_det;
+    b[2][2] = (a[3][0] * s4 - a[3][1] * s2 + a[3][3] * s0) * inv_det;
+    b[2][3] = (a[2][1] * s2 - a[2][0] * s4 - a[2][3] * s0) * inv_det;
+
+    b[3][0] = (a[1][1] * c1 - a[1][0] * c3 - a[1][2] * c0) * inv_det;
+    b[3][1] = (a[0][0] * c3 - a[0][1] * c1 + a[0][2] * c0) * inv_det;
+    b[3][2] = (a[3][1] * s1 - a[3][0] * s3 - a[3][2] * s0) * inv_det;
+    b[3][3] = (a[2][0] * s3 - a[2][1] * s1 + a[2][2] * s0) * inv_det;
+
+    return r.to_mat();
+}
+
+// Applies `op` to 8 matrices at a time. The last 1-7 go through a padded copy.
+template <Mat4x8 (*op)(const Mat4x8 &)>
+void map_matrices_soa(const fo::Matrix4x4 *src, fo::Matrix4x4 *dst, u32 count) {
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        simd::store_mat4x8(dst + i, op(simd::load_mat4x8(src + i)));
+    }
+
+    if (i < count) {
+        fo::Matrix4x4 padded[8];
+        const u32 n = count - i;
+        for (u32 j = 0; j < 8; ++j) {
+            padded[j] = j < n ? src[i + j] : eng::math::identity_matrix;
+        }
+        simd::store_mat4x8(padded, op(simd::load_mat4x8(padded)));
+        for (u32 j = 0; j < n; ++j) {
+            dst[i + j] = padded[j];
+        }
+    }
+}
+
+// -- Versors
+
+REALLY_INLINE Vec4x8 load_versors8(const fo::Quaternion *p, u32 stride) {
+    return simd::load_vec4x8(reinterpret_cast<const fo::Vector4 *>(p), stride);
+}
+
+REALLY_INLINE void store_versors8(fo::Quaternion *p, u32 stride, const Vec4x8 &q) {
+    simd::store_vec4x8(reinterpret_cast<fo::Vector4 *>(p), stride, q);
+}
+
+REALLY_INLINE Float8 load_alphas8(const float *alphas, u32 alpha_step) {
+    return alpha_step == 0 ? simd::splat8(alphas[0]) : simd::load8(alphas);
+}
+
+// nlerp along the shorter arc. With `fast_slerp`, alpha is first corrected so that the result follows the arc
+// like slerp does: t' = t + t (t - 1/2) (t - 1) (A (t - 1/2)^2 + B), where A and B are cubic and quadratic
+// polynomials in cos(theta) fitted to minimize the error of the resulting rotation (as in "Approximating slerp"
+// by Arseny Kapoulkine). Within 8e-4 radians of the exact slerp, where plain nlerp can be off by 0.14.
+template <bool fast_slerp> REALLY_INLINE Vec4x8 blend_versors_soa(const Vec4x8 &a, const Vec4x8 &b, Float8 t) {
+    using namespace simd;
+
+    const Float8 d = dot(a, b);
+    const Float8 sign = and8(d, splat8(-0.0f));
+    const Vec4x8 b_near = Vec4x8{ xor8(b.x, sign), xor8(b.y, sign), xor8(b.z, sign), xor8(b.w, sign) };
+
+    if (fast_slerp) {
+        const Float8 cos_theta = abs(d);
+        Float8 ka = mul_add(cos_theta, splat8(-1.43519f), splat8(3.55645f));
+        ka = mul_add(cos_theta, ka, splat8(-3.2452f));
+        ka = mul_add(cos_theta, ka, splat8(1.0904f));
+        Float8 kb = mul_add(cos_theta, splat8(0.215638f), splat8(-1.06021f));
+        kb = mul_add(cos_theta, kb, splat8(0.848013f));
+
+        const Float8 t_half = t - splat8(0.5f);
+        const Float8 k = mul_add(ka * t_half, t_half, kb);
+        t = mul_add(t * t_half * (t - splat8(1.0f)), k, t);
+    }
+
+    return normalize(a * (splat8(1.0f) - t) + b_near * t);
+}
+
+REALLY_INLINE Mat4x8 matrix_from_versor_soa(const Vec4x8 &q) {
+    using namespace simd;
+
+    const Float8 one = splat8(1.0f);
+    const Float8 zero = zero8();
+    const Float8 x2 = q.x + q.x;
+    const Float8 y2 = q.y + q.y;
+    const Float8 z2 = q.z + q.z;
+
+    const Float8 xx = q.x * x2, yy = q.y * y2, zz = q.z * z2;
+    const Float8 xy = q.x * y2, xz = q.x * z2, yz = q.y * z2;
+    const Float8 wx = q.w * x2, wy = q.w * y2, wz = q.w * z2;
+
+    return Mat4x8{ Vec4x8{ one - (yy + zz), xy + wz, xz - wy, zero },
+                   Vec4x8{ xy - wz, one - (xx + zz), yz + wx, zero },
+                   Vec4x8{ xz + wy, yz - wx, one - (xx + yy), zero },
+                   Vec4x8{ zero, zero, zero, one } };
+}
+
+void normalize_versors_soa(const fo::Quaternion *src, fo::Quaternion *dst, u32 count) {
+    constexpr u32 stride = sizeof(fo::Quaternion);
+
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        store_versors8(dst + i, stride, simd::normalize(load_versors8(src + i, stride)));
+    }
+
+    if (i < count) {
+        fo::Quaternion padded[8];
+        const u32 n = count - i;
+        for (u32 j = 0; j < 8; ++j) {
+            padded[j] = j < n ? src[i + j] : eng::math::identity_versor;
+        }
+        store_versors8(padded, stride, simd::normalize(load_versors8(padded, stride)));
+        for (u32 j = 0; j < n; ++j) {
+            dst[i + j] = padded[j];
+        }
+    }
+}
+
+template <bool fast_slerp>
+void blend_versors_n_soa(const fo::Quaternion *a,
+                         const fo::Quaternion *b,
+                         const float *alphas,
+                         u32 alpha_step,
+                         fo::Quaternion *dst,
+                         u32 count) {
+    constexpr u32 stride = sizeof(fo::Quaternion);
+
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const Float8 t = load_alphas8(alphas + i * alpha_step, alpha_step);
+        const Vec4x8 q = blend_versors_soa<fast_slerp>(load_versors8(a + i, stride), load_versors8(b + i, stride), t);
+        store_versors8(dst + i, stride, q);
+    }
+
+    if (i < count) {
+        fo::Quaternion padded_a[8];
+        fo::Quaternion padded_b[8];
+        alignas(32) float padded_alphas[8];
+        const u32 n = count - i;
+        for (u32 j = 0; j < 8; ++j) {
+            padded_a[j] = j < n ? a[i + j] : eng::math::identity_versor;
+            padded_b[j] = j < n ? b[i + j] : eng::math::identity_versor;
+            padded_alphas[j] = j < n ? alphas[(i + j) * alpha_step] : 0.0f;
+        }
+        const Vec4x8 q = blend_versors_soa<fast_slerp>(
+            load_versors8(padded_a, stride), load_versors8(padded_b, stride), simd::load8(padded_alphas));
+        store_versors8(padded_a, stride, q);
+        for (u32 j = 0; j < n; ++j) {
+            dst[i + j] = padded_a[j];
+        }
+    }
+}
+
+void matrix_from_versors_soa(const fo::Quaternion *src, fo::Matrix4x4 *dst, u32 count) {
+    constexpr u32 stride = sizeof(fo::Quaternion);
+
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        simd::store_mat4x8(dst + i, matrix_from_versor_soa(load_versors8(src + i, stride)));
+    }
+
+    if (i < count) {
+        fo::Quaternion padded[8];
+        fo::Matrix4x4 matrices[8];
+        const u32 n = count - i;
+        for (u32 j = 0; j < 8; ++j) {
+            padded[j] = j < n ? src[i + j] : eng::math::identity_versor;
+        }
+        simd::store_mat4x8(matrices, matrix_from_versor_soa(load_versors8(padded, stride)));
+        for (u32 j = 0; j < n; ++j) {
+            dst[i + j] = matrices[j];
+        }
+    }
+}
+
+// -- LocalTransforms. The scale and position are gathered with the strided Vec3x8 loads, which have a variant
+// taking the number of valid elements, so only the orientations need a padded copy at the tail.
+
+struct LocalTransform8 {
+    Vec3x8 scale;
+    Vec4x8 orientation;
+    Vec3x8 position;
+};
+
+// `n` is the number of valid elements, 1 to 8. `orientations` must have 8 valid elements.
+REALLY_INLINE LocalTransform8 load_local_transforms8(const eng::math::LocalTransform *p,
+                                                     const fo::Quaternion *orientations,
+                                                     u32 orientation_stride,
+                                                     u32 n) {
+    constexpr u32 stride = sizeof(eng::math::LocalTransform);
+    if (n == 8) {
+        return LocalTransform8{ simd::load_vec3x8(&p->scale, stride),
+                                load_versors8(orientations, orientation_stride),
+                                simd::load_vec3x8(&p->position, stride) };
+    }
+    return LocalTransform8{ simd::load_vec3x8(&p->scale, stride, n),
+                            load_versors8(orientations, orientation_stride),
+                            simd::load_vec3x8(&p->position, stride, n) };
+}
+
+// Copies the orientations of up to 8 transforms into `padded`, filling the rest with the identity.
+REALLY_INLINE void pad_orientations(const eng::math::LocalTransform *p, u32 n, fo::Quaternion *padded) {
+    for (u32 j = 0; j < 8; ++j) {
+        padded[j] = j < n ? p[j].orientation : eng::math::identity_versor;
+    }
+}
+
+void blend_local_transforms_soa(const eng::math::LocalTransform *a,
+                                const eng::math::LocalTransform *b,
+                                const float *alphas,
+                                u32 alpha_step,
+                                eng::math::LocalTransform *dst,
+                                u32 count) {
+    constexpr u32 stride = sizeof(eng::math::LocalTransform);
+
+    const auto blend = [](const LocalTransform8 &ta, const LocalTransform8 &tb, Float8 t, LocalTransform8 &out) {
+        const Float8 s = simd::splat8(1.0f) - t;
+        out.scale = ta.scale * s + tb.scale * t;
+        out.position = ta.position * s + tb.position * t;
+        out.orientation = blend_versors_soa<true>(ta.orientation, tb.orientation, t);
+    };
+
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        LocalTransform8 t;
+        blend(load_local_transforms8(a + i, &a[i].orientation, stride, 8),
+              load_local_transforms8(b + i, &b[i].orientation, stride, 8),
+              load_alphas8(alphas + i * alpha_step, alpha_step),
+              t);
+        simd::store_vec3x8(&dst[i].scale, stride, t.scale);
+        store_versors8(&dst[i].orientation, stride, t.orientation);
+        simd::store_vec3x8(&dst[i].position, stride, t.position);
+    }
+
+    if (i < count) {
+        constexpr u32 q_stride = sizeof(fo::Quaternion);
+        fo::Quaternion padded_a[8];
+        fo::Quaternion padded_b[8];
+        alignas(32) float padded_alphas[8];
+        const u32 n = count - i;
+        pad_orientations(a + i, n, padded_a);
+        pad_orientations(b + i, n, padded_b);
+        for (u32 j = 0; j < 8; ++j) {
+            padded_alphas[j] = j < n ? alphas[(i + j) * alpha_step] : 0.0f;
+        }
+
+        LocalTransform8 t;
+        blend(load_local_transforms8(a + i, padded_a, q_stride, n),
+              load_local_transforms8(b + i, padded_b, q_stride, n),
+              simd::load8(padded_alphas),
+              t);
+        store_versors8(padded_a, q_stride, t.orientation);
+        simd::store_vec3x8(&dst[i].scale, stride, n, t.scale);
+        simd::store_vec3x8(&dst[i].position, stride, n, t.position);
+        for (u32 j = 0; j < n; ++j) {
+            dst[i + j].orientation = padded_a[j];
+        }
+    }
+}
+
+// R * S, then the translation in the last column, same as LocalTransform::get_mat4
+REALLY_INLINE Mat4x8 matrix_from_local_transform_soa(const LocalTransform8 &t) {
+    Mat4x8 m = matrix_from_versor_soa(t.orientation);
+    m.x = m.x * t.scale.x;
+    m.y = m.y * t.scale.y;
+    m.z = m.z * t.scale.z;
+    m.t = Vec4x8{ t.position.x, t.position.y, t.position.z, simd::splat8(1.0f) };
+    return m;
+}
+
+void matrix_from_local_transforms_soa(const eng::math::LocalTransform *src,
+                                      fo::Matrix4x4 *dst,
+                                      u32 count) {
+    constexpr u32 stride = sizeof(eng::math::LocalTransform);
+
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const LocalTransform8 t = load_local_transforms8(src + i, &src[i].orientation, stride, 8);
+        simd::store_mat4x8(dst + i, matrix_from_local_transform_soa(t));
+    }
+
+    if (i < count) {
+        fo::Quaternion padded[8];
+        fo::Matrix4x4 matrices[8];
+        const u32 n = count - i;
+        pad_orientations(src + i, n, padded);
+        simd::store_mat4x8(matrices,
+                           matrix_from_local_transform_soa(
+                               load_local_transforms8(src + i, padded, sizeof(fo::Quaternion), n)));
+        for (u32 j = 0; j < n; ++j) {
+            dst[i + j] = matrices[j];
+        }
+    }
+}
+
+// -- Symmetric 3x3 eigensolver. Cyclic Jacobi: each rotation zeroes one off-diagonal element, and sweeping over
+// the three of them repeatedly converges quadratically. All lanes do the same rotations, so the sweeps go on
+// until every lane has converged.
+
+// Rotates rows/columns p and q to zero a_pq. r is the third index. v_p and v_q are the columns of the
+// accumulated rotation, which become the eigenvectors.
+REALLY_INLINE void jacobi_rotate(
+    Float8 &a_pp, Float8 &a_qq, Float8 &a_pq, Float8 &a_rp, Float8 &a_rq, Vec3x8 &v_p, Vec3x8 &v_q) {
+    using namespace simd;
+
+    // tan of the rotation angle, the smaller root of t^2 + 2 theta t - 1 = 0. A huge theta makes t = 0,
+    // a_pq = 0 would make it NaN so gets t = 0 explicitly.
+    const Float8 theta = (a_qq - a_pp) / (a_pq + a_pq);
+    const Float8 abs_theta = abs(theta);
+    Float8 t = splat8(1.0f) / (abs_theta + sqrt(mul_add(abs_theta, abs_theta, splat8(1.0f))));
+    t = xor8(t, and8(theta, splat8(-0.0f)));
+    t = select(cmp_eq(a_pq, zero8()), zero8(), t);
+
+    const Float8 c = splat8(1.0f) / sqrt(mul_add(t, t, splat8(1.0f)));
+    const Float8 s = t * c;
+
+    a_pp = a_pp - t * a_pq;
+    a_qq = mul_add(t, a_pq, a_qq);
+    a_pq = zero8();
+
+    const Float8 rp = a_rp;
+    a_rp = c * rp - s * a_rq;
+    a_rq = mul_add(s, rp, c * a_rq);
+
+    const Vec3x8 vp = v_p;
+    v_p = vp * c - v_q * s;
+    v_q = vp * s + v_q * c;
+}
+
+// Swaps eigenpairs i and j in the lanes where eigenvalue i is smaller
+REALLY_INLINE void sort_eigenpair(Float8 &value_i, Float8 &value_j, Vec3x8 &vector_i, Vec3x8 &vector_j) {
+    const Float8 swap = simd::cmp_lt(value_i, value_j);
+    const Float8 vi = value_i;
+    const Vec3x8 ui = vector_i;
+    value_i = simd::select(swap, value_j, vi);
+    value_j = simd::select(swap, vi, value_j);
+    vector_i = simd::select(swap, vector_j, ui);
+    vector_j = simd::select(swap, ui, vector_j);
+}
+
+// Results in the same form as eigensolve_sym3x3: decreasing eigenvalues, right-handed eigenvectors.
+REALLY_INLINE void jacobi_eigensolve_soa(const Vec3x8 &col_x,
+                                         const Vec3x8 &col_y,
+                                         const Vec3x8 &col_z,
+                                         Vec3x8 &eigenvalues,
+                                         Vec3x8 &vx,
+                                         Vec3x8 &vy,
+                                         Vec3x8 &vz) {
+    using namespace simd;
+
+    constexpr int max_sweeps = 8;
+    // Converged when the off-diagonal elements are around 1e-6 of the diagonal
+    const Float8 tolerance = splat8(1e-12f);
+
+    // Scaled so the largest element is 1, which keeps the squares below from overflowing or underflowing
+    Float8 scale = max(max(abs(col_x.x), abs(col_y.x)), max(abs(col_z.x), abs(col_y.y)));
+    scale = max(scale, max(abs(col_z.y), abs(col_z.z)));
+    scale = select(cmp_eq(scale, zero8()), splat8(1.0f), scale);
+    const Float8 inv_scale = splat8(1.0f) / scale;
+
+    Float8 a00 = col_x.x * inv_scale;
+    Float8 a01 = col_y.x * inv_scale;
+    Float8 a02 = col_z.x * inv_scale;
+    Float8 a11 = col_y.y * inv_scale;
+    Float8 a12 = col_z.y * inv_scale;
+    Float8 a22 = col_z.z * inv_scale;
+
+    const Float8 one = splat8(1.0f);
+    const Float8 zero = zero8();
+    vx = Vec3x8{ one, zero, zero };
+    vy = Vec3x8{ zero, one, zero };
+    vz = Vec3x8{ zero, zero, one };
+
+    for (int sweep = 0; sweep < max_sweeps; ++sweep) {
+        const Float8 off = mul_add(a01, a01, mul_add(a02, a02, a12 * a12));
+        const Float8 diag = mul_add(a00, a00, mul_add(a11, a11, a22 * a22));
+        if (all(cmp_le(off, diag * tolerance))) {
+            break;
+        }
+
+        jacobi_rotate(a00, a11, a01, a02, a12, vx, vy);
+        jacobi_rotate(a00, a22, a02, a01, a12, vx, vz);
+        jacobi_rotate(a11, a22, a12, a01, a02, vy, vz);
+    }
+
+    Float8 l0 = a00 * scale;
+    Float8 l1 = a11 * scale;
+    Float8 l2 = a22 * scale;
+    sort_eigenpair(l0, l1, vx, vy);
+    sort_eigenpair(l1, l2, vy, vz);
+    sort_eigenpair(l0, l1, vx, vy);
+
+    eigenvalues = Vec3x8{ l0, l1, l2 };
+    vz = cross3(vx, vy);
+}
+
+void eigensolve_sym3x3_soa(const fo::Matrix3x3 *symm, eng::math::SymmetricEigenSolver3x3_Result *out, u32 count) {
+    constexpr u32 stride = sizeof(fo::Matrix3x3);
+    constexpr u32 out_stride = sizeof(eng::math::SymmetricEigenSolver3x3_Result);
+
+    for (u32 i = 0; i < count; i += 8) {
+        const u32 n = count - i < 8 ? count - i : 8;
+
+        Vec3x8 x, y, z;
+        if (n == 8) {
+            x = simd::load_vec3x8(&symm[i].x, stride);
+            y = simd::load_vec3x8(&symm[i].y, stride);
+            z = simd::load_vec3x8(&symm[i].z, stride);
+        } else {
+            x = simd::load_vec3x8(&symm[i].x, stride, n);
+            y = simd::load_vec3x8(&symm[i].y, stride, n);
+            z = simd::load_vec3x8(&symm[i].z, stride, n);
+        }
+
+        Vec3x8 eigenvalues, vx, vy, vz;
+        jacobi_eigensolve_soa(x, y, z, eigenvalues, vx, vy, vz);
+
+        if (n == 8) {
+            simd::store_vec3x8(&out[i].eigenvalues, out_stride, eigenvalues);
+            simd::store_vec3x8(&out[i].eigenvectors.x, out_stride, vx);
+            simd::store_vec3x8(&out[i].eigenvectors.y, out_stride, vy);
+            simd::store_vec3x8(&out[i].eigenvectors.z, out_stride, vz);
+        } else {
+            simd::store_vec3x8(&out[i].eigenvalues, out_stride, n, eigenvalues);
+            simd::store_vec3x8(&out[i].eigenvectors.x, out_stride, n, vx);
+            simd::store_vec3x8(&out[i].eigenvectors.y, out_stride, n, vy);
+            simd::store_vec3x8(&out[i].eigenvectors.z, out_stride, n, vz);
+        }
+    }
+}
+
+// -- Packed attribute formats
+
+// The first n (1 to 4) numbers at p in the low lanes, zero in the rest. Nothing past them is read or written.
+REALLY_INLINE __m128 load_partial(const float *p, u32 n) {
+    switch (n) {
+    case 1: return _mm_load_ss(p);
+    case 2: return _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double *>(p)));
+    case 3: return load_vec3(reinterpret_cast<const fo::Vector3 *>(p));
+    default: return _mm_loadu_ps(p);
+    }
+}
+
+REALLY_INLINE void store_partial(float *p, __m128 v, u32 n) {
+    switch (n) {
+    case 1: _mm_store_ss(p, v); break;
+    case 2: _mm_storel_pi(reinterpret_cast<__m64 *>(p), v); break;
+    case 3: store_vec3(reinterpret_cast<fo::Vector3 *>(p), v); break;
+    default: _mm_storeu_ps(p, v); break;
+    }
+}
+
+// 16 bit numbers go in the low 64 bits of the register
+REALLY_INLINE __m128i load_partial(const u16 *p, u32 n) {
+    u64 bits = 0;
+    switch (n) {
+    case 1: memcpy(&bits, p, 2); break;
+    case 2: memcpy(&bits, p, 4); break;
+    case 3: memcpy(&bits, p, 6); break;
+    default: memcpy(&bits, p, 8); break;
+    }
+    return _mm_loadl_epi64(reinterpret_cast<const __m128i *>(&bits));
+}
+
+REALLY_INLINE void store_partial(u16 *p, __m128i v, u32 n) {
+    u64 bits;
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(&bits), v);
+    switch (n) {
+    case 1: memcpy(p, &bits, 2); break;
+    case 2: memcpy(p, &bits, 4); break;
+    case 3: memcpy(p, &bits, 6); break;
+    default: memcpy(p, &bits, 8); break;
+    }
+}
+
+REALLY_INLINE void store_partial(i16 *p, __m128i v, u32 n) { store_partial(reinterpret_cast<u16 *>(p), v, n); }
+
+// 8 bit numbers in the low 32 bits
+REALLY_INLINE void store_partial(u8 *p, __m128i v, u32 n) {
+    const u32 bits = (u32)_mm_cvtsi128_si32(v);
+    switch (n) {
+    case 1: memcpy(p, &bits, 1); break;
+    case 2: memcpy(p, &bits, 2); break;
+    case 3: memcpy(p, &bits, 3); break;
+    default: memcpy(p, &bits, 4); break;
+    }
+}
+
+// Calls `convert` on the numbers of each element, or on runs of 4 numbers when both arrays are tightly packed.
+template <typename Src, typename Dst, typename Convert>
+REALLY_INLINE void convert_attributes(
+    const Src *src, u32 src_stride, Dst *dst, u32 dst_stride, u32 count, u32 components, Convert convert) {
+    if (src_stride == components * sizeof(Src) && dst_stride == components * sizeof(Dst)) {
+        const u32 total = count * components;
+        u32 i = 0;
+        for (; i + 4 <= total; i += 4) {
+            store_partial(dst + i, convert(load_partial(src + i, 4)), 4);
+        }
+        if (i < total) {
+            store_partial(dst + i, convert(load_partial(src + i, total - i)), total - i);
+        }
+        return;
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        store_partial(dst, convert(load_partial(src, components)), components);
+        src = advance_bytes(src, src_stride);
+        dst = advance_bytes(dst, dst_stride);
+    }
+}
+
+// round(clamp(f, -1, 1) * 32767) in each 32 bit lane. max_ps returns its second operand if either is NaN.
+REALLY_INLINE __m128i snorm16_lanes(__m128 f) {
+    const __m128 clamped = _mm_min_ps(_mm_max_ps(f, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+    return _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(32767.0f)));
+}
+
+REALLY_INLINE __m128i unorm8_lanes(__m128 f) {
+    const __m128 clamped = _mm_min_ps(_mm_max_ps(f, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    return _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(255.0f)));
+}
+
+// ±1 with the sign of x, including that of ±0
+REALLY_INLINE Float8 sign_not_zero(Float8 x) {
+    return simd::or8(simd::and8(x, simd::splat8(-0.0f)), simd::splat8(1.0f));
+}
+
+// Writes the first n of 8 (u, v) pairs as snorm16s
+REALLY_INLINE void store_snorm16x2(i16 *dst, u32 dst_stride, Float8 u, Float8 v, u32 n) {
+    for (u32 half = 0; half < 2 && half * 4 < n; ++half) {
+        const __m128i ui = snorm16_lanes(half == 0 ? simd::low_half(u) : simd::high_half(u));
+        const __m128i vi = snorm16_lanes(half == 0 ? simd::low_half(v) : simd::high_half(v));
+
+        // u0 v0 u1 v1 u2 v2 u3 v3
+        alignas(16) u32 pairs[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(pairs),
+                        _mm_packs_epi32(_mm_unpacklo_epi32(ui, vi), _mm_unpackhi_epi32(ui, vi)));
+
+        for (u32 k = 0; k < 4 && half * 4 + k < n; ++k) {
+            memcpy(dst, &pairs[k], 4);
+            dst = advance_bytes(dst, dst_stride);
+        }
+    }
+}
+
+// Reads the first n of 8 (u, v) snorm16 pairs, the unused lanes are zero
+REALLY_INLINE void load_snorm16x2(const i16 *src, u32 src_stride, u32 n, Float8 &u, Float8 &v) {
+    alignas(16) u32 pairs[8] = {};
+    for (u32 k = 0; k < n; ++k) {
+        memcpy(&pairs[k], src, 4);
+        src = advance_bytes(src, src_stride);
+    }
+
+    __m128 u_halves[2], v_halves[2];
+    for (int half = 0; half < 2; ++half) {
+        const __m128i w = _mm_load_si128(reinterpret_cast<const __m128i *>(pairs + 4 * half));
+        u_halves[half] = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(w, 16), 16));
+        v_halves[half] = _mm_cvtepi32_ps(_mm_srai_epi32(w, 16));
+    }
+
+    const Float8 scale = simd::splat8(1.0f / 32767.0f);
+    const Float8 minus_one = simd::splat8(-1.0f);
+    u = simd::max(simd::from_halves(u_halves[0], u_halves[1]) * scale, minus_one);
+    v = simd::max(simd::from_halves(v_halves[0], v_halves[1]) * scale, minus_one);
+}
+
+// Same steps as the scalar encode_octahedral_snorm16 and decode_octahedral_snorm16, 8 vectors at a time
+void encode_octahedral_soa(const fo::Vector3 *src, u32 src_stride, i16 *dst, u32 dst_stride, u32 count) {
+    const Float8 one = simd::splat8(1.0f);
+
+    for (u32 i = 0; i < count; i += 8) {
+        const u32 n = count - i < 8 ? count - i : 8;
+        const Vec3x8 v = n == 8 ? simd::load_vec3x8(src, src_stride) : simd::load_vec3x8(src, src_stride, n);
+
+        // Project onto the octahedron |x| + |y| + |z| = 1, then fold the lower half over the diagonals
+        const Float8 l1 = simd::abs(v.x) + simd::abs(v.y) + simd::abs(v.z);
+        const Float8 inv_l1 = one / simd::max(l1, simd::splat8(1e-30f));
+        const Float8 x = v.x * inv_l1;
+        const Float8 y = v.y * inv_l1;
+
+        const Float8 lower = simd::cmp_lt(v.z, simd::zero8());
+        const Float8 folded_x = (one - simd::abs(y)) * sign_not_zero(x);
+        const Float8 folded_y = (one - simd::abs(x)) * sign_not_zero(y);
+
+        store_snorm16x2(dst, dst_stride, simd::select(lower, folded_x, x), simd::select(lower, folded_y, y), n);
+
+        src = advance_bytes(src, 8 * src_stride);
+        dst = advance_bytes(dst, 8 * dst_stride);
+    }
+}
+
+void decode_octahedral_soa(const i16 *src, u32 src_stride, fo::Vector3 *dst, u32 dst_stride, u32 count) {
+    const Float8 one = simd::splat8(1.0f);
+
+    for (u32 i = 0; i < count; i += 8) {
+        const u32 n = count - i < 8 ? count - i : 8;
+
+        Float8 x, y;
+        load_snorm16x2(src, src_stride, n, x, y);
+
+        // Unfold the lower half
+        const Float8 z = one - simd::abs(x) - simd::abs(y);
+        const Float8 t = simd::max(simd::negate(z), simd::zero8());
+        x = x - t * sign_not_zero(x);
+        y = y - t * sign_not_zero(y);
+
+        const Vec3x8 d = simd::normalize(Vec3x8{ x, y, z });
+        if (n == 8) {
+            simd::store_vec3x8(dst, dst_stride, d);
+        } else {
+            simd::store_vec3x8(dst, dst_stride, n, d);
+        }
+
+        src = advance_bytes(src, 8 * src_stride);
+        dst = advance_bytes(dst, 8 * dst_stride);
+    }
+}
+
+// -- Reductions over points
+
+// The float sums of each lane cover this many points / 8 before going into the double totals
+constexpr u32 k_points_per_float_block = 1024;
+
+REALLY_INLINE Vec3x8 load_points8(const fo::Vector3 *p, u32 stride) {
+    return stride == sizeof(fo::Vector3) ? simd::load_vec3x8(p) : simd::load_vec3x8(p, stride);
+}
+
+// Adds the lanes to `total` in lane order
+REALLY_INLINE void add_lanes(Float8 v, double &total) {
+    alignas(32) float lanes[8];
+    simd::store8(lanes, v);
+    for (int i = 0; i < 8; ++i) {
+        total += lanes[i];
+    }
+}
+
+REALLY_INLINE float min_of_lanes(Float8 v) {
+    alignas(32) float lanes[8];
+    simd::store8(lanes, v);
+    float m = lanes[0];
+    for (int i = 1; i < 8; ++i) {
+        m = lanes[i] < m ? lanes[i] : m;
+    }
+    return m;
+}
+
+REALLY_INLINE float max_of_lanes(Float8 v) {
+    alignas(32) float lanes[8];
+    simd::store8(lanes, v);
+    float m = lanes[0];
+    for (int i = 1; i < 8; ++i) {
+        m = lanes[i] > m ? lanes[i] : m;
+    }
+    return m;
+}
+
+// The last 0-7 points are done one at a time, so no lanes have to be masked off.
+void bounds_soa(const fo::Vector3 *points, u32 stride, u32 count, fo::Vector3 &min_out, fo::Vector3 &max_out) {
+    Vec3x8 lo = simd::splat3x8(*points);
+    Vec3x8 hi = lo;
+
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const Vec3x8 p = load_points8(points, stride);
+        lo = simd::min(lo, p);
+        hi = simd::max(hi, p);
+        points = advance_bytes(points, 8 * stride);
+    }
+
+    fo::Vector3 mn{ min_of_lanes(lo.x), min_of_lanes(lo.y), min_of_lanes(lo.z) };
+    fo::Vector3 mx{ max_of_lanes(hi.x), max_of_lanes(hi.y), max_of_lanes(hi.z) };
+    for (; i < count; ++i) {
+        const fo::Vector3 &p = *points;
+        mn = fo::Vector3{ p.x < mn.x ? p.x : mn.x, p.y < mn.y ? p.y : mn.y, p.z < mn.z ? p.z : mn.z };
+        mx = fo::Vector3{ p.x > mx.x ? p.x : mx.x, p.y > mx.y ? p.y : mx.y, p.z > mx.z ? p.z : mx.z };
+        points = advance_bytes(points, stride);
+    }
+
+    min_out = mn;
+    max_out = mx;
+}
+
+void sum_soa(const fo::Vector3 *points, u32 stride, u32 count, double sum_out[3]) {
+    double total[3] = { 0.0, 0.0, 0.0 };
+
+    u32 i = 0;
+    while (i + 8 <= count) {
+        const u32 block_end = count - i > k_points_per_float_block ? i + k_points_per_float_block : count;
+
+        Vec3x8 sum = simd::splat3x8(fo::Vector3{ 0.0f, 0.0f, 0.0f });
+        for (; i + 8 <= block_end; i += 8) {
+            sum = sum + load_points8(points, stride);
+            points = advance_bytes(points, 8 * stride);
+        }
+
+        add_lanes(sum.x, total[0]);
+        add_lanes(sum.y, total[1]);
+        add_lanes(sum.z, total[2]);
+    }
+
+    for (; i < count; ++i) {
+        total[0] += points->x;
+        total[1] += points->y;
+        total[2] += points->z;
+        points = advance_bytes(points, stride);
+    }
+
+    sum_out[0] = total[0];
+    sum_out[1] = total[1];
+    sum_out[2] = total[2];
+}
+
+void covariance_soa(
+    const fo::Vector3 *points, u32 stride, u32 count, const fo::Vector3 &mean, double sums_out[6]) {
+    double total[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    const Vec3x8 m = simd::splat3x8(mean);
+
+    u32 i = 0;
+    while (i + 8 <= count) {
+        const u32 block_end = count - i > k_points_per_float_block ? i + k_points_per_float_block : count;
+
+        Float8 xx = simd::zero8(), yy = simd::zero8(), zz = simd::zero8();
+        Float8 xy = simd::zero8(), xz = simd::zero8(), yz = simd::zero8();
+        for (; i + 8 <= block_end; i += 8) {
+            const Vec3x8 d = load_points8(points, stride) - m;
+            xx = simd::mul_add(d.x, d.x, xx);
+            yy = simd::mul_add(d.y, d.y, yy);
+            zz = simd::mul_add(d.z, d.z, zz);
+            xy = simd::mul_add(d.x, d.y, xy);
+            xz = simd::mul_add(d.x, d.z, xz);
+            yz = simd::mul_add(d.y, d.z, yz);
+            points = advance_bytes(points, 8 * stride);
+        }
+
+        add_lanes(xx, total[0]);
+        add_lanes(yy, total[1]);
+        add_lanes(zz, total[2]);
+        add_lanes(xy, total[3]);
+        add_lanes(xz, total[4]);
+        add_lanes(yz, total[5]);
+    }
+
+    for (; i < count; ++i) {
+        const double dx = points->x - mean.x;
+        const double dy = points->y - mean.y;
+        const double dz = points->z - mean.z;
+        total[0] += dx * dx;
+        total[1] += dy * dy;
+        total[2] += dz * dz;
+        total[3] += dx * dy;
+        total[4] += dx * dz;
+        total[5] += dy * dz;
+        points = advance_bytes(points, stride);
+    }
+
+    for (int k = 0; k < 6; ++k) {
+        sums_out[k] = total[k];
+    }
+}
+
+// Greatest of the lanes, and the lowest index among the lanes that have it
+REALLY_INLINE void argmax_of_lanes(Float8 values, Float8 indices, float &value_out, u32 &index_out) {
+    alignas(32) float v[8];
+    alignas(32) float idx[8];
+    simd::store8(v, values);
+    simd::store8(idx, indices);
+
+    u32 best = 0;
+    for (u32 i = 1; i < 8; ++i) {
+        if (v[i] > v[best] || (v[i] == v[best] && idx[i] < idx[best])) {
+            best = i;
+        }
+    }
+    value_out = v[best];
+    index_out = u32(idx[best]);
+}
+
+REALLY_INLINE Float8 first_lane_indices() {
+    alignas(32) static const float indices[8] = { 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f };
+    return simd::load8(indices);
+}
+
+// The smallest dot products are found as the largest negated ones, so both sides keep the first index they see.
+void extreme_points_soa(const fo::Vector3 *points,
+                        u32 stride,
+                        u32 count,
+                        const fo::Vector3 *directions,
+                        u32 num_directions,
+                        u32 *min_indices_out,
+                        u32 *max_indices_out) {
+    Vec3x8 dirs[k_max_extreme_directions];
+    Float8 hi[k_max_extreme_directions], lo[k_max_extreme_directions];
+    Float8 hi_index[k_max_extreme_directions], lo_index[k_max_extreme_directions];
+
+    for (u32 d = 0; d < num_directions; ++d) {
+        dirs[d] = simd::splat3x8(directions[d]);
+        hi[d] = simd::splat8(-INFINITY);
+        lo[d] = simd::splat8(-INFINITY);
+        hi_index[d] = simd::zero8();
+        lo_index[d] = simd::zero8();
+    }
+
+    const fo::Vector3 *p = points;
+    Float8 indices = first_lane_indices();
+    const Float8 eight = simd::splat8(8.0f);
+
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const Vec3x8 v = load_points8(p, stride);
+        for (u32 d = 0; d < num_directions; ++d) {
+            const Float8 dot = simd::dot(v, dirs[d]);
+            const Float8 neg_dot = simd::negate(dot);
+            const Float8 higher = simd::cmp_gt(dot, hi[d]);
+            const Float8 lower = simd::cmp_gt(neg_dot, lo[d]);
+            hi[d] = simd::select(higher, dot, hi[d]);
+            hi_index[d] = simd::select(higher, indices, hi_index[d]);
+            lo[d] = simd::select(lower, neg_dot, lo[d]);
+            lo_index[d] = simd::select(lower, indices, lo_index[d]);
+        }
+        indices = indices + eight;
+        p = advance_bytes(p, 8 * stride);
+    }
+
+    for (u32 d = 0; d < num_directions; ++d) {
+        float max_dot, neg_min_dot;
+        u32 max_index = 0, min_index = 0;
+        if (i != 0) {
+            argmax_of_lanes(hi[d], hi_index[d], max_dot, max_index);
+            argmax_of_lanes(lo[d], lo_index[d], neg_min_dot, min_index);
+        } else {
+            max_dot = -INFINITY;
+            neg_min_dot = -INFINITY;
+        }
+
+        const fo::Vector3 *tail = p;
+        for (u32 j = i; j < count; ++j) {
+            const fo::Vector3 &dir = directions[d];
+            const float dot = tail->x * dir.x + tail->y * dir.y + tail->z * dir.z;
+            if (dot > max_dot) {
+                max_dot = dot;
+                max_index = j;
+            }
+            if (-dot > neg_min_dot) {
+                neg_min_dot = -dot;
+                min_index = j;
+            }
+            tail = advance_bytes(tail, stride);
+        }
+
+        max_indices_out[d] = max_index;
+        min_indices_out[d] = min_index;
+    }
+}
+
+void farthest_point_soa(
+    const fo::Vector3 *points, u32 stride, u32 count, const fo::Vector3 &from, u32 &index_out, float &dist2_out) {
+    const Vec3x8 center = simd::splat3x8(from);
+    Float8 farthest = simd::splat8(-1.0f);
+    Float8 farthest_index = simd::zero8();
+    Float8 indices = first_lane_indices();
+    const Float8 eight = simd::splat8(8.0f);
+
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const Vec3x8 d = load_points8(points, stride) - center;
+        const Float8 dist2 = simd::dot(d, d);
+        const Float8 farther = simd::cmp_gt(dist2, farthest);
+        farthest = simd::select(farther, dist2, farthest);
+        farthest_index = simd::select(farther, indices, farthest_index);
+        indices = indices + eight;
+        points = advance_bytes(points, 8 * stride);
+    }
+
+    float max_dist2 = -1.0f;
+    u32 max_index = 0;
+    if (i != 0) {
+        argmax_of_lanes(farthest, farthest_index, max_dist2, max_index);
+    }
+
+    for (; i < count; ++i) {
+        const fo::Vector3 d = *points - from;
+        const float dist2 = d.x * d.x + d.y * d.y + d.z * d.z;
+        if (dist2 > max_dist2) {
+            max_dist2 = dist2;
+            max_index = i;
+        }
+        points = advance_bytes(points, stride);
+    }
+
+    index_out = max_index;
+    dist2_out = max_dist2;
+}
+
+// -- Frustum culling
+
+// The 6 planes splatted, and which side of each axis their normals point to. The corner of a box farthest along a
+// normal takes its max coordinate on the axes the normal is positive on and its min on the others, so the octant
+// picks the corner without looking at the box.
+struct CullPlanes8 {
+    Vec3x8 normal[6];
+    Float8 d[6];
+    bool positive[6][3];
+};
+
+REALLY_INLINE CullPlanes8 splat_cull_planes(const fo::Vector4 *planes) {
+    CullPlanes8 p8;
+    for (u32 p = 0; p < 6; ++p) {
+        const fo::Vector4 &plane = planes[p];
+        p8.normal[p] = simd::splat3x8(fo::Vector3{ plane.x, plane.y, plane.z });
+        p8.d[p] = simd::splat8(plane.w);
+        p8.positive[p][0] = plane.x > 0.0f;
+        p8.positive[p][1] = plane.y > 0.0f;
+        p8.positive[p][2] = plane.z > 0.0f;
+    }
+    return p8;
+}
+
+REALLY_INLINE Float8 spheres_outside(const CullPlanes8 &planes, u32 p, const Vec4x8 &spheres) {
+    const Float8 dist = simd::dot(planes.normal[p], Vec3x8{ spheres.x, spheres.y, spheres.z }) + planes.d[p];
+    return simd::cmp_lt(dist, simd::negate(spheres.w));
+}
+
+REALLY_INLINE Float8 boxes_outside(const CullPlanes8 &planes, u32 p, const Vec3x8 &min, const Vec3x8 &max) {
+    const bool *positive = planes.positive[p];
+    const Vec3x8 corner{ positive[0] ? max.x : min.x, positive[1] ? max.y : min.y, positive[2] ? max.z : min.z };
+    return simd::cmp_lt(simd::dot(planes.normal[p], corner) + planes.d[p], simd::zero8());
+}
+
+// Lanes not entirely outside any plane, as bits. `outside_of(p)` gives the lanes outside plane p. The plane in
+// `*cache` goes first, and a plane that culls all 8 lanes is put there for next time. Groups of objects that are
+// near each other tend to be culled by the same plane frame after frame, so those take a single plane test.
+template <typename OutsideFn> REALLY_INLINE u32 visible_lanes(OutsideFn &&outside_of, u8 *cache) {
+    const u32 first = cache && *cache < 6 ? *cache : 0;
+
+    Float8 outside = outside_of(first);
+    if (simd::all(outside)) {
+        return 0;
+    }
+
+    for (u32 p = 0; p < 6; ++p) {
+        if (p == first) {
+            continue;
+        }
+        outside = outside | outside_of(p);
+        if (simd::all(outside)) {
+            if (cache) {
+                *cache = u8(p);
+            }
+            return 0;
+        }
+    }
+    return u32(~simd::movemask(outside)) & 0xffu;
+}
+
+// Calls `visible_in_group(i, n, cache)` on each group of 8 objects starting at i, n of which are real (the last
+// group can be short), and stores the bits it returns, cleared past `count`.
+template <typename GroupFn>
+REALLY_INLINE void for_each_cull_group(u32 count, u8 *visible_bits, u8 *plane_cache, GroupFn &&visible_in_group) {
+    for (u32 i = 0, g = 0; i < count; i += 8, ++g) {
+        const u32 n = count - i < 8 ? count - i : 8;
+        const u32 bits = visible_in_group(i, n, plane_cache ? plane_cache + g : nullptr);
+        visible_bits[g] = u8(bits & ((1u << n) - 1));
+    }
+}
+
+// Copies n < 8 elements to the front of a zeroed block of 8 so the usual loads can be used on it
+template <typename T> REALLY_INLINE void copy_to_block8(const T *src, u32 n, T (&block)[8]) {
+    memset(block, 0, sizeof(block));
+    memcpy(block, src, n * sizeof(T));
+}
+
+void cull_spheres_soa(
+    const fo::Vector4 *planes, const fo::Vector4 *spheres, u32 count, u8 *visible_bits, u8 *plane_cache) {
+    const CullPlanes8 p8 = splat_cull_planes(planes);
+    for_each_cull_group(count, visible_bits, plane_cache, [&](u32 i, u32 n, u8 *cache) {
+        Vec4x8 s;
+        if (n == 8) {
+            s = simd::load_vec4x8(spheres + i);
+        } else {
+            fo::Vector4 block[8];
+            copy_to_block8(spheres + i, n, block);
+            s = simd::load_vec4x8(block);
+        }
+        return visible_lanes([&](u32 p) { return spheres_outside(p8, p, s); }, cache);
+    });
+}
+
+void cull_aabbs_soa(const fo::Vector4 *planes, const fo::AABB *boxes, u32 count, u8 *visible_bits, u8 *plane_cache) {
+    const CullPlanes8 p8 = splat_cull_planes(planes);
+    for_each_cull_group(count, visible_bits, plane_cache, [&](u32 i, u32 n, u8 *cache) {
+        fo::AABB block[8];
+        const fo::AABB *b = boxes + i;
+        if (n != 8) {
+            copy_to_block8(b, n, block);
+            b = block;
+        }
+        const Vec3x8 min = simd::load_vec3x8(&b->min, sizeof(fo::AABB));
+        const Vec3x8 max = simd::load_vec3x8(&b->max, sizeof(fo::AABB));
+        return visible_lanes([&](u32 p) { return boxes_outside(p8, p, min, max); }, cache);
+    });
+}
+
+REALLY_INLINE Float8 load_cull_lanes(const float *p, u32 i, u32 n) {
+    if (n == 8) {
+        return simd::load8(p + i);
+    }
+    float block[8];
+    copy_to_block8(p + i, n, block);
+    return simd::load8(block);
+}
+
+void cull_sphere_arrays_soa(const fo::Vector4 *planes,
+                            const float *const center[3],
+                            const float *radius,
+                            u32 count,
+                            u8 *visible_bits,
+                            u8 *plane_cache) {
+    const CullPlanes8 p8 = splat_cull_planes(planes);
+    for_each_cull_group(count, visible_bits, plane_cache, [&](u32 i, u32 n, u8 *cache) {
+        const Vec4x8 s{ load_cull_lanes(center[0], i, n),
+                        load_cull_lanes(center[1], i, n),
+                        load_cull_lanes(center[2], i, n),
+                        load_cull_lanes(radius, i, n) };
+        return visible_lanes([&](u32 p) { return spheres_outside(p8, p, s); }, cache);
+    });
+}
+
+void cull_aabb_arrays_soa(const fo::Vector4 *planes,
+                          const float *const min[3],
+                          const float *const max[3],
+                          u32 count,
+                          u8 *visible_bits,
+                          u8 *plane_cache) {
+    const CullPlanes8 p8 = splat_cull_planes(planes);
+    for_each_cull_group(count, visible_bits, plane_cache, [&](u32 i, u32 n, u8 *cache) {
+        const Vec3x8 lo{
+            load_cull_lanes(min[0], i, n), load_cull_lanes(min[1], i, n), load_cull_lanes(min[2], i, n)
+        };
+        const Vec3x8 hi{
+            load_cull_lanes(max[0], i, n), load_cull_lanes(max[1], i, n), load_cull_lanes(max[2], i, n)
+        };
+        return visible_lanes([&](u32 p) { return boxes_outside(p8, p, lo, hi); }, cache);
+    });
+}
+
+// Each row of a triangle's bounds is done in blocks of 8 pixels starting at a multiple of 8, which never go past
+// the end of the row as the width is a multiple of 8. The lanes outside the edges or the bounds are masked off.
+// Every block is stored, masked or not, which is cheaper than branching on blocks the triangle misses. The edge
+// values and depth are stepped from one block to the next, so they can come out a little different from the
+// scalar kernel's right on the edges.
+void rasterize_occluders_soa(
+    const OccluderTriangle *triangles, u32 count, float *depth, u32 width, u32 row_begin, u32 row_end) {
+    const Float8 lane_offsets = simd::from_lanes(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    const Float8 eight = simd::splat8(8.0f);
+    const Float8 zero = simd::zero8();
+
+    for (u32 t = 0; t < count; ++t) {
+        const OccluderTriangle &tri = triangles[t];
+        const i32 y_begin = tri.min_y > i32(row_begin) ? tri.min_y : i32(row_begin);
+        const i32 y_end = tri.max_y + 1 < i32(row_end) ? tri.max_y + 1 : i32(row_end);
+        if (y_begin >= y_end) {
+            continue;
+        }
+
+        const Float8 a0 = simd::splat8(tri.edge_a[0]);
+        const Float8 a1 = simd::splat8(tri.edge_a[1]);
+        const Float8 a2 = simd::splat8(tri.edge_a[2]);
+        const Float8 dzdx = simd::splat8(tri.depth_dx);
+        const Float8 step0 = a0 * eight;
+        const Float8 step1 = a1 * eight;
+        const Float8 step2 = a2 * eight;
+        const Float8 step_z = dzdx * eight;
+
+        const i32 x_begin = tri.min_x & ~7;
+        const Float8 first_px = simd::splat8(float(x_begin)) + lane_offsets;
+        const Float8 first_x = simd::splat8(float(tri.min_x));
+        const Float8 last_x = simd::splat8(float(tri.max_x) + 1.0f);
+
+        for (i32 y = y_begin; y < y_end; ++y) {
+            const float py = float(y) + 0.5f;
+            Float8 e0 = a0 * first_px + simd::splat8(tri.edge_b[0] * py + tri.edge_c[0]);
+            Float8 e1 = a1 * first_px + simd::splat8(tri.edge_b[1] * py + tri.edge_c[1]);
+            Float8 e2 = a2 * first_px + simd::splat8(tri.edge_b[2] * py + tri.edge_c[2]);
+            Float8 z = dzdx * first_px + simd::splat8(tri.depth_dy * py + tri.depth_c);
+            Float8 px = first_px;
+            float *row = depth + size_t(y) * width;
+
+            for (i32 x = x_begin; x <= tri.max_x; x += 8) {
+                const Float8 inside = simd::cmp_ge(e0, zero) & simd::cmp_ge(e1, zero) & simd::cmp_ge(e2, zero) &
+                                      simd::cmp_gt(px, first_x) & simd::cmp_lt(px, last_x);
+                const Float8 d = simd::load8(row + x);
+                simd::store8(row + x, simd::select(inside, simd::min(d, z), d));
+
+                e0 = e0 + step0;
+                e1 = e1 + step1;
+                e2 = e2 + step2;
+                z = z + step_z;
+                px = px + eight;
+            }
+        }
+    }
+}
+
+} // namespace
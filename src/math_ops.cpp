@@ -1,9 +1,11 @@
 // Contains the non-inline functions from math_ops.h
 
+#include "math_kernels.h"
 #include "robust_eigensolver.h"
 
 #include <learnogl/kitchen_sink.h>
 #include <learnogl/math_ops.h>
+#include <learnogl/parallel_for.h>
 #include <learnogl/vmath.h>
 #include <scaffold/const_log.h>
 #include <scaffold/debug.h>
@@ -70,6 +72,174 @@ Matrix4x4 ortho_proj(const OrthoRange &x_source,
     // clang-format on
 }
 
+void transform_points(
+    const Matrix4x4 &m, const Vector3 *src, u32 src_stride, Vector3 *dst, u32 dst_stride, u32 count) {
+    kernels::transform_kernels().points(m, src, src_stride, dst, dst_stride, count);
+}
+
+void transform_vectors(
+    const Matrix4x4 &m, const Vector3 *src, u32 src_stride, Vector3 *dst, u32 dst_stride, u32 count) {
+    kernels::transform_kernels().vectors(m, src, src_stride, dst, dst_stride, count);
+}
+
+void transform_normals(
+    const Matrix4x4 &m, const Vector3 *src, u32 src_stride, Vector3 *dst, u32 dst_stride, u32 count) {
+    const Matrix4x4 normal_mat = normal_matrix(m);
+    kernels::transform_kernels().normals(normal_mat, src, src_stride, dst, dst_stride, count);
+}
+
+// Matrices per parallel_for chunk. 64KB each way, and a multiple of the 8 the kernels do at a time.
+static constexpr u32 k_matrices_per_chunk = 1024;
+
+void inverse_n(const Matrix4x4 *src, Matrix4x4 *dst, u32 count, bool multithreaded) {
+    const auto kernel = kernels::matrix_kernels().inverse;
+    if (!multithreaded) {
+        kernel(src, dst, count);
+        return;
+    }
+    parallel_for(count, k_matrices_per_chunk, [&](u32 begin, u32 end) {
+        kernel(src + begin, dst + begin, end - begin);
+    });
+}
+
+void inverse_rotation_translation_n(const Matrix4x4 *src, Matrix4x4 *dst, u32 count, bool multithreaded) {
+    const auto kernel = kernels::matrix_kernels().inverse_rotation_translation;
+    if (!multithreaded) {
+        kernel(src, dst, count);
+        return;
+    }
+    parallel_for(count, k_matrices_per_chunk, [&](u32 begin, u32 end) {
+        kernel(src + begin, dst + begin, end - begin);
+    });
+}
+
+void mul_mat_mat_n(const Matrix4x4 *a, const Matrix4x4 *b, Matrix4x4 *dst, u32 count, bool multithreaded) {
+    const auto kernel = kernels::matrix_kernels().mul_mat_mat;
+    if (!multithreaded) {
+        kernel(a, b, dst, count);
+        return;
+    }
+    parallel_for(count, k_matrices_per_chunk, [&](u32 begin, u32 end) {
+        kernel(a + begin, b + begin, dst + begin, end - begin);
+    });
+}
+
+void eigensolve_sym3x3_n(const Matrix3x3 *symm, SymmetricEigenSolver3x3_Result *out, u32 count, bool multithreaded) {
+    const auto kernel = kernels::matrix_kernels().eigensolve_sym3x3;
+    if (!multithreaded) {
+        kernel(symm, out, count);
+        return;
+    }
+    parallel_for(count, k_matrices_per_chunk, [&](u32 begin, u32 end) {
+        kernel(symm + begin, out + begin, end - begin);
+    });
+}
+
+static constexpr u32 k_versors_per_chunk = 2048;
+
+void normalize_n(const Quaternion *src, Quaternion *dst, u32 count, bool multithreaded) {
+    const auto kernel = kernels::versor_kernels().normalize;
+    if (!multithreaded) {
+        kernel(src, dst, count);
+        return;
+    }
+    parallel_for(count, k_versors_per_chunk, [&](u32 begin, u32 end) {
+        kernel(src + begin, dst + begin, end - begin);
+    });
+}
+
+static void blend_versors_n(kernels::VersorBlendKernel kernel,
+                            const Quaternion *a,
+                            const Quaternion *b,
+                            const float *alphas,
+                            u32 alpha_step,
+                            Quaternion *dst,
+                            u32 count,
+                            bool multithreaded) {
+    if (!multithreaded) {
+        kernel(a, b, alphas, alpha_step, dst, count);
+        return;
+    }
+    parallel_for(count, k_versors_per_chunk, [&](u32 begin, u32 end) {
+        kernel(a + begin, b + begin, alphas + begin * alpha_step, alpha_step, dst + begin, end - begin);
+    });
+}
+
+void nlerp_n(const Quaternion *a, const Quaternion *b, float alpha, Quaternion *dst, u32 count, bool multithreaded) {
+    blend_versors_n(kernels::versor_kernels().nlerp, a, b, &alpha, 0, dst, count, multithreaded);
+}
+
+void nlerp_n(
+    const Quaternion *a, const Quaternion *b, const float *alphas, Quaternion *dst, u32 count, bool multithreaded) {
+    blend_versors_n(kernels::versor_kernels().nlerp, a, b, alphas, 1, dst, count, multithreaded);
+}
+
+void slerp_n(const Quaternion *a, const Quaternion *b, float alpha, Quaternion *dst, u32 count, bool multithreaded) {
+    blend_versors_n(kernels::versor_kernels().slerp, a, b, &alpha, 0, dst, count, multithreaded);
+}
+
+void slerp_n(
+    const Quaternion *a, const Quaternion *b, const float *alphas, Quaternion *dst, u32 count, bool multithreaded) {
+    blend_versors_n(kernels::versor_kernels().slerp, a, b, alphas, 1, dst, count, multithreaded);
+}
+
+void matrix_from_versor_n(const Quaternion *src, Matrix4x4 *dst, u32 count, bool multithreaded) {
+    const auto kernel = kernels::versor_kernels().matrix_from_versor;
+    if (!multithreaded) {
+        kernel(src, dst, count);
+        return;
+    }
+    parallel_for(count, k_matrices_per_chunk, [&](u32 begin, u32 end) {
+        kernel(src + begin, dst + begin, end - begin);
+    });
+}
+
+static void slerp_local_transforms_n(const LocalTransform *a,
+                                     const LocalTransform *b,
+                                     const float *alphas,
+                                     u32 alpha_step,
+                                     LocalTransform *dst,
+                                     u32 count,
+                                     bool multithreaded) {
+    const auto kernel = kernels::versor_kernels().slerp_local_transforms;
+    if (!multithreaded) {
+        kernel(a, b, alphas, alpha_step, dst, count);
+        return;
+    }
+    parallel_for(count, k_matrices_per_chunk, [&](u32 begin, u32 end) {
+        kernel(a + begin, b + begin, alphas + begin * alpha_step, alpha_step, dst + begin, end - begin);
+    });
+}
+
+void slerp_n(const LocalTransform *a,
+             const LocalTransform *b,
+             float alpha,
+             LocalTransform *dst,
+             u32 count,
+             bool multithreaded) {
+    slerp_local_transforms_n(a, b, &alpha, 0, dst, count, multithreaded);
+}
+
+void slerp_n(const LocalTransform *a,
+             const LocalTransform *b,
+             const float *alphas,
+             LocalTransform *dst,
+             u32 count,
+             bool multithreaded) {
+    slerp_local_transforms_n(a, b, alphas, 1, dst, count, multithreaded);
+}
+
+void matrix_from_local_transform_n(const LocalTransform *src, Matrix4x4 *dst, u32 count, bool multithreaded) {
+    const auto kernel = kernels::versor_kernels().matrix_from_local_transform;
+    if (!multithreaded) {
+        kernel(src, dst, count);
+        return;
+    }
+    parallel_for(count, k_matrices_per_chunk, [&](u32 begin, u32 end) {
+        kernel(src + begin, dst + begin, end - begin);
+    });
+}
+
 fo::Quaternion versor_from_matrix(const fo::Matrix4x4 &mat) {
     struct MatrixAsArray {
         float c[4][4];
@@ -103,6 +273,131 @@ fo::Quaternion versor_from_matrix(const fo::Matrix4x4 &mat) {
     return q;
 }
 
+static inline u32 float_bits(float f) {
+    u32 u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static inline float float_from_bits(u32 u) {
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+// float_to_half_fast3_rtne and half_to_float_fast5 from https://gist.github.com/rygorous/2156668. The SSE
+// kernels do the same thing in 4 lanes, and F16C gives the same results.
+uint16_t f32_to_f16(float f) {
+    constexpr u32 f32_infinity = 255u << 23;
+    constexpr u32 f16_max = (127u + 16) << 23; // Everything from here on is infinity or NaN
+    constexpr u32 subnormal_magic = ((127u - 15) + (23 - 10) + 1) << 23;
+
+    u32 bits = float_bits(f);
+    const u32 sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    u32 h;
+    if (bits >= f16_max) {
+        h = bits > f32_infinity ? 0x7e00 : 0x7c00;
+    } else if (bits < (113u << 23)) {
+        // Subnormal or zero. Adding the magic number makes the FPU round the mantissa for us.
+        h = float_bits(float_from_bits(bits) + float_from_bits(subnormal_magic)) - subnormal_magic;
+    } else {
+        // Rebias the exponent and round the mantissa, ties to even
+        const u32 mantissa_odd = (bits >> 13) & 1;
+        bits += (u32(15 - 127) << 23) + 0xfff + mantissa_odd;
+        h = bits >> 13;
+    }
+    return uint16_t(h | (sign >> 16));
+}
+
+float f16_to_f32(uint16_t h) {
+    constexpr u32 shifted_exp = 0x7c00u << 13;
+
+    u32 bits = (h & 0x7fffu) << 13;
+    const u32 exp = bits & shifted_exp;
+    bits += (127u - 15) << 23;
+
+    if (exp == shifted_exp) {
+        bits += (128u - 16) << 23; // Infinity or NaN
+    } else if (exp == 0) {
+        // Subnormal, renormalize
+        bits = float_bits(float_from_bits(bits + (1u << 23)) - float_from_bits(113u << 23));
+    }
+    return float_from_bits(bits | (u32(h & 0x8000u) << 16));
+}
+
+// The comparisons are written so that NaN ends up at the lower end, same as the SSE kernels.
+// std::nearbyint rounds ties to even like cvtps2dq.
+int16_t f32_to_snorm16(float f) {
+    const float clamped = f >= -1.0f ? (f <= 1.0f ? f : 1.0f) : -1.0f;
+    return int16_t(std::nearbyint(clamped * 32767.0f));
+}
+
+uint8_t f32_to_unorm8(float f) {
+    const float clamped = f >= 0.0f ? (f <= 1.0f ? f : 1.0f) : 0.0f;
+    return uint8_t(std::nearbyint(clamped * 255.0f));
+}
+
+static inline float sign_not_zero(float f) { return std::copysign(1.0f, f); }
+
+void encode_octahedral_snorm16(const Vector3 &n, int16_t out[2]) {
+    // Project onto the octahedron |x| + |y| + |z| = 1, then fold the lower half over the diagonals
+    const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    const float inv_l1 = 1.0f / std::max(l1, 1e-30f);
+    float x = n.x * inv_l1;
+    float y = n.y * inv_l1;
+
+    if (n.z < 0.0f) {
+        const float folded_x = (1.0f - std::abs(y)) * sign_not_zero(x);
+        const float folded_y = (1.0f - std::abs(x)) * sign_not_zero(y);
+        x = folded_x;
+        y = folded_y;
+    }
+
+    out[0] = f32_to_snorm16(x);
+    out[1] = f32_to_snorm16(y);
+}
+
+Vector3 decode_octahedral_snorm16(const int16_t in[2]) {
+    float x = std::max(in[0] * (1.0f / 32767.0f), -1.0f);
+    float y = std::max(in[1] * (1.0f / 32767.0f), -1.0f);
+
+    const float z = 1.0f - std::abs(x) - std::abs(y);
+    const float t = std::max(-z, 0.0f);
+    x -= t * sign_not_zero(x);
+    y -= t * sign_not_zero(y);
+    return normalize(Vector3{ x, y, z });
+}
+
+void f32_to_f16(const float *src, u32 src_stride, uint16_t *dst, u32 dst_stride, u32 count, u32 components) {
+    assert(components >= 1 && components <= 4);
+    kernels::pack_kernels().f32_to_f16(src, src_stride, dst, dst_stride, count, components);
+}
+
+void f16_to_f32(const uint16_t *src, u32 src_stride, float *dst, u32 dst_stride, u32 count, u32 components) {
+    assert(components >= 1 && components <= 4);
+    kernels::pack_kernels().f16_to_f32(src, src_stride, dst, dst_stride, count, components);
+}
+
+void f32_to_snorm16(const float *src, u32 src_stride, int16_t *dst, u32 dst_stride, u32 count, u32 components) {
+    assert(components >= 1 && components <= 4);
+    kernels::pack_kernels().f32_to_snorm16(src, src_stride, dst, dst_stride, count, components);
+}
+
+void f32_to_unorm8(const float *src, u32 src_stride, uint8_t *dst, u32 dst_stride, u32 count, u32 components) {
+    assert(components >= 1 && components <= 4);
+    kernels::pack_kernels().f32_to_unorm8(src, src_stride, dst, dst_stride, count, components);
+}
+
+void encode_octahedral_snorm16(const Vector3 *src, u32 src_stride, int16_t *dst, u32 dst_stride, u32 count) {
+    kernels::pack_kernels().encode_octahedral(src, src_stride, dst, dst_stride, count);
+}
+
+void decode_octahedral_snorm16(const int16_t *src, u32 src_stride, Vector3 *dst, u32 dst_stride, u32 count) {
+    kernels::pack_kernels().decode_octahedral(src, src_stride, dst, dst_stride, count);
+}
+
 } // namespace math
 
 } // namespace eng
@@ -1,5 +1,6 @@
 #include <learnogl/eng.h>
 #include <learnogl/kitchen_sink.h>
+#include <learnogl/mesh_optimize.h>
 
 #include <algorithm>
 #include <assert.h>
@@ -47,7 +48,30 @@ Model::~Model() {
     }
 }
 
+// Quantizes the meshes of the model from `first_mesh` on, replacing their buffers. 2D meshes are left as they are.
+static void quantize_meshes(Model &m, u32 first_mesh) {
+    for (u32 j = first_mesh; j < size(m._mesh_array); ++j) {
+        MeshData &md = m._mesh_array[j];
+        if (md.positions_are_2d || md.o.position_offset == ATTRIBUTE_NOT_PRESENT) {
+            continue;
+        }
+        MeshData quantized;
+        quantize_mesh(md, *m._buffer_allocator, quantized);
+        LOG_F(INFO,
+              "Mesh %u quantized: %u -> %u bytes per vertex",
+              j,
+              md.o.packed_attr_size,
+              quantized.o.packed_attr_size);
+        m._buffer_allocator->deallocate(md.buffer);
+        md = quantized;
+    }
+}
+
 bool load(Model &m, const char *file_name, Vector2 fill_uv, uint32_t model_load_flags) {
+    if (is_cooked_model_file(file_name)) {
+        return load_cooked(m, file_name);
+    }
+
     unsigned postprocess_steps = 0;
 
     if (model_load_flags & ModelLoadFlagBits::TRIANGULATE) {
@@ -87,17 +111,45 @@ bool load(Model &m, const char *file_name, Vector2 fill_uv, uint32_t model_load_
                assimp_scene->mNumMeshes, MAX_MESHES_IN_MODEL);
     */
 
-    resize(m._mesh_array, assimp_scene->mNumMeshes);
+    reserve(m._mesh_array, assimp_scene->mNumMeshes);
 
     const auto load_bones = !bool(model_load_flags & mesh::IGNORE_BONES);
 
     for (int i = 0; i < assimp_scene->mNumMeshes; ++i) {
+        const u32 first_mesh = size(m._mesh_array);
+        MeshData &md = push_back_get(m._mesh_array, MeshData{});
         init_mesh_buffer(assimp_scene->mMeshes[i],
-                         &m._mesh_array[i],
+                         &md,
                          m._buffer_allocator,
                          model_load_flags & ModelLoadFlagBits::FILL_CONST_UV,
                          fill_uv,
                          load_bones);
+
+        if (md.o.has_wide_indices() && md.o.num_bones == 0 &&
+            (model_load_flags & ModelLoadFlagBits::SPLIT_FOR_U16_INDICES)) {
+            const MeshData whole = md;
+            pop_back(m._mesh_array);
+            const u32 num_parts = split_for_u16_indices(whole, *m._buffer_allocator, m._mesh_array);
+            m._buffer_allocator->deallocate(whole.buffer);
+            LOG_F(INFO, "Mesh %d with %u vertices split into %u meshes", i, whole.o.num_vertices, num_parts);
+        }
+
+        for (u32 j = first_mesh; j < size(m._mesh_array); ++j) {
+            if (model_load_flags & ModelLoadFlagBits::OPTIMIZE_VERTEX_ORDER) {
+                const MeshOptimizeStats stats = optimize_mesh(m._mesh_array[j]);
+                LOG_F(INFO,
+                      "Mesh %u vertex order optimized: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+                      j,
+                      stats.before.acmr,
+                      stats.after.acmr,
+                      stats.before.atvr,
+                      stats.after.atvr);
+            }
+        }
+
+        if (model_load_flags & ModelLoadFlagBits::QUANTIZE_VERTICES) {
+            quantize_meshes(m, first_mesh);
+        }
     }
 
     aiReleaseImport(assimp_scene);
@@ -107,6 +159,11 @@ bool load(Model &m, const char *file_name, Vector2 fill_uv, uint32_t model_load_
 
 void free_mesh_buffers(Model &m) {
     assert(m._buffer_allocator != nullptr && "Already freed the buffer?");
+    if (m._mapped_file != nullptr) {
+        unmap_cooked_model(m);
+        m._buffer_allocator = nullptr;
+        return;
+    }
     for (MeshData &md : m._mesh_array) {
         m._buffer_allocator->deallocate(md.buffer);
         md.buffer = nullptr;
@@ -118,36 +175,38 @@ bool load_then_transform(
     Model &m, const char *file_name, Vector2 fill_uv, u32 model_load_flags, const Matrix4x4 &transform) {
     using namespace math;
 
-    auto res = load(m, file_name, fill_uv, model_load_flags);
+    // Quantize once transformed
+    auto res = load(m, file_name, fill_uv, model_load_flags & ~ModelLoadFlagBits::QUANTIZE_VERTICES);
     if (!res) {
         return res;
     }
 
     for (auto &md : m._mesh_array) {
-        for (u32 i = 0; i < md.o.num_vertices; ++i) {
-            uint8_t *pack = md.buffer + i * md.o.packed_attr_size;
-            Vector3 *position = (Vector3 *)(pack + md.o.position_offset);
-            Vector3 *normal = (Vector3 *)(pack + md.o.normal_offset);
-            Vector4 *tangent = (Vector4 *)(pack + md.o.tangent_offset);
-
-            if (md.o.position_offset != ATTRIBUTE_NOT_PRESENT) {
-                *position = transform * Vector4(*position, 1.0f);
-            }
+        CHECK_F(!md.o.is_quantized(), "%s was cooked with quantized vertices, can't transform them", file_name);
+        const u32 stride = md.o.packed_attr_size;
+        const u32 n = md.o.num_vertices;
 
-            if (md.o.normal_offset != ATTRIBUTE_NOT_PRESENT) {
-                *normal = transform * Vector4(*normal, 0.0f);
-            }
+        if (md.o.position_offset != ATTRIBUTE_NOT_PRESENT) {
+            auto positions = (Vector3 *)(md.buffer + md.o.position_offset);
+            transform_points(transform, positions, stride, positions, stride, n);
+        }
 
-            if (md.o.tangent_offset != ATTRIBUTE_NOT_PRESENT) {
-                Vector3 t = Vector3(*tangent);
-                t = transform * Vector4(t, 0.0f);
-                tangent->x = t.x;
-                tangent->y = t.y;
-                tangent->z = t.z;
-            }
+        if (md.o.normal_offset != ATTRIBUTE_NOT_PRESENT) {
+            auto normals = (Vector3 *)(md.buffer + md.o.normal_offset);
+            transform_normals(transform, normals, stride, normals, stride, n);
+        }
+
+        // Only the xyz part of the tangent gets transformed, the handedness in w is left as is.
+        if (md.o.tangent_offset != ATTRIBUTE_NOT_PRESENT) {
+            auto tangents = (Vector3 *)(md.buffer + md.o.tangent_offset);
+            transform_vectors(transform, tangents, stride, tangents, stride, n);
         }
     }
 
+    if ((model_load_flags & ModelLoadFlagBits::QUANTIZE_VERTICES) && m._mapped_file == nullptr) {
+        quantize_meshes(m, 0);
+    }
+
     return true;
 }
 
@@ -171,8 +230,8 @@ void init_mesh_buffer(const aiMesh *mesh,
     fo::Vector<fo::Matrix4x4> offset_transforms;
     fo::Vector<mesh::AffectingBones> affecting_bones_for_vertex;
 
-    CHECK_LT_F(
-        info->o.num_vertices, std::numeric_limits<u16>::max(), "Mesh cannot be stored using 16 bit indices");
+    info->o.index_size = info->o.num_vertices <= mesh::k_max_vertices_for_u16_indices ? sizeof(mesh::IndexType)
+                                                                                      : sizeof(mesh::WideIndexType);
 
     // First we calculate the buffer size we need and set up the offsets of each attribute array
     info->o.packed_attr_size = 0;
@@ -215,7 +274,7 @@ void init_mesh_buffer(const aiMesh *mesh,
     // Allocate space for bones
     if (mesh->HasBones() && load_bones) {
         info->o.bone_data_offset =
-            (info->o.packed_attr_size * info->o.num_vertices) + (info->o.num_faces * 3 * sizeof(uint16_t));
+            info->o.get_vertices_size_in_bytes() + info->o.get_indices_size_in_bytes();
 
         const auto num_bones = mesh->mNumBones;
         info->o.num_bones = num_bones;
@@ -367,16 +426,17 @@ void init_mesh_buffer(const aiMesh *mesh,
 
     if (mesh->HasFaces()) {
         DLOG_F(INFO, "Mesh verts have faces, duh");
-        unsigned short *p = (unsigned short *)(info->buffer + info->o.get_indices_size_in_bytes());
-        for (unsigned i = 0; i < info->o.num_faces; ++i, p += 3) {
+        u8 *indices = info->buffer + info->o.get_indices_byte_offset();
+        for (unsigned i = 0; i < info->o.num_faces; ++i) {
             const aiFace *face = &mesh->mFaces[i];
             assert(face->mNumIndices == 3 && "Assimp mesh's face doesn't have 3 indices.");
-            p[0] = (unsigned short)(face->mIndices[0]);
-            p[1] = (unsigned short)(face->mIndices[1]);
-            p[2] = (unsigned short)(face->mIndices[2]);
-            assert(p[0] < (1u << 16) - 1u);
-            assert(p[1] < (1u << 16) - 1u);
-            assert(p[2] < (1u << 16) - 1u);
+            for (unsigned k = 0; k < 3; ++k) {
+                if (info->o.has_wide_indices()) {
+                    ((mesh::WideIndexType *)indices)[i * 3 + k] = face->mIndices[k];
+                } else {
+                    ((mesh::IndexType *)indices)[i * 3 + k] = (mesh::IndexType)face->mIndices[k];
+                }
+            }
         }
     }
 
@@ -397,9 +457,9 @@ void init_mesh_buffer(const aiMesh *mesh,
 }
 
 /// Calculates tangent for a single triangle
-static inline void calculate_tangent(mesh::IndexType i0,
-                                     mesh::IndexType i1,
-                                     mesh::IndexType i2,
+static inline void calculate_tangent(u32 i0,
+                                     u32 i1,
+                                     u32 i2,
                                      mesh::ForTangentSpaceCalc *vertices,
                                      Vector3 *bitangent_buffer) {
     auto &v0 = vertices[i0];
@@ -439,10 +499,11 @@ static inline void calculate_tangent(mesh::IndexType i0,
 
 namespace mesh {
 
-void calculate_tangents(ForTangentSpaceCalc *vertices,
-                        uint32_t num_vertices,
-                        IndexType *indices,
-                        uint32_t num_indices) {
+template <typename Index>
+static void calculate_tangents_impl(ForTangentSpaceCalc *vertices,
+                                    uint32_t num_vertices,
+                                    const Index *indices,
+                                    uint32_t num_indices) {
     Vector3 *bitangent_buffer =
         (Vector3 *)memory_globals::default_allocator().allocate(num_vertices * sizeof(Vector3));
 
@@ -467,6 +528,20 @@ void calculate_tangents(ForTangentSpaceCalc *vertices,
     memory_globals::default_allocator().deallocate(bitangent_buffer);
 }
 
+void calculate_tangents(ForTangentSpaceCalc *vertices,
+                        uint32_t num_vertices,
+                        const IndexType *indices,
+                        uint32_t num_indices) {
+    calculate_tangents_impl(vertices, num_vertices, indices, num_indices);
+}
+
+void calculate_tangents(ForTangentSpaceCalc *vertices,
+                        uint32_t num_vertices,
+                        const WideIndexType *indices,
+                        uint32_t num_indices) {
+    calculate_tangents_impl(vertices, num_vertices, indices, num_indices);
+}
+
 } // namespace mesh
 
 } // namespace eng
@@ -0,0 +1,111 @@
+// Moving indices between the two index sizes, and splitting meshes too large for u16 indices.
+
+#include <learnogl/mesh.h>
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <string.h>
+
+using namespace fo;
+
+namespace eng {
+
+namespace mesh {
+
+void read_indices(const MeshData &m, u32 *indices_out) {
+    const u32 num_indices = m.o.num_faces * 3;
+    if (m.o.has_wide_indices()) {
+        memcpy(indices_out, indices_begin(m), num_indices * sizeof(WideIndexType));
+    } else {
+        const IndexType *indices = reinterpret_cast<const IndexType *>(indices_begin(m));
+        std::copy(indices, indices + num_indices, indices_out);
+    }
+}
+
+void write_indices(MeshData &m, const u32 *indices) {
+    const u32 num_indices = m.o.num_faces * 3;
+    u8 *indices_out = m.buffer + m.o.get_indices_byte_offset();
+    if (m.o.has_wide_indices()) {
+        memcpy(indices_out, indices, num_indices * sizeof(WideIndexType));
+    } else {
+        std::transform(indices, indices + num_indices, (IndexType *)indices_out, [](u32 i) {
+            return IndexType(i);
+        });
+    }
+}
+
+u32 split_for_u16_indices(const MeshData &md, Allocator &buffer_allocator, Array<MeshData> &parts, u32 max_vertices) {
+    CHECK_F(md.o.num_bones == 0, "Cannot split a skinned mesh");
+    CHECK_F(max_vertices >= 3 && max_vertices <= k_max_vertices_for_u16_indices,
+            "Max vertices per part %u is not in [3, %u]",
+            max_vertices,
+            k_max_vertices_for_u16_indices);
+
+    Allocator &allocator = memory_globals::default_allocator();
+    const u32 num_triangles = md.o.num_faces;
+    const u32 stride = md.o.packed_attr_size;
+
+    Array<u32> indices(allocator, num_triangles * 3);
+    read_indices(md, data(indices));
+
+    // The part each vertex was last added to, numbered from 1, and its index in that part
+    Array<u32> added_to_part(allocator, md.o.num_vertices);
+    std::fill(begin(added_to_part), end(added_to_part), 0u);
+    Array<u32> index_in_part(allocator, md.o.num_vertices);
+
+    Array<u32> part_vertices(allocator);
+    Array<IndexType> part_indices(allocator);
+    reserve(part_vertices, std::min(max_vertices, md.o.num_vertices));
+    reserve(part_indices, num_triangles * 3);
+
+    u32 num_parts = 0;
+    u32 first_triangle = 0;
+    while (first_triangle < num_triangles) {
+        const u32 part = ++num_parts;
+        clear(part_vertices);
+        clear(part_indices);
+
+        // Take triangles in order while their vertices fit
+        u32 t = first_triangle;
+        for (; t < num_triangles; ++t) {
+            const u32 *tri = &indices[t * 3];
+            const u32 num_new = u32(added_to_part[tri[0]] != part) +
+                                u32(added_to_part[tri[1]] != part && tri[1] != tri[0]) +
+                                u32(added_to_part[tri[2]] != part && tri[2] != tri[0] && tri[2] != tri[1]);
+            if (size(part_vertices) + num_new > max_vertices) {
+                break;
+            }
+            for (u32 k = 0; k < 3; ++k) {
+                const u32 v = tri[k];
+                if (added_to_part[v] != part) {
+                    added_to_part[v] = part;
+                    index_in_part[v] = size(part_vertices);
+                    push_back(part_vertices, v);
+                }
+                push_back(part_indices, IndexType(index_in_part[v]));
+            }
+        }
+
+        MeshData &out = push_back_get(parts, MeshData{});
+        out.o = md.o;
+        out.o.num_vertices = size(part_vertices);
+        out.o.num_faces = t - first_triangle;
+        out.o.index_size = sizeof(IndexType);
+        out.positions_are_2d = md.positions_are_2d;
+
+        const u32 buffer_size = out.o.get_vertices_size_in_bytes() + out.o.get_indices_size_in_bytes();
+        out.buffer = (u8 *)buffer_allocator.allocate(buffer_size, 64);
+        for (u32 i = 0; i < size(part_vertices); ++i) {
+            memcpy(out.buffer + i * stride, md.buffer + size_t(part_vertices[i]) * stride, stride);
+        }
+        memcpy(out.buffer + out.o.get_indices_byte_offset(), data(part_indices), out.o.get_indices_size_in_bytes());
+
+        first_triangle = t;
+    }
+
+    return num_parts;
+}
+
+} // namespace mesh
+
+} // namespace eng
@@ -0,0 +1,265 @@
+#include <learnogl/mesh_optimize.h>
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <string.h>
+
+using namespace fo;
+using namespace eng::math;
+
+namespace eng {
+
+namespace mesh {
+
+static constexpr u32 k_no_vertex = ~u32(0);
+
+VertexCacheStats simulate_vertex_cache(const u32 *indices, u32 num_indices, u32 num_vertices, u32 cache_size) {
+    // A vertex is in the FIFO if it was pushed less than cache_size pushes ago
+    Array<u32> pushed_at(memory_globals::default_allocator(), num_vertices);
+    std::fill(begin(pushed_at), end(pushed_at), 0u);
+    u32 num_pushes = 0;
+    for (u32 i = 0; i < num_indices; ++i) {
+        const u32 v = indices[i];
+        if (pushed_at[v] == 0 || num_pushes - (pushed_at[v] - 1) >= cache_size) {
+            pushed_at[v] = ++num_pushes;
+        }
+    }
+    const u32 num_triangles = num_indices / 3;
+    return VertexCacheStats{ num_triangles == 0 ? 0.0f : float(num_pushes) / num_triangles,
+                             num_vertices == 0 ? 0.0f : float(num_pushes) / num_vertices };
+}
+
+void optimize_vertex_cache(
+    u32 *indices, u32 num_indices, u32 num_vertices, u32 cache_size, Array<u32> *cluster_starts) {
+    CHECK_F(num_indices % 3 == 0, "Not a triangle list");
+    const u32 num_triangles = num_indices / 3;
+    if (cluster_starts) {
+        clear(*cluster_starts);
+    }
+    if (num_triangles == 0 || num_vertices == 0) {
+        return;
+    }
+    Allocator &allocator = memory_globals::default_allocator();
+
+    // The triangles around each vertex, and how many of them are still to be emitted
+    Array<u32> live_count(allocator, num_vertices + 1);
+    std::fill(begin(live_count), end(live_count), 0u);
+    for (u32 i = 0; i < num_indices; ++i) {
+        ++live_count[indices[i]];
+    }
+    Array<u32> adjacency_start(allocator, num_vertices + 1);
+    adjacency_start[0] = 0;
+    for (u32 v = 0; v < num_vertices; ++v) {
+        adjacency_start[v + 1] = adjacency_start[v] + live_count[v];
+    }
+    Array<u32> adjacency(allocator, num_indices);
+    {
+        Array<u32> fill_at(allocator, num_vertices);
+        memcpy(data(fill_at), data(adjacency_start), num_vertices * sizeof(u32));
+        for (u32 i = 0; i < num_indices; ++i) {
+            adjacency[fill_at[indices[i]]++] = i / 3;
+        }
+    }
+
+    Array<u32> cache_time(allocator, num_vertices);
+    std::fill(begin(cache_time), end(cache_time), 0u);
+    Array<u8> emitted(allocator, num_triangles);
+    std::fill(begin(emitted), end(emitted), u8(0));
+    Array<u32> dead_end_stack(allocator);
+    Array<u32> candidates(allocator);
+    Array<u32> output(allocator);
+    reserve(output, num_indices);
+
+    u32 time = cache_size + 1;
+    u32 next_unvisited = 0;
+    u32 fanning = 0;
+    while (live_count[fanning] == 0 && fanning + 1 < num_vertices) {
+        ++fanning;
+    }
+    bool jumped = true;
+
+    while (fanning != k_no_vertex) {
+        if (jumped && cluster_starts) {
+            push_back(*cluster_starts, size(output));
+        }
+
+        // Emit the triangles around the fanning vertex
+        clear(candidates);
+        for (u32 a = adjacency_start[fanning]; a < adjacency_start[fanning + 1]; ++a) {
+            const u32 t = adjacency[a];
+            if (emitted[t]) {
+                continue;
+            }
+            emitted[t] = 1;
+            for (u32 k = 0; k < 3; ++k) {
+                const u32 v = indices[t * 3 + k];
+                push_back(output, v);
+                push_back(dead_end_stack, v);
+                push_back(candidates, v);
+                --live_count[v];
+                if (time - cache_time[v] > cache_size) {
+                    cache_time[v] = time++;
+                }
+            }
+        }
+
+        // Next, the candidate still in the cache after its remaining triangles are emitted that has been in the
+        // longest, or failing that the most recently used vertex with triangles left, or the next one in order
+        u32 best = k_no_vertex;
+        i32 best_priority = -1;
+        for (u32 v : candidates) {
+            if (live_count[v] == 0) {
+                continue;
+            }
+            i32 priority = 0;
+            if (time - cache_time[v] + 2 * live_count[v] <= cache_size) {
+                priority = i32(time - cache_time[v]);
+            }
+            if (priority > best_priority) {
+                best_priority = priority;
+                best = v;
+            }
+        }
+        jumped = best == k_no_vertex;
+        if (jumped) {
+            while (size(dead_end_stack) != 0 && best == k_no_vertex) {
+                const u32 v = back(dead_end_stack);
+                pop_back(dead_end_stack);
+                best = live_count[v] != 0 ? v : k_no_vertex;
+            }
+            while (best == k_no_vertex && next_unvisited < num_vertices) {
+                best = live_count[next_unvisited] != 0 ? next_unvisited : k_no_vertex;
+                ++next_unvisited;
+            }
+        }
+        fanning = best;
+    }
+
+    CHECK_F(size(output) == num_indices, "Emitted %u of %u indices", size(output), num_indices);
+    memcpy(indices, data(output), num_indices * sizeof(u32));
+}
+
+void optimize_overdraw(u32 *indices,
+                       u32 num_indices,
+                       const Vector3 *positions,
+                       u32 position_stride,
+                       const u32 *cluster_starts,
+                       u32 num_clusters) {
+    const auto position = [&](u32 v) -> const Vector3 & {
+        return *(const Vector3 *)((const u8 *)positions + size_t(v) * position_stride);
+    };
+
+    // Area weighted centroid and normal of each cluster, and of the mesh
+    struct Cluster {
+        Vector3 centroid;
+        Vector3 normal;
+        float area;
+        float sort_key;
+        u32 begin;
+        u32 end;
+    };
+    Array<Cluster> clusters(memory_globals::default_allocator(), num_clusters);
+    Vector3 mesh_centroid = zero_3;
+    float mesh_area = 0.0f;
+    for (u32 c = 0; c < num_clusters; ++c) {
+        Cluster &cluster = clusters[c];
+        cluster.begin = cluster_starts[c];
+        cluster.end = c + 1 < num_clusters ? cluster_starts[c + 1] : num_indices;
+        cluster.centroid = zero_3;
+        cluster.normal = zero_3;
+        cluster.area = 0.0f;
+        for (u32 i = cluster.begin; i < cluster.end; i += 3) {
+            const Vector3 &p0 = position(indices[i]);
+            const Vector3 &p1 = position(indices[i + 1]);
+            const Vector3 &p2 = position(indices[i + 2]);
+            const Vector3 n = cross(p1 - p0, p2 - p0);
+            const float area = magnitude(n);
+            cluster.centroid = cluster.centroid + (p0 + p1 + p2) * (area / 3.0f);
+            cluster.normal = cluster.normal + n;
+            cluster.area += area;
+        }
+        mesh_centroid = mesh_centroid + cluster.centroid;
+        mesh_area += cluster.area;
+        cluster.centroid = cluster.area > 0.0f ? cluster.centroid / cluster.area : position(indices[cluster.begin]);
+    }
+    mesh_centroid = mesh_area > 0.0f ? mesh_centroid / mesh_area : zero_3;
+
+    // Clusters on the outside facing away from the center occlude the rest from most directions
+    for (Cluster &cluster : clusters) {
+        const float normal_length = magnitude(cluster.normal);
+        cluster.sort_key =
+            normal_length > 0.0f ? dot(cluster.centroid - mesh_centroid, cluster.normal / normal_length) : 0.0f;
+    }
+    std::stable_sort(begin(clusters), end(clusters), [](const Cluster &a, const Cluster &b) {
+        return a.sort_key > b.sort_key;
+    });
+
+    Array<u32> sorted(memory_globals::default_allocator());
+    reserve(sorted, num_indices);
+    for (const Cluster &cluster : clusters) {
+        for (u32 i = cluster.begin; i < cluster.end; ++i) {
+            push_back(sorted, indices[i]);
+        }
+    }
+    memcpy(indices, data(sorted), num_indices * sizeof(u32));
+}
+
+void optimize_vertex_fetch(u32 *indices, u32 num_indices, u8 *vertices, u32 num_vertices, u32 vertex_size) {
+    Allocator &allocator = memory_globals::default_allocator();
+    Array<u32> new_index(allocator, num_vertices);
+    std::fill(begin(new_index), end(new_index), k_no_vertex);
+
+    u32 count = 0;
+    for (u32 i = 0; i < num_indices; ++i) {
+        u32 &n = new_index[indices[i]];
+        if (n == k_no_vertex) {
+            n = count++;
+        }
+        indices[i] = n;
+    }
+    for (u32 v = 0; v < num_vertices; ++v) {
+        if (new_index[v] == k_no_vertex) {
+            new_index[v] = count++;
+        }
+    }
+
+    Array<u8> moved(allocator, num_vertices * vertex_size);
+    for (u32 v = 0; v < num_vertices; ++v) {
+        memcpy(&moved[new_index[v] * vertex_size], vertices + size_t(v) * vertex_size, vertex_size);
+    }
+    memcpy(vertices, data(moved), size_t(num_vertices) * vertex_size);
+}
+
+MeshOptimizeStats optimize_mesh(MeshData &md, u32 cache_size) {
+    CHECK_F(!md.o.is_quantized(), "Optimize the mesh before quantizing it");
+    const u32 num_indices = md.o.num_faces * 3;
+    const u32 num_vertices = md.o.num_vertices;
+
+    Array<u32> indices(memory_globals::default_allocator(), num_indices);
+    read_indices(md, data(indices));
+
+    MeshOptimizeStats stats;
+    stats.before = simulate_vertex_cache(data(indices), num_indices, num_vertices, cache_size);
+
+    Array<u32> cluster_starts(memory_globals::default_allocator());
+    optimize_vertex_cache(data(indices), num_indices, num_vertices, cache_size, &cluster_starts);
+    if (md.o.position_offset != ATTRIBUTE_NOT_PRESENT && !md.positions_are_2d) {
+        optimize_overdraw(data(indices),
+                          num_indices,
+                          (const Vector3 *)(md.buffer + md.o.position_offset),
+                          md.o.packed_attr_size,
+                          data(cluster_starts),
+                          size(cluster_starts));
+    }
+    if (md.o.num_bones == 0) {
+        optimize_vertex_fetch(data(indices), num_indices, md.buffer, num_vertices, md.o.packed_attr_size);
+    }
+
+    stats.after = simulate_vertex_cache(data(indices), num_indices, num_vertices, cache_size);
+    write_indices(md, data(indices));
+    return stats;
+}
+
+} // namespace mesh
+
+} // namespace eng
@@ -0,0 +1,143 @@
+// Converting meshes to the quantized vertex format, and reading their positions back.
+
+#include <learnogl/bounding_shapes.h>
+#include <learnogl/math_ops.h>
+#include <learnogl/mesh.h>
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <string.h>
+
+using namespace fo;
+using namespace eng::math;
+
+namespace eng {
+
+namespace mesh {
+
+// Sizes of the quantized attributes
+constexpr u32 k_quantized_position_size = 4 * sizeof(u16);
+constexpr u32 k_quantized_normal_size = 2 * sizeof(i16);
+constexpr u32 k_quantized_uv_size = 2 * sizeof(u16);
+constexpr u32 k_quantized_tangent_size = 4 * sizeof(i16);
+
+static inline u16 quantize_unorm16(float f, float min, float scale) {
+    return u16(std::min(std::max(std::nearbyint((f - min) * scale), 0.0f), 65535.0f));
+}
+
+void quantize_mesh(const MeshData &md, Allocator &buffer_allocator, MeshData &quantized_out) {
+    CHECK_F(md.o.position_offset != ATTRIBUTE_NOT_PRESENT && !md.positions_are_2d, "Need 3D positions");
+    CHECK_F(!md.o.is_quantized(), "Already quantized");
+
+    const u32 num_vertices = md.o.num_vertices;
+    const u32 src_stride = md.o.packed_attr_size;
+    const u8 *src = md.buffer;
+
+    MeshData &q = quantized_out;
+    q.o = md.o;
+    q.o.vertex_format = VERTEX_FORMAT_QUANTIZED;
+    q.positions_are_2d = false;
+
+    u32 offset = 0;
+    q.o.position_offset = offset;
+    offset += k_quantized_position_size;
+    if (md.o.normal_offset != ATTRIBUTE_NOT_PRESENT) {
+        q.o.normal_offset = offset;
+        offset += k_quantized_normal_size;
+    }
+    if (md.o.tex2d_offset != ATTRIBUTE_NOT_PRESENT) {
+        q.o.tex2d_offset = offset;
+        offset += k_quantized_uv_size;
+    }
+    if (md.o.tangent_offset != ATTRIBUTE_NOT_PRESENT) {
+        q.o.tangent_offset = offset;
+        offset += k_quantized_tangent_size;
+    }
+    q.o.packed_attr_size = offset;
+    q.o.bone_data_offset = md.o.num_bones != 0 ? q.o.get_bones_byte_offset() : ATTRIBUTE_NOT_PRESENT;
+    const u32 dst_stride = q.o.packed_attr_size;
+
+    // Indices and bone data follow the vertices as they are
+    const u32 tail_size = md.o.get_indices_size_in_bytes() + md.o.get_bone_data_size_in_bytes();
+    q.buffer = (u8 *)buffer_allocator.allocate(q.o.get_vertices_size_in_bytes() + tail_size, 64);
+    memset(q.buffer, 0, q.o.get_vertices_size_in_bytes());
+    memcpy(q.buffer + q.o.get_indices_byte_offset(), md.buffer + md.o.get_indices_byte_offset(), tail_size);
+
+    // Positions, relative to the bounding box
+    const auto *positions = reinterpret_cast<const Vector3 *>(src + md.o.position_offset);
+    const AABB box = num_vertices != 0 ? calculate_AABB(positions, src_stride, num_vertices) : AABB{};
+    q.o.position_min = box.min;
+    q.o.position_extent = box.max - box.min;
+
+    const Vector3 &extent = q.o.position_extent;
+    const Vector3 scale{ extent.x > 0.0f ? 65535.0f / extent.x : 0.0f,
+                         extent.y > 0.0f ? 65535.0f / extent.y : 0.0f,
+                         extent.z > 0.0f ? 65535.0f / extent.z : 0.0f };
+    for (u32 i = 0; i < num_vertices; ++i) {
+        const Vector3 &p = *reinterpret_cast<const Vector3 *>(src + size_t(i) * src_stride + md.o.position_offset);
+        u16 *out = reinterpret_cast<u16 *>(q.buffer + size_t(i) * dst_stride + q.o.position_offset);
+        out[0] = quantize_unorm16(p.x, box.min.x, scale.x);
+        out[1] = quantize_unorm16(p.y, box.min.y, scale.y);
+        out[2] = quantize_unorm16(p.z, box.min.z, scale.z);
+        out[3] = 0xffff;
+    }
+
+    if (md.o.normal_offset != ATTRIBUTE_NOT_PRESENT) {
+        encode_octahedral_snorm16(reinterpret_cast<const Vector3 *>(src + md.o.normal_offset),
+                                  src_stride,
+                                  reinterpret_cast<i16 *>(q.buffer + q.o.normal_offset),
+                                  dst_stride,
+                                  num_vertices);
+    }
+
+    if (md.o.tex2d_offset != ATTRIBUTE_NOT_PRESENT) {
+        f32_to_f16(reinterpret_cast<const float *>(src + md.o.tex2d_offset),
+                   src_stride,
+                   reinterpret_cast<u16 *>(q.buffer + q.o.tex2d_offset),
+                   dst_stride,
+                   num_vertices,
+                   2);
+    }
+
+    // The tangent's direction is encoded like the normal, the handedness in w goes to z as is
+    if (md.o.tangent_offset != ATTRIBUTE_NOT_PRESENT) {
+        encode_octahedral_snorm16(reinterpret_cast<const Vector3 *>(src + md.o.tangent_offset),
+                                  src_stride,
+                                  reinterpret_cast<i16 *>(q.buffer + q.o.tangent_offset),
+                                  dst_stride,
+                                  num_vertices);
+        f32_to_snorm16(reinterpret_cast<const float *>(src + md.o.tangent_offset + 3 * sizeof(float)),
+                       src_stride,
+                       reinterpret_cast<i16 *>(q.buffer + q.o.tangent_offset + 2 * sizeof(i16)),
+                       dst_stride,
+                       num_vertices,
+                       1);
+    }
+}
+
+void read_positions(const MeshData &m, Vector3 *positions_out) {
+    CHECK_F(m.o.position_offset != ATTRIBUTE_NOT_PRESENT && !m.positions_are_2d, "Need 3D positions");
+
+    const u32 stride = m.o.packed_attr_size;
+    const u8 *positions = m.buffer + m.o.position_offset;
+    if (!m.o.is_quantized()) {
+        for (u32 i = 0; i < m.o.num_vertices; ++i) {
+            memcpy(&positions_out[i], positions + size_t(i) * stride, sizeof(Vector3));
+        }
+        return;
+    }
+
+    // Same as GL's normalization of unorm16 followed by position_dequantize_matrix
+    const Vector3 &min = m.o.position_min;
+    const Vector3 &extent = m.o.position_extent;
+    for (u32 i = 0; i < m.o.num_vertices; ++i) {
+        const u16 *q = reinterpret_cast<const u16 *>(positions + size_t(i) * stride);
+        positions_out[i] = Vector3{ min.x + extent.x * (q[0] / 65535.0f),
+                                    min.y + extent.y * (q[1] / 65535.0f),
+                                    min.z + extent.z * (q[2] / 65535.0f) };
+    }
+}
+
+} // namespace mesh
+
+} // namespace eng
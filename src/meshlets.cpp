@@ -0,0 +1,205 @@
+#include <learnogl/bounding_shapes.h>
+#include <learnogl/math_ops.h>
+#include <learnogl/meshlets.h>
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <string.h>
+
+using namespace fo;
+using namespace eng::math;
+
+namespace eng {
+
+namespace mesh {
+
+static constexpr u32 k_no_meshlet = ~u32(0);
+
+// The smallest cone around the triangles' normals. Its axis is the center of the smallest sphere around the unit
+// normals, which is the axis of the narrowest cone when they are all within 90 degrees of each other.
+static Vector4 normal_cone(const Vector3 *normals, u32 num_normals) {
+    const Vector4 no_cone{ 0.0f, 0.0f, 1.0f, k_meshlet_no_cone_cutoff };
+    if (num_normals == 0) {
+        return no_cone;
+    }
+
+    const BoundingSphere sphere = create_minimal_bounding_sphere(normals, num_normals);
+    const float center_length = magnitude(sphere.center);
+    if (center_length < 1e-6f) {
+        return no_cone;
+    }
+    const Vector3 axis = sphere.center / center_length;
+
+    float min_dot = 1.0f;
+    for (u32 i = 0; i < num_normals; ++i) {
+        min_dot = std::min(min_dot, dot(normals[i], axis));
+    }
+
+    // Normals more than 90 degrees apart, some triangle faces the camera from any side
+    if (min_dot <= 0.0f) {
+        return no_cone;
+    }
+    return Vector4{ axis, std::sqrt(1.0f - min_dot * min_dot) };
+}
+
+void build_meshlets(
+    const MeshData &md, Allocator &allocator, MeshletData &meshlets_out, u32 max_vertices, u32 max_triangles) {
+    CHECK_F(md.o.position_offset != ATTRIBUTE_NOT_PRESENT && !md.positions_are_2d, "Need 3D positions");
+    CHECK_F(!md.o.is_quantized(), "Build the meshlets before quantizing the mesh");
+    CHECK_F(max_vertices >= 3 && max_vertices <= 256 && max_triangles >= 1,
+            "Meshlets of %u vertices and %u triangles",
+            max_vertices,
+            max_triangles);
+
+    Allocator &temp_allocator = memory_globals::default_allocator();
+    const u32 num_triangles = md.o.num_faces;
+    Array<u32> indices(temp_allocator, num_triangles * 3);
+    read_indices(md, data(indices));
+
+    Array<Meshlet> meshlets(temp_allocator);
+    Array<u32> vertex_indices(temp_allocator);
+    Array<u32> triangles(temp_allocator);
+    reserve(vertex_indices, num_triangles);
+    reserve(triangles, num_triangles);
+
+    // The meshlet each vertex was last added to, and its index in that meshlet
+    Array<u32> meshlet_of_vertex(temp_allocator, md.o.num_vertices);
+    std::fill(begin(meshlet_of_vertex), end(meshlet_of_vertex), k_no_meshlet);
+    Array<u32> index_in_meshlet(temp_allocator, md.o.num_vertices);
+
+    Meshlet current{ 0, 0, 0, 0 };
+    for (u32 t = 0; t < num_triangles; ++t) {
+        const u32 *tri = &indices[t * 3];
+        const u32 id = size(meshlets);
+        const u32 num_new = u32(meshlet_of_vertex[tri[0]] != id) +
+                            u32(meshlet_of_vertex[tri[1]] != id && tri[1] != tri[0]) +
+                            u32(meshlet_of_vertex[tri[2]] != id && tri[2] != tri[0] && tri[2] != tri[1]);
+        if (current.num_vertices + num_new > max_vertices || current.num_triangles == max_triangles) {
+            push_back(meshlets, current);
+            current = Meshlet{ size(vertex_indices), size(triangles), 0, 0 };
+            --t;
+            continue;
+        }
+
+        u32 packed = 0;
+        for (u32 k = 0; k < 3; ++k) {
+            const u32 v = tri[k];
+            if (meshlet_of_vertex[v] != id) {
+                meshlet_of_vertex[v] = id;
+                index_in_meshlet[v] = current.num_vertices++;
+                push_back(vertex_indices, v);
+            }
+            packed |= index_in_meshlet[v] << (k * 8);
+        }
+        push_back(triangles, packed);
+        ++current.num_triangles;
+    }
+    if (current.num_triangles != 0) {
+        push_back(meshlets, current);
+    }
+
+    MeshletData &m = meshlets_out;
+    m.o.num_meshlets = size(meshlets);
+    m.o.num_vertex_indices = size(vertex_indices);
+    m.o.num_triangles = size(triangles);
+    m.buffer = (u8 *)allocator.allocate(m.o.get_size_in_bytes(), k_meshlet_buffer_alignment);
+    memset(m.buffer, 0, m.o.get_size_in_bytes());
+    std::copy(begin(meshlets), end(meshlets), meshlets_begin(m));
+    std::copy(begin(vertex_indices), end(vertex_indices), meshlet_vertex_indices_begin(m));
+    std::copy(begin(triangles), end(triangles), meshlet_triangles_begin(m));
+
+    // Bounds
+    const auto position = [&](u32 v) -> const Vector3 & {
+        return *(const Vector3 *)(md.buffer + md.o.position_offset + size_t(v) * md.o.packed_attr_size);
+    };
+    Array<Vector3> positions(temp_allocator);
+    Array<Vector3> normals(temp_allocator);
+    reserve(positions, max_vertices);
+    reserve(normals, max_triangles);
+
+    MeshletBounds *bounds = meshlet_bounds_begin(m);
+    for (u32 i = 0; i < size(meshlets); ++i) {
+        const Meshlet &meshlet = meshlets[i];
+        const u32 *meshlet_vertices = &vertex_indices[meshlet.vertex_offset];
+
+        clear(positions);
+        for (u32 j = 0; j < meshlet.num_vertices; ++j) {
+            push_back(positions, position(meshlet_vertices[j]));
+        }
+        const BoundingSphere sphere = create_minimal_bounding_sphere(data(positions), size(positions));
+
+        // Triangles with no area to speak of, like the ones at a pole that rounding keeps from being degenerate,
+        // cover no pixels and face any which way, so they don't count
+        const float min_length = 1e-6f * sphere.radius * sphere.radius;
+        clear(normals);
+        for (u32 j = 0; j < meshlet.num_triangles; ++j) {
+            const u32 packed = triangles[meshlet.triangle_offset + j];
+            const Vector3 &p0 = positions[meshlet_triangle_corner(packed, 0)];
+            const Vector3 &p1 = positions[meshlet_triangle_corner(packed, 1)];
+            const Vector3 &p2 = positions[meshlet_triangle_corner(packed, 2)];
+            const Vector3 n = cross(p1 - p0, p2 - p0);
+            const float length = magnitude(n);
+            if (length > min_length) {
+                push_back(normals, n / length);
+            }
+        }
+
+        bounds[i].sphere = Vector4{ sphere.center, sphere.radius };
+        bounds[i].cone = normal_cone(data(normals), size(normals));
+    }
+}
+
+void free_meshlets(MeshletData &m, Allocator &allocator) {
+    allocator.deallocate(m.buffer);
+    m.buffer = nullptr;
+    m.o = MeshletsOffsetsAndSizes{};
+}
+
+void cull_meshlets(const MeshletData &m,
+                   const Matrix4x4 &world_from_model,
+                   const FrustumPlanes &frustum,
+                   const Vector3 &camera_position,
+                   const OcclusionBuffer *occlusion,
+                   u8 *visible_bits) {
+    const u32 num_meshlets = m.o.num_meshlets;
+    const MeshletBounds *bounds = meshlet_bounds_begin(m);
+    const float scale = magnitude(Vector3(world_from_model.x));
+
+    Array<BoundingSphere> spheres(memory_globals::default_allocator(), num_meshlets);
+    for (u32 i = 0; i < num_meshlets; ++i) {
+        const Vector4 &s = bounds[i].sphere;
+        const Vector4 center = world_from_model * Vector4{ s.x, s.y, s.z, 1.0f };
+        spheres[i] = BoundingSphere{ Vector3(center), s.w * scale };
+    }
+    frustum_cull(frustum, data(spheres), num_meshlets, visible_bits);
+
+    for (u32 i = 0; i < num_meshlets; ++i) {
+        u8 &bits = visible_bits[i / 8];
+        const u8 bit = u8(1u << (i % 8));
+        if ((bits & bit) == 0) {
+            continue;
+        }
+
+        const BoundingSphere &sphere = spheres[i];
+        const Vector4 &cone = bounds[i].cone;
+        const Vector3 to_center = sphere.center - camera_position;
+        if (cone.w <= 1.0f) {
+            const Vector4 axis = world_from_model * Vector4{ cone.x, cone.y, cone.z, 0.0f };
+            if (dot(to_center, normalize(Vector3(axis))) >= cone.w * magnitude(to_center) + sphere.radius) {
+                bits &= ~bit;
+                continue;
+            }
+        }
+
+        if (occlusion) {
+            const Vector3 extent{ sphere.radius, sphere.radius, sphere.radius };
+            if (!test_occludee(*occlusion, AABB{ sphere.center - extent, sphere.center + extent })) {
+                bits &= ~bit;
+            }
+        }
+    }
+}
+
+} // namespace mesh
+
+} // namespace eng
@@ -0,0 +1,361 @@
+#include "math_kernels.h"
+
+#include <learnogl/frustum.h>
+#include <learnogl/mesh.h>
+#include <learnogl/occlusion_culling.h>
+#include <learnogl/parallel_for.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace fo;
+using namespace eng::math;
+
+namespace eng {
+
+namespace {
+
+// Triangles are clipped against the near plane and against a guard band of twice the screen's size, so the screen
+// coordinates the edge functions are set up with stay small. Far away triangles aren't clipped, they only lose
+// against whatever is nearer.
+constexpr float k_guard_band = 2.0f;
+constexpr u32 k_num_clip_planes = 5;
+
+// Each plane clips off one more vertex at most
+constexpr u32 k_max_clipped_vertices = 3 + k_num_clip_planes;
+
+// Signed distances of the vertex to the clip planes, inside when >= 0
+float clip_distance(const Vector4 &v, u32 plane) {
+    switch (plane) {
+    case 0:
+        return v.z + v.w;
+    case 1:
+        return k_guard_band * v.w - v.x;
+    case 2:
+        return k_guard_band * v.w + v.x;
+    case 3:
+        return k_guard_band * v.w - v.y;
+    default:
+        return k_guard_band * v.w + v.y;
+    }
+}
+
+u32 outside_planes(const Vector4 &v) {
+    u32 mask = 0;
+    for (u32 plane = 0; plane < k_num_clip_planes; ++plane) {
+        mask |= clip_distance(v, plane) < 0.0f ? 1u << plane : 0u;
+    }
+    return mask;
+}
+
+// Sutherland-Hodgman, one plane at a time. Returns the number of vertices left in `polygon`.
+u32 clip_polygon(Vector4 (&polygon)[k_max_clipped_vertices], u32 num_vertices, u32 planes_to_clip) {
+    Vector4 clipped[k_max_clipped_vertices];
+
+    for (u32 plane = 0; plane < k_num_clip_planes && num_vertices != 0; ++plane) {
+        if ((planes_to_clip & (1u << plane)) == 0) {
+            continue;
+        }
+
+        u32 num_clipped = 0;
+        for (u32 i = 0; i < num_vertices; ++i) {
+            const Vector4 &a = polygon[i];
+            const Vector4 &b = polygon[(i + 1) % num_vertices];
+            const float da = clip_distance(a, plane);
+            const float db = clip_distance(b, plane);
+            if (da >= 0.0f) {
+                clipped[num_clipped++] = a;
+            }
+            if ((da >= 0.0f) != (db >= 0.0f)) {
+                const float t = da / (da - db);
+                clipped[num_clipped++] = Vector4{ a.x + (b.x - a.x) * t,
+                                                  a.y + (b.y - a.y) * t,
+                                                  a.z + (b.z - a.z) * t,
+                                                  a.w + (b.w - a.w) * t };
+            }
+        }
+
+        std::copy(clipped, clipped + num_clipped, polygon);
+        num_vertices = num_clipped;
+    }
+    return num_vertices;
+}
+
+// Screen position in pixels, and NDC depth
+struct ScreenVertex {
+    double x;
+    double y;
+    double z;
+};
+
+ScreenVertex to_screen(const OcclusionBuffer &buffer, const Vector4 &clip) {
+    const double inv_w = 1.0 / double(clip.w);
+    return ScreenVertex{ (double(clip.x) * inv_w * 0.5 + 0.5) * buffer.width,
+                         (double(clip.y) * inv_w * 0.5 + 0.5) * buffer.height,
+                         double(clip.z) * inv_w };
+}
+
+// The setup is done in doubles, as the constant terms of the edge functions are differences of big products
+void add_screen_triangle(OcclusionBuffer &buffer,
+                         const ScreenVertex &v0,
+                         const ScreenVertex &v1,
+                         const ScreenVertex &v2) {
+    const ScreenVertex v[3] = { v0, v1, v2 };
+
+    const double area2 = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+    if (std::abs(area2) < 1e-8) {
+        return;
+    }
+
+    // Pixels whose centers are within the triangle's bounds
+    const double min_x = std::min({ v0.x, v1.x, v2.x });
+    const double max_x = std::max({ v0.x, v1.x, v2.x });
+    const double min_y = std::min({ v0.y, v1.y, v2.y });
+    const double max_y = std::max({ v0.y, v1.y, v2.y });
+
+    OccluderTriangle tri;
+    tri.min_x = std::max(i32(std::ceil(min_x - 0.5)), 0);
+    tri.max_x = std::min(i32(std::floor(max_x - 0.5)), i32(buffer.width) - 1);
+    tri.min_y = std::max(i32(std::ceil(min_y - 0.5)), 0);
+    tri.max_y = std::min(i32(std::floor(max_y - 0.5)), i32(buffer.height) - 1);
+    if (tri.min_x > tri.max_x || tri.min_y > tri.max_y) {
+        return;
+    }
+
+    // Positive to the left of each edge of a counter-clockwise triangle, flipped for clockwise ones
+    const double sign = area2 > 0.0 ? 1.0 : -1.0;
+    for (u32 e = 0; e < 3; ++e) {
+        const ScreenVertex &from = v[e];
+        const ScreenVertex &to = v[(e + 1) % 3];
+        const double a = -(to.y - from.y) * sign;
+        const double b = (to.x - from.x) * sign;
+        tri.edge_a[e] = float(a);
+        tri.edge_b[e] = float(b);
+        tri.edge_c[e] = float(-(a * from.x + b * from.y));
+    }
+
+    const double dzdx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area2;
+    const double dzdy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area2;
+    tri.depth_dx = float(dzdx);
+    tri.depth_dy = float(dzdy);
+    tri.depth_c = float(v0.z - dzdx * v0.x - dzdy * v0.y);
+
+    push_back(buffer.triangles, tri);
+}
+
+template <typename IndexType>
+void add_occluder_triangles(OcclusionBuffer &buffer,
+                            const Vector3 *positions,
+                            u32 stride,
+                            const IndexType *indices,
+                            u32 num_triangles,
+                            const Matrix4x4 &world_from_model) {
+    const Matrix4x4 clip_from_model = buffer.clip_from_world * world_from_model;
+
+    const auto clip_vertex = [&](u32 triangle, u32 corner) {
+        const Vector3 &p = *reinterpret_cast<const Vector3 *>(reinterpret_cast<const u8 *>(positions) +
+                                                              size_t(indices[triangle * 3 + corner]) * stride);
+        return clip_from_model * Vector4{ p.x, p.y, p.z, 1.0f };
+    };
+
+    for (u32 i = 0; i < num_triangles; ++i) {
+        Vector4 polygon[k_max_clipped_vertices] = { clip_vertex(i, 0), clip_vertex(i, 1), clip_vertex(i, 2) };
+
+        const u32 outside_0 = outside_planes(polygon[0]);
+        const u32 outside_1 = outside_planes(polygon[1]);
+        const u32 outside_2 = outside_planes(polygon[2]);
+        if ((outside_0 & outside_1 & outside_2) != 0) {
+            continue;
+        }
+
+        u32 num_vertices = 3;
+        const u32 planes_to_clip = outside_0 | outside_1 | outside_2;
+        if (planes_to_clip != 0) {
+            num_vertices = clip_polygon(polygon, num_vertices, planes_to_clip);
+        }
+
+        if (num_vertices < 3) {
+            continue;
+        }
+        const ScreenVertex first = to_screen(buffer, polygon[0]);
+        ScreenVertex previous = to_screen(buffer, polygon[1]);
+        for (u32 v = 2; v < num_vertices; ++v) {
+            const ScreenVertex current = to_screen(buffer, polygon[v]);
+            add_screen_triangle(buffer, first, previous, current);
+            previous = current;
+        }
+    }
+}
+
+} // namespace
+
+void init_occlusion_buffer(OcclusionBuffer &buffer, uint32_t width, uint32_t height) {
+    CHECK_F(width != 0 && height != 0 && width % k_occlusion_tile_width == 0 &&
+                height % k_occlusion_tile_height == 0,
+            "Occlusion buffer size %ux%u is not a multiple of the %ux%u tiles",
+            width,
+            height,
+            k_occlusion_tile_width,
+            k_occlusion_tile_height);
+
+    buffer.width = width;
+    buffer.height = height;
+    resize(buffer.depth, width * height);
+    resize(buffer.tile_depth, (width / k_occlusion_tile_width) * (height / k_occlusion_tile_height));
+    std::fill(begin(buffer.depth), end(buffer.depth), k_occlusion_empty_depth);
+    std::fill(begin(buffer.tile_depth), end(buffer.tile_depth), k_occlusion_empty_depth);
+    clear(buffer.triangles);
+}
+
+void begin_occlusion_frame(OcclusionBuffer &buffer, const Matrix4x4 &clip_from_world) {
+    buffer.clip_from_world = clip_from_world;
+    clear(buffer.triangles);
+}
+
+void add_occluder(OcclusionBuffer &buffer,
+                  const Vector3 *positions,
+                  uint32_t stride,
+                  const uint32_t *indices,
+                  uint32_t num_triangles,
+                  const Matrix4x4 &world_from_model) {
+    add_occluder_triangles(buffer, positions, stride, indices, num_triangles, world_from_model);
+}
+
+void add_occluder(OcclusionBuffer &buffer, const mesh::MeshData &mesh_data, const Matrix4x4 &world_from_model) {
+    CHECK_F(!mesh_data.o.is_quantized(), "Occluder meshes must not be quantized");
+    const auto *positions = reinterpret_cast<const Vector3 *>(mesh_data.buffer + mesh_data.o.position_offset);
+    const u32 stride = mesh_data.o.packed_attr_size;
+    const u8 *indices = mesh::indices_begin(mesh_data);
+    if (mesh_data.o.has_wide_indices()) {
+        add_occluder_triangles(
+            buffer, positions, stride, (const mesh::WideIndexType *)indices, mesh_data.o.num_faces, world_from_model);
+    } else {
+        add_occluder_triangles(
+            buffer, positions, stride, (const mesh::IndexType *)indices, mesh_data.o.num_faces, world_from_model);
+    }
+}
+
+void rasterize_occluders(OcclusionBuffer &buffer, bool multithreaded) {
+    const u32 width = buffer.width;
+    const u32 tiles_per_row = width / k_occlusion_tile_width;
+    const u32 num_tile_rows = buffer.height / k_occlusion_tile_height;
+    const auto rasterize = kernels::occlusion_kernels().rasterize;
+
+    const auto do_tile_rows = [&](u32 begin_tile_row, u32 end_tile_row) {
+        const u32 row_begin = begin_tile_row * k_occlusion_tile_height;
+        const u32 row_end = end_tile_row * k_occlusion_tile_height;
+        float *depth = data(buffer.depth);
+        std::fill(depth + size_t(row_begin) * width, depth + size_t(row_end) * width, k_occlusion_empty_depth);
+
+        rasterize(data(buffer.triangles), size(buffer.triangles), depth, width, row_begin, row_end);
+
+        for (u32 tile_row = begin_tile_row; tile_row < end_tile_row; ++tile_row) {
+            for (u32 tile = 0; tile < tiles_per_row; ++tile) {
+                float farthest = -k_occlusion_empty_depth;
+                for (u32 y = 0; y < k_occlusion_tile_height; ++y) {
+                    const float *row = depth + size_t(tile_row * k_occlusion_tile_height + y) * width +
+                                       tile * k_occlusion_tile_width;
+                    for (u32 x = 0; x < k_occlusion_tile_width; ++x) {
+                        farthest = std::max(farthest, row[x]);
+                    }
+                }
+                buffer.tile_depth[tile_row * tiles_per_row + tile] = farthest;
+            }
+        }
+    };
+
+    if (multithreaded) {
+        parallel_for(num_tile_rows, 1, do_tile_rows);
+    } else {
+        do_tile_rows(0, num_tile_rows);
+    }
+}
+
+bool test_occludee(const OcclusionBuffer &buffer, const AABB &world_box) {
+    float min_x = k_occlusion_empty_depth;
+    float min_y = k_occlusion_empty_depth;
+    float max_x = -k_occlusion_empty_depth;
+    float max_y = -k_occlusion_empty_depth;
+    float nearest = k_occlusion_empty_depth;
+
+    for (u32 corner = 0; corner < 8; ++corner) {
+        const Vector4 p{ corner & 1 ? world_box.max.x : world_box.min.x,
+                         corner & 2 ? world_box.max.y : world_box.min.y,
+                         corner & 4 ? world_box.max.z : world_box.min.z,
+                         1.0f };
+        const Vector4 clip = buffer.clip_from_world * p;
+        if (clip.z < -clip.w || clip.w <= 0.0f) {
+            return true;
+        }
+        const float inv_w = 1.0f / clip.w;
+        const float x = (clip.x * inv_w * 0.5f + 0.5f) * buffer.width;
+        const float y = (clip.y * inv_w * 0.5f + 0.5f) * buffer.height;
+        min_x = std::min(min_x, x);
+        max_x = std::max(max_x, x);
+        min_y = std::min(min_y, y);
+        max_y = std::max(max_y, y);
+        nearest = std::min(nearest, clip.z * inv_w);
+    }
+
+    if (max_x < 0.0f || max_y < 0.0f || min_x >= float(buffer.width) || min_y >= float(buffer.height)) {
+        return true;
+    }
+
+    // Every pixel the box's screen rectangle touches
+    const u32 x0 = u32(std::max(min_x, 0.0f));
+    const u32 y0 = u32(std::max(min_y, 0.0f));
+    const u32 x1 = u32(std::min(max_x, float(buffer.width - 1)));
+    const u32 y1 = u32(std::min(max_y, float(buffer.height - 1)));
+
+    const u32 tiles_per_row = buffer.width / k_occlusion_tile_width;
+    for (u32 tile_y = y0 / k_occlusion_tile_height; tile_y <= y1 / k_occlusion_tile_height; ++tile_y) {
+        for (u32 tile_x = x0 / k_occlusion_tile_width; tile_x <= x1 / k_occlusion_tile_width; ++tile_x) {
+            if (buffer.tile_depth[tile_y * tiles_per_row + tile_x] < nearest) {
+                continue;
+            }
+
+            // Some pixel of the tile is behind the box, see if it's one the box covers
+            const u32 px0 = std::max(x0, tile_x * k_occlusion_tile_width);
+            const u32 px1 = std::min(x1, tile_x * k_occlusion_tile_width + k_occlusion_tile_width - 1);
+            const u32 py0 = std::max(y0, tile_y * k_occlusion_tile_height);
+            const u32 py1 = std::min(y1, tile_y * k_occlusion_tile_height + k_occlusion_tile_height - 1);
+            for (u32 y = py0; y <= py1; ++y) {
+                for (u32 x = px0; x <= px1; ++x) {
+                    if (buffer.depth[y * buffer.width + x] >= nearest) {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+void occlusion_cull(const OcclusionBuffer &buffer,
+                    const AABB *boxes,
+                    uint32_t num_boxes,
+                    uint8_t *visible_bits,
+                    bool multithreaded) {
+    // Chunks of whole bytes, so no two threads write the same one
+    const auto do_bytes = [&](u32 begin, u32 end) {
+        for (u32 byte = begin; byte < end; ++byte) {
+            u8 bits = visible_bits[byte];
+            for (u32 bit = 0; bit < 8 && bits >> bit != 0; ++bit) {
+                const u32 i = byte * 8 + bit;
+                if ((bits & (1u << bit)) != 0 && i < num_boxes && !test_occludee(buffer, boxes[i])) {
+                    bits &= u8(~(1u << bit));
+                }
+            }
+            visible_bits[byte] = bits;
+        }
+    };
+
+    const u32 num_bytes = cull_bytes_for(num_boxes);
+    if (multithreaded) {
+        parallel_for(num_bytes, 64, do_bytes);
+    } else {
+        do_bytes(0, num_bytes);
+    }
+}
+
+} // namespace eng
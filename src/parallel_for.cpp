@@ -0,0 +1,170 @@
+#include <learnogl/parallel_for.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace eng {
+
+namespace {
+
+struct Job {
+    ParallelRangeFn fn = nullptr;
+    void *context = nullptr;
+    u32 count = 0;
+    u32 chunk_size = 0;
+    u32 num_chunks = 0;
+    std::atomic<u32> next_chunk{ 0 };
+    std::atomic<u32> chunks_done{ 0 };
+};
+
+// Set on the worker threads and on a thread while it's running a parallel_for, so nested calls run inline.
+thread_local bool inside_parallel_for = false;
+
+struct WorkerPool {
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable job_posted;
+    std::condition_variable job_finished;
+
+    Job *job = nullptr;
+    u64 job_generation = 0; // Incremented per job, so each worker joins a job only once
+    u32 workers_in_job = 0;
+    bool quit = false;
+
+    // Only one parallel_for can use the workers at a time
+    std::mutex submit_mutex;
+
+    WorkerPool() {
+        const u32 hw = std::max(1u, std::thread::hardware_concurrency());
+        threads.reserve(hw - 1);
+        for (u32 i = 0; i + 1 < hw; ++i) {
+            threads.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        job_posted.notify_all();
+        for (auto &t : threads) {
+            t.join();
+        }
+    }
+
+    void worker_loop() {
+        inside_parallel_for = true;
+
+        u64 seen_generation = 0;
+
+        for (;;) {
+            Job *current = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                job_posted.wait(lock, [&] { return quit || (job && job_generation != seen_generation); });
+                if (quit) {
+                    return;
+                }
+                seen_generation = job_generation;
+                current = job;
+                ++workers_in_job;
+            }
+
+            run_chunks(*current);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --workers_in_job;
+            }
+            job_finished.notify_all();
+        }
+    }
+
+    static void run_chunks(Job &job) {
+        for (;;) {
+            const u32 chunk = job.next_chunk.fetch_add(1, std::memory_order_relaxed);
+            if (chunk >= job.num_chunks) {
+                return;
+            }
+            const u32 begin = chunk * job.chunk_size;
+            const u32 end = std::min(job.count, begin + job.chunk_size);
+            job.fn(job.context, begin, end);
+            job.chunks_done.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    void run(Job &new_job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &new_job;
+            ++job_generation;
+        }
+        job_posted.notify_all();
+
+        run_chunks(new_job);
+
+        // Wait until the chunks are done and no worker is still looking at the job, as it lives on our stack.
+        std::unique_lock<std::mutex> lock(mutex);
+        job_finished.wait(lock, [&] {
+            return new_job.chunks_done.load(std::memory_order_acquire) == new_job.num_chunks &&
+                   workers_in_job == 0;
+        });
+        job = nullptr;
+    }
+};
+
+WorkerPool &worker_pool() {
+    static WorkerPool pool;
+    return pool;
+}
+
+} // namespace
+
+u32 parallel_for_thread_count() { return (u32)worker_pool().threads.size() + 1; }
+
+void parallel_for_erased(u32 count, u32 chunk_size, ParallelRangeFn fn, void *context) {
+    if (count == 0) {
+        return;
+    }
+
+    chunk_size = std::max(1u, chunk_size);
+    const u32 num_chunks = parallel_for_chunk_count(count, chunk_size);
+
+    auto run_inline = [&] {
+        for (u32 begin = 0; begin < count; begin += chunk_size) {
+            fn(context, begin, std::min(count, begin + chunk_size));
+        }
+    };
+
+    if (num_chunks == 1 || inside_parallel_for) {
+        run_inline();
+        return;
+    }
+
+    WorkerPool &pool = worker_pool();
+
+    std::unique_lock<std::mutex> submit_lock(pool.submit_mutex, std::try_to_lock);
+    if (!submit_lock.owns_lock() || pool.threads.empty()) {
+        run_inline();
+        return;
+    }
+
+    Job job;
+    job.fn = fn;
+    job.context = context;
+    job.count = count;
+    job.chunk_size = chunk_size;
+    job.num_chunks = num_chunks;
+
+    inside_parallel_for = true;
+    pool.run(job);
+    inside_parallel_for = false;
+}
+
+} // namespace eng
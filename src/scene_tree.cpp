@@ -1,36 +1,346 @@
+#include <learnogl/frustum.h>
+#include <learnogl/parallel_for.h>
 #include <learnogl/scene_tree.h>
 #include <loguru.hpp>
-#include <scaffold/vector.h>
+
+#include <algorithm>
+#include <string.h>
+
+using namespace fo;
+using namespace eng::math;
 
 namespace eng {
 
-SceneTree::SceneTree(u32 node_pool_size)
-    : _pool_allocator(sizeof(SceneTree::Node), node_pool_size) {}
+// The local matrices of the nodes to update are computed this many at a time, from copies of their local
+// transforms, which keeps the copies in L1
+static constexpr u32 k_update_batch_size = 256;
 
-SceneTree::Node *SceneTree::allocate_node() {
-    SceneTree::Node *node =
-        fo::push_back(_nodes_by_id, fo::make_new<SceneTree::Node>(_pool_allocator, ++_next_id_counter));
+// The multithreaded update hands out whole root subtrees, gathered into tasks of at least this many nodes
+static constexpr u32 k_min_nodes_per_task = 4 * k_update_batch_size;
 
-    CHECK_EQ_F(_next_id_counter, fo::size(_matrices_by_id));
+// Updates the world matrices of the given nodes, whose parents' world matrices are up to date or come earlier in
+// `indices`. `locals_scratch` and `matrices_scratch` hold k_update_batch_size elements.
+static void update_nodes(const u32 *indices,
+                         u32 count,
+                         const u32 *parents,
+                         const LocalTransform *local_transforms,
+                         Matrix4x4 *world,
+                         LocalTransform *locals_scratch,
+                         Matrix4x4 *matrices_scratch) {
+    for (u32 begin = 0; begin < count; begin += k_update_batch_size) {
+        const u32 batch_count = std::min(count - begin, k_update_batch_size);
 
-    ++_next_id_counter;
-    node->scene_tree_id = _next_id_counter;
-    fo::push_back(_matrices_by_id, node->transform.get_mat4());
+        // A run of consecutive nodes, like all of them after a load, needs no copying. Once grouped by root for the
+        // multithreaded update the indices need not be increasing, so each one is checked.
+        const LocalTransform *locals = &local_transforms[indices[begin]];
+        u32 run = 1;
+        while (run < batch_count && indices[begin + run] == indices[begin] + run) {
+            ++run;
+        }
+        if (run != batch_count) {
+            for (u32 k = 0; k < batch_count; ++k) {
+                locals_scratch[k] = local_transforms[indices[begin + k]];
+            }
+            locals = locals_scratch;
+        }
+        matrix_from_local_transform_n(locals, matrices_scratch, batch_count);
+
+        // In order, so a parent in the same batch is done before its children
+        for (u32 k = 0; k < batch_count; ++k) {
+            const u32 i = indices[begin + k];
+            const u32 parent = parents[i];
+            world[i] = parent == SceneTree::k_no_parent ? matrices_scratch[k] : world[parent] * matrices_scratch[k];
+        }
+    }
+}
 
-    fo::push_back(_nodes_by_id, node);
+SceneTree::SceneTree(u32 initial_capacity, Allocator &allocator)
+    : _parents(allocator)
+    , _local_transforms(allocator)
+    , _world_matrices(allocator)
+    , _flags(allocator)
+    , _roots(allocator)
+    , _handle_slots(allocator)
+    , _slot_nodes(allocator)
+    , _slot_generations(allocator)
+    , _update_indices(allocator)
+    , _update_locals(allocator)
+    , _update_matrices(allocator)
+    , _task_starts(allocator) {
+    reserve(_parents, initial_capacity);
+    reserve(_local_transforms, initial_capacity);
+    reserve(_world_matrices, initial_capacity);
+    reserve(_flags, initial_capacity);
+    reserve(_roots, initial_capacity);
+    reserve(_handle_slots, initial_capacity);
+    reserve(_slot_nodes, initial_capacity);
+    reserve(_slot_generations, initial_capacity);
 }
 
-void SceneTree::remove_node(SceneTree::Node *node) {
-    if (!node) {
+SceneNodeHandle SceneTree::add_node(SceneNodeHandle parent_handle, const LocalTransform &local_transform) {
+    const u32 parent = parent_handle.is_null() ? k_no_parent : node_index(parent_handle);
+    const u32 node = size(_parents);
+
+    u32 slot = _first_free_slot;
+    if (slot != k_no_parent) {
+        _first_free_slot = _slot_nodes[slot];
+        _slot_nodes[slot] = node;
+    } else {
+        slot = size(_slot_nodes);
+        CHECK_F(slot <= SceneNodeHandle::Slot_Mask::max(), "Too many scene nodes");
+        push_back(_slot_nodes, node);
+        push_back(_slot_generations, u8(1));
+    }
+
+    push_back(_parents, parent);
+    push_back(_local_transforms, local_transform);
+    push_back(_world_matrices, identity_matrix);
+    push_back(_flags, u8(DIRTY));
+    push_back(_roots, parent == k_no_parent ? node : _roots[parent]);
+    push_back(_handle_slots, slot);
+    ++_layout_version;
+    return handle(node);
+}
+
+void SceneTree::remove_node(SceneNodeHandle handle) {
+    const u32 node = node_index(handle);
+
+    // Descendants come after the node, and are removed when their parent is. The nodes removed before had all of
+    // their descendants removed along with them, so a removed parent always means a descendant.
+    const auto remove = [this](u32 i) {
+        _flags[i] = REMOVED;
+        ++_num_removed;
+
+        // Next generation, skipping 0 so the null handle stays null
+        const u32 slot = _handle_slots[i];
+        _slot_generations[slot] = _slot_generations[slot] == 255 ? u8(1) : u8(_slot_generations[slot] + 1);
+        _slot_nodes[slot] = _first_free_slot;
+        _first_free_slot = slot;
+    };
+
+    ++_layout_version;
+    remove(node);
+    for (u32 i = node + 1; i < size(_parents); ++i) {
+        const u32 parent = _parents[i];
+        if ((_flags[i] & REMOVED) == 0 && parent != k_no_parent && (_flags[parent] & REMOVED) != 0) {
+            remove(i);
+        }
+    }
+}
+
+void SceneTree::set_local_transform(SceneNodeHandle handle, const LocalTransform &local_transform) {
+    const u32 node = node_index(handle);
+    _local_transforms[node] = local_transform;
+    _flags[node] |= DIRTY;
+}
+
+void SceneTree::compact() {
+    if (_num_removed == 0) {
         return;
     }
 
-    _nodes_by_id[node->scene_tree_id] = nullptr;
+    // Moving each node alive down in place. Parents and roots are alive and were moved before their nodes, so
+    // their new indices are known by then.
+    const u32 old_size = size(_parents);
+    resize(_update_indices, old_size);
+    u32 *new_indices = data(_update_indices);
+
+    u32 count = 0;
+    for (u32 i = 0; i < old_size; ++i) {
+        if ((_flags[i] & REMOVED) != 0) {
+            continue;
+        }
+        new_indices[i] = count;
+        const u32 parent = _parents[i];
+        _parents[count] = parent == k_no_parent ? k_no_parent : new_indices[parent];
+        _local_transforms[count] = _local_transforms[i];
+        _world_matrices[count] = _world_matrices[i];
+        _flags[count] = _flags[i];
+        _roots[count] = new_indices[_roots[i]];
+        _handle_slots[count] = _handle_slots[i];
+        _slot_nodes[_handle_slots[count]] = count;
+        ++count;
+    }
+
+    resize(_parents, count);
+    resize(_local_transforms, count);
+    resize(_world_matrices, count);
+    resize(_flags, count);
+    resize(_roots, count);
+    resize(_handle_slots, count);
+    _num_removed = 0;
+    ++_layout_version;
+}
+
+u32 SceneTree::node_index(SceneNodeHandle handle) const {
+    CHECK_F(is_valid(handle), "Scene node handle 0x%x is stale or null", handle.bits);
+    return _slot_nodes[handle.slot()];
+}
+
+SceneNodeHandle SceneTree::handle(u32 node) const {
+    DCHECK_F(is_alive(node), "Node %u is not alive", node);
+    const u32 slot = _handle_slots[node];
+    return SceneNodeHandle{ SceneNodeHandle::Slot_Mask::shift(slot) |
+                            SceneNodeHandle::Generation_Mask::shift(_slot_generations[slot]) };
+}
+
+void SceneTree::update_world_matrices(bool multithreaded) {
+    const u32 array_size = size(_parents);
+    const u32 *parents = data(_parents);
+    u8 *flags = data(_flags);
+
+    // Find the nodes to update. A node's world matrix changes if its local transform did or its parent's world
+    // matrix did, and the parent has been through here already.
+    ++_update_count;
+    clear(_update_indices);
+    for (u32 i = 0; i < array_size; ++i) {
+        const u8 f = flags[i];
+        if ((f & REMOVED) != 0) {
+            continue;
+        }
+        const u32 parent = parents[i];
+        const bool changed = (f & DIRTY) != 0 || (parent != k_no_parent && (flags[parent] & WORLD_CHANGED) != 0);
+        flags[i] = u8((changed ? WORLD_CHANGED : 0) | ((f & WORLD_CHANGED) != 0 ? WORLD_CHANGED_BEFORE : 0));
+        if (changed) {
+            push_back(_update_indices, i);
+        }
+    }
 
-    u32 id = node->scene_tree_id;
-    std::swap(_matrices_by_id[id], fo::back(_matrices_by_id));
+    const u32 num_to_update = size(_update_indices);
+    const LocalTransform *local_transforms = data(_local_transforms);
+    Matrix4x4 *world = data(_world_matrices);
 
-    fo::make_delete(_pool_allocator, node);
+    if (!multithreaded || num_to_update < 2 * k_min_nodes_per_task) {
+        resize(_update_locals, k_update_batch_size);
+        resize(_update_matrices, k_update_batch_size);
+        update_nodes(data(_update_indices),
+                     num_to_update,
+                     parents,
+                     local_transforms,
+                     world,
+                     data(_update_locals),
+                     data(_update_matrices));
+        return;
+    }
+
+    // Nodes under different roots don't depend on each other. A root is the first node of its subtree, so when the
+    // subtrees were added one after another, as when loading a level, the nodes to update are already grouped by
+    // root. Otherwise a stable sort groups them while keeping parents before children.
+    const u32 *roots = data(_roots);
+    u32 *indices = data(_update_indices);
+    const auto by_root = [roots](u32 a, u32 b) { return roots[a] < roots[b]; };
+    if (!std::is_sorted(indices, indices + num_to_update, by_root)) {
+        std::stable_sort(indices, indices + num_to_update, by_root);
+    }
+
+    // Cut the list into tasks at root boundaries
+    clear(_task_starts);
+    push_back(_task_starts, 0u);
+    for (u32 k = 1; k < num_to_update; ++k) {
+        if (k - back(_task_starts) >= k_min_nodes_per_task && roots[indices[k]] != roots[indices[k - 1]]) {
+            push_back(_task_starts, k);
+        }
+    }
+    const u32 num_tasks = size(_task_starts);
+    push_back(_task_starts, num_to_update);
+
+    resize(_update_locals, num_tasks * k_update_batch_size);
+    resize(_update_matrices, num_tasks * k_update_batch_size);
+
+    parallel_for(num_tasks, 1, [&](u32 begin, u32 end) {
+        for (u32 task = begin; task < end; ++task) {
+            const u32 start = _task_starts[task];
+            update_nodes(indices + start,
+                         _task_starts[task + 1] - start,
+                         parents,
+                         local_transforms,
+                         world,
+                         data(_update_locals) + task * k_update_batch_size,
+                         data(_update_matrices) + task * k_update_batch_size);
+        }
+    });
+}
+
+void SceneTree::publish_snapshot(SceneSnapshots &snapshots, const u8 *visible_bits) const {
+    SceneSnapshot &snapshot = snapshots.begin_write();
+
+    const u32 count = size(_parents);
+    const u8 *flags = data(_flags);
+
+    // The flags tell which matrices changed in the last two updates
+    const bool copy_changed_only = snapshot.source == this && snapshot.source_layout_version == _layout_version &&
+                                   snapshot.source_update_count + 2 >= _update_count;
+    if (copy_changed_only) {
+        for (u32 i = 0; i < count; ++i) {
+            if ((flags[i] & (WORLD_CHANGED | WORLD_CHANGED_BEFORE)) != 0) {
+                snapshot.world_matrices[i] = _world_matrices[i];
+            }
+        }
+    } else {
+        resize(snapshot.world_matrices, count);
+        resize(snapshot.handles, count);
+        memcpy(data(snapshot.world_matrices), data(_world_matrices), count * sizeof(Matrix4x4));
+        for (u32 i = 0; i < count; ++i) {
+            snapshot.handles[i] = (flags[i] & REMOVED) == 0 ? handle(i) : SceneNodeHandle{};
+        }
+    }
+
+    const u32 num_bytes = cull_bytes_for(count);
+    resize(snapshot.visible_bits, num_bytes);
+    if (visible_bits != nullptr) {
+        memcpy(data(snapshot.visible_bits), visible_bits, num_bytes);
+    } else {
+        memset(data(snapshot.visible_bits), 0xff, num_bytes);
+    }
+    if (_num_removed != 0) {
+        for (u32 i = 0; i < count; ++i) {
+            if ((flags[i] & REMOVED) != 0) {
+                snapshot.visible_bits[i / 8] &= u8(~(1u << (i % 8)));
+            }
+        }
+    }
+
+    snapshot.source = this;
+    snapshot.source_layout_version = _layout_version;
+    snapshot.source_update_count = _update_count;
+    snapshots.end_write();
+}
+
+SceneSnapshots::SceneSnapshots(Allocator &allocator)
+    : _snapshots{ SceneSnapshot(allocator), SceneSnapshot(allocator) } {}
+
+SceneSnapshot &SceneSnapshots::begin_write() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    CHECK_F(_writing == -1, "Already writing a snapshot");
+    _writing = _published == -1 ? 0 : 1 - _published;
+    _released.wait(lock, [this] { return _reading != _writing; });
+    return _snapshots[_writing];
+}
+
+void SceneSnapshots::end_write() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    CHECK_F(_writing != -1, "Not writing a snapshot");
+    _snapshots[_writing].frame = ++_num_published;
+    _published = _writing;
+    _writing = -1;
+}
+
+const SceneSnapshot *SceneSnapshots::acquire_latest() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    CHECK_F(_reading == -1, "Already reading a snapshot");
+    if (_published == -1) {
+        return nullptr;
+    }
+    _reading = _published;
+    return &_snapshots[_reading];
+}
+
+void SceneSnapshots::release() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _reading = -1;
+    }
+    _released.notify_one();
 }
 
 } // namespace eng
@@ -0,0 +1,224 @@
+#include <learnogl/spatial_hash_grid.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace fo;
+
+namespace eng {
+
+namespace {
+
+// The points are sorted by bucket with an LSD radix sort, a counting sort on k_radix_bits of the bucket at a time,
+// which takes two passes at most. Each pass counts the digits in each chunk of points, and scatters the chunks to
+// where the counts before them say, so the sort is stable and comes out the same however the chunks are run.
+constexpr u32 k_radix_bits = 11;
+constexpr u32 k_radix_size = 1u << k_radix_bits;
+constexpr u32 k_points_per_chunk = 1u << 14;
+
+constexpr u32 k_min_buckets = 16;
+
+template <typename Fn> void for_each_chunk(u32 count, u32 chunk_size, bool multithreaded, Fn &&fn) {
+    if (multithreaded) {
+        parallel_for(count, chunk_size, fn);
+        return;
+    }
+    for (u32 begin = 0; begin < count; begin += chunk_size) {
+        fn(begin, std::min(begin + chunk_size, count));
+    }
+}
+
+// One counting sort pass over the digit at `shift`. `indices_in` null means the identity.
+void radix_pass(const u32 *buckets_in,
+                const u32 *indices_in,
+                u32 *buckets_out,
+                u32 *indices_out,
+                u32 num_points,
+                u32 shift,
+                bool multithreaded) {
+    const u32 num_chunks = parallel_for_chunk_count(num_points, k_points_per_chunk);
+    std::vector<u32> offsets(size_t(num_chunks) * k_radix_size, 0);
+
+    for_each_chunk(num_points, k_points_per_chunk, multithreaded, [&](u32 begin, u32 end) {
+        u32 *counts = &offsets[size_t(begin / k_points_per_chunk) * k_radix_size];
+        for (u32 i = begin; i < end; ++i) {
+            ++counts[(buckets_in[i] >> shift) & (k_radix_size - 1)];
+        }
+    });
+
+    // Digit by digit, chunk by chunk
+    u32 start = 0;
+    for (u32 digit = 0; digit < k_radix_size; ++digit) {
+        for (u32 chunk = 0; chunk < num_chunks; ++chunk) {
+            const u32 count = offsets[size_t(chunk) * k_radix_size + digit];
+            offsets[size_t(chunk) * k_radix_size + digit] = start;
+            start += count;
+        }
+    }
+
+    for_each_chunk(num_points, k_points_per_chunk, multithreaded, [&](u32 begin, u32 end) {
+        u32 *next = &offsets[size_t(begin / k_points_per_chunk) * k_radix_size];
+        for (u32 i = begin; i < end; ++i) {
+            const u32 to = next[(buckets_in[i] >> shift) & (k_radix_size - 1)]++;
+            buckets_out[to] = buckets_in[i];
+            indices_out[to] = indices_in ? indices_in[i] : i;
+        }
+    });
+}
+
+// Calls `accept(s, i)` on each pair of sorted indices s < i of points near each other, where `query_radius(s)` is
+// how far from point s to look, and collects the pairs it returns true for.
+template <typename QueryRadiusFn, typename AcceptFn>
+void find_pairs(const SpatialHashGrid &grid,
+                QueryRadiusFn &&query_radius,
+                AcceptFn &&accept,
+                Array<PointPair> &pairs_out,
+                bool multithreaded) {
+    const u32 num_points = size(grid.sorted_indices);
+    std::vector<std::vector<PointPair>> chunk_pairs(parallel_for_chunk_count(num_points, k_points_per_chunk));
+
+    for_each_chunk(num_points, k_points_per_chunk, multithreaded, [&](u32 begin, u32 end) {
+        std::vector<PointPair> &pairs = chunk_pairs[begin / k_points_per_chunk];
+        for (u32 s = begin; s < end; ++s) {
+            for_each_point_near(grid, grid.sorted_positions[s], query_radius(s), [&](u32 i) {
+                if (i > s && accept(s, i)) {
+                    const u32 a = grid.sorted_indices[s];
+                    const u32 b = grid.sorted_indices[i];
+                    pairs.push_back(PointPair{ std::min(a, b), std::max(a, b) });
+                }
+            });
+        }
+    });
+
+    clear(pairs_out);
+    size_t num_pairs = 0;
+    for (const auto &pairs : chunk_pairs) {
+        num_pairs += pairs.size();
+    }
+    reserve(pairs_out, u32(num_pairs));
+    for (const auto &pairs : chunk_pairs) {
+        for (const PointPair &pair : pairs) {
+            push_back(pairs_out, pair);
+        }
+    }
+}
+
+} // namespace
+
+void build_spatial_hash_grid(SpatialHashGrid &grid,
+                             const Vector3 *positions,
+                             uint32_t stride,
+                             uint32_t num_points,
+                             float cell_size,
+                             bool multithreaded) {
+    CHECK_F(cell_size > 0.0f, "Cell size must be positive, got %f", cell_size);
+
+    grid.cell_size = cell_size;
+    grid.inv_cell_size = 1.0f / cell_size;
+    grid.num_buckets = k_min_buckets;
+    while (grid.num_buckets < num_points && grid.num_buckets < k_spatial_hash_grid_max_buckets) {
+        grid.num_buckets *= 2;
+    }
+
+    u32 bucket_bits = 0;
+    while ((1u << bucket_bits) < grid.num_buckets) {
+        ++bucket_bits;
+    }
+    const u32 num_passes = (bucket_bits + k_radix_bits - 1) / k_radix_bits;
+
+    resize(grid.sorted_buckets, num_points);
+    resize(grid.sorted_indices, num_points);
+    resize(grid.sorted_positions, num_points);
+    resize(grid.scratch, 2 * num_points);
+
+    const auto position = [positions, stride](u32 i) {
+        return *reinterpret_cast<const Vector3 *>(reinterpret_cast<const u8 *>(positions) + size_t(i) * stride);
+    };
+
+    // The passes go back and forth between the scratch arrays and the sorted ones, ending in the sorted ones
+    u32 *buffers[2][2] = { { data(grid.scratch), data(grid.scratch) + num_points },
+                           { data(grid.sorted_buckets), data(grid.sorted_indices) } };
+    u32 from = num_passes % 2 == 0 ? 1 : 0;
+
+    for_each_chunk(num_points, k_points_per_chunk, multithreaded, [&](u32 begin, u32 end) {
+        for (u32 i = begin; i < end; ++i) {
+            buffers[from][0][i] = spatial_hash_bucket(grid, position(i));
+        }
+    });
+
+    for (u32 pass = 0; pass < num_passes; ++pass) {
+        radix_pass(buffers[from][0],
+                   pass == 0 ? nullptr : buffers[from][1],
+                   buffers[1 - from][0],
+                   buffers[1 - from][1],
+                   num_points,
+                   pass * k_radix_bits,
+                   multithreaded);
+        from = 1 - from;
+    }
+
+    // Bucket b starts at the first point with a bucket >= b. Each point sets the starts of the buckets from the
+    // one after the previous point's up to its own.
+    resize(grid.bucket_starts, grid.num_buckets + 1);
+    const u32 *sorted_buckets = data(grid.sorted_buckets);
+    u32 *bucket_starts = data(grid.bucket_starts);
+
+    for_each_chunk(num_points, k_points_per_chunk, multithreaded, [&](u32 begin, u32 end) {
+        for (u32 i = begin; i < end; ++i) {
+            const u32 first = i == 0 ? 0 : sorted_buckets[i - 1] + 1;
+            for (u32 b = first; b <= sorted_buckets[i]; ++b) {
+                bucket_starts[b] = i;
+            }
+            grid.sorted_positions[i] = position(grid.sorted_indices[i]);
+        }
+    });
+
+    const u32 first_after_last = num_points == 0 ? 0 : sorted_buckets[num_points - 1] + 1;
+    std::fill(bucket_starts + first_after_last, bucket_starts + grid.num_buckets + 1, num_points);
+}
+
+void find_neighbour_pairs(const SpatialHashGrid &grid,
+                          float radius,
+                          Array<PointPair> &pairs_out,
+                          bool multithreaded) {
+    const float radius_squared = radius * radius;
+    find_pairs(
+        grid,
+        [radius](u32) { return radius; },
+        [&grid, radius_squared](u32 s, u32 i) {
+            const float distance_squared =
+                spatial_hash_distance_squared(grid.sorted_positions[s], grid.sorted_positions[i]);
+            return distance_squared <= radius_squared;
+        },
+        pairs_out,
+        multithreaded);
+}
+
+void find_overlapping_spheres(const SpatialHashGrid &grid,
+                              const float *radii,
+                              Array<PointPair> &pairs_out,
+                              bool multithreaded) {
+    float max_radius = 0.0f;
+    for (const u32 index : grid.sorted_indices) {
+        max_radius = std::max(max_radius, radii[index]);
+    }
+    CHECK_F(2.0f * max_radius <= grid.cell_size,
+            "Spheres of radius up to %f need a cell size of at least %f, have %f",
+            max_radius,
+            2.0f * max_radius,
+            grid.cell_size);
+
+    find_pairs(
+        grid,
+        [&grid, radii, max_radius](u32 s) { return radii[grid.sorted_indices[s]] + max_radius; },
+        [&grid, radii](u32 s, u32 i) {
+            return test_sphere_sphere(grid.sorted_positions[s],
+                                      radii[grid.sorted_indices[s]],
+                                      grid.sorted_positions[i],
+                                      radii[grid.sorted_indices[i]]);
+        },
+        pairs_out,
+        multithreaded);
+}
+
+} // namespace eng
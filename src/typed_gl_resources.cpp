@@ -1236,6 +1236,14 @@ VaoFormatDesc vao_format_from_mesh_data(const mesh::StrippedMeshData &m) {
     VaoAttributeFormat texcoord2d(2, GL_FLOAT, GL_FALSE, m.tex2d_offset, 0, 0);
     VaoAttributeFormat tangent(4, GL_FLOAT, GL_FALSE, m.tangent_offset, 0, 0);
 
+    // See mesh::VertexFormat. The shader decodes the octahedral normal and tangent, see quantized_vertex.inc.glsl.
+    if (m.vertex_format == mesh::VERTEX_FORMAT_QUANTIZED) {
+        position = VaoAttributeFormat(4, GL_UNSIGNED_SHORT, GL_TRUE, m.position_offset, 0, 0);
+        normal = VaoAttributeFormat(2, GL_SHORT, GL_TRUE, m.normal_offset, 0, 0);
+        texcoord2d = VaoAttributeFormat(2, GL_HALF_FLOAT, GL_FALSE, m.tex2d_offset, 0, 0);
+        tangent = VaoAttributeFormat(4, GL_SHORT, GL_TRUE, m.tangent_offset, 0, 0);
+    }
+
     fo::TempAllocator512 ta;
     fo::Array<VaoAttributeFormat> array(ta);
     fo::reserve(array, 4);
@@ -492,6 +492,7 @@ struct SSAODemo {
 	ComPtr<ID3D11InputLayout> pos_normal_inputlayout;
 	ComPtr<ID3D11Buffer> mesh_vb;
 	ComPtr<ID3D11Buffer> mesh_ib;
+	DXGI_FORMAT mesh_index_format;
 	eng::mesh::StrippedMeshData mesh_data;
 
 	struct {
@@ -636,6 +637,7 @@ namespace app_loop
 
 		LOG_F(INFO, "Loaded mesh");
 		app.mesh_data = eng::mesh::StrippedMeshData(tri_mesh[0].o);
+		app.mesh_index_format = tri_mesh[0].o.has_wide_indices() ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
 
 		app.camera.set_look_at(xmload(xm3(0.0f, 0.0f, -2.0f)), xm_origin(), xm_unit_y());
 		app.camera.set_proj(0.5f, 4000.0f, XM_PI / 4.0f, float(d3dconf.window_width) / d3dconf.window_height);
@@ -832,7 +834,7 @@ namespace app_loop
 			u32 start_offsets[] = { 0u };
 
 			d3d11_misc::context()->IASetVertexBuffers(0, 1, vb_at_slot, strides, start_offsets);
-			d3d11_misc::context()->IASetIndexBuffer(app.mesh_ib.Get(), DXGI_FORMAT_R16_UINT, 0);
+			d3d11_misc::context()->IASetIndexBuffer(app.mesh_ib.Get(), app.mesh_index_format, 0);
 		}
 
 		d3d11_misc::context()->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -888,7 +890,7 @@ namespace app_loop
 				u32 start_offsets[] = { 0u };
 
 				d3d11_misc::context()->IASetVertexBuffers(0, 1, vb_at_slot, strides, start_offsets);
-				d3d11_misc::context()->IASetIndexBuffer(app.mesh_ib.Get(), DXGI_FORMAT_R16_UINT, 0);
+				d3d11_misc::context()->IASetIndexBuffer(app.mesh_ib.Get(), app.mesh_index_format, 0);
 			}
 
 			d3d11_misc::context()->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
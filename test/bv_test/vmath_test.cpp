@@ -1,5 +1,5 @@
 #include <assert.h>
-#include <learnogl/math_types.h>
+#include <learnogl/vmath.h>
 
 void assert_equal(simd::Vector4 v, float x, float y, float z, float w = 0.f) {
     alignas(16) float comps[4];
@@ -21,6 +21,88 @@ void assert_equal(simd::Vector4 a, simd::Vector4 b) {
     assert(comps_0[3] == comps_1[3]);
 }
 
+void test_packs() {
+    fo::Vector3 points[8];
+    for (int i = 0; i < 8; ++i) {
+        points[i] = fo::Vector3{ float(i), float(i * 2 + 1), float(-i) };
+    }
+
+    // AoS -> SoA -> AoS round trip
+    auto pack = simd::load_vec3x8(points);
+    for (int i = 0; i < 8; ++i) {
+        assert(simd::lane(pack.x, i) == points[i].x);
+        assert(simd::lane(pack.y, i) == points[i].y);
+        assert(simd::lane(pack.z, i) == points[i].z);
+    }
+
+    fo::Vector3 stored[8] = {};
+    simd::store_vec3x8(stored, pack);
+    for (int i = 0; i < 8; ++i) {
+        assert(stored[i].x == points[i].x && stored[i].y == points[i].y && stored[i].z == points[i].z);
+    }
+
+    // Strided with a partial count leaves the unused lanes zero
+    auto partial = simd::load_vec3x8(points, sizeof(fo::Vector3) * 2, 3);
+    assert(simd::lane(partial.y, 2) == points[4].y);
+    assert(simd::lane(partial.x, 3) == 0.0f && simd::lane(partial.z, 7) == 0.0f);
+
+    // Strided full pack, stored back into every other element without touching the ones in between
+    fo::Vector3 spaced[16];
+    for (int i = 0; i < 16; ++i) {
+        spaced[i] = points[i / 2];
+    }
+    auto strided = simd::load_vec3x8(spaced, sizeof(fo::Vector3) * 2);
+    assert(simd::lane(strided.y, 5) == points[5].y);
+    simd::store_vec3x8(spaced + 1, sizeof(fo::Vector3) * 2, strided * simd::splat8(2.0f));
+    for (int i = 0; i < 8; ++i) {
+        assert(spaced[2 * i].z == points[i].z && spaced[2 * i + 1].z == 2.0f * points[i].z);
+    }
+
+    fo::Vector4 quads[8];
+    for (int i = 0; i < 8; ++i) {
+        quads[i] = fo::Vector4{ float(i), float(i + 10), float(i + 20), float(i + 30) };
+    }
+    fo::Vector4 quads_out[8];
+    simd::store_vec4x8(quads_out, simd::load_vec4x8(quads));
+    for (int i = 0; i < 8; ++i) {
+        assert(quads_out[i].x == quads[i].x && quads_out[i].w == quads[i].w);
+    }
+
+    // Dot and cross
+    auto ones = simd::splat3x8(fo::Vector3{ 1.0f, 1.0f, 1.0f });
+    auto d = simd::dot(pack, ones);
+    auto c = simd::cross3(pack, ones);
+    for (int i = 0; i < 8; ++i) {
+        const auto &p = points[i];
+        assert(simd::lane(d, i) == p.x + p.y + p.z);
+        assert(simd::lane(c.x, i) == p.y - p.z);
+        assert(simd::lane(c.y, i) == p.z - p.x);
+        assert(simd::lane(c.z, i) == p.x - p.y);
+    }
+
+    // Normalize
+    auto n = simd::normalize(simd::load_vec3x8(points) + ones);
+    for (int i = 0; i < 8; ++i) {
+        assert(fabsf(simd::lane(simd::sq_mag(n), i) - 1.0f) < 1e-5f);
+    }
+
+    // Comparison masks and select
+    auto mask = simd::cmp_lt(pack.x, simd::splat8(3.5f));
+    assert(simd::movemask(mask) == 0x0f);
+    assert(simd::any(mask) && !simd::all(mask));
+
+    auto picked = simd::select(mask, pack, ones);
+    assert(simd::lane(picked.y, 1) == points[1].y);
+    assert(simd::lane(picked.y, 6) == 1.0f);
+
+    auto lo = simd::min(pack, ones);
+    auto hi = simd::max(pack, ones);
+    assert(simd::lane(lo.x, 5) == 1.0f && simd::lane(hi.x, 5) == 5.0f);
+    assert(simd::lane(lo.z, 5) == -5.0f && simd::lane(hi.z, 0) == 1.0f);
+
+    printf("Packs OK\n");
+}
+
 int main() {
     auto v1 = simd::from_coords(1.0, 2.0, 3.0, 4.0);
     auto v2 = simd::from_coords(1.0, 2.0, 3.0, 4.0);
@@ -32,14 +114,14 @@ int main() {
     printf("Added: %f %f %f %f\n", res[0], res[1], res[2], res[3]);
 
     auto v4 = simd::from_coord_array(res);
-    auto v5 = simd::swizzle<Y_, Z_, X_, Z_>(v4);
+    auto v5 = simd::swizzle<simd::Y_, simd::Z_, simd::X_, simd::Z_>(v4);
 
     _mm_store_ps(res, v5.m);
     printf("Swizzled: %f %f %f %f\n", res[0], res[1], res[2], res[3]);
 
     auto vdot = dot(v1, v2);
 
-    assert_equal(vdot, 30.0, 0.0, 0.0, 0.0);
+    assert_equal(vdot, 30.0, 30.0, 30.0, 30.0);
 
     // Dot product
     _mm_store_ps(res, dot(v1, v2).m);
@@ -52,4 +134,6 @@ int main() {
 
     _mm_store_ps(res, r.m);
     printf("HSum: %f %f %f %f\n", res[0], res[1], res[2], res[3]);
+
+    test_packs();
 }
@@ -6,6 +6,7 @@
 #include <learnogl/eng>
 #include <learnogl/math_ops.h>
 #include <learnogl/mesh.h>
+#include <learnogl/typed_gl_resources.h>
 #include <learnogl/kitchen_sink.h>
 #include <learnogl/stb_image.h>
 #include <scaffold/debug.h>
@@ -42,6 +43,7 @@ struct App {
     unsigned num_meshes;
     GLuint model_vaos[MAX_MESHES_IN_MODEL];          // vao for each mesh
     unsigned model_num_indices[MAX_MESHES_IN_MODEL]; // num vertices in each mesh
+    GLenum model_index_types[MAX_MESHES_IN_MODEL];
 
     eye::State eye;
     Matrix4x4 view_mat;
@@ -254,6 +256,7 @@ template <> void init<App>(App &app) {
     debug("Num meshes: %u", app.num_meshes);
     for (unsigned i = 0; i < app.num_meshes; ++i) {
         app.model_num_indices[i] = num_indices(model._mesh_array[i]);
+        app.model_index_types[i] = eng::gl_index_type(mesh::StrippedMeshData(model._mesh_array[i].o));
     }
 
     app.program = eng::create_program(vert_shader_src, frag_shader_src);
@@ -358,7 +361,7 @@ template <> void render<App>(App &app) {
     // Draw each mesh as usual
     for (unsigned i = 0; i < app.num_meshes; ++i) {
         glBindVertexArray(app.model_vaos[i]);
-        glDrawElements(GL_TRIANGLES, app.model_num_indices[i], GL_UNSIGNED_SHORT, 0);
+        glDrawElements(GL_TRIANGLES, app.model_num_indices[i], app.model_index_types[i], 0);
         glBindVertexArray(0);
     }
 
@@ -1,5 +1,6 @@
 #include "inc.h"
 #include <learnogl/mesh.h>
+#include <learnogl/typed_gl_resources.h>
 
 using namespace fo;
 using namespace math;
@@ -26,6 +27,7 @@ struct App {
     GLuint vao_attribs;
     GLuint model_vaos[MAX_MESHES_IN_MODEL];
     unsigned model_num_indices[MAX_MESHES_IN_MODEL];
+    GLenum model_index_types[MAX_MESHES_IN_MODEL];
 
     GLFWwindow *window;
     int width;
@@ -182,6 +184,7 @@ void create_model(App &app) {
     debug("Num meshes: %u", app.num_meshes);
     for (unsigned i = 0; i < app.num_meshes; ++i) {
         app.model_num_indices[i] = num_indices(model._mesh_array[i]);
+        app.model_index_types[i] = eng::gl_index_type(mesh::StrippedMeshData(model._mesh_array[i].o));
     }
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -398,7 +401,7 @@ template <> void render<App>(App &app) {
         // Mesh VAO
         glBindVertexArray(app.model_vaos[i]);
         // Draw call
-        glDrawElements(GL_TRIANGLES, app.model_num_indices[i], GL_UNSIGNED_SHORT, 0);
+        glDrawElements(GL_TRIANGLES, app.model_num_indices[i], app.model_index_types[i], 0);
     }
 #endif
 
@@ -0,0 +1,132 @@
+// Checks inverse_n, inverse_rotation_translation_n and mul_mat_mat_n against the one-matrix-at-a-time functions,
+// for every kernel and with odd counts so the tail handling gets exercised.
+
+#include "math_kernels.h"
+
+#include <learnogl/cpu_features.h>
+#include <learnogl/math_ops.h>
+#include <learnogl/rng.h>
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <stdio.h>
+#include <vector>
+
+using namespace fo;
+using namespace eng::math;
+
+static Matrix4x4 random_matrix() {
+    Matrix4x4 m;
+    float *f = reinterpret_cast<float *>(&m);
+    for (int i = 0; i < 16; ++i) {
+        f[i] = (float)rng::random(-10.0, 10.0);
+    }
+    // Keep it well away from singular
+    m.x.x += 20.0f;
+    m.y.y += 20.0f;
+    m.z.z += 20.0f;
+    m.t.w += 20.0f;
+    return m;
+}
+
+static Matrix4x4 random_rigid_transform() {
+    const Vector3 axis =
+        normalize(Vector3{ (float)rng::random(-1.0, 1.0), (float)rng::random(-1.0, 1.0), 1.0f });
+    return translation_matrix((float)rng::random(-100.0, 100.0),
+                              (float)rng::random(-100.0, 100.0),
+                              (float)rng::random(-100.0, 100.0)) *
+           rotation_matrix(axis, (float)rng::random(-pi, pi));
+}
+
+// Largest difference relative to the magnitude of the expected element
+static float max_relative_diff(const Matrix4x4 &expected, const Matrix4x4 &got) {
+    const float *a = reinterpret_cast<const float *>(&expected);
+    const float *b = reinterpret_cast<const float *>(&got);
+    float diff = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        diff = std::max(diff, std::abs(a[i] - b[i]) / (1.0f + std::abs(a[i])));
+    }
+    return diff;
+}
+
+static void check_all(const std::vector<Matrix4x4> &expected, const std::vector<Matrix4x4> &got, const char *what) {
+    CHECK_EQ_F(expected.size(), got.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        const float diff = max_relative_diff(expected[i], got[i]);
+        CHECK_F(diff < 1e-4f, "%s: matrix %zu differs by %f", what, i, diff);
+    }
+}
+
+using MapKernel = kernels::MatrixMapKernel;
+using MulKernel = kernels::MatrixMulKernel;
+
+struct NamedKernels {
+    const char *name;
+    MapKernel inverse;
+    MapKernel inverse_rotation_translation;
+    MulKernel mul_mat_mat;
+};
+
+int main() {
+    rng::init_rng(0xbadcafe);
+
+    std::vector<NamedKernels> kernel_sets = {
+        { "sse", kernels::inverse_n_sse, kernels::inverse_rotation_translation_n_sse, kernels::mul_mat_mat_n_sse },
+    };
+
+#if LOGL_HAVE_AVX2_KERNELS
+    if (eng::cpu_features().avx2 && eng::cpu_features().fma) {
+        kernel_sets.push_back(NamedKernels{ "avx2",
+                                            kernels::inverse_n_avx2,
+                                            kernels::inverse_rotation_translation_n_avx2,
+                                            kernels::mul_mat_mat_n_avx2 });
+    }
+#endif
+
+    printf("CPU features: %s\n", eng::cpu_features_string());
+
+    for (u32 count : { 0u, 1u, 7u, 8u, 9u, 31u, 1000u, 5000u }) {
+        std::vector<Matrix4x4> a(count), b(count), rigid(count);
+        std::generate(a.begin(), a.end(), random_matrix);
+        std::generate(b.begin(), b.end(), random_matrix);
+        std::generate(rigid.begin(), rigid.end(), random_rigid_transform);
+
+        std::vector<Matrix4x4> expected_inverse(count), expected_rigid_inverse(count), expected_product(count);
+        for (u32 i = 0; i < count; ++i) {
+            expected_inverse[i] = inverse(a[i]);
+            expected_rigid_inverse[i] = inverse_rotation_translation(rigid[i]);
+            expected_product[i] = a[i] * b[i];
+        }
+
+        for (const auto &k : kernel_sets) {
+            // In place, as that's how these get called mostly
+            auto out = a;
+            k.inverse(out.data(), out.data(), count);
+            check_all(expected_inverse, out, k.name);
+
+            out = rigid;
+            k.inverse_rotation_translation(out.data(), out.data(), count);
+            check_all(expected_rigid_inverse, out, k.name);
+
+            out = b;
+            k.mul_mat_mat(a.data(), out.data(), out.data(), count);
+            check_all(expected_product, out, k.name);
+        }
+
+        // The public functions, single and multithreaded
+        for (bool multithreaded : { false, true }) {
+            std::vector<Matrix4x4> out(count);
+            inverse_n(a.data(), out.data(), count, multithreaded);
+            check_all(expected_inverse, out, "inverse_n");
+
+            inverse_rotation_translation_n(rigid.data(), out.data(), count, multithreaded);
+            check_all(expected_rigid_inverse, out, "inverse_rotation_translation_n");
+
+            mul_mat_mat_n(a.data(), b.data(), out.data(), count, multithreaded);
+            check_all(expected_product, out, "mul_mat_mat_n");
+        }
+    }
+
+    printf("OK\n");
+}
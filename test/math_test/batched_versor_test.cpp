@@ -0,0 +1,239 @@
+// Checks the batched versor and LocalTransform functions against the scalar ones, for every kernel and with odd
+// counts so the tail handling gets exercised. slerp_n is only an approximation, so that one is checked against
+// the error bound given in math_ops.h.
+
+#include "math_kernels.h"
+
+#include <learnogl/cpu_features.h>
+#include <learnogl/math_ops.h>
+#include <learnogl/rng.h>
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <stdio.h>
+#include <vector>
+
+using namespace fo;
+using namespace eng::math;
+
+static Quaternion random_versor() {
+    const Vector3 axis = normalize(
+        Vector3{ (float)rng::random(-1.0, 1.0), (float)rng::random(-1.0, 1.0), (float)rng::random(0.1, 1.0) });
+    return versor_from_axis_angle(axis, (float)rng::random(-2.0 * pi, 2.0 * pi));
+}
+
+// Within a few degrees of `q`, where nlerp and the approximation are at their most accurate and the exact slerp
+// takes its nlerp fallback.
+static Quaternion nearby_versor(const Quaternion &q) {
+    const Quaternion d = versor_from_axis_angle(unit_y, (float)rng::random(-0.05, 0.05));
+    return normalize(mul(q, d));
+}
+
+static Vector3 random_vector(double lo, double hi) {
+    return Vector3{ (float)rng::random(lo, hi), (float)rng::random(lo, hi), (float)rng::random(lo, hi) };
+}
+
+static LocalTransform random_local_transform() {
+    return LocalTransform(random_vector(0.1, 4.0), random_versor(), random_vector(-100.0, 100.0));
+}
+
+// Angle of the rotation between two versors. From the distance between them rather than acos of their dot
+// product, which has an error of about 1e-3 radians when it's close to 1.
+static float angle_between(const Quaternion &a, const Quaternion &b) {
+    const double qa[4] = { a.x, a.y, a.z, a.w };
+    const double qb[4] = { b.x, b.y, b.z, b.w };
+    double dot = 0.0, len_a = 0.0, len_b = 0.0;
+    for (int i = 0; i < 4; ++i) {
+        dot += qa[i] * qb[i];
+        len_a += qa[i] * qa[i];
+        len_b += qb[i] * qb[i];
+    }
+    const double sign = dot < 0.0 ? -1.0 : 1.0;
+    double chord = 0.0;
+    for (int i = 0; i < 4; ++i) {
+        const double d = qa[i] / std::sqrt(len_a) - sign * qb[i] / std::sqrt(len_b);
+        chord += d * d;
+    }
+    return float(4.0 * std::asin(std::min(1.0, std::sqrt(chord) / 2.0)));
+}
+
+static float max_diff(const float *a, const float *b, u32 n) {
+    float diff = 0.0f;
+    for (u32 i = 0; i < n; ++i) {
+        diff = std::max(diff, std::abs(a[i] - b[i]) / (1.0f + std::abs(a[i])));
+    }
+    return diff;
+}
+
+template <typename T>
+static void check_all(const std::vector<T> &expected, const std::vector<T> &got, const char *what) {
+    CHECK_EQ_F(expected.size(), got.size());
+    constexpr u32 n = sizeof(T) / sizeof(float);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        const float diff =
+            max_diff(reinterpret_cast<const float *>(&expected[i]), reinterpret_cast<const float *>(&got[i]), n);
+        CHECK_F(diff < 1e-5f, "%s: element %zu differs by %f", what, i, diff);
+    }
+}
+
+static void check_versors_near(const std::vector<Quaternion> &expected,
+                               const std::vector<Quaternion> &got,
+                               float max_angle,
+                               const char *what) {
+    CHECK_EQ_F(expected.size(), got.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        const float angle = angle_between(expected[i], got[i]);
+        CHECK_F(angle < max_angle, "%s: versor %zu is %f radians off", what, i, angle);
+    }
+}
+
+// The error bound of slerp_n, plus some for float rounding
+constexpr float slerp_max_error = 1e-3f;
+
+struct NamedKernels {
+    const char *name;
+    kernels::VersorKernels k;
+};
+
+int main() {
+    rng::init_rng(0xbadcafe);
+
+    std::vector<NamedKernels> kernel_sets = {
+        { "sse",
+          { kernels::normalize_n_sse,
+            kernels::nlerp_n_sse,
+            kernels::slerp_n_sse,
+            kernels::matrix_from_versor_n_sse,
+            kernels::slerp_local_transforms_sse,
+            kernels::matrix_from_local_transform_n_sse } },
+    };
+
+#if LOGL_HAVE_AVX2_KERNELS
+    if (eng::cpu_features().avx2 && eng::cpu_features().fma) {
+        kernel_sets.push_back(NamedKernels{ "avx2",
+                                            { kernels::normalize_n_avx2,
+                                              kernels::nlerp_n_avx2,
+                                              kernels::slerp_n_avx2,
+                                              kernels::matrix_from_versor_n_avx2,
+                                              kernels::slerp_local_transforms_avx2,
+                                              kernels::matrix_from_local_transform_n_avx2 } });
+    }
+#endif
+
+    printf("CPU features: %s\n", eng::cpu_features_string());
+
+    for (u32 count : { 0u, 1u, 7u, 8u, 9u, 31u, 1000u, 5000u }) {
+        std::vector<Quaternion> a(count), b(count), unnormalized(count);
+        std::vector<float> alphas(count);
+        std::vector<LocalTransform> ta(count), tb(count);
+
+        for (u32 i = 0; i < count; ++i) {
+            a[i] = random_versor();
+            b[i] = i % 4 == 0 ? nearby_versor(a[i]) : random_versor();
+            const float k = (float)rng::random(0.1, 10.0);
+            unnormalized[i] = Quaternion{ a[i].x * k, a[i].y * k, a[i].z * k, a[i].w * k };
+            alphas[i] = (float)rng::random(0.0, 1.0);
+            ta[i] = random_local_transform();
+            tb[i] = random_local_transform();
+        }
+        const float alpha = 0.3f;
+
+        std::vector<Quaternion> expected_normalized(count), expected_nlerp(count), expected_slerp(count);
+        std::vector<Quaternion> expected_nlerp_one_alpha(count), expected_slerp_one_alpha(count);
+        std::vector<Matrix4x4> expected_versor_matrices(count), expected_transform_matrices(count);
+        std::vector<LocalTransform> expected_blended(count);
+
+        kernels::normalize_n_scalar(unnormalized.data(), expected_normalized.data(), count);
+        kernels::nlerp_n_scalar(a.data(), b.data(), alphas.data(), 1, expected_nlerp.data(), count);
+        kernels::slerp_n_scalar(a.data(), b.data(), alphas.data(), 1, expected_slerp.data(), count);
+        kernels::nlerp_n_scalar(a.data(), b.data(), &alpha, 0, expected_nlerp_one_alpha.data(), count);
+        kernels::slerp_n_scalar(a.data(), b.data(), &alpha, 0, expected_slerp_one_alpha.data(), count);
+        kernels::matrix_from_versor_n_scalar(a.data(), expected_versor_matrices.data(), count);
+        kernels::matrix_from_local_transform_n_scalar(ta.data(), expected_transform_matrices.data(), count);
+        kernels::slerp_local_transforms_scalar(ta.data(), tb.data(), alphas.data(), 1, expected_blended.data(), count);
+
+        for (u32 i = 0; i < count; ++i) {
+            // The reference itself, against the rotation angle it should give
+            const float theta = angle_between(a[i], b[i]);
+            CHECK_F(std::abs(angle_between(a[i], expected_slerp[i]) - alphas[i] * theta) < 1e-3f);
+        }
+
+        for (const auto &named : kernel_sets) {
+            const auto &k = named.k;
+
+            // In place, as with the matrix kernels
+            auto out = unnormalized;
+            k.normalize(out.data(), out.data(), count);
+            check_all(expected_normalized, out, named.name);
+
+            out = b;
+            k.nlerp(a.data(), out.data(), alphas.data(), 1, out.data(), count);
+            check_all(expected_nlerp, out, named.name);
+
+            k.nlerp(a.data(), b.data(), &alpha, 0, out.data(), count);
+            check_all(expected_nlerp_one_alpha, out, named.name);
+
+            out = a;
+            k.slerp(out.data(), b.data(), alphas.data(), 1, out.data(), count);
+            check_versors_near(expected_slerp, out, slerp_max_error, named.name);
+
+            k.slerp(a.data(), b.data(), &alpha, 0, out.data(), count);
+            check_versors_near(expected_slerp_one_alpha, out, slerp_max_error, named.name);
+
+            std::vector<Matrix4x4> matrices(count);
+            k.matrix_from_versor(a.data(), matrices.data(), count);
+            check_all(expected_versor_matrices, matrices, named.name);
+
+            k.matrix_from_local_transform(ta.data(), matrices.data(), count);
+            check_all(expected_transform_matrices, matrices, named.name);
+
+            auto blended = ta;
+            k.slerp_local_transforms(blended.data(), tb.data(), alphas.data(), 1, blended.data(), count);
+            for (u32 i = 0; i < count; ++i) {
+                const LocalTransform &e = expected_blended[i];
+                CHECK_F(max_diff(&e.scale.x, &blended[i].scale.x, 3) < 1e-5f, "%s: scale %u", named.name, i);
+                CHECK_F(
+                    max_diff(&e.position.x, &blended[i].position.x, 3) < 1e-5f, "%s: position %u", named.name, i);
+                CHECK_F(angle_between(e.orientation, blended[i].orientation) < slerp_max_error,
+                        "%s: orientation %u",
+                        named.name,
+                        i);
+            }
+        }
+
+        // The public functions, single and multithreaded
+        for (bool multithreaded : { false, true }) {
+            std::vector<Quaternion> out(count);
+            normalize_n(unnormalized.data(), out.data(), count, multithreaded);
+            check_all(expected_normalized, out, "normalize_n");
+
+            nlerp_n(a.data(), b.data(), alphas.data(), out.data(), count, multithreaded);
+            check_all(expected_nlerp, out, "nlerp_n");
+
+            nlerp_n(a.data(), b.data(), alpha, out.data(), count, multithreaded);
+            check_all(expected_nlerp_one_alpha, out, "nlerp_n");
+
+            slerp_n(a.data(), b.data(), alphas.data(), out.data(), count, multithreaded);
+            check_versors_near(expected_slerp, out, slerp_max_error, "slerp_n");
+
+            slerp_n(a.data(), b.data(), alpha, out.data(), count, multithreaded);
+            check_versors_near(expected_slerp_one_alpha, out, slerp_max_error, "slerp_n");
+
+            std::vector<Matrix4x4> matrices(count);
+            matrix_from_versor_n(a.data(), matrices.data(), count, multithreaded);
+            check_all(expected_versor_matrices, matrices, "matrix_from_versor_n");
+
+            matrix_from_local_transform_n(ta.data(), matrices.data(), count, multithreaded);
+            check_all(expected_transform_matrices, matrices, "matrix_from_local_transform_n");
+
+            std::vector<LocalTransform> blended(count);
+            slerp_n(ta.data(), tb.data(), alphas.data(), blended.data(), count, multithreaded);
+            for (u32 i = 0; i < count; ++i) {
+                CHECK_F(angle_between(expected_blended[i].orientation, blended[i].orientation) < slerp_max_error);
+            }
+        }
+    }
+
+    printf("OK\n");
+}
@@ -0,0 +1,438 @@
+// Checks the point reductions behind calculate_AABB, calculate_principal_axis and create_minimal_bounding_sphere. The
+// SIMD kernels are checked against the scalar ones, the multithreaded and strided forms of the public functions
+// against the plain ones, bit for bit, the principal axis of point clouds far from the origin against what they were
+// made from, and the minimal sphere against a brute force search.
+
+#include "math_kernels.h"
+
+#include <learnogl/bounding_shapes.h>
+#include <learnogl/cpu_features.h>
+#include <learnogl/math_ops.h>
+#include <learnogl/rng.h>
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+using namespace fo;
+using namespace eng::math;
+
+// Positions inside a bigger vertex, like the ones in a MeshData buffer
+struct Vertex {
+    Vector3 position;
+    Vector3 normal;
+    float uv[2];
+};
+
+static bool same_bits(const void *a, const void *b, size_t num_bytes) { return memcmp(a, b, num_bytes) == 0; }
+
+static bool close(double a, double b, double tolerance) {
+    return std::abs(a - b) <= tolerance * std::max(1.0, std::max(std::abs(a), std::abs(b)));
+}
+
+static Matrix3x3 rotation_about(const Vector3 &axis, float angle) {
+    const Matrix4x4 m = rotation_matrix(normalize(axis), angle);
+    return Matrix3x3{ Vector3(m.x), Vector3(m.y), Vector3(m.z) };
+}
+
+// A box of the given half extents, rotated and moved away from the origin
+static std::vector<Vertex> random_cloud(u32 count, Vector3 half_extent, const Matrix3x3 &rotation, Vector3 center) {
+    std::vector<Vertex> vertices(count + 1);
+    for (u32 i = 0; i < count; ++i) {
+        const Vector3 local{ (float)rng::random(-half_extent.x, half_extent.x),
+                             (float)rng::random(-half_extent.y, half_extent.y),
+                             (float)rng::random(-half_extent.z, half_extent.z) };
+        vertices[i].position = rotation.x * local.x + rotation.y * local.y + rotation.z * local.z + center;
+        vertices[i].normal = Vector3{ 7.0f, 7.0f, 7.0f };
+    }
+    return vertices;
+}
+
+struct NamedPointKernels {
+    const char *name;
+    kernels::PointKernels k;
+};
+
+static void check_kernels(const NamedPointKernels &named, const std::vector<Vertex> &vertices, u32 count) {
+    const Vector3 *points = &vertices[0].position;
+    const u32 stride = sizeof(Vertex);
+
+    Vector3 min, max, expected_min, expected_max;
+    named.k.bounds(points, stride, count, min, max);
+    kernels::bounds_scalar(points, stride, count, expected_min, expected_max);
+    CHECK_F(same_bits(&min, &expected_min, sizeof(Vector3)) && same_bits(&max, &expected_max, sizeof(Vector3)),
+            "%s bounds of %u points",
+            named.name,
+            count);
+
+    double sum[3], expected_sum[3];
+    named.k.sum(points, stride, count, sum);
+    kernels::sum_scalar(points, stride, count, expected_sum);
+
+    // The kernels sum blocks in float, so only as close as the magnitude of the points allows
+    double max_abs = 0.0;
+    for (u32 i = 0; i < count; ++i) {
+        const Vector3 &p = vertices[i].position;
+        max_abs = std::max(max_abs, double(std::max(std::abs(p.x), std::max(std::abs(p.y), std::abs(p.z)))));
+    }
+    for (u32 i = 0; i < 3; ++i) {
+        CHECK_F(close(sum[i] / count, expected_sum[i] / count, 1e-5 * std::max(1.0, max_abs)),
+                "%s sum of %u points",
+                named.name,
+                count);
+    }
+
+    const Vector3 mean{
+        float(expected_sum[0] / count), float(expected_sum[1] / count), float(expected_sum[2] / count)
+    };
+    double sums[6], expected_sums[6];
+    named.k.covariance(points, stride, count, mean, sums);
+    kernels::covariance_scalar(points, stride, count, mean, expected_sums);
+    for (u32 i = 0; i < 6; ++i) {
+        CHECK_F(close(sums[i] / count, expected_sums[i] / count, 1e-4),
+                "%s covariance of %u points",
+                named.name,
+                count);
+    }
+
+    // The SIMD kernels use FMA where they can, so a different point is fine as long as it's as far out
+    const Vector3 directions[] = { { 1.0f, 0.0f, 0.0f }, { 1.0f, -1.0f, 1.0f }, { -0.3f, 0.2f, 0.9f } };
+    u32 min_indices[3], max_indices[3], expected_min_indices[3], expected_max_indices[3];
+    named.k.extreme_points(points, stride, count, directions, 3, min_indices, max_indices);
+    kernels::extreme_points_scalar(points, stride, count, directions, 3, expected_min_indices, expected_max_indices);
+    for (u32 d = 0; d < 3; ++d) {
+        const auto dot_at = [&](u32 i) { return (double)dot(vertices[i].position, directions[d]); };
+        CHECK_F(min_indices[d] < count && max_indices[d] < count, "%s extreme points in range", named.name);
+        CHECK_F(close(dot_at(min_indices[d]), dot_at(expected_min_indices[d]), 1e-6) &&
+                    close(dot_at(max_indices[d]), dot_at(expected_max_indices[d]), 1e-6),
+                "%s extreme points of %u points",
+                named.name,
+                count);
+    }
+
+    const Vector3 from = vertices[count / 2].position + Vector3{ 0.5f, -0.25f, 0.125f };
+    u32 farthest, expected_farthest;
+    float dist2, expected_dist2;
+    named.k.farthest_point(points, stride, count, from, farthest, dist2);
+    kernels::farthest_point_scalar(points, stride, count, from, expected_farthest, expected_dist2);
+    CHECK_F(farthest < count && close(dist2, expected_dist2, 1e-6) &&
+                close(square_magnitude(vertices[farthest].position - from), expected_dist2, 1e-6),
+            "%s farthest point of %u points",
+            named.name,
+            count);
+}
+
+// -- Minimal bounding sphere
+
+struct Sphere3d {
+    double center[3];
+    double radius;
+};
+
+static double dist(const double *a, const Vector3 &p) {
+    const double dx = p.x - a[0], dy = p.y - a[1], dz = p.z - a[2];
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+// Sphere through the given points with its center in their affine hull. False if they're degenerate.
+static bool circumsphere(const Vector3 *const *p, u32 n, Sphere3d &out) {
+    // Center = p0 + sum of t_i * (p_i - p0), with |c - p_i| = |c - p0|, which is a linear system in the t_i
+    double e[3][3], m[3][3], rhs[3];
+    for (u32 i = 1; i < n; ++i) {
+        e[i - 1][0] = p[i]->x - (double)p[0]->x;
+        e[i - 1][1] = p[i]->y - (double)p[0]->y;
+        e[i - 1][2] = p[i]->z - (double)p[0]->z;
+    }
+    const u32 k = n - 1;
+    for (u32 i = 0; i < k; ++i) {
+        for (u32 j = 0; j < k; ++j) {
+            m[i][j] = 2.0 * (e[i][0] * e[j][0] + e[i][1] * e[j][1] + e[i][2] * e[j][2]);
+        }
+        rhs[i] = e[i][0] * e[i][0] + e[i][1] * e[i][1] + e[i][2] * e[i][2];
+    }
+
+    // Gaussian elimination with partial pivoting
+    double t[3] = {};
+    for (u32 col = 0; col < k; ++col) {
+        u32 pivot = col;
+        for (u32 row = col + 1; row < k; ++row) {
+            if (std::abs(m[row][col]) > std::abs(m[pivot][col])) {
+                pivot = row;
+            }
+        }
+        if (std::abs(m[pivot][col]) < 1e-9 * std::max(1.0, std::abs(m[0][0]))) {
+            return false;
+        }
+        std::swap(m[col], m[pivot]);
+        std::swap(rhs[col], rhs[pivot]);
+        for (u32 row = col + 1; row < k; ++row) {
+            const double f = m[row][col] / m[col][col];
+            for (u32 j = col; j < k; ++j) {
+                m[row][j] -= f * m[col][j];
+            }
+            rhs[row] -= f * rhs[col];
+        }
+    }
+    for (int row = int(k) - 1; row >= 0; --row) {
+        double x = rhs[row];
+        for (u32 j = row + 1; j < k; ++j) {
+            x -= m[row][j] * t[j];
+        }
+        t[row] = x / m[row][row];
+    }
+
+    out.center[0] = p[0]->x;
+    out.center[1] = p[0]->y;
+    out.center[2] = p[0]->z;
+    for (u32 i = 0; i < k; ++i) {
+        for (u32 j = 0; j < 3; ++j) {
+            out.center[j] += t[i] * e[i][j];
+        }
+    }
+    out.radius = dist(out.center, *p[0]);
+    return true;
+}
+
+// Smallest of the spheres through 1 to 4 of the points that contains all of them
+static double brute_force_minimal_radius(const std::vector<Vector3> &points) {
+    const u32 n = (u32)points.size();
+    double best = INFINITY;
+
+    const auto try_sphere = [&](std::initializer_list<u32> indices) {
+        const Vector3 *p[4];
+        u32 k = 0;
+        for (u32 i : indices) {
+            p[k++] = &points[i];
+        }
+        Sphere3d sphere;
+        if (!circumsphere(p, k, sphere) || sphere.radius >= best) {
+            return;
+        }
+        for (const Vector3 &q : points) {
+            if (dist(sphere.center, q) > sphere.radius * (1.0 + 1e-9) + 1e-12) {
+                return;
+            }
+        }
+        best = sphere.radius;
+    };
+
+    for (u32 a = 0; a < n; ++a) {
+        try_sphere({ a });
+        for (u32 b = a + 1; b < n; ++b) {
+            try_sphere({ a, b });
+            for (u32 c = b + 1; c < n; ++c) {
+                try_sphere({ a, b, c });
+                for (u32 d = c + 1; d < n; ++d) {
+                    try_sphere({ a, b, c, d });
+                }
+            }
+        }
+    }
+    return best;
+}
+
+static void check_contains(const eng::BoundingSphere &sphere, const Vector3 *points, u32 stride, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        const Vector3 &p = *kernels::advance_bytes(points, size_t(i) * stride);
+        CHECK_F(square_magnitude(p - sphere.center) <= sphere.radius * sphere.radius,
+                "Point %u of %u outside the sphere",
+                i,
+                count);
+    }
+}
+
+static void check_minimal_sphere(const std::vector<Vector3> &points, double expected_radius, double tolerance) {
+    const u32 count = (u32)points.size();
+    const eng::BoundingSphere sphere = eng::create_minimal_bounding_sphere(points.data(), count);
+    check_contains(sphere, points.data(), sizeof(Vector3), count);
+    CHECK_F(close(sphere.radius, expected_radius, tolerance),
+            "Minimal sphere of %u points has radius %f, expected %f",
+            count,
+            sphere.radius,
+            expected_radius);
+}
+
+static void check_minimal_spheres() {
+    // Against the brute force search, on small random clouds of different shapes
+    for (u32 trial = 0; trial < 200; ++trial) {
+        const u32 count = 1 + trial % 20;
+        const Matrix3x3 rotation = rotation_about(Vector3{ 1.0f, 1.0f, float(trial) }, 0.1f * trial);
+        const float flatness = trial % 3 == 0 ? 0.0f : 1.0f;
+        std::vector<Vector3> points;
+        for (const Vertex &v : random_cloud(count, Vector3{ 3.0f, 2.0f, flatness }, rotation, Vector3{ 5, 6, 7 })) {
+            points.push_back(v.position);
+        }
+        points.pop_back();
+        check_minimal_sphere(points, brute_force_minimal_radius(points), 1e-5);
+    }
+
+    // Degenerate ones. Cube corners are cospherical, a grid is coplanar and full of cocircular points.
+    std::vector<Vector3> cube;
+    for (u32 i = 0; i < 8; ++i) {
+        cube.push_back(Vector3{ (i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f });
+    }
+    check_minimal_sphere(cube, std::sqrt(3.0), 1e-6);
+
+    std::vector<Vector3> grid;
+    for (u32 i = 0; i < 64; ++i) {
+        grid.push_back(Vector3{ float(i % 8), float(i / 8), 100.0f });
+    }
+    check_minimal_sphere(grid, std::sqrt(2.0) * 3.5, 1e-6);
+
+    std::vector<Vector3> line;
+    for (u32 i = 0; i < 100; ++i) {
+        line.push_back(Vector3{ 1.0f, 2.0f, 3.0f } * float(i) / 99.0f);
+    }
+    check_minimal_sphere(line, std::sqrt(14.0) / 2.0, 1e-6);
+
+    check_minimal_sphere(std::vector<Vector3>(10, Vector3{ -1.0f, 2.0f, 3.0f }), 0.0, 1e-6);
+    check_minimal_sphere(std::vector<Vector3>(1, Vector3{ 4.0f, 5.0f, 6.0f }), 0.0, 1e-6);
+
+    // A ball with the poles on it, and many points inside
+    std::vector<Vector3> ball = { { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f } };
+    while (ball.size() < 100000) {
+        const Vector3 p{
+            (float)rng::random(-1.0, 1.0), (float)rng::random(-1.0, 1.0), (float)rng::random(-1.0, 1.0)
+        };
+        if (square_magnitude(p) < 0.99f) {
+            ball.push_back(p);
+        }
+    }
+    check_minimal_sphere(ball, 1.0, 1e-6);
+}
+
+// Large clouds. The input stays as it was, the strided and multithreaded forms give the same sphere, and it's no
+// bigger than what create_bounding_sphere_iterative finds.
+static void check_large_minimal_sphere(u32 count) {
+    const Matrix3x3 rotation = rotation_about(Vector3{ 2.0f, -1.0f, 0.5f }, 0.3f);
+    const std::vector<Vertex> vertices =
+        random_cloud(count, Vector3{ 30.0f, 20.0f, 10.0f }, rotation, Vector3{ -1e4f, 3e3f, 2e4f });
+    const std::vector<Vertex> copy = vertices;
+
+    std::vector<Vector3> packed(count);
+    for (u32 i = 0; i < count; ++i) {
+        packed[i] = vertices[i].position;
+    }
+
+    const eng::BoundingSphere sphere = eng::create_minimal_bounding_sphere(packed.data(), count);
+    const eng::BoundingSphere strided =
+        eng::create_minimal_bounding_sphere(&vertices[0].position, sizeof(Vertex), count);
+    const eng::BoundingSphere mt =
+        eng::create_minimal_bounding_sphere(&vertices[0].position, sizeof(Vertex), count, true);
+
+    CHECK_F(same_bits(&sphere, &strided, sizeof(sphere)), "Strided minimal sphere of %u points", count);
+    CHECK_F(same_bits(&sphere, &mt, sizeof(sphere)), "Multithreaded minimal sphere of %u points", count);
+    CHECK_F(same_bits(vertices.data(), copy.data(), count * sizeof(Vertex)), "Points were modified");
+    check_contains(sphere, packed.data(), sizeof(Vector3), count);
+
+    if (count <= 10000) {
+        const eng::PrincipalAxis pa = eng::calculate_principal_axis(packed.data(), count);
+        const eng::BoundingSphere iterative = eng::create_bounding_sphere_iterative(pa, packed.data(), count);
+        // Both centers are rounded to floats, which far from the origin moves them by up to half a float step
+        const float rounding = 2e4f * std::numeric_limits<float>::epsilon() * 2.0f;
+        CHECK_F(sphere.radius <= iterative.radius + rounding,
+                "Minimal sphere radius %f, iterative %f",
+                sphere.radius,
+                iterative.radius);
+    }
+}
+
+static void check_public_functions(u32 count) {
+    const Matrix3x3 rotation = rotation_about(Vector3{ 1.0f, 2.0f, -0.5f }, 0.7f);
+    const std::vector<Vertex> vertices =
+        random_cloud(count, Vector3{ 100.0f, 10.0f, 1.0f }, rotation, Vector3{ 1e4f, -2e4f, 5e3f });
+
+    std::vector<Vector3> packed(count);
+    for (u32 i = 0; i < count; ++i) {
+        packed[i] = vertices[i].position;
+    }
+
+    const AABB aabb = eng::calculate_AABB(packed.data(), count);
+    const AABB strided_aabb = eng::calculate_AABB(&vertices[0].position, sizeof(Vertex), count);
+    const AABB mt_aabb = eng::calculate_AABB(&vertices[0].position, sizeof(Vertex), count, true);
+    CHECK_F(same_bits(&aabb, &strided_aabb, sizeof(AABB)), "Strided AABB of %u points", count);
+    CHECK_F(same_bits(&aabb, &mt_aabb, sizeof(AABB)), "Multithreaded AABB of %u points", count);
+
+    for (u32 i = 0; i < count; ++i) {
+        const Vector3 &p = packed[i];
+        CHECK_F(aabb.min.x <= p.x && aabb.min.y <= p.y && aabb.min.z <= p.z, "AABB min, point %u", i);
+        CHECK_F(aabb.max.x >= p.x && aabb.max.y >= p.y && aabb.max.z >= p.z, "AABB max, point %u", i);
+    }
+
+    const eng::PrincipalAxis pa = eng::calculate_principal_axis(packed.data(), count);
+    const eng::PrincipalAxis strided_pa =
+        eng::calculate_principal_axis(&vertices[0].position, sizeof(Vertex), count);
+    const eng::PrincipalAxis mt_pa =
+        eng::calculate_principal_axis(&vertices[0].position, sizeof(Vertex), count, true);
+    CHECK_F(same_bits(&pa, &strided_pa, sizeof(pa)), "Strided principal axis of %u points", count);
+    CHECK_F(same_bits(&pa, &mt_pa, sizeof(pa)), "Multithreaded principal axis of %u points", count);
+
+    double mean[3] = { 0.0, 0.0, 0.0 };
+    for (const Vector3 &p : packed) {
+        mean[0] += p.x;
+        mean[1] += p.y;
+        mean[2] += p.z;
+    }
+    CHECK_F(close(pa.mean.x, mean[0] / count, 1e-6) && close(pa.mean.y, mean[1] / count, 1e-6) &&
+                close(pa.mean.z, mean[2] / count, 1e-6),
+            "Mean of %u points",
+            count);
+
+    // The longest side of the box is the axis with the most spread
+    if (count >= 1000) {
+        const float along_longest = dot(pa.axes[pa.axis_with_max_extent], rotation.x);
+        CHECK_F(std::abs(along_longest) > 0.999f, "Principal axis of %u points is off by %f", count, along_longest);
+    }
+}
+
+int main() {
+    rng::init_rng(0xb0b0);
+
+    std::vector<NamedPointKernels> kernel_sets = {
+        { "sse",
+          { kernels::bounds_sse,
+            kernels::sum_sse,
+            kernels::covariance_sse,
+            kernels::extreme_points_sse,
+            kernels::farthest_point_sse } },
+    };
+
+#if LOGL_HAVE_AVX2_KERNELS
+    const eng::CpuFeatures &cpu = eng::cpu_features();
+    if (cpu.avx2 && cpu.fma) {
+        kernel_sets.push_back(NamedPointKernels{ "avx2",
+                                                 { kernels::bounds_avx2,
+                                                   kernels::sum_avx2,
+                                                   kernels::covariance_avx2,
+                                                   kernels::extreme_points_avx2,
+                                                   kernels::farthest_point_avx2 } });
+    }
+#endif
+
+    printf("CPU features: %s\n", eng::cpu_features_string());
+
+    const Matrix3x3 rotation = rotation_about(Vector3{ -3.0f, 1.0f, 2.0f }, 1.3f);
+    for (const auto &named : kernel_sets) {
+        for (u32 count : { 1u, 3u, 8u, 9u, 1000u, 5000u }) {
+            check_kernels(named, random_cloud(count, Vector3{ 1.0f, 2.0f, 3.0f }, rotation, Vector3{}), count);
+            const Vector3 far_away{ -3e3f, 1e3f, 7e3f };
+            check_kernels(named, random_cloud(count, Vector3{ 50.0f, 5.0f, 0.5f }, rotation, far_away), count);
+        }
+    }
+
+    // Enough points for several chunks
+    for (u32 count : { 1u, 7u, 1000u, 100000u, 1000003u }) {
+        check_public_functions(count);
+    }
+
+    check_minimal_spheres();
+    for (u32 count : { 2u, 9u, 10000u, 1000003u }) {
+        check_large_minimal_sphere(count);
+    }
+
+    printf("OK\n");
+}
@@ -0,0 +1,349 @@
+// Checks the BVH against brute force raycasts over the same triangles and boxes, that the tree is well formed, and
+// that the multithreaded build gives the same tree as the single-threaded one.
+
+#include <learnogl/bvh.h>
+#include <learnogl/math_ops.h>
+#include <learnogl/rng.h>
+
+#include <loguru.hpp>
+
+#include <limits>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+using namespace fo;
+using namespace eng::math;
+
+static float random_float(float min, float max) { return (float)rng::random(min, max); }
+
+static Vector3 random_vector(float min, float max) {
+    return Vector3{ random_float(min, max), random_float(min, max), random_float(min, max) };
+}
+
+static Vector3 random_direction() {
+    Vector3 d;
+    do {
+        d = random_vector(-1.0f, 1.0f);
+    } while (square_magnitude(d) < 0.01f || square_magnitude(d) > 1.0f);
+    return normalize(d);
+}
+
+// Positions inside a bigger vertex, like the ones in a MeshData buffer
+struct Vertex {
+    Vector3 position;
+    Vector3 normal;
+};
+
+struct TriangleSoup {
+    std::vector<Vertex> vertices;
+    std::vector<u32> indices;
+
+    u32 num_triangles() const { return u32(indices.size() / 3); }
+    const Vector3 &vertex(u32 triangle, u32 corner) const {
+        return vertices[indices[triangle * 3 + corner]].position;
+    }
+};
+
+// Small triangles spread through a cube, some of them sharing vertices
+static TriangleSoup random_soup(u32 num_triangles, float triangle_size) {
+    TriangleSoup soup;
+    for (u32 i = 0; i < num_triangles; ++i) {
+        const Vector3 center = random_vector(-100.0f, 100.0f);
+        const u32 first = u32(soup.vertices.size());
+        for (u32 k = 0; k < 3; ++k) {
+            soup.vertices.push_back(Vertex{ center + random_vector(-triangle_size, triangle_size), {} });
+        }
+        soup.indices.insert(soup.indices.end(), { first, first + 1, first + 2 });
+        if (i % 4 == 3) {
+            soup.indices.insert(soup.indices.end(), { first, first + 2, first - 1 });
+            ++i;
+        }
+    }
+    return soup;
+}
+
+// Same test as the BVH's, over every triangle. The tests here are built for the native CPU, so it can round
+// differently where the compiler contracts to FMAs.
+static bool brute_force_raycast(const TriangleSoup &soup, const Ray &ray, float t_max, eng::RayHit &hit) {
+    bool found = false;
+    for (u32 i = 0; i < soup.num_triangles(); ++i) {
+        const Vector3 v0 = soup.vertex(i, 0);
+        const Vector3 e1 = soup.vertex(i, 1) - v0;
+        const Vector3 e2 = soup.vertex(i, 2) - v0;
+
+        const Vector3 p = cross(ray.direction, e2);
+        const float det = dot(e1, p);
+        if (det == 0.0f) {
+            continue;
+        }
+        const float inv_det = 1.0f / det;
+        const Vector3 s = ray.origin - v0;
+        const float u = dot(s, p) * inv_det;
+        if (u < 0.0f || u > 1.0f) {
+            continue;
+        }
+        const Vector3 q = cross(s, e1);
+        const float v = dot(ray.direction, q) * inv_det;
+        if (v < 0.0f || u + v > 1.0f) {
+            continue;
+        }
+        const float t = dot(e2, q) * inv_det;
+        if (t >= 0.0f && t <= t_max && (!found || t < hit.t)) {
+            hit = eng::RayHit{ t, i, u, v };
+            found = true;
+        }
+    }
+    return found;
+}
+
+static float brute_force_box_entry(const AABB &box, const Ray &ray) {
+    float t_enter = 0.0f;
+    float t_exit = std::numeric_limits<float>::infinity();
+    for (u32 axis = 0; axis < 3; ++axis) {
+        const float o = (&ray.origin.x)[axis];
+        const float d = (&ray.direction.x)[axis];
+        const float lo = (&box.min.x)[axis];
+        const float hi = (&box.max.x)[axis];
+        if (d == 0.0f) {
+            if (o < lo || o > hi) {
+                return std::numeric_limits<float>::infinity();
+            }
+            continue;
+        }
+        const float t0 = (lo - o) / d;
+        const float t1 = (hi - o) / d;
+        t_enter = std::max(t_enter, std::min(t0, t1));
+        t_exit = std::min(t_exit, std::max(t0, t1));
+    }
+    return t_enter <= t_exit ? t_enter : std::numeric_limits<float>::infinity();
+}
+
+static bool close(float a, float b) { return std::abs(a - b) <= 1e-4f * std::max(1.0f, std::abs(b)); }
+
+static bool contains(const eng::BVHNode &node, const AABB &box) {
+    return node.min.x <= box.min.x && node.min.y <= box.min.y && node.min.z <= box.min.z &&
+           node.max.x >= box.max.x && node.max.y >= box.max.y && node.max.z >= box.max.z;
+}
+
+// Each primitive is in exactly one leaf, leaves are within their ancestors, and the skip indices point past the
+// subtrees in depth-first order.
+static void check_structure(const eng::BVH &bvh, const AABB *primitive_bounds, u32 num_primitives) {
+    const u32 num_nodes = size(bvh.nodes);
+    CHECK_F(num_nodes >= 1 && num_nodes <= 2 * num_primitives - 1,
+            "%u nodes for %u primitives",
+            num_nodes,
+            num_primitives);
+    CHECK_F(size(bvh.primitive_indices) == num_primitives, "Primitive indices");
+
+    std::vector<u32> times_seen(num_primitives, 0);
+    u32 next_leaf_primitive = 0;
+
+    // The ancestors of the current node, as indices
+    std::vector<u32> ancestors;
+    for (u32 i = 0; i < num_nodes; ++i) {
+        const eng::BVHNode &node = bvh.nodes[i];
+        while (!ancestors.empty() && bvh.nodes[ancestors.back()].skip_index <= i) {
+            CHECK_F(bvh.nodes[ancestors.back()].skip_index == i, "Skip index of node %u", ancestors.back());
+            ancestors.pop_back();
+        }
+        CHECK_F(node.skip_index > i && node.skip_index <= num_nodes, "Skip index %u of node %u", node.skip_index, i);
+        CHECK_F(ancestors.empty() == (i == 0), "Node %u is outside the root", i);
+
+        if (!node.is_leaf()) {
+            CHECK_F(node.skip_index >= i + 3, "Interior node %u has two children", i);
+            ancestors.push_back(i);
+            continue;
+        }
+
+        CHECK_F(node.skip_index == i + 1, "Leaf %u skips to the next node", i);
+        CHECK_F(node.num_primitives() >= 1 && node.num_primitives() <= eng::k_bvh_max_leaf_primitives, "Leaf size");
+        CHECK_F(node.first_primitive() == next_leaf_primitive, "Leaves are in primitive order");
+        next_leaf_primitive += node.num_primitives();
+
+        for (u32 k = node.first_primitive(); k < node.first_primitive() + node.num_primitives(); ++k) {
+            const u32 primitive = bvh.primitive_indices[k];
+            CHECK_F(primitive < num_primitives, "Primitive index %u", primitive);
+            ++times_seen[primitive];
+            CHECK_F(contains(node, primitive_bounds[primitive]), "Leaf %u contains its primitives", i);
+            for (u32 a : ancestors) {
+                CHECK_F(contains(bvh.nodes[a], primitive_bounds[primitive]), "Node %u contains leaf %u", a, i);
+            }
+        }
+    }
+
+    CHECK_F(next_leaf_primitive == num_primitives, "Leaves cover every primitive");
+    for (u32 i = 0; i < num_primitives; ++i) {
+        CHECK_F(times_seen[i] == 1, "Primitive %u is in %u leaves", i, times_seen[i]);
+    }
+}
+
+static bool same_bvh(const eng::BVH &a, const eng::BVH &b) {
+    return size(a.nodes) == size(b.nodes) && size(a.primitive_indices) == size(b.primitive_indices) &&
+           memcmp(data(a.nodes), data(b.nodes), size(a.nodes) * sizeof(eng::BVHNode)) == 0 &&
+           memcmp(data(a.primitive_indices), data(b.primitive_indices), size(a.primitive_indices) * 4) == 0;
+}
+
+static void check_triangles(const TriangleSoup &soup, u32 num_rays) {
+    const u32 num_triangles = soup.num_triangles();
+
+    eng::TriangleBVH bvh;
+    eng::build_bvh(bvh, &soup.vertices[0].position, sizeof(Vertex), soup.indices.data(), num_triangles);
+
+    std::vector<AABB> bounds(num_triangles);
+    for (u32 i = 0; i < num_triangles; ++i) {
+        AABB box{ soup.vertex(i, 0), soup.vertex(i, 0) };
+        for (u32 k = 1; k < 3; ++k) {
+            const Vector3 &p = soup.vertex(i, k);
+            box.min = Vector3{ std::min(box.min.x, p.x), std::min(box.min.y, p.y), std::min(box.min.z, p.z) };
+            box.max = Vector3{ std::max(box.max.x, p.x), std::max(box.max.y, p.y), std::max(box.max.z, p.z) };
+        }
+        bounds[i] = box;
+    }
+    check_structure(bvh.bvh, bounds.data(), num_triangles);
+
+    eng::BVHBuildOptions options;
+    options.multithreaded = true;
+    eng::TriangleBVH mt_bvh;
+    eng::build_bvh(mt_bvh, &soup.vertices[0].position, sizeof(Vertex), soup.indices.data(), num_triangles, options);
+    CHECK_F(same_bvh(bvh.bvh, mt_bvh.bvh), "Multithreaded build of %u triangles", num_triangles);
+
+    u32 num_hits = 0;
+    for (u32 i = 0; i < num_rays; ++i) {
+        // Half the rays aimed at a triangle so that most of them hit something
+        const Vector3 origin = random_vector(-150.0f, 150.0f);
+        Vector3 direction = random_direction();
+        if (i % 2 == 0) {
+            const u32 target = u32(rng::random(0.0, double(num_triangles))) % num_triangles;
+            const Vector3 p = (soup.vertex(target, 0) + soup.vertex(target, 1) + soup.vertex(target, 2)) / 3.0f;
+            direction = normalize(p - origin);
+        }
+        const Ray ray(origin, direction);
+        const float t_max = i % 3 == 0 ? 50.0f : std::numeric_limits<float>::infinity();
+
+        eng::RayHit expected;
+        eng::RayHit hit;
+        const bool expected_found = brute_force_raycast(soup, ray, t_max, expected);
+        const bool found = eng::raycast(bvh, ray, t_max, hit);
+        CHECK_F(found == expected_found, "Ray %u hit %d, expected %d", i, found, expected_found);
+        if (!found) {
+            continue;
+        }
+
+        ++num_hits;
+        CHECK_F(close(hit.t, expected.t), "Ray %u hit at %f, expected %f", i, hit.t, expected.t);
+
+        // The point at t is where u and v say it is on the triangle
+        CHECK_F(hit.primitive < num_triangles, "Hit triangle %u", hit.primitive);
+        const Vector3 &v0 = soup.vertex(hit.primitive, 0);
+        const Vector3 on_triangle =
+            v0 + (soup.vertex(hit.primitive, 1) - v0) * hit.u + (soup.vertex(hit.primitive, 2) - v0) * hit.v;
+        CHECK_F(hit.u >= 0.0f && hit.v >= 0.0f && hit.u + hit.v <= 1.0f &&
+                    magnitude(ray.origin + ray.direction * hit.t - on_triangle) < 1e-3f * std::max(1.0f, hit.t),
+                "Ray %u hit triangle %u where it says",
+                i,
+                hit.primitive);
+    }
+    CHECK_F(num_rays == 0 || num_hits > num_rays / 4, "Only %u of %u rays hit", num_hits, num_rays);
+}
+
+static void check_boxes(u32 num_boxes, u32 num_rays) {
+    std::vector<AABB> boxes(num_boxes);
+    for (AABB &box : boxes) {
+        const Vector3 center = random_vector(-100.0f, 100.0f);
+        const Vector3 half_extent = random_vector(0.1f, 3.0f);
+        box = AABB{ center - half_extent, center + half_extent };
+    }
+
+    eng::BVH bvh;
+    eng::build_bvh(bvh, boxes.data(), num_boxes);
+    check_structure(bvh, boxes.data(), num_boxes);
+
+    eng::BVHBuildOptions options;
+    options.multithreaded = true;
+    options.max_leaf_primitives = 8;
+    eng::BVH mt_bvh;
+    eng::build_bvh(mt_bvh, boxes.data(), num_boxes, options);
+    options.multithreaded = false;
+    eng::build_bvh(bvh, boxes.data(), num_boxes, options);
+    CHECK_F(same_bvh(bvh, mt_bvh), "Multithreaded build of %u boxes", num_boxes);
+
+    for (u32 i = 0; i < num_rays; ++i) {
+        const Ray ray(random_vector(-150.0f, 150.0f), random_direction());
+
+        float expected_t = std::numeric_limits<float>::infinity();
+        for (const AABB &box : boxes) {
+            expected_t = std::min(expected_t, brute_force_box_entry(box, ray));
+        }
+
+        eng::RayHit hit;
+        const bool found = eng::raycast(bvh, boxes.data(), ray, std::numeric_limits<float>::infinity(), hit);
+        CHECK_F(found == (expected_t != std::numeric_limits<float>::infinity()), "Box ray %u", i);
+        if (found) {
+            // The BVH multiplies by the reciprocal of the direction instead of dividing
+            CHECK_F(close(hit.t, expected_t), "Box ray %u at %f, expected %f", i, hit.t, expected_t);
+            CHECK_F(close(brute_force_box_entry(boxes[hit.primitive], ray), hit.t),
+                    "Box ray %u hit box %u where it says",
+                    i,
+                    hit.primitive);
+        }
+    }
+}
+
+// Every triangle the same, so no split helps and the leaves are split in the middle instead
+static void check_degenerate() {
+    TriangleSoup soup;
+    soup.vertices = { Vertex{ { 0.0f, 0.0f, 0.0f }, {} },
+                      Vertex{ { 1.0f, 0.0f, 0.0f }, {} },
+                      Vertex{ { 0.0f, 1.0f, 0.0f }, {} } };
+    for (u32 i = 0; i < 100; ++i) {
+        soup.indices.insert(soup.indices.end(), { 0u, 1u, 2u });
+    }
+
+    eng::TriangleBVH bvh;
+    eng::build_bvh(bvh, &soup.vertices[0].position, sizeof(Vertex), soup.indices.data(), soup.num_triangles());
+    const AABB bounds{ { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 0.0f } };
+    std::vector<AABB> all_bounds(soup.num_triangles(), bounds);
+    check_structure(bvh.bvh, all_bounds.data(), soup.num_triangles());
+
+    eng::RayHit hit;
+    CHECK_F(eng::raycast(bvh, Ray({ 0.25f, 0.25f, 5.0f }, { 0.0f, 0.0f, -1.0f }), 10.0f, hit) &&
+                std::abs(hit.t - 5.0f) < 1e-5f,
+            "Hit the stacked triangles");
+    CHECK_F(!eng::raycast(bvh, Ray({ 0.25f, 0.25f, 5.0f }, { 0.0f, 0.0f, -1.0f }), 4.0f, hit), "Stopped at t_max");
+    CHECK_F(!eng::raycast(bvh, Ray({ 0.75f, 0.75f, 5.0f }, { 0.0f, 0.0f, -1.0f }), 10.0f, hit), "Missed");
+
+    // Parallel to the plane of the triangles, in it
+    CHECK_F(!eng::raycast(bvh, Ray({ -1.0f, 0.25f, 0.0f }, { 1.0f, 0.0f, 0.0f }), 10.0f, hit), "Ray in the plane");
+
+    // No triangles or boxes, built over the BVHs from before
+    eng::build_bvh(bvh, &soup.vertices[0].position, sizeof(Vertex), soup.indices.data(), 0);
+    CHECK_F(size(bvh.bvh.nodes) == 0 && size(bvh.bvh.primitive_indices) == 0 && size(bvh.triangles) == 0,
+            "Empty triangle BVH");
+    CHECK_F(!eng::raycast(bvh, Ray({ 0.25f, 0.25f, 5.0f }, { 0.0f, 0.0f, -1.0f }), 10.0f, hit), "Hit no triangles");
+
+    eng::BVH box_bvh;
+    eng::build_bvh(box_bvh, all_bounds.data(), u32(all_bounds.size()));
+    eng::build_bvh(box_bvh, nullptr, 0);
+    CHECK_F(size(box_bvh.nodes) == 0 && size(box_bvh.primitive_indices) == 0, "Empty box BVH");
+    CHECK_F(!eng::raycast(box_bvh, nullptr, Ray({ 0.25f, 0.25f, 5.0f }, { 0.0f, 0.0f, -1.0f }), 10.0f, hit),
+            "Hit no boxes");
+}
+
+int main() {
+    rng::init_rng(0xb7b);
+
+    check_degenerate();
+
+    for (u32 num_triangles : { 1u, 2u, 5u, 64u, 1000u }) {
+        check_triangles(random_soup(num_triangles, 2.0f), 500);
+    }
+    check_boxes(1, 100);
+    check_boxes(3000, 500);
+
+    // Big enough for the top of the tree to be split separately from the subtrees
+    check_triangles(random_soup(150000, 1.0f), 50);
+    check_boxes(100000, 50);
+
+    printf("OK\n");
+}
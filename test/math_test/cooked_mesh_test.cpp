@@ -0,0 +1,126 @@
+// Writes a model made up here to a cooked file and checks that mapping it gives back the same meshes, with the
+// buffers aligned, that changing a mapped buffer leaves the file alone, and that files from another version or
+// cut short are refused.
+
+#include <learnogl/mesh.h>
+#include <learnogl/rng.h>
+
+#include <loguru.hpp>
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+using namespace fo;
+using namespace eng;
+
+static const char *k_file_name = "cooked_mesh_test.logm";
+
+// A mesh with positions, normals and uvs, and bone data when num_bones isn't 0. Indices are u32 past what u16
+// can index.
+static void make_mesh(mesh::Model &m, u32 i, u32 num_vertices, u32 num_faces, u32 num_bones) {
+    mesh::MeshData &md = m._mesh_array[i];
+    md.o.num_vertices = num_vertices;
+    md.o.num_faces = num_faces;
+    md.o.position_offset = 0;
+    md.o.normal_offset = sizeof(Vector3);
+    md.o.tex2d_offset = 2 * sizeof(Vector3);
+    md.o.tangent_offset = mesh::ATTRIBUTE_NOT_PRESENT;
+    md.o.packed_attr_size = 2 * sizeof(Vector3) + sizeof(Vector2);
+    md.o.num_bones = num_bones;
+    md.o.index_size = num_vertices <= mesh::k_max_vertices_for_u16_indices ? sizeof(mesh::IndexType)
+                                                                           : sizeof(mesh::WideIndexType);
+    md.o.bone_data_offset = num_bones == 0 ? mesh::ATTRIBUTE_NOT_PRESENT : md.o.get_bones_byte_offset();
+    // Only to see the quantization fields go through, the vertices being random anyway
+    md.o.vertex_format = i == 0 ? mesh::VERTEX_FORMAT_QUANTIZED : mesh::VERTEX_FORMAT_F32;
+    md.o.position_min = Vector3{ -1.0f, -2.0f, -3.0f };
+    md.o.position_extent = Vector3{ 2.0f, 4.0f, 6.0f };
+    md.positions_are_2d = i % 2 == 1;
+
+    const u32 size = md.o.get_vertices_size_in_bytes() + md.o.get_indices_size_in_bytes() +
+                     md.o.get_bone_data_size_in_bytes();
+    md.buffer = (u8 *)m._buffer_allocator->allocate(size, 64);
+    for (u32 b = 0; b < size; ++b) {
+        md.buffer[b] = u8(rng::random_i32(0, 256));
+    }
+}
+
+static u32 buffer_size(const mesh::MeshData &md) {
+    return md.o.get_vertices_size_in_bytes() + md.o.get_indices_size_in_bytes() + md.o.get_bone_data_size_in_bytes();
+}
+
+static std::vector<u8> read_whole_file(const char *file_name) {
+    FILE *f = fopen(file_name, "rb");
+    CHECK_F(f != nullptr, "Opening %s", file_name);
+    std::vector<u8> bytes;
+    u8 chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) != 0) {
+        bytes.insert(bytes.end(), chunk, chunk + n);
+    }
+    fclose(f);
+    return bytes;
+}
+
+static void write_whole_file(const char *file_name, const std::vector<u8> &bytes) {
+    FILE *f = fopen(file_name, "wb");
+    CHECK_F(f != nullptr && fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size(), "Writing %s", file_name);
+    fclose(f);
+}
+
+int main() {
+    rng::init_rng(0xc00c);
+
+    mesh::Model source;
+    resize(source._mesh_array, 3);
+    make_mesh(source, 0, 1001, 1500, 0);
+    make_mesh(source, 1, 7, 3, 4);
+    make_mesh(source, 2, 70000, 100000, 0);
+
+    CHECK_F(mesh::write_cooked_model(source, k_file_name, mesh::TRIANGULATE), "Writing the cooked file");
+    CHECK_F(mesh::is_cooked_model_file(k_file_name), "Recognized as cooked");
+    CHECK_F(!mesh::is_cooked_model_file(SOURCE_DIR "/cooked_mesh_test.cpp"), "Not cooked");
+
+    const std::vector<u8> file_bytes = read_whole_file(k_file_name);
+
+    {
+        mesh::Model loaded;
+        CHECK_F(mesh::load(loaded, k_file_name), "Loading the cooked file");
+        CHECK_F(mesh::num_meshes(loaded) == mesh::num_meshes(source), "Number of meshes");
+
+        for (u32 i = 0; i < mesh::num_meshes(source); ++i) {
+            const mesh::MeshData &a = mesh::mesh_data(source, i);
+            const mesh::MeshData &b = mesh::mesh_data(loaded, i);
+            CHECK_F(memcmp(&a.o, &b.o, sizeof(a.o)) == 0, "Mesh %u offsets and sizes", i);
+            CHECK_F(a.positions_are_2d == b.positions_are_2d, "Mesh %u positions_are_2d", i);
+            CHECK_F(uintptr_t(b.buffer) % mesh::k_cooked_buffer_alignment == 0, "Mesh %u buffer alignment", i);
+            CHECK_F(memcmp(a.buffer, b.buffer, buffer_size(a)) == 0, "Mesh %u buffer", i);
+        }
+
+        // Copy-on-write
+        memset(mesh::mesh_data(loaded, 2).buffer, 0xab, 1024);
+    }
+    CHECK_F(read_whole_file(k_file_name) == file_bytes, "File changed by writing to the mapping");
+
+    // Another version
+    std::vector<u8> bytes = file_bytes;
+    bytes[4] += 1;
+    write_whole_file(k_file_name, bytes);
+    {
+        mesh::Model loaded;
+        CHECK_F(!mesh::load_cooked(loaded, k_file_name), "Loaded a file of another version");
+        CHECK_F(mesh::num_meshes(loaded) == 0, "Meshes left after failing");
+    }
+
+    // Cut short
+    bytes = file_bytes;
+    bytes.resize(bytes.size() - 100);
+    write_whole_file(k_file_name, bytes);
+    {
+        mesh::Model loaded;
+        CHECK_F(!mesh::load_cooked(loaded, k_file_name), "Loaded a truncated file");
+    }
+
+    remove(k_file_name);
+    printf("OK\n");
+}
@@ -0,0 +1,297 @@
+// Moves, creates and destroys proxies in a dynamic AABB tree over many frames, checking after each one that the
+// tree is well formed, that the pairs it reports together with the earlier ones still overlapping are exactly the
+// overlapping pairs found by brute force, and that box queries and raycasts find what brute force does.
+
+#include <learnogl/dynamic_aabb_tree.h>
+#include <learnogl/math_ops.h>
+#include <learnogl/rng.h>
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <stdio.h>
+#include <utility>
+#include <vector>
+
+using namespace fo;
+using namespace eng::math;
+
+static float random_float(float min, float max) { return (float)rng::random(min, max); }
+
+static Vector3 random_vector(float min, float max) {
+    return Vector3{ random_float(min, max), random_float(min, max), random_float(min, max) };
+}
+
+static AABB random_box(float world_size) {
+    const Vector3 center = random_vector(-world_size, world_size);
+    const Vector3 half_extent = random_vector(0.2f, 2.0f);
+    return AABB{ center - half_extent, center + half_extent };
+}
+
+static bool contains(const AABB &outer, const AABB &inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+           inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+}
+
+// Checks the links, boxes and heights below each node, and that every node is either in the tree or free. Returns
+// the number of leaves.
+static u32 check_structure(const eng::DynamicAABBTree &tree) {
+    const u32 num_nodes = size(tree.nodes);
+    std::vector<bool> seen(num_nodes, false);
+    u32 num_leaves = 0;
+
+    if (tree.root != eng::k_null_proxy) {
+        CHECK_F(tree.nodes[tree.root].parent == eng::k_null_proxy, "Root has a parent");
+
+        std::vector<u32> stack{ tree.root };
+        while (!stack.empty()) {
+            const u32 id = stack.back();
+            stack.pop_back();
+            CHECK_F(id < num_nodes && !seen[id], "Node %u reached twice", id);
+            seen[id] = true;
+
+            const eng::DynamicAABBTreeNode &node = tree.nodes[id];
+            if (node.is_leaf()) {
+                CHECK_F(node.height == 0, "Leaf %u has height %d", id, node.height);
+                ++num_leaves;
+                continue;
+            }
+
+            const eng::DynamicAABBTreeNode &child_1 = tree.nodes[node.child_1];
+            const eng::DynamicAABBTreeNode &child_2 = tree.nodes[node.child_2];
+            CHECK_F(child_1.parent == id && child_2.parent == id, "Children of %u don't point back to it", id);
+            CHECK_F(contains(node.box, child_1.box) && contains(node.box, child_2.box),
+                    "Box of %u doesn't contain its children",
+                    id);
+            CHECK_F(node.height == 1 + std::max(child_1.height, child_2.height),
+                    "Wrong height %d at %u",
+                    node.height,
+                    id);
+            stack.push_back(node.child_1);
+            stack.push_back(node.child_2);
+        }
+    }
+
+    u32 num_free = 0;
+    for (u32 id = tree.free_list; id != eng::k_null_proxy; id = tree.nodes[id].parent) {
+        CHECK_F(!seen[id] && tree.nodes[id].height == -1, "Free node %u is in the tree", id);
+        seen[id] = true;
+        ++num_free;
+    }
+
+    CHECK_F(num_leaves == tree.num_proxies, "%u leaves, %u proxies", num_leaves, tree.num_proxies);
+    CHECK_F(num_free + 2 * num_leaves - (num_leaves != 0) == num_nodes,
+            "%u nodes, %u leaves, %u free",
+            num_nodes,
+            num_leaves,
+            num_free);
+
+    // Balancing keeps it within a small factor of the best possible height
+    const int32_t best_height = num_leaves < 2 ? 0 : int32_t(std::ceil(std::log2(double(num_leaves))));
+    CHECK_F(eng::height(tree) <= 2 * best_height + 1,
+            "Height %d for %u leaves",
+            eng::height(tree),
+            num_leaves);
+    return num_leaves;
+}
+
+using PairSet = std::set<std::pair<u32, u32>>;
+
+static PairSet brute_force_pairs(const eng::DynamicAABBTree &tree, const std::vector<u32> &proxies) {
+    PairSet pairs;
+    for (size_t i = 0; i < proxies.size(); ++i) {
+        for (size_t j = i + 1; j < proxies.size(); ++j) {
+            const u32 a = std::min(proxies[i], proxies[j]);
+            const u32 b = std::max(proxies[i], proxies[j]);
+            if (eng::test_aabb_aabb(eng::fat_box(tree, a), eng::fat_box(tree, b))) {
+                pairs.insert({ a, b });
+            }
+        }
+    }
+    return pairs;
+}
+
+// The pairs reported and the pairs from before that still overlap are all the overlapping pairs
+static void check_pairs(eng::DynamicAABBTree &tree,
+                        const std::vector<u32> &proxies,
+                        PairSet &known,
+                        Array<eng::ProxyPair> &pairs) {
+    eng::update_pairs(tree, pairs);
+
+    for (u32 i = 0; i < size(pairs); ++i) {
+        CHECK_F(pairs[i].a < pairs[i].b, "Pair not ordered");
+        const bool after_previous =
+            i == 0 || pairs[i - 1].a < pairs[i].a || (pairs[i - 1].a == pairs[i].a && pairs[i - 1].b < pairs[i].b);
+        CHECK_F(after_previous, "Pairs not sorted or repeated");
+    }
+
+    const std::set<u32> alive(proxies.begin(), proxies.end());
+    PairSet still_known;
+    for (const auto &pair : known) {
+        if (alive.count(pair.first) && alive.count(pair.second) &&
+            eng::test_aabb_aabb(eng::fat_box(tree, pair.first), eng::fat_box(tree, pair.second))) {
+            still_known.insert(pair);
+        }
+    }
+    for (const eng::ProxyPair &pair : pairs) {
+        still_known.insert({ pair.a, pair.b });
+    }
+
+    const PairSet expected = brute_force_pairs(tree, proxies);
+    CHECK_F(still_known == expected, "%zu pairs known, %zu overlap", still_known.size(), expected.size());
+    known = expected;
+}
+
+static void check_queries(const eng::DynamicAABBTree &tree, const std::vector<u32> &proxies, float world_size) {
+    for (u32 round = 0; round < 20; ++round) {
+        const AABB box = random_box(world_size);
+        std::vector<u32> found;
+        eng::query(tree, box, [&](u32 proxy) {
+            found.push_back(proxy);
+            return true;
+        });
+        std::sort(found.begin(), found.end());
+
+        std::vector<u32> expected;
+        for (const u32 proxy : proxies) {
+            if (eng::test_aabb_aabb(eng::fat_box(tree, proxy), box)) {
+                expected.push_back(proxy);
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+        CHECK_F(found == expected, "Query found %zu, expected %zu", found.size(), expected.size());
+
+        // Nearest fat box along a ray
+        const Ray ray(random_vector(-world_size, world_size), random_vector(-1.0f, 1.0f));
+        const eng::PrecomputedRay precomputed(ray);
+        float nearest = std::numeric_limits<float>::infinity();
+        eng::raycast(tree, ray, nearest, [&](u32, float t) { return nearest = std::min(nearest, t); });
+
+        float expected_nearest = std::numeric_limits<float>::infinity();
+        for (const u32 proxy : proxies) {
+            float t;
+            if (eng::test_ray_aabb(precomputed, eng::fat_box(tree, proxy), expected_nearest, t)) {
+                expected_nearest = std::min(expected_nearest, t);
+            }
+        }
+        CHECK_F(nearest == expected_nearest, "Raycast hit at %f, expected %f", nearest, expected_nearest);
+    }
+}
+
+static void check_moving_proxies() {
+    const float world_size = 60.0f;
+    eng::DynamicAABBTree tree;
+    Array<eng::ProxyPair> pairs(memory_globals::default_allocator());
+    PairSet known;
+
+    std::vector<AABB> boxes(1500);
+    std::vector<u64> user_data(boxes.size());
+    std::vector<u32> proxies(boxes.size());
+    for (u32 i = 0; i < boxes.size(); ++i) {
+        boxes[i] = random_box(world_size);
+        user_data[i] = i;
+    }
+    eng::create_proxies(tree, boxes.data(), user_data.data(), u32(boxes.size()), proxies.data());
+    check_structure(tree);
+    for (u32 i = 0; i < proxies.size(); ++i) {
+        CHECK_F(eng::user_data(tree, proxies[i]) == i, "User data");
+        CHECK_F(contains(eng::fat_box(tree, proxies[i]), boxes[i]), "Fat box doesn't contain the box");
+    }
+    check_pairs(tree, proxies, known, pairs);
+
+    for (u32 frame = 0; frame < 60; ++frame) {
+        // Most move a little, some a lot
+        std::vector<u32> moved;
+        std::vector<AABB> moved_boxes;
+        std::vector<Vector3> displacements;
+        for (u32 i = 0; i < proxies.size(); ++i) {
+            if (rng::random() < 0.3) {
+                const Vector3 d =
+                    rng::random() < 0.05 ? random_vector(-10.0f, 10.0f) : random_vector(-0.3f, 0.3f);
+                boxes[i] = AABB{ boxes[i].min + d, boxes[i].max + d };
+                moved.push_back(proxies[i]);
+                moved_boxes.push_back(boxes[i]);
+                displacements.push_back(d);
+            }
+        }
+
+        // One at a time on odd frames, in a batch on even ones, and everything moves on every 20th
+        if (frame % 20 == 19) {
+            for (u32 i = 0; i < proxies.size(); ++i) {
+                boxes[i] = random_box(world_size);
+            }
+            eng::move_proxies(tree, proxies.data(), boxes.data(), nullptr, u32(proxies.size()));
+        } else if (frame % 2 == 0) {
+            eng::move_proxies(tree, moved.data(), moved_boxes.data(), displacements.data(), u32(moved.size()));
+        } else {
+            for (u32 i = 0; i < moved.size(); ++i) {
+                eng::move_proxy(tree, moved[i], moved_boxes[i], displacements[i]);
+            }
+        }
+
+        // Replace a few
+        for (u32 k = 0; k < 20; ++k) {
+            const u32 i = rng::random_i32(0, i32(proxies.size()));
+            eng::destroy_proxy(tree, proxies[i]);
+            boxes[i] = random_box(world_size);
+            proxies[i] = eng::create_proxy(tree, boxes[i], i);
+        }
+
+        for (u32 i = 0; i < proxies.size(); ++i) {
+            CHECK_F(contains(eng::fat_box(tree, proxies[i]), boxes[i]), "Fat box doesn't contain the box");
+        }
+        check_structure(tree);
+        check_pairs(tree, proxies, known, pairs);
+        check_queries(tree, proxies, world_size);
+    }
+
+    eng::rebuild(tree);
+    check_structure(tree);
+    check_queries(tree, proxies, world_size);
+
+    eng::destroy_proxies(tree, proxies.data(), u32(proxies.size()));
+    CHECK_F(check_structure(tree) == 0 && tree.root == eng::k_null_proxy, "Tree not empty");
+}
+
+// Moving within the fat box leaves the tree alone, leaving it or stopping after a fast move doesn't
+static void check_fat_boxes() {
+    eng::DynamicAABBTree tree;
+    tree.margin = 0.5f;
+    const AABB box{ { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } };
+    const u32 proxy = eng::create_proxy(tree, box, 7);
+    const u32 other = eng::create_proxy(tree, AABB{ { 5.0f, 0.0f, 0.0f }, { 6.0f, 1.0f, 1.0f } }, 8);
+
+    Array<eng::ProxyPair> pairs(memory_globals::default_allocator());
+    eng::update_pairs(tree, pairs);
+    CHECK_F(size(pairs) == 0, "No pairs");
+
+    const Vector3 zero{ 0.0f, 0.0f, 0.0f };
+    const Vector3 small{ 0.25f, 0.0f, 0.0f };
+    CHECK_F(!eng::move_proxy(tree, proxy, AABB{ box.min + small, box.max + small }, zero), "Moved within margin");
+
+    // Fast, so the fat box gets stretched ahead along the displacement
+    const Vector3 fast{ 1.0f, 0.0f, 0.0f };
+    CHECK_F(eng::move_proxy(tree, proxy, AABB{ box.min + fast, box.max + fast }, fast), "Left the fat box");
+    CHECK_F(eng::fat_box(tree, proxy).max.x == 2.0f + 0.5f + 4.0f, "Fat box stretched along the displacement");
+
+    eng::update_pairs(tree, pairs);
+    CHECK_F(size(pairs) == 1 && pairs[0].a == proxy && pairs[0].b == other, "Now overlapping");
+    eng::update_pairs(tree, pairs);
+    CHECK_F(size(pairs) == 0, "Nothing moved since");
+
+    // Stopped inside the stretched box, which is now too big
+    CHECK_F(eng::move_proxy(tree, proxy, AABB{ box.min + fast, box.max + fast }, zero), "Fat box shrinks");
+    CHECK_F(eng::fat_box(tree, proxy).max.x == 2.5f, "Fat box shrunk");
+    check_structure(tree);
+}
+
+int main() {
+    rng::init_rng(0xaabb);
+
+    check_fat_boxes();
+    check_moving_proxies();
+
+    printf("OK\n");
+}
@@ -1,36 +1,256 @@
+// Accuracy of eigensolve_sym3x3 and the batched Jacobi kernels behind eigensolve_sym3x3_n. Runs on the matrices
+// in SymmetricMatrices.txt (written by numpy_generate_symmetric.py), covariance matrices of random point sets,
+// and some that are hard for iterative solvers: diagonal, repeated eigenvalues, rank deficient, tiny and huge.
+
+#include "math_kernels.h"
+
+#include <learnogl/cpu_features.h>
 #include <learnogl/math_ops.h>
-#include <scaffold/debug.h>
+#include <learnogl/rng.h>
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
 
 using namespace fo;
-using namespace math;
+using namespace eng::math;
+
+// Errors are relative to the largest element of the matrix
+static constexpr float kTolerance = 1e-5f;
+
+static float max_abs_element(const Matrix3x3 &m) {
+    const float *f = reinterpret_cast<const float *>(&m);
+    float max_abs = 0.0f;
+    for (int i = 0; i < 9; ++i) {
+        max_abs = std::max(max_abs, std::abs(f[i]));
+    }
+    return max_abs;
+}
+
+// Reads the matrices printed by numpy, i.e. "[[a b c]\n [d e f]\n [g h i]]" one after another
+static std::vector<Matrix3x3> read_numpy_matrices(const char *file_name) {
+    FILE *f = fopen(file_name, "r");
+    CHECK_F(f != nullptr, "Could not open %s", file_name);
 
-static constexpr float kTolerance = 0.0001;
+    std::vector<float> numbers;
+    std::vector<char> token;
+    for (int c = fgetc(f); c != EOF; c = fgetc(f)) {
+        if (c == '[' || c == ']' || c == ' ' || c == '\n' || c == '\r') {
+            if (!token.empty()) {
+                token.push_back('\0');
+                numbers.push_back(strtof(token.data(), nullptr));
+                token.clear();
+            }
+        } else {
+            token.push_back((char)c);
+        }
+    }
+    fclose(f);
 
-static bool float_equal(const float f1, const float f2) { return std::abs(f1 - f2) <= kTolerance; }
+    CHECK_F(numbers.size() % 9 == 0, "Expected 3x3 matrices in %s", file_name);
 
-static bool vec_equal(const Vector3 &v1, const Vector3 &v2) {
-    return float_equal(v1.x, v2.x) && float_equal(v1.y, v2.y) && float_equal(v1.z, v2.z);
+    std::vector<Matrix3x3> matrices(numbers.size() / 9);
+    for (size_t i = 0; i < matrices.size(); ++i) {
+        const float *e = &numbers[i * 9];
+        // Symmetric, so row or column order doesn't matter
+        matrices[i] =
+            Matrix3x3{ Vector3{ e[0], e[1], e[2] }, Vector3{ e[3], e[4], e[5] }, Vector3{ e[6], e[7], e[8] } };
+    }
+    return matrices;
 }
 
-static bool mat_equal(const Matrix3x3 &m1, const Matrix3x3 &m2) {
-    return vec_equal(m1.x, m2.x) && vec_equal(m1.y, m2.y) && vec_equal(m1.z, m2.z);
+static Matrix3x3 covariance(const std::vector<Vector3> &points) {
+    Vector3 mean = zero_3;
+    for (const Vector3 &p : points) {
+        mean = mean + p;
+    }
+    mean = mean / float(points.size());
+
+    float c[3][3] = {};
+    for (const Vector3 &p : points) {
+        const float d[3] = { p.x - mean.x, p.y - mean.y, p.z - mean.z };
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                c[i][j] += d[i] * d[j] / float(points.size());
+            }
+        }
+    }
+    return Matrix3x3{ Vector3{ c[0][0], c[0][1], c[0][2] },
+                      Vector3{ c[1][0], c[1][1], c[1][2] },
+                      Vector3{ c[2][0], c[2][1], c[2][2] } };
+}
+
+// R * diag(l) * R^T for a random rotation R
+static Matrix3x3 with_eigenvalues(float l0, float l1, float l2) {
+    const Vector3 axis = normalize(
+        Vector3{ (float)rng::random(-1.0, 1.0), (float)rng::random(-1.0, 1.0), (float)rng::random(0.1, 1.0) });
+    const Matrix4x4 r = matrix_from_versor(versor_from_axis_angle(axis, (float)rng::random(-pi, pi)));
+    const Vector3 rx = Vector3(r.x), ry = Vector3(r.y), rz = Vector3(r.z);
+
+    const float l[3] = { l0, l1, l2 };
+    const Vector3 cols[3] = { rx, ry, rz };
+    float c[3][3] = {};
+    for (int k = 0; k < 3; ++k) {
+        const float v[3] = { cols[k].x, cols[k].y, cols[k].z };
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                c[i][j] += l[k] * v[i] * v[j];
+            }
+        }
+    }
+    // Make it exactly symmetric
+    return Matrix3x3{ Vector3{ c[0][0], c[0][1], c[0][2] },
+                      Vector3{ c[0][1], c[1][1], c[1][2] },
+                      Vector3{ c[0][2], c[1][2], c[2][2] } };
+}
+
+static std::vector<Matrix3x3> test_matrices() {
+    auto matrices = read_numpy_matrices(SOURCE_DIR "/SymmetricMatrices.txt");
+
+    // Same as numpy_generate_symmetric.py: 100 points on a grid within a cube of radius 1000
+    for (int i = 0; i < 200; ++i) {
+        std::vector<Vector3> points(100);
+        for (Vector3 &p : points) {
+            p = Vector3{ 100.0f * rng::random_i32(-10, 11),
+                         100.0f * rng::random_i32(-10, 11),
+                         100.0f * rng::random_i32(-10, 11) };
+        }
+        matrices.push_back(covariance(points));
+    }
+
+    // Flat and thin point sets, like the parts of a mesh
+    for (int i = 0; i < 100; ++i) {
+        std::vector<Vector3> points(50);
+        const float thickness = i % 2 == 0 ? 0.0f : 0.01f;
+        for (Vector3 &p : points) {
+            p = Vector3{ (float)rng::random(-5.0, 5.0),
+                         (float)rng::random(-1.0, 1.0),
+                         thickness * (float)rng::random(-1.0, 1.0) };
+            if (i % 4 >= 2) {
+                p.y *= thickness;
+            }
+        }
+        matrices.push_back(covariance(points));
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        const float l = (float)rng::random(0.1, 100.0);
+        matrices.push_back(with_eigenvalues(l, l, l * 0.5f));            // Repeated
+        matrices.push_back(with_eigenvalues(l, l * (1.0f + 1e-4f), -l)); // Nearly repeated, indefinite
+        matrices.push_back(with_eigenvalues(l, 0.0f, 0.0f));             // Rank 1
+        matrices.push_back(with_eigenvalues(l * 1e-12f, l * 2e-12f, l * 3e-12f));
+        matrices.push_back(with_eigenvalues(l * 1e12f, l * 1e6f, l));
+    }
+
+    matrices.push_back(Matrix3x3{ Vector3{ 3, 0, 0 }, Vector3{ 0, 1, 0 }, Vector3{ 0, 0, 2 } });
+    matrices.push_back(Matrix3x3{ Vector3{ 1, 0, 0 }, Vector3{ 0, 1, 0 }, Vector3{ 0, 0, 1 } });
+    matrices.push_back(Matrix3x3{ zero_3, zero_3, zero_3 });
+
+    return matrices;
 }
 
-static bool is_symmetric(const Matrix3x3 m) { return m.y.x == m.x.y && m.z.x == m.x.z && m.z.y == m.y.z; }
+// Checks that the result is a valid eigendecomposition in the form eigensolve_sym3x3 promises
+static void
+check_decomposition(const Matrix3x3 &m, const SymmetricEigenSolver3x3_Result &r, const char *what, size_t i) {
+    const float norm = std::max(max_abs_element(m), 1e-30f);
+
+    const float *values = &r.eigenvalues.x;
+    const Vector3 *vectors = &r.eigenvectors.x;
 
-bool test(const Matrix3x3 m, const Vector3 &eigenvalues, const Matrix3x3 &eigenvectors) {
-    log_assert(is_symmetric(m), "Given matrix is not symmetric");
+    for (int k = 0; k < 3; ++k) {
+        const Vector3 residual = mul(m, vectors[k]) - vectors[k] * values[k];
+        const float error = magnitude(residual) / norm;
+        CHECK_F(error < kTolerance, "%s: matrix %zu, eigenpair %d has residual %g", what, i, k, error);
+        CHECK_F(std::abs(magnitude(vectors[k]) - 1.0f) < kTolerance,
+                "%s: matrix %zu, eigenvector %d is not unit length",
+                what,
+                i,
+                k);
+    }
+
+    CHECK_F(values[0] >= values[1] && values[1] >= values[2], "%s: matrix %zu, eigenvalues not sorted", what, i);
+
+    CHECK_F(std::abs(dot(vectors[0], vectors[1])) < kTolerance &&
+                std::abs(dot(vectors[0], vectors[2])) < kTolerance &&
+                std::abs(dot(vectors[1], vectors[2])) < kTolerance,
+            "%s: matrix %zu, eigenvectors not orthogonal",
+            what,
+            i);
+    CHECK_F(dot(cross(vectors[0], vectors[1]), vectors[2]) > 0.0f, "%s: matrix %zu, not right handed", what, i);
+}
 
-    SymmetricEigenSolver3x3_Result result;
+// Compares against the scalar solver. Eigenvectors are only unique (up to sign) for well separated eigenvalues.
+static void check_same(const Matrix3x3 &m,
+                       const SymmetricEigenSolver3x3_Result &expected,
+                       const SymmetricEigenSolver3x3_Result &got,
+                       const char *what,
+                       size_t i) {
+    const float norm = std::max(max_abs_element(m), 1e-30f);
+    const float *e = &expected.eigenvalues.x;
+    const float *g = &got.eigenvalues.x;
 
-    eigensolve_sym3x3(m.x.x, m.y.x, m.z.x, m.y.y, m.z.y, m.z.z, result);
+    for (int k = 0; k < 3; ++k) {
+        const float error = std::abs(e[k] - g[k]) / norm;
+        CHECK_F(error < kTolerance, "%s: matrix %zu, eigenvalue %d differs by %g", what, i, k, error);
 
-    if (!mat_equal(result.eigenvectors, eigenvectors)) {
-        printf("NOT CORRECT EIGENVECTORS: \n");
-        print_matrix_classic("EXPECTED:", eigenvectors);
-        printf("CALCULATED: ", result.eigenvectors);
+        const float gap = std::min(k > 0 ? e[k - 1] - e[k] : norm, k < 2 ? e[k] - e[k + 1] : norm);
+        if (gap > 1e-2f * norm) {
+            const float d = std::abs(dot((&expected.eigenvectors.x)[k], (&got.eigenvectors.x)[k]));
+            CHECK_F(d > 1.0f - 1e-4f, "%s: matrix %zu, eigenvector %d differs, dot = %f", what, i, k, d);
+        }
     }
 }
 
+using EigensolveKernel = kernels::EigensolveKernel;
+
 int main() {
+    rng::init_rng(0xbadcafe);
+
+    const std::vector<Matrix3x3> matrices = test_matrices();
+    const u32 count = (u32)matrices.size();
+
+    std::vector<SymmetricEigenSolver3x3_Result> expected(count);
+    for (u32 i = 0; i < count; ++i) {
+        eigensolve_sym3x3(matrices[i], expected[i]);
+        check_decomposition(matrices[i], expected[i], "eigensolve_sym3x3", i);
+    }
+
+    struct NamedKernel {
+        const char *name;
+        EigensolveKernel kernel;
+    };
+
+    std::vector<NamedKernel> named_kernels = { { "sse", kernels::eigensolve_sym3x3_n_sse } };
+#if LOGL_HAVE_AVX2_KERNELS
+    if (eng::cpu_features().avx2 && eng::cpu_features().fma) {
+        named_kernels.push_back({ "avx2", kernels::eigensolve_sym3x3_n_avx2 });
+    }
+#endif
+
+    printf("CPU features: %s\n", eng::cpu_features_string());
+
+    for (const auto &k : named_kernels) {
+        // Odd count for the tail
+        for (u32 n : { count, count - 5, 1u }) {
+            std::vector<SymmetricEigenSolver3x3_Result> got(n);
+            k.kernel(matrices.data(), got.data(), n);
+            for (u32 i = 0; i < n; ++i) {
+                check_decomposition(matrices[i], got[i], k.name, i);
+                check_same(matrices[i], expected[i], got[i], k.name, i);
+            }
+        }
+    }
+
+    for (bool multithreaded : { false, true }) {
+        std::vector<SymmetricEigenSolver3x3_Result> got(count);
+        eigensolve_sym3x3_n(matrices.data(), got.data(), count, multithreaded);
+        for (u32 i = 0; i < count; ++i) {
+            check_same(matrices[i], expected[i], got[i], "eigensolve_sym3x3_n", i);
+        }
+    }
+
+    printf("Checked %u matrices. OK\n", count);
 }
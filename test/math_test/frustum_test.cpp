@@ -0,0 +1,240 @@
+// Checks the frustum culling kernels against the scalar ones, with and without the plane cache, and the planes
+// extracted from a perspective projection against a few spheres we know the answer for.
+
+#include "math_kernels.h"
+
+#include <learnogl/cpu_features.h>
+#include <learnogl/frustum.h>
+#include <learnogl/math_ops.h>
+#include <learnogl/rng.h>
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <stdio.h>
+#include <vector>
+
+using namespace fo;
+using namespace eng::math;
+
+// Looking down -z with a 90 degree fov, so the side planes are at 45 degrees
+static eng::FrustumPlanes test_frustum() {
+    eng::FrustumPlanes frustum;
+    frustum.init_from_projection_matrix(perspective_projection(0.1f, 100.0f, pi / 2.0f, 1.0f));
+    return frustum;
+}
+
+static bool is_visible(const std::vector<u8> &bits, u32 i) { return (bits[i / 8] >> (i % 8)) & 1; }
+
+// How far inside the sphere is from the plane it's farthest outside of. Near 0, rounding decides.
+static float sphere_margin(const eng::FrustumPlanes &frustum, const Vector4 &s) {
+    float margin = INFINITY;
+    for (const Vector4 &plane : frustum.planes) {
+        margin = std::min(margin, plane.x * s.x + plane.y * s.y + plane.z * s.z + plane.w + s.w);
+    }
+    return margin;
+}
+
+static float box_margin(const eng::FrustumPlanes &frustum, const AABB &box) {
+    float margin = INFINITY;
+    for (const Vector4 &plane : frustum.planes) {
+        const Vector3 corner{ plane.x > 0.0f ? box.max.x : box.min.x,
+                              plane.y > 0.0f ? box.max.y : box.min.y,
+                              plane.z > 0.0f ? box.max.z : box.min.z };
+        margin = std::min(margin, plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w);
+    }
+    return margin;
+}
+
+static void check_planes() {
+    const eng::FrustumPlanes frustum = test_frustum();
+
+    const eng::BoundingSphere spheres[] = {
+        { { 0.0f, 0.0f, -10.0f }, 1.0f },   // In front
+        { { 0.0f, 0.0f, 10.0f }, 1.0f },    // Behind
+        { { 20.0f, 0.0f, -10.0f }, 1.0f },  // Right of the right plane
+        { { 11.0f, 0.0f, -10.0f }, 2.0f },  // Crossing the right plane
+        { { 0.0f, -30.0f, -10.0f }, 1.0f }, // Below
+        { { 0.0f, 0.0f, -0.05f }, 0.01f },  // Before the near plane
+        { { 0.0f, 0.0f, -0.05f }, 0.1f },   // Crossing the near plane
+        { { 0.0f, 0.0f, -150.0f }, 10.0f }, // Past the far plane
+        { { 0.0f, 0.0f, -105.0f }, 10.0f }, // Crossing the far plane
+    };
+    const bool expected[] = { true, false, false, true, false, false, true, false, true };
+    const u32 count = sizeof(spheres) / sizeof(spheres[0]);
+
+    std::vector<u8> bits(eng::cull_bytes_for(count));
+    eng::frustum_cull(frustum, spheres, count, bits.data());
+    for (u32 i = 0; i < count; ++i) {
+        CHECK_F(is_visible(bits, i) == expected[i], "Sphere %u", i);
+    }
+
+    for (const Vector4 &plane : frustum.planes) {
+        CHECK_F(std::abs(magnitude(Vector3(plane)) - 1.0f) < 1e-5f, "Plane normals are unit length");
+    }
+}
+
+struct NamedCullKernels {
+    const char *name;
+    eng::math::kernels::CullKernels k;
+};
+
+// Runs `cull(bits, cache)` twice with a cache, the second time with what the first left in it, and once without,
+// and checks all three against `expected`. Also checks that nothing past the last byte is touched.
+template <typename CullFn, typename MarginFn>
+static void check_against_scalar(
+    const char *name, u32 count, CullFn &&cull, const std::vector<u8> &expected, MarginFn &&margin) {
+    const u32 num_bytes = eng::cull_bytes_for(count);
+    std::vector<u8> cache(num_bytes + 1, 0);
+    cache[num_bytes] = 0xcd;
+
+    for (u32 run = 0; run < 3; ++run) {
+        std::vector<u8> bits(num_bytes + 1, 0xab);
+        cull(bits.data(), run == 2 ? nullptr : cache.data());
+        CHECK_F(bits[num_bytes] == 0xab && cache[num_bytes] == 0xcd, "%s wrote past the end", name);
+
+        for (u32 i = 0; i < count; ++i) {
+            CHECK_F(is_visible(bits, i) == is_visible(expected, i) || std::abs(margin(i)) < 1e-3f,
+                    "%s, object %u of %u, run %u",
+                    name,
+                    i,
+                    count,
+                    run);
+        }
+        for (u32 i = count; i < num_bytes * 8; ++i) {
+            CHECK_F(!is_visible(bits, i), "%s set bit %u past the end", name, i);
+        }
+    }
+
+    for (u32 i = 0; i < num_bytes; ++i) {
+        CHECK_F(cache[i] < 6, "%s left plane %u in the cache", name, cache[i]);
+    }
+}
+
+static void check_kernels(const NamedCullKernels &named, u32 count) {
+    const eng::FrustumPlanes frustum = test_frustum();
+    namespace kernels = eng::math::kernels;
+
+    // Sorted along x so that groups of 8 are near each other, like they'd be in a scene
+    std::vector<Vector4> spheres(count);
+    std::vector<AABB> boxes(count);
+    std::vector<float> coords[7];
+    for (auto &c : coords) {
+        c.resize(count);
+    }
+    for (u32 i = 0; i < count; ++i) {
+        const float x = -150.0f + 300.0f * float(i) / float(count);
+        const Vector3 c{ x, (float)rng::random(-60.0, 60.0), (float)rng::random(-110.0, 10.0) };
+        const float r = (float)rng::random(0.1, 5.0);
+        const Vector3 half_extent{ r, (float)rng::random(0.1, 5.0), (float)rng::random(0.1, 5.0) };
+        spheres[i] = Vector4{ c, r };
+        boxes[i] = AABB{ c - half_extent, c + half_extent };
+        coords[0][i] = c.x;
+        coords[1][i] = c.y;
+        coords[2][i] = c.z;
+        coords[3][i] = r;
+        coords[4][i] = boxes[i].max.x;
+        coords[5][i] = boxes[i].max.y;
+        coords[6][i] = boxes[i].max.z;
+    }
+
+    std::vector<float> min_coords[3];
+    for (u32 j = 0; j < 3; ++j) {
+        min_coords[j].resize(count);
+        for (u32 i = 0; i < count; ++i) {
+            min_coords[j][i] = (&boxes[i].min.x)[j];
+        }
+    }
+
+    const float *center[3] = { coords[0].data(), coords[1].data(), coords[2].data() };
+    const float *min[3] = { min_coords[0].data(), min_coords[1].data(), min_coords[2].data() };
+    const float *max[3] = { coords[4].data(), coords[5].data(), coords[6].data() };
+    const Vector4 *planes = frustum.planes;
+
+    std::vector<u8> expected_spheres(eng::cull_bytes_for(count) + 1);
+    std::vector<u8> expected_boxes(eng::cull_bytes_for(count) + 1);
+    kernels::cull_spheres_scalar(planes, spheres.data(), count, expected_spheres.data(), nullptr);
+    kernels::cull_aabbs_scalar(planes, boxes.data(), count, expected_boxes.data(), nullptr);
+
+    std::vector<u8> expected_arrays(eng::cull_bytes_for(count) + 1);
+    kernels::cull_sphere_arrays_scalar(planes, center, coords[3].data(), count, expected_arrays.data(), nullptr);
+    CHECK_F(std::equal(expected_arrays.begin(), expected_arrays.end(), expected_spheres.begin()), "Scalar arrays");
+    kernels::cull_aabb_arrays_scalar(planes, min, max, count, expected_arrays.data(), nullptr);
+    CHECK_F(std::equal(expected_arrays.begin(), expected_arrays.end(), expected_boxes.begin()), "Scalar arrays");
+
+    const auto sphere_margin_of = [&](u32 i) { return sphere_margin(frustum, spheres[i]); };
+    const auto box_margin_of = [&](u32 i) { return box_margin(frustum, boxes[i]); };
+
+    check_against_scalar(
+        named.name,
+        count,
+        [&](u8 *bits, u8 *cache) { named.k.spheres(planes, spheres.data(), count, bits, cache); },
+        expected_spheres,
+        sphere_margin_of);
+    check_against_scalar(
+        named.name,
+        count,
+        [&](u8 *bits, u8 *cache) { named.k.aabbs(planes, boxes.data(), count, bits, cache); },
+        expected_boxes,
+        box_margin_of);
+    check_against_scalar(
+        named.name,
+        count,
+        [&](u8 *bits, u8 *cache) { named.k.sphere_arrays(planes, center, coords[3].data(), count, bits, cache); },
+        expected_spheres,
+        sphere_margin_of);
+    check_against_scalar(
+        named.name,
+        count,
+        [&](u8 *bits, u8 *cache) { named.k.aabb_arrays(planes, min, max, count, bits, cache); },
+        expected_boxes,
+        box_margin_of);
+
+    // Compaction gives the set bits in order
+    std::vector<u32> indices(count);
+    const u32 num_visible = eng::compact_visible_indices(expected_spheres.data(), count, indices.data());
+    u32 n = 0;
+    for (u32 i = 0; i < count; ++i) {
+        if (is_visible(expected_spheres, i)) {
+            CHECK_F(n < num_visible && indices[n] == i, "Compacted index %u", n);
+            ++n;
+        }
+    }
+    CHECK_F(n == num_visible, "Compacted %u of %u visible", num_visible, n);
+}
+
+int main() {
+    rng::init_rng(0xc0111);
+
+    check_planes();
+
+    namespace kernels = eng::math::kernels;
+    std::vector<NamedCullKernels> kernel_sets = {
+        { "sse",
+          { kernels::cull_spheres_sse,
+            kernels::cull_aabbs_sse,
+            kernels::cull_sphere_arrays_sse,
+            kernels::cull_aabb_arrays_sse } },
+    };
+
+#if LOGL_HAVE_AVX2_KERNELS
+    const eng::CpuFeatures &cpu = eng::cpu_features();
+    if (cpu.avx2 && cpu.fma) {
+        kernel_sets.push_back(NamedCullKernels{ "avx2",
+                                                { kernels::cull_spheres_avx2,
+                                                  kernels::cull_aabbs_avx2,
+                                                  kernels::cull_sphere_arrays_avx2,
+                                                  kernels::cull_aabb_arrays_avx2 } });
+    }
+#endif
+
+    printf("CPU features: %s\n", eng::cpu_features_string());
+
+    for (const auto &named : kernel_sets) {
+        for (u32 count : { 0u, 1u, 7u, 8u, 9u, 100u, 10000u }) {
+            check_kernels(named, count);
+        }
+    }
+
+    printf("OK\n");
+}
@@ -0,0 +1,245 @@
+// Checks the ray packet tests in intersection_test.h against ray/box and ray/sphere tests done one at a time in
+// double, including rays with zero direction components and rays starting on the faces of the boxes.
+
+#include <learnogl/intersection_test.h>
+#include <learnogl/math_ops.h>
+#include <learnogl/rng.h>
+
+#include <loguru.hpp>
+
+#include <limits>
+#include <stdio.h>
+#include <vector>
+
+using namespace fo;
+using namespace eng::math;
+
+static float random_float(float min, float max) { return (float)rng::random(min, max); }
+
+static Vector3 random_vector(float min, float max) {
+    return Vector3{ random_float(min, max), random_float(min, max), random_float(min, max) };
+}
+
+static const float k_inf = std::numeric_limits<float>::infinity();
+
+// What the tests should say, with a margin for how far from the boundary the answer is. Lanes with a margin
+// close to 0 can go either way in float.
+struct Expected {
+    bool hit;
+    double t;
+    double margin;
+};
+
+static Expected box_reference(const Ray &ray, const AABB &box, float t_max) {
+    double t_near = 0.0;
+    double t_far = t_max;
+    double margin = std::numeric_limits<double>::infinity();
+    for (u32 axis = 0; axis < 3; ++axis) {
+        const double o = (&ray.origin.x)[axis];
+        const double d = (&ray.direction.x)[axis];
+        const double lo = (&box.min.x)[axis];
+        const double hi = (&box.max.x)[axis];
+        if (d == 0.0) {
+            const double distance_to_faces = std::min(std::abs(o - lo), std::abs(o - hi));
+            if (o < lo || o > hi) {
+                return Expected{ false, 0.0, distance_to_faces };
+            }
+            margin = std::min(margin, distance_to_faces);
+            continue;
+        }
+        const double t0 = (lo - o) / d;
+        const double t1 = (hi - o) / d;
+        t_near = std::max(t_near, std::min(t0, t1));
+        t_far = std::min(t_far, std::max(t0, t1));
+    }
+    return Expected{ t_near <= t_far, t_near, std::min(margin, std::abs(t_far - t_near)) };
+}
+
+static Expected sphere_reference(const Ray &ray, const Vector3 &center, float radius, float t_max) {
+    const double oc[3] = { double(ray.origin.x) - center.x,
+                           double(ray.origin.y) - center.y,
+                           double(ray.origin.z) - center.z };
+    const double d[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+    const double a = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+    const double b = oc[0] * d[0] + oc[1] * d[1] + oc[2] * d[2];
+    const double c = oc[0] * oc[0] + oc[1] * oc[1] + oc[2] * oc[2] - double(radius) * radius;
+    const double discriminant = b * b - a * c;
+
+    if (c <= 0.0) {
+        return Expected{ true, 0.0, std::abs(c) / radius };
+    }
+    if (discriminant < 0.0) {
+        return Expected{ false, 0.0, std::abs(discriminant) / (a * radius) };
+    }
+    const double t = (-b - std::sqrt(discriminant)) / a;
+    return Expected{ t >= 0.0 && t <= t_max, t, std::min(std::min(std::abs(t), std::abs(t - t_max)), discriminant) };
+}
+
+static float lane4(__m128 v, u32 i) {
+    alignas(16) float f[4];
+    _mm_store_ps(f, v);
+    return f[i];
+}
+
+static void check_lane(const char *what, u32 lane, int mask, float t, const Expected &expected) {
+    const bool hit = (mask >> lane) & 1;
+    if (expected.margin < 1e-3) {
+        return;
+    }
+    CHECK_F(hit == expected.hit, "%s, lane %u: hit %d, expected %d", what, lane, hit, expected.hit);
+    CHECK_F(!hit || std::abs(t - expected.t) <= 1e-4 * std::max(1.0, expected.t),
+            "%s, lane %u: t = %f, expected %f",
+            what,
+            lane,
+            t,
+            expected.t);
+}
+
+// Mostly random, but some of them axis-aligned, some with a zero component, some starting on a face of `box`
+static Ray random_ray(u32 i, const AABB &box) {
+    Vector3 origin = random_vector(-20.0f, 20.0f);
+    Vector3 direction = random_vector(-1.0f, 1.0f);
+
+    switch (i % 6) {
+    case 1:
+        direction.y = 0.0f;
+        break;
+    case 2:
+        direction = Vector3{ 0.0f, 0.0f, -1.0f };
+        origin.x = random_float(box.min.x, box.max.x);
+        origin.y = random_float(box.min.y, box.max.y);
+        break;
+    case 3:
+        // Just inside the min x face, parallel to it
+        origin.x = box.min.x + 0.01f;
+        direction.x = 0.0f;
+        break;
+    case 4:
+        direction = direction * 1000.0f;
+        break;
+    default:
+        break;
+    }
+    return Ray(origin, direction);
+}
+
+static AABB random_box() {
+    const Vector3 center = random_vector(-10.0f, 10.0f);
+    const Vector3 half_extent = random_vector(0.5f, 5.0f);
+    return AABB{ center - half_extent, center + half_extent };
+}
+
+static void check_packets_against_box() {
+    for (u32 round = 0; round < 2000; ++round) {
+        const AABB box = random_box();
+        std::vector<Ray> rays;
+        for (u32 i = 0; i < 8; ++i) {
+            rays.push_back(random_ray(round * 8 + i, box));
+        }
+        const float t_max = round % 2 == 0 ? k_inf : 15.0f;
+
+        const eng::RayPacket4 packet4 = eng::make_ray_packet4(rays.data());
+        __m128 t4;
+        const int mask4 = eng::test_ray_packet_aabb(packet4, box, _mm_set1_ps(t_max), t4);
+        for (u32 i = 0; i < 4; ++i) {
+            check_lane("4 rays, 1 box", i, mask4, lane4(t4, i), box_reference(rays[i], box, t_max));
+        }
+
+        const eng::RayPacket8 packet8 = eng::make_ray_packet8(rays.data());
+        simd::Float8 t8;
+        const int mask8 = eng::test_ray_packet_aabb(packet8, box, simd::splat8(t_max), t8);
+        for (u32 i = 0; i < 8; ++i) {
+            check_lane("8 rays, 1 box", i, mask8, simd::lane(t8, i), box_reference(rays[i], box, t_max));
+        }
+    }
+}
+
+static void check_ray_against_boxes() {
+    for (u32 round = 0; round < 2000; ++round) {
+        AABB boxes[8];
+        for (AABB &box : boxes) {
+            box = random_box();
+        }
+        const Ray ray = random_ray(round, boxes[round % 8]);
+        const eng::PrecomputedRay precomputed(ray);
+        const float t_max = round % 2 == 0 ? k_inf : 15.0f;
+
+        __m128 t4;
+        const int mask4 = eng::test_ray_aabb_packet(precomputed, eng::make_aabb_packet4(boxes), t_max, t4);
+        for (u32 i = 0; i < 4; ++i) {
+            check_lane("1 ray, 4 boxes", i, mask4, lane4(t4, i), box_reference(ray, boxes[i], t_max));
+        }
+
+        simd::Float8 t8;
+        const int mask8 = eng::test_ray_aabb_packet(precomputed, eng::make_aabb_packet8(boxes), t_max, t8);
+        for (u32 i = 0; i < 8; ++i) {
+            check_lane("1 ray, 8 boxes", i, mask8, simd::lane(t8, i), box_reference(ray, boxes[i], t_max));
+        }
+    }
+}
+
+static void check_packets_against_sphere() {
+    for (u32 round = 0; round < 2000; ++round) {
+        const Vector3 center = random_vector(-10.0f, 10.0f);
+        const float radius = random_float(0.5f, 8.0f);
+        const AABB around{ center - Vector3{ radius, radius, radius }, center + Vector3{ radius, radius, radius } };
+
+        std::vector<Ray> rays;
+        for (u32 i = 0; i < 8; ++i) {
+            rays.push_back(random_ray(round * 8 + i, around));
+        }
+        const float t_max = round % 2 == 0 ? k_inf : 15.0f;
+
+        __m128 t4;
+        const int mask4 =
+            eng::test_ray_packet_sphere(eng::make_ray_packet4(rays.data()), center, radius, _mm_set1_ps(t_max), t4);
+        for (u32 i = 0; i < 4; ++i) {
+            check_lane(
+                "4 rays, 1 sphere", i, mask4, lane4(t4, i), sphere_reference(rays[i], center, radius, t_max));
+        }
+
+        simd::Float8 t8;
+        const int mask8 =
+            eng::test_ray_packet_sphere(eng::make_ray_packet8(rays.data()), center, radius, simd::splat8(t_max), t8);
+        for (u32 i = 0; i < 8; ++i) {
+            check_lane(
+                "8 rays, 1 sphere", i, mask8, simd::lane(t8, i), sphere_reference(rays[i], center, radius, t_max));
+        }
+    }
+}
+
+// Rays with zero direction components are inside the slabs they start between, outside the others, and the
+// distances stay finite
+static void check_parallel() {
+    const AABB box{ { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } };
+    const Ray rays[4] = { Ray({ 0.25f, 0.5f, -1.0f }, { 0.0f, 0.0f, 1.0f }),
+                          Ray({ 0.75f, 0.5f, -1.0f }, { -0.0f, -0.0f, 1.0f }),
+                          Ray({ 0.5f, 1.5f, 2.0f }, { 0.0f, 0.0f, -1.0f }),
+                          Ray({ 0.5f, 0.5f, 0.5f }, { 0.0f, 0.0f, 0.0f }) };
+
+    __m128 t;
+    const int mask = eng::test_ray_packet_aabb(eng::make_ray_packet4(rays), box, _mm_set1_ps(k_inf), t);
+    CHECK_F(mask == 0xb, "Rays parallel to the faces, mask %x", mask);
+    CHECK_F(lane4(t, 0) == 1.0f && lane4(t, 1) == 1.0f && lane4(t, 3) == 0.0f, "Entry distances");
+
+    // Starting on a face and parallel to it. Either answer is fine, but not a NaN.
+    const Ray on_face[4] = { Ray({ 0.0f, 0.5f, -1.0f }, { 0.0f, 0.0f, 1.0f }),
+                             Ray({ 1.0f, 0.5f, -1.0f }, { 0.0f, 0.0f, 1.0f }),
+                             Ray({ 0.0f, 0.5f, -1.0f }, { -0.0f, 0.0f, 1.0f }),
+                             Ray({ 1.0f, 0.5f, -1.0f }, { -0.0f, 0.0f, 1.0f }) };
+    eng::test_ray_packet_aabb(eng::make_ray_packet4(on_face), box, _mm_set1_ps(k_inf), t);
+    for (u32 i = 0; i < 4; ++i) {
+        CHECK_F(!std::isnan(lane4(t, i)), "NaN for a ray on a face");
+    }
+}
+
+int main() {
+    rng::init_rng(0x5ab);
+
+    check_parallel();
+    check_packets_against_box();
+    check_ray_against_boxes();
+    check_packets_against_sphere();
+
+    printf("OK\n");
+}
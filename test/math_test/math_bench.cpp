@@ -0,0 +1,1447 @@
+// Benchmarks of the eng::math API over arrays of the sizes we see per frame: a few hundred to tens of
+// thousands of transforms, and meshes with up to ~64K vertices (the limit of u16 indices).
+//
+// Writes JSON to logl_math_bench.json in the working directory unless --benchmark_out is given, so runs with
+// different compilers, LOGL_NATIVE_ARCH and LOGL_SIMD_LEVEL settings can be diffed with compare.py from the
+// benchmark library. The CPU features the kernels were picked from and the compiler are printed at start.
+
+#include <learnogl/bounding_shapes.h>
+#include <learnogl/bvh.h>
+#include <learnogl/cpu_features.h>
+#include <learnogl/dynamic_aabb_tree.h>
+#include <learnogl/frustum.h>
+#include <learnogl/intersection_test.h>
+#include <learnogl/math_ops.h>
+#include <learnogl/mesh.h>
+#include <learnogl/mesh_optimize.h>
+#include <learnogl/meshlets.h>
+#include <learnogl/occlusion_culling.h>
+#include <learnogl/rng.h>
+#include <learnogl/scene_tree.h>
+#include <learnogl/spatial_hash_grid.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace fo;
+using namespace eng;
+using namespace eng::math;
+
+static float random_float(float min, float max) { return (float)rng::random(min, max); }
+
+static Vector3 random_vector(float min, float max) {
+    return Vector3{ random_float(min, max), random_float(min, max), random_float(min, max) };
+}
+
+static Quaternion random_versor() {
+    const Vector3 axis = normalize(random_vector(-1.0f, 1.0f) + Vector3{ 0.0f, 0.0f, 2.0f });
+    return versor_from_axis_angle(axis, random_float(-pi, pi));
+}
+
+// Model matrices: rotation, non-uniform scale and translation.
+static std::vector<Matrix4x4> random_model_matrices(u32 count) {
+    std::vector<Matrix4x4> matrices(count);
+    for (auto &m : matrices) {
+        const Vector3 t = random_vector(-100.0f, 100.0f);
+        m = translation_matrix(t.x, t.y, t.z) * matrix_from_versor(random_versor()) *
+            xyz_scale_matrix(random_float(0.5f, 2.0f), random_float(0.5f, 2.0f), random_float(0.5f, 2.0f));
+    }
+    return matrices;
+}
+
+static std::vector<Matrix4x4> random_rigid_matrices(u32 count) {
+    std::vector<Matrix4x4> matrices(count);
+    for (auto &m : matrices) {
+        const Vector3 t = random_vector(-100.0f, 100.0f);
+        m = translation_matrix(t.x, t.y, t.z) * matrix_from_versor(random_versor());
+    }
+    return matrices;
+}
+
+static std::vector<Vector3> random_points(u32 count) {
+    std::vector<Vector3> points(count);
+    std::generate(points.begin(), points.end(), [] { return random_vector(-50.0f, 50.0f); });
+    return points;
+}
+
+// Matrix counts
+static void matrix_counts(benchmark::internal::Benchmark *b) { b->RangeMultiplier(8)->Range(64, 32768); }
+
+// Point cloud and mesh vertex counts
+static void point_counts(benchmark::internal::Benchmark *b) { b->RangeMultiplier(8)->Range(512, 1 << 18); }
+
+// -- Matrices
+
+static void BM_mul_mat_mat(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    auto a = random_model_matrices(count);
+    auto b = random_model_matrices(count);
+    std::vector<Matrix4x4> out(count);
+
+    for (auto _ : state) {
+        for (u32 i = 0; i < count; ++i) {
+            out[i] = mul_mat_mat(a[i], b[i]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_mul_mat_mat)->Apply(matrix_counts);
+
+static void BM_mul_mat_mat_n(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    auto a = random_model_matrices(count);
+    auto b = random_model_matrices(count);
+    std::vector<Matrix4x4> out(count);
+
+    for (auto _ : state) {
+        mul_mat_mat_n(a.data(), b.data(), out.data(), count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_mul_mat_mat_n)->Apply(matrix_counts);
+
+static void BM_inverse(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    auto src = random_model_matrices(count);
+    std::vector<Matrix4x4> out(count);
+
+    for (auto _ : state) {
+        for (u32 i = 0; i < count; ++i) {
+            out[i] = inverse(src[i]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_inverse)->Apply(matrix_counts);
+
+static void BM_inverse_n(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const bool multithreaded = state.range(1) != 0;
+    auto src = random_model_matrices(count);
+    std::vector<Matrix4x4> out(count);
+
+    for (auto _ : state) {
+        inverse_n(src.data(), out.data(), count, multithreaded);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_inverse_n)->Apply([](benchmark::internal::Benchmark *b) {
+    for (int count = 64; count <= 32768; count *= 8) {
+        b->Args({ count, 0 });
+        b->Args({ count, 1 });
+    }
+});
+
+static void BM_inverse_rotation_translation(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    auto src = random_rigid_matrices(count);
+    std::vector<Matrix4x4> out(count);
+
+    for (auto _ : state) {
+        for (u32 i = 0; i < count; ++i) {
+            out[i] = inverse_rotation_translation(src[i]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_inverse_rotation_translation)->Apply(matrix_counts);
+
+static void BM_inverse_rotation_translation_n(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    auto src = random_rigid_matrices(count);
+    std::vector<Matrix4x4> out(count);
+
+    for (auto _ : state) {
+        inverse_rotation_translation_n(src.data(), out.data(), count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_inverse_rotation_translation_n)->Apply(matrix_counts);
+
+static void BM_transpose_update(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    auto matrices = random_model_matrices(count);
+
+    for (auto _ : state) {
+        for (auto &m : matrices) {
+            transpose_update(m);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_transpose_update)->Apply(matrix_counts);
+
+// One vertex at a time, the way mesh::load_then_transform used to do it. Baseline for the batched versions.
+static void BM_transform_points_scalar(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const Matrix4x4 m = random_model_matrices(1)[0];
+    auto points = random_points(count);
+
+    for (auto _ : state) {
+        for (auto &p : points) {
+            p = Vector3(m * Vector4(p, 1.0f));
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_transform_points_scalar)->Apply(point_counts);
+
+static void BM_transform_points(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const Matrix4x4 m = random_model_matrices(1)[0];
+    auto points = random_points(count);
+
+    for (auto _ : state) {
+        transform_points(m, points.data(), points.data(), count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_transform_points)->Apply(point_counts);
+
+static void BM_transform_vectors_scalar(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const Matrix4x4 m = random_model_matrices(1)[0];
+    auto vectors = random_points(count);
+
+    for (auto _ : state) {
+        for (auto &v : vectors) {
+            v = Vector3(m * Vector4(v, 0.0f));
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_transform_vectors_scalar)->Apply(point_counts);
+
+static void BM_transform_vectors(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const Matrix4x4 m = random_model_matrices(1)[0];
+    auto vectors = random_points(count);
+
+    for (auto _ : state) {
+        transform_vectors(m, vectors.data(), vectors.data(), count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_transform_vectors)->Apply(point_counts);
+
+static void BM_transform_normals_scalar(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const Matrix4x4 m = random_model_matrices(1)[0];
+    auto normals = random_points(count);
+
+    for (auto _ : state) {
+        const Matrix4x4 nm = normal_matrix(m);
+        for (auto &n : normals) {
+            n = normalize(Vector3(nm * Vector4(n, 0.0f)));
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_transform_normals_scalar)->Apply(point_counts);
+
+static void BM_transform_normals(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const Matrix4x4 m = random_model_matrices(1)[0];
+    auto normals = random_points(count);
+
+    for (auto _ : state) {
+        transform_normals(m, normals.data(), normals.data(), count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_transform_normals)->Apply(point_counts);
+
+// Fills a byte buffer of `count` elements spaced `stride` bytes apart with random points.
+static std::vector<u8> random_strided_points(u32 count, u32 stride) {
+    std::vector<u8> buffer(size_t(count) * stride + sizeof(Vector3));
+    for (u32 i = 0; i < count; ++i) {
+        *reinterpret_cast<Vector3 *>(buffer.data() + size_t(i) * stride) = random_vector(-50.0f, 50.0f);
+    }
+    return buffer;
+}
+
+// (count, stride) pairs. Tightly packed, and the strides of a position-normal-uv and a
+// position-normal-uv-tangent pack.
+static void strided_point_counts(benchmark::internal::Benchmark *b) {
+    for (int count : { 1 << 10, 1 << 16, 1 << 20 }) {
+        for (int stride : { 12, 32, 64 }) {
+            b->Args({ count, stride });
+        }
+    }
+}
+
+static void BM_transform_points_strided_scalar(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const u32 stride = (u32)state.range(1);
+    const Matrix4x4 m = random_model_matrices(1)[0];
+    auto buffer = random_strided_points(count, stride);
+
+    for (auto _ : state) {
+        for (u32 i = 0; i < count; ++i) {
+            auto p = reinterpret_cast<Vector3 *>(buffer.data() + size_t(i) * stride);
+            *p = Vector3(m * Vector4(*p, 1.0f));
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_transform_points_strided_scalar)->Apply(strided_point_counts);
+
+static void BM_transform_points_strided(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const u32 stride = (u32)state.range(1);
+    const Matrix4x4 m = random_model_matrices(1)[0];
+    auto buffer = random_strided_points(count, stride);
+    auto points = reinterpret_cast<Vector3 *>(buffer.data());
+
+    for (auto _ : state) {
+        transform_points(m, points, stride, points, stride, count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_transform_points_strided)->Apply(strided_point_counts);
+
+static void BM_transform_vectors_strided(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const u32 stride = (u32)state.range(1);
+    const Matrix4x4 m = random_model_matrices(1)[0];
+    auto buffer = random_strided_points(count, stride);
+    auto vectors = reinterpret_cast<Vector3 *>(buffer.data());
+
+    for (auto _ : state) {
+        transform_vectors(m, vectors, stride, vectors, stride, count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_transform_vectors_strided)->Apply(strided_point_counts);
+
+static void BM_transform_normals_strided(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const u32 stride = (u32)state.range(1);
+    const Matrix4x4 m = random_model_matrices(1)[0];
+    auto buffer = random_strided_points(count, stride);
+    auto normals = reinterpret_cast<Vector3 *>(buffer.data());
+
+    for (auto _ : state) {
+        transform_normals(m, normals, stride, normals, stride, count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_transform_normals_strided)->Apply(strided_point_counts);
+
+// -- Quaternions
+
+static void BM_versor_mul(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    std::vector<Quaternion> a(count), b(count), out(count);
+    std::generate(a.begin(), a.end(), random_versor);
+    std::generate(b.begin(), b.end(), random_versor);
+
+    for (auto _ : state) {
+        for (u32 i = 0; i < count; ++i) {
+            out[i] = mul(a[i], b[i]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_versor_mul)->Apply(matrix_counts);
+
+static void BM_versor_nlerp(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    std::vector<Quaternion> a(count), b(count), out(count);
+    std::vector<float> alpha(count);
+    std::generate(a.begin(), a.end(), random_versor);
+    std::generate(b.begin(), b.end(), random_versor);
+    std::generate(alpha.begin(), alpha.end(), [] { return random_float(0.0f, 1.0f); });
+
+    for (auto _ : state) {
+        for (u32 i = 0; i < count; ++i) {
+            out[i] = nlerp(a[i], Vector4{ b[i].x, b[i].y, b[i].z, b[i].w }, alpha[i]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_versor_nlerp)->Apply(matrix_counts);
+
+static void BM_versor_nlerp_n(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    std::vector<Quaternion> a(count), b(count), out(count);
+    std::vector<float> alpha(count);
+    std::generate(a.begin(), a.end(), random_versor);
+    std::generate(b.begin(), b.end(), random_versor);
+    std::generate(alpha.begin(), alpha.end(), [] { return random_float(0.0f, 1.0f); });
+
+    for (auto _ : state) {
+        nlerp_n(a.data(), b.data(), alpha.data(), out.data(), count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_versor_nlerp_n)->Apply(matrix_counts);
+
+static void BM_versor_slerp(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    std::vector<Quaternion> a(count), b(count), out(count);
+    std::vector<float> alpha(count);
+    std::generate(a.begin(), a.end(), random_versor);
+    std::generate(b.begin(), b.end(), random_versor);
+    std::generate(alpha.begin(), alpha.end(), [] { return random_float(0.0f, 1.0f); });
+
+    for (auto _ : state) {
+        for (u32 i = 0; i < count; ++i) {
+            out[i] = slerp(a[i], b[i], alpha[i]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_versor_slerp)->Apply(matrix_counts);
+
+static void BM_versor_slerp_n(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    std::vector<Quaternion> a(count), b(count), out(count);
+    std::vector<float> alpha(count);
+    std::generate(a.begin(), a.end(), random_versor);
+    std::generate(b.begin(), b.end(), random_versor);
+    std::generate(alpha.begin(), alpha.end(), [] { return random_float(0.0f, 1.0f); });
+
+    for (auto _ : state) {
+        slerp_n(a.data(), b.data(), alpha.data(), out.data(), count, state.range(1) != 0);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_versor_slerp_n)->Apply([](benchmark::internal::Benchmark *b) {
+    for (i64 count = 64; count <= 32768; count *= 8) {
+        b->Args({ count, 0 })->Args({ count, 1 });
+    }
+});
+
+static void BM_matrix_from_versor(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    std::vector<Quaternion> q(count);
+    std::vector<Matrix4x4> out(count);
+    std::generate(q.begin(), q.end(), random_versor);
+
+    for (auto _ : state) {
+        for (u32 i = 0; i < count; ++i) {
+            out[i] = matrix_from_versor(q[i]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_matrix_from_versor)->Apply(matrix_counts);
+
+static void BM_matrix_from_versor_n(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    std::vector<Quaternion> q(count);
+    std::vector<Matrix4x4> out(count);
+    std::generate(q.begin(), q.end(), random_versor);
+
+    for (auto _ : state) {
+        matrix_from_versor_n(q.data(), out.data(), count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_matrix_from_versor_n)->Apply(matrix_counts);
+
+// A skeleton's worth of keyframe blending: pose = blend(key0, key1), then the local matrices
+static void BM_local_transform_slerp_n(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    std::vector<LocalTransform> a(count), b(count), out(count);
+    std::vector<Matrix4x4> matrices(count);
+    for (u32 i = 0; i < count; ++i) {
+        a[i] = LocalTransform(random_vector(0.5f, 2.0f), random_versor(), random_vector(-10.0f, 10.0f));
+        b[i] = LocalTransform(random_vector(0.5f, 2.0f), random_versor(), random_vector(-10.0f, 10.0f));
+    }
+
+    for (auto _ : state) {
+        slerp_n(a.data(), b.data(), 0.25f, out.data(), count);
+        matrix_from_local_transform_n(out.data(), matrices.data(), count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_local_transform_slerp_n)->Apply(matrix_counts);
+
+// Covariance matrices of small point clouds, what calculate_principal_axis solves
+static std::vector<Matrix3x3> random_covariances(u32 count) {
+    std::vector<Matrix3x3> matrices(count);
+    for (auto &m : matrices) {
+        const Vector3 a = random_vector(-1.0f, 1.0f), b = random_vector(-1.0f, 1.0f), c = random_vector(-1.0f, 1.0f);
+        const Vector3 d = random_vector(0.01f, 10.0f);
+        // a a^T d.x + b b^T d.y + c c^T d.z
+        m = Matrix3x3{ a * (a.x * d.x) + b * (b.x * d.y) + c * (c.x * d.z),
+                       a * (a.y * d.x) + b * (b.y * d.y) + c * (c.y * d.z),
+                       a * (a.z * d.x) + b * (b.z * d.y) + c * (c.z * d.z) };
+    }
+    return matrices;
+}
+
+static void BM_eigensolve_sym3x3(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    auto src = random_covariances(count);
+    std::vector<SymmetricEigenSolver3x3_Result> out(count);
+
+    for (auto _ : state) {
+        for (u32 i = 0; i < count; ++i) {
+            eigensolve_sym3x3(src[i], out[i]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_eigensolve_sym3x3)->Apply(matrix_counts);
+
+static void BM_eigensolve_sym3x3_n(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const bool multithreaded = state.range(1) != 0;
+    auto src = random_covariances(count);
+    std::vector<SymmetricEigenSolver3x3_Result> out(count);
+
+    for (auto _ : state) {
+        eigensolve_sym3x3_n(src.data(), out.data(), count, multithreaded);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_eigensolve_sym3x3_n)->Apply([](benchmark::internal::Benchmark *b) {
+    for (int count = 64; count <= 32768; count *= 8) {
+        b->Args({ count, 0 });
+        b->Args({ count, 1 });
+    }
+});
+
+// -- Packed attribute formats. Positions of a vertex buffer with 32 byte vertices to half floats, and normals
+// to octahedral snorm16s.
+
+struct BenchVertex {
+    Vector3 position;
+    Vector3 normal;
+    Vector2 uv;
+};
+
+static std::vector<BenchVertex> random_vertices(u32 count) {
+    std::vector<BenchVertex> vertices(count);
+    for (auto &v : vertices) {
+        v.position = random_vector(-50.0f, 50.0f);
+        v.normal = normalize(random_vector(-1.0f, 1.0f) + Vector3{ 0.0f, 0.0f, 0.01f });
+        v.uv = Vector2{ random_float(0.0f, 1.0f), random_float(0.0f, 1.0f) };
+    }
+    return vertices;
+}
+
+static void BM_f32_to_f16(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const auto vertices = random_vertices(count);
+    std::vector<u16> out(count * 4);
+
+    for (auto _ : state) {
+        for (u32 i = 0; i < count; ++i) {
+            out[i * 4 + 0] = f32_to_f16(vertices[i].position.x);
+            out[i * 4 + 1] = f32_to_f16(vertices[i].position.y);
+            out[i * 4 + 2] = f32_to_f16(vertices[i].position.z);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_f32_to_f16)->Apply(point_counts);
+
+static void BM_f32_to_f16_strided(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const auto vertices = random_vertices(count);
+    std::vector<u16> out(count * 4);
+
+    for (auto _ : state) {
+        f32_to_f16(&vertices[0].position.x, sizeof(BenchVertex), out.data(), 4 * sizeof(u16), count, 3);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_f32_to_f16_strided)->Apply(point_counts);
+
+static void BM_encode_octahedral_snorm16(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const auto vertices = random_vertices(count);
+    std::vector<int16_t> out(count * 2);
+
+    for (auto _ : state) {
+        for (u32 i = 0; i < count; ++i) {
+            encode_octahedral_snorm16(vertices[i].normal, &out[i * 2]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_encode_octahedral_snorm16)->Apply(point_counts);
+
+static void BM_encode_octahedral_snorm16_strided(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const auto vertices = random_vertices(count);
+    std::vector<int16_t> out(count * 2);
+
+    for (auto _ : state) {
+        encode_octahedral_snorm16(&vertices[0].normal, sizeof(BenchVertex), out.data(), 2 * sizeof(int16_t), count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_encode_octahedral_snorm16_strided)->Apply(point_counts);
+
+// -- Intersection
+
+static void BM_closest_point_in_obb(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    auto points = random_points(count);
+    std::vector<Vector3> out(count);
+
+    OBB obb;
+    obb.center = Vector3{ 1.0f, 2.0f, 3.0f };
+    const Matrix4x4 r = matrix_from_versor(random_versor());
+    obb.xyz[0] = Vector3(r.x);
+    obb.xyz[1] = Vector3(r.y);
+    obb.xyz[2] = Vector3(r.z);
+    obb.he = Vector3{ 10.0f, 5.0f, 20.0f };
+
+    for (auto _ : state) {
+        for (u32 i = 0; i < count; ++i) {
+            out[i] = closest_point_in_obb(points[i], obb);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_closest_point_in_obb)->Apply(point_counts);
+
+// -- Frustum culling. Objects spread around a camera looking down -z, so most of them are culled. Sorted along x
+// like a spatially ordered scene, which is what the plane cache relies on.
+
+static eng::FrustumPlanes bench_frustum() {
+    eng::FrustumPlanes frustum;
+    frustum.init_from_projection_matrix(perspective_projection(0.1f, 500.0f, pi / 3.0f, 16.0f / 9.0f));
+    return frustum;
+}
+
+static std::vector<BoundingSphere> random_scene_spheres(u32 count) {
+    std::vector<BoundingSphere> spheres(count);
+    for (u32 i = 0; i < count; ++i) {
+        const float x = -500.0f + 1000.0f * float(i) / float(count);
+        const Vector3 center{ x, random_float(-50.0f, 50.0f), random_float(-500.0f, 500.0f) };
+        spheres[i] = BoundingSphere{ center, random_float(0.5f, 5.0f) };
+    }
+    return spheres;
+}
+
+// Args are the number of objects, and whether to keep a plane cache
+static void cull_counts(benchmark::internal::Benchmark *b) {
+    for (int count = 1024; count <= (1 << 17); count *= 8) {
+        b->Args({ count, 0 })->Args({ count, 1 });
+    }
+}
+
+static void BM_frustum_cull_spheres_scalar(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const auto spheres = random_scene_spheres(count);
+    const eng::FrustumPlanes frustum = bench_frustum();
+    std::vector<u8> bits(eng::cull_bytes_for(count));
+
+    for (auto _ : state) {
+        for (u32 i = 0; i < count; ++i) {
+            bool visible = true;
+            for (const Vector4 &plane : frustum.planes) {
+                visible = visible && dot(Vector3(plane), spheres[i].center) + plane.w >= -spheres[i].radius;
+            }
+            bits[i / 8] = visible ? u8(bits[i / 8] | (1u << (i % 8))) : u8(bits[i / 8] & ~(1u << (i % 8)));
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_frustum_cull_spheres_scalar)->RangeMultiplier(8)->Range(1024, 1 << 17);
+
+static void BM_frustum_cull_spheres(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const auto spheres = random_scene_spheres(count);
+    const eng::FrustumPlanes frustum = bench_frustum();
+    std::vector<u8> bits(eng::cull_bytes_for(count));
+    std::vector<u8> cache(eng::cull_bytes_for(count));
+    u8 *plane_cache = state.range(1) != 0 ? cache.data() : nullptr;
+
+    for (auto _ : state) {
+        frustum_cull(frustum, spheres.data(), count, bits.data(), plane_cache);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_frustum_cull_spheres)->Apply(cull_counts);
+
+static void BM_frustum_cull_aabbs(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const auto spheres = random_scene_spheres(count);
+    std::vector<AABB> boxes(count);
+    for (u32 i = 0; i < count; ++i) {
+        const Vector3 r{ spheres[i].radius, spheres[i].radius, spheres[i].radius };
+        boxes[i] = AABB{ spheres[i].center - r, spheres[i].center + r };
+    }
+    const eng::FrustumPlanes frustum = bench_frustum();
+    std::vector<u8> bits(eng::cull_bytes_for(count));
+    std::vector<u8> cache(eng::cull_bytes_for(count));
+    u8 *plane_cache = state.range(1) != 0 ? cache.data() : nullptr;
+
+    for (auto _ : state) {
+        frustum_cull(frustum, boxes.data(), count, bits.data(), plane_cache);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_frustum_cull_aabbs)->Apply(cull_counts);
+
+static void BM_compact_visible_indices(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const auto spheres = random_scene_spheres(count);
+    std::vector<u8> bits(eng::cull_bytes_for(count));
+    frustum_cull(bench_frustum(), spheres.data(), count, bits.data());
+    std::vector<u32> indices(count);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(compact_visible_indices(bits.data(), count, indices.data()));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_compact_visible_indices)->RangeMultiplier(8)->Range(1024, 1 << 17);
+
+// -- Bounding volumes
+
+static void BM_calculate_AABB(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    auto points = random_points(count);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(calculate_AABB(points.data(), count));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_calculate_AABB)->Apply(point_counts);
+
+static void BM_calculate_principal_axis(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    auto points = random_points(count);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(calculate_principal_axis(points.data(), count));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_calculate_principal_axis)->Apply(point_counts);
+
+// Positions read in place from a vertex buffer, up to a few million of them, with and without the workers
+static void large_point_counts(benchmark::internal::Benchmark *b) {
+    for (int count = 4096; count <= (1 << 21); count *= 8) {
+        b->Args({ count, 0 });
+        b->Args({ count, 1 });
+    }
+}
+
+static void BM_calculate_AABB_strided(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const bool multithreaded = state.range(1) != 0;
+    const auto vertices = random_vertices(count);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(calculate_AABB(&vertices[0].position, sizeof(BenchVertex), count, multithreaded));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_calculate_AABB_strided)->Apply(large_point_counts);
+
+static void BM_calculate_principal_axis_strided(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const bool multithreaded = state.range(1) != 0;
+    const auto vertices = random_vertices(count);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            calculate_principal_axis(&vertices[0].position, sizeof(BenchVertex), count, multithreaded));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_calculate_principal_axis_strided)->Apply(large_point_counts);
+
+static void BM_create_bounding_sphere(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    auto points = random_points(count);
+    const PrincipalAxis pa = calculate_principal_axis(points.data(), count);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(create_bounding_sphere(pa, points.data(), count));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_create_bounding_sphere)->Apply(point_counts);
+
+// Shuffles its input, so each iteration also pays for copying the points back. That copy is small next to the
+// iterations it does.
+static void BM_create_bounding_sphere_iterative(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const auto points = random_points(count);
+    auto scratch = points;
+    const PrincipalAxis pa = calculate_principal_axis(points.data(), count);
+
+    for (auto _ : state) {
+        std::copy(points.begin(), points.end(), scratch.begin());
+        benchmark::DoNotOptimize(create_bounding_sphere_iterative(pa, scratch.data(), count));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_create_bounding_sphere_iterative)->RangeMultiplier(8)->Range(512, 32768);
+
+static void BM_create_minimal_bounding_sphere(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const auto points = random_points(count);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(create_minimal_bounding_sphere(points.data(), count));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_create_minimal_bounding_sphere)->Apply(point_counts);
+
+static void BM_create_minimal_bounding_sphere_strided(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const bool multithreaded = state.range(1) != 0;
+    const auto vertices = random_vertices(count);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            create_minimal_bounding_sphere(&vertices[0].position, sizeof(BenchVertex), count, multithreaded));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_create_minimal_bounding_sphere_strided)->Apply(large_point_counts);
+
+// -- Ray packets. One ray against many boxes, one at a time and 8 at a time.
+
+static std::vector<AABB> random_boxes(u32 count) {
+    std::vector<AABB> boxes(count);
+    for (AABB &box : boxes) {
+        const Vector3 center = random_vector(-100.0f, 100.0f);
+        const Vector3 half_extent{ random_float(0.5f, 5.0f), random_float(0.5f, 5.0f), random_float(0.5f, 5.0f) };
+        box = AABB{ center - half_extent, center + half_extent };
+    }
+    return boxes;
+}
+
+static void BM_ray_aabbs_scalar(benchmark::State &state) {
+    const auto boxes = random_boxes(1024);
+    const eng::PrecomputedRay ray(Ray::from_look_at(Vector3{ -150.0f, 3.0f, 7.0f }, Vector3{ 0.0f, 0.0f, 0.0f }));
+
+    for (auto _ : state) {
+        u32 num_hits = 0;
+        for (const AABB &box : boxes) {
+            float t_near = 0.0f;
+            float t_far = 1000.0f;
+            for (u32 axis = 0; axis < 3; ++axis) {
+                const float o = (&ray.origin.x)[axis];
+                const float t0 = ((&box.min.x)[axis] - o) * (&ray.inv_direction.x)[axis];
+                const float t1 = ((&box.max.x)[axis] - o) * (&ray.inv_direction.x)[axis];
+                t_near = std::max(t_near, std::min(t0, t1));
+                t_far = std::min(t_far, std::max(t0, t1));
+            }
+            num_hits += t_near <= t_far;
+        }
+        benchmark::DoNotOptimize(num_hits);
+    }
+    state.SetItemsProcessed(state.iterations() * boxes.size());
+}
+BENCHMARK(BM_ray_aabbs_scalar);
+
+static void BM_ray_aabb_packet8(benchmark::State &state) {
+    const auto boxes = random_boxes(1024);
+    std::vector<eng::AABBPacket8> packets;
+    for (u32 i = 0; i < boxes.size(); i += 8) {
+        packets.push_back(eng::make_aabb_packet8(&boxes[i]));
+    }
+    const eng::PrecomputedRay ray(Ray::from_look_at(Vector3{ -150.0f, 3.0f, 7.0f }, Vector3{ 0.0f, 0.0f, 0.0f }));
+
+    for (auto _ : state) {
+        int hit_masks = 0;
+        for (const eng::AABBPacket8 &packet : packets) {
+            simd::Float8 t_enter;
+            hit_masks ^= eng::test_ray_aabb_packet(ray, packet, 1000.0f, t_enter);
+        }
+        benchmark::DoNotOptimize(hit_masks);
+    }
+    state.SetItemsProcessed(state.iterations() * boxes.size());
+}
+BENCHMARK(BM_ray_aabb_packet8);
+
+static void BM_ray_packet8_sphere(benchmark::State &state) {
+    std::vector<Ray> rays;
+    for (u32 i = 0; i < 1024; ++i) {
+        rays.push_back(Ray::from_look_at(random_vector(-100.0f, 100.0f), random_vector(-5.0f, 5.0f)));
+    }
+    std::vector<eng::RayPacket8> packets;
+    for (u32 i = 0; i < rays.size(); i += 8) {
+        packets.push_back(eng::make_ray_packet8(&rays[i]));
+    }
+
+    for (auto _ : state) {
+        int hit_masks = 0;
+        for (const eng::RayPacket8 &packet : packets) {
+            simd::Float8 t_enter;
+            hit_masks ^= eng::test_ray_packet_sphere(
+                packet, Vector3{ 1.0f, 2.0f, 3.0f }, 4.0f, simd::splat8(1000.0f), t_enter);
+        }
+        benchmark::DoNotOptimize(hit_masks);
+    }
+    state.SetItemsProcessed(state.iterations() * rays.size());
+}
+BENCHMARK(BM_ray_packet8_sphere);
+
+// -- BVH. A wavy grid of the given size on a side, two triangles per cell, picked with rays from above like a mouse
+// over a terrain.
+
+struct GridMesh {
+    std::vector<Vector3> positions;
+    std::vector<u32> indices;
+};
+
+static GridMesh wavy_grid(u32 side) {
+    GridMesh grid;
+    grid.positions.resize(size_t(side + 1) * (side + 1));
+    for (u32 z = 0; z <= side; ++z) {
+        for (u32 x = 0; x <= side; ++x) {
+            const float y = 5.0f * std::sin(float(x) * 0.05f) * std::cos(float(z) * 0.07f);
+            grid.positions[z * (side + 1) + x] = Vector3{ float(x), y, float(z) };
+        }
+    }
+    grid.indices.reserve(size_t(side) * side * 6);
+    for (u32 z = 0; z < side; ++z) {
+        for (u32 x = 0; x < side; ++x) {
+            const u32 i = z * (side + 1) + x;
+            grid.indices.insert(grid.indices.end(), { i, i + side + 1, i + 1, i + 1, i + side + 1, i + side + 2 });
+        }
+    }
+    return grid;
+}
+
+static std::vector<Ray> random_picking_rays(u32 side, u32 count) {
+    std::vector<Ray> rays;
+    for (u32 i = 0; i < count; ++i) {
+        const Vector3 origin{ float(side) * 0.5f, 100.0f, float(side) * 0.5f };
+        const Vector3 target{ random_float(0.0f, float(side)), 0.0f, random_float(0.0f, float(side)) };
+        rays.push_back(Ray::from_look_at(origin, target));
+    }
+    return rays;
+}
+
+// Args are the number of cells on a side, and whether to build multithreaded
+static void BM_build_triangle_bvh(benchmark::State &state) {
+    const u32 side = (u32)state.range(0);
+    const GridMesh grid = wavy_grid(side);
+    const u32 num_triangles = u32(grid.indices.size() / 3);
+
+    eng::BVHBuildOptions options;
+    options.multithreaded = state.range(1) != 0;
+    eng::TriangleBVH bvh;
+
+    for (auto _ : state) {
+        eng::build_bvh(bvh, grid.positions.data(), sizeof(Vector3), grid.indices.data(), num_triangles, options);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * num_triangles);
+}
+BENCHMARK(BM_build_triangle_bvh)
+    ->Args({ 64, 0 })
+    ->Args({ 256, 0 })
+    ->Args({ 708, 0 })
+    ->Args({ 708, 1 })
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_raycast_triangle_bvh(benchmark::State &state) {
+    const u32 side = (u32)state.range(0);
+    const GridMesh grid = wavy_grid(side);
+    eng::TriangleBVH bvh;
+    eng::build_bvh(bvh, grid.positions.data(), sizeof(Vector3), grid.indices.data(), u32(grid.indices.size() / 3));
+    const auto rays = random_picking_rays(side, 1024);
+
+    u32 i = 0;
+    for (auto _ : state) {
+        eng::RayHit hit;
+        benchmark::DoNotOptimize(eng::raycast(bvh, rays[i++ % rays.size()], 1000.0f, hit));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_raycast_triangle_bvh)->Arg(64)->Arg(256)->Arg(708);
+
+// -- Dynamic AABB tree. A crowd of objects at a constant density, each moving at its own velocity, updated and
+// paired up once per frame. Args are the number of objects, and whether to rebuild the tree every frame instead of
+// updating it.
+
+static void BM_dynamic_aabb_tree_frame(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const float world_size = 4.0f * std::cbrt(float(count));
+
+    std::vector<AABB> boxes(count);
+    std::vector<Vector3> velocities(count);
+    std::vector<u64> user_data(count);
+    for (u32 i = 0; i < count; ++i) {
+        const Vector3 center = random_vector(-world_size, world_size);
+        boxes[i] = AABB{ center - Vector3{ 0.5f, 0.5f, 0.5f }, center + Vector3{ 0.5f, 0.5f, 0.5f } };
+        velocities[i] = random_vector(-0.05f, 0.05f);
+        user_data[i] = i;
+    }
+
+    eng::DynamicAABBTree tree;
+    std::vector<u32> proxies(count);
+    eng::create_proxies(tree, boxes.data(), user_data.data(), count, proxies.data());
+    Array<eng::ProxyPair> pairs(memory_globals::default_allocator());
+    eng::update_pairs(tree, pairs);
+
+    const bool rebuild_every_frame = state.range(1) != 0;
+    for (auto _ : state) {
+        for (u32 i = 0; i < count; ++i) {
+            boxes[i] = AABB{ boxes[i].min + velocities[i], boxes[i].max + velocities[i] };
+        }
+        eng::move_proxies(tree, proxies.data(), boxes.data(), velocities.data(), count);
+        if (rebuild_every_frame) {
+            eng::rebuild(tree);
+        }
+        eng::update_pairs(tree, pairs);
+        benchmark::DoNotOptimize(size(pairs));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_dynamic_aabb_tree_frame)
+    ->Args({ 1000, 0 })
+    ->Args({ 10000, 0 })
+    ->Args({ 10000, 1 })
+    ->Args({ 50000, 0 })
+    ->Unit(benchmark::kMicrosecond);
+
+// -- Spatial hash grid. Particles at the density of a fluid, about 30 within the smoothing radius of each, which is
+// half the cell size. Args are the number of particles, and whether to use the parallel_for workers.
+
+static std::vector<Vector3> fluid_particles(u32 count, float smoothing_radius) {
+    // 30 neighbours in a sphere of the smoothing radius
+    const float volume = float(count) / 30.0f * (4.0f / 3.0f) * 3.14159f * std::pow(smoothing_radius, 3.0f);
+    const float half_side = 0.5f * std::cbrt(volume);
+    std::vector<Vector3> positions(count);
+    for (Vector3 &p : positions) {
+        p = random_vector(-half_side, half_side);
+    }
+    return positions;
+}
+
+static void BM_build_spatial_hash_grid(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const auto positions = fluid_particles(count, 0.5f);
+    eng::SpatialHashGrid grid;
+
+    for (auto _ : state) {
+        eng::build_spatial_hash_grid(grid, positions.data(), sizeof(Vector3), count, 1.0f, state.range(1) != 0);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_build_spatial_hash_grid)
+    ->Args({ 10000, 0 })
+    ->Args({ 1000000, 0 })
+    ->Args({ 1000000, 1 })
+    ->Unit(benchmark::kMicrosecond);
+
+// An SPH density sum over each particle's neighbours
+static void BM_spatial_hash_grid_neighbours(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    const auto positions = fluid_particles(count, 0.5f);
+    eng::SpatialHashGrid grid;
+    eng::build_spatial_hash_grid(grid, positions.data(), sizeof(Vector3), count, 1.0f, true);
+    std::vector<float> densities(count);
+
+    for (auto _ : state) {
+        std::fill(densities.begin(), densities.end(), 0.0f);
+        eng::for_each_neighbour_of_each_point(
+            grid,
+            0.5f,
+            [&](u32 i, u32, float distance_squared) {
+                const float w = 0.25f - distance_squared;
+                densities[i] += w * w * w;
+            },
+            state.range(1) != 0);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_spatial_hash_grid_neighbours)
+    ->Args({ 10000, 0 })
+    ->Args({ 1000000, 0 })
+    ->Args({ 1000000, 1 })
+    ->Unit(benchmark::kMillisecond);
+
+// -- Occlusion culling. A city of box buildings in front of the camera, rasterized as occluders into a 320x192
+// buffer, and boxes of objects scattered among them tested against it.
+
+static void add_building_occluders(eng::OcclusionBuffer &buffer, u32 num_buildings) {
+    const Vector3 corners[8] = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 },
+                                 { 0, 0, 1 }, { 1, 0, 1 }, { 0, 1, 1 }, { 1, 1, 1 } };
+    const u32 indices[36] = { 0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4,
+                              2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5 };
+
+    for (u32 i = 0; i < num_buildings; ++i) {
+        const Vector3 size{ random_float(2.0f, 8.0f), random_float(5.0f, 30.0f), random_float(2.0f, 8.0f) };
+        const Vector3 position{ random_float(-100.0f, 100.0f), -10.0f, random_float(-150.0f, -10.0f) };
+        Matrix4x4 world_from_model = identity_matrix;
+        world_from_model.x.x = size.x;
+        world_from_model.y.y = size.y;
+        world_from_model.z.z = size.z;
+        world_from_model.t = Vector4{ position.x, position.y, position.z, 1.0f };
+        eng::add_occluder(buffer, corners, sizeof(Vector3), indices, 12, world_from_model);
+    }
+}
+
+static Matrix4x4 occlusion_bench_projection() {
+    return perspective_projection(0.5f, 500.0f, pi / 3.0f, 320.0f / 192.0f);
+}
+
+// Args are the number of buildings, and whether to use the parallel_for workers
+static void BM_rasterize_occluders(benchmark::State &state) {
+    eng::OcclusionBuffer buffer;
+    eng::init_occlusion_buffer(buffer, 320, 192);
+    eng::begin_occlusion_frame(buffer, occlusion_bench_projection());
+    add_building_occluders(buffer, (u32)state.range(0));
+
+    for (auto _ : state) {
+        eng::rasterize_occluders(buffer, state.range(1) != 0);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * size(buffer.triangles));
+}
+BENCHMARK(BM_rasterize_occluders)
+    ->Args({ 50, 0 })
+    ->Args({ 200, 0 })
+    ->Args({ 200, 1 })
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_occlusion_cull(benchmark::State &state) {
+    const u32 count = (u32)state.range(0);
+    eng::OcclusionBuffer buffer;
+    eng::init_occlusion_buffer(buffer, 320, 192);
+    eng::begin_occlusion_frame(buffer, occlusion_bench_projection());
+    add_building_occluders(buffer, 200);
+    eng::rasterize_occluders(buffer);
+
+    std::vector<AABB> boxes(count);
+    for (AABB &box : boxes) {
+        const Vector3 center{
+            random_float(-100.0f, 100.0f), random_float(-10.0f, 10.0f), random_float(-150.0f, -10.0f)
+        };
+        box = AABB{ center - Vector3{ 1.0f, 1.0f, 1.0f }, center + Vector3{ 1.0f, 1.0f, 1.0f } };
+    }
+    std::vector<u8> bits(eng::cull_bytes_for(count));
+
+    for (auto _ : state) {
+        std::fill(bits.begin(), bits.end(), u8(0xff));
+        eng::occlusion_cull(buffer, boxes.data(), count, bits.data(), state.range(1) != 0);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_occlusion_cull)->Args({ 10000, 0 })->Args({ 10000, 1 })->Unit(benchmark::kMicrosecond);
+
+// -- Scene tree. 100k nodes in 500 hierarchies of 200, like the props and characters of a level.
+
+static constexpr u32 k_bench_scene_roots = 500;
+static constexpr u32 k_bench_scene_nodes_per_root = 200;
+
+static std::vector<eng::SceneNodeHandle> build_bench_scene_tree(eng::SceneTree &tree) {
+    std::vector<eng::SceneNodeHandle> nodes;
+    for (u32 r = 0; r < k_bench_scene_roots; ++r) {
+        const u32 root = u32(nodes.size());
+        nodes.push_back(tree.add_node({}, LocalTransform(one_3, random_versor(), random_vector(-100.0f, 100.0f))));
+        for (u32 i = 1; i < k_bench_scene_nodes_per_root; ++i) {
+            const eng::SceneNodeHandle parent = nodes[root + u32(rng::random_i32(0, i32(i)))];
+            const LocalTransform local(one_3, random_versor(), random_vector(-1.0f, 1.0f));
+            nodes.push_back(tree.add_node(parent, local));
+        }
+    }
+    return nodes;
+}
+
+// Args are how many of the hierarchies move each frame, whether every node of the moving ones is animated or just
+// the root, and whether the update is multithreaded.
+static void BM_scene_tree_update(benchmark::State &state) {
+    constexpr u32 nodes_per_root = k_bench_scene_nodes_per_root;
+    eng::SceneTree tree(k_bench_scene_roots * nodes_per_root);
+    const std::vector<eng::SceneNodeHandle> nodes = build_bench_scene_tree(tree);
+    tree.update_world_matrices();
+
+    const u32 num_moving = (u32)state.range(0);
+    const bool animate_all_nodes = state.range(1) != 0;
+    const bool multithreaded = state.range(2) != 0;
+    const LocalTransform moved(one_3, random_versor(), random_vector(-100.0f, 100.0f));
+    for (auto _ : state) {
+        for (u32 r = 0; r < num_moving; ++r) {
+            const u32 root = r * nodes_per_root;
+            const u32 end = animate_all_nodes ? root + nodes_per_root : root + 1;
+            for (u32 i = root; i < end; ++i) {
+                tree.set_local_transform(nodes[i], moved);
+            }
+        }
+        tree.update_world_matrices(multithreaded);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * tree.num_nodes());
+}
+BENCHMARK(BM_scene_tree_update)
+    ->Args({ 500, 1, 0 })
+    ->Args({ 500, 1, 1 })
+    ->Args({ 500, 0, 0 })
+    ->Args({ 500, 0, 1 })
+    ->Args({ 50, 0, 0 })
+    ->Args({ 50, 0, 1 })
+    ->Args({ 0, 0, 0 })
+    ->Unit(benchmark::kMicrosecond);
+
+// Publishing a snapshot after each update, with the roots of the given number of hierarchies moving
+static void BM_scene_tree_publish_snapshot(benchmark::State &state) {
+    eng::SceneTree tree(k_bench_scene_roots * k_bench_scene_nodes_per_root);
+    const std::vector<eng::SceneNodeHandle> nodes = build_bench_scene_tree(tree);
+    eng::SceneSnapshots snapshots;
+
+    const u32 num_moving = (u32)state.range(0);
+    const LocalTransform moved(one_3, random_versor(), random_vector(-100.0f, 100.0f));
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (u32 r = 0; r < num_moving; ++r) {
+            tree.set_local_transform(nodes[r * k_bench_scene_nodes_per_root], moved);
+        }
+        tree.update_world_matrices();
+        state.ResumeTiming();
+
+        tree.publish_snapshot(snapshots);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * tree.num_nodes());
+}
+BENCHMARK(BM_scene_tree_publish_snapshot)->Arg(500)->Arg(50)->Arg(0)->Unit(benchmark::kMicrosecond);
+
+// -- Mesh
+
+// A (side x side) grid of vertices on a bumpy surface, two triangles per cell.
+static void make_grid_mesh(u32 side,
+                           std::vector<mesh::ForTangentSpaceCalc> &vertices,
+                           std::vector<mesh::IndexType> &indices) {
+    vertices.resize(side * side);
+    for (u32 y = 0; y < side; ++y) {
+        for (u32 x = 0; x < side; ++x) {
+            auto &v = vertices[y * side + x];
+            const float u = (float)x / (side - 1);
+            const float w = (float)y / (side - 1);
+            v.position = Vector3{ u * 10.0f, std::sin(u * 6.0f) * std::cos(w * 4.0f), w * 10.0f };
+            v.normal = Vector3{ 0.0f, 1.0f, 0.0f };
+            v.st = Vector2{ u, w };
+            v.t_and_h = Vector4{ 0.0f, 0.0f, 0.0f, 0.0f };
+        }
+    }
+
+    indices.clear();
+    for (u32 y = 0; y + 1 < side; ++y) {
+        for (u32 x = 0; x + 1 < side; ++x) {
+            const auto i = (mesh::IndexType)(y * side + x);
+            const auto right = (mesh::IndexType)(i + 1);
+            const auto below = (mesh::IndexType)(i + side);
+            const auto diagonal = (mesh::IndexType)(below + 1);
+            indices.insert(indices.end(), { i, below, right, right, below, diagonal });
+        }
+    }
+}
+
+static void BM_calculate_tangents(benchmark::State &state) {
+    const u32 side = (u32)state.range(0);
+    std::vector<mesh::ForTangentSpaceCalc> vertices;
+    std::vector<mesh::IndexType> indices;
+    make_grid_mesh(side, vertices, indices);
+
+    for (auto _ : state) {
+        mesh::calculate_tangents(vertices.data(), (u32)vertices.size(), indices.data(), (u32)indices.size());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * vertices.size());
+}
+// Up to 255 x 255 vertices, the most that u16 indices can address
+BENCHMARK(BM_calculate_tangents)->Arg(32)->Arg(128)->Arg(255);
+
+// Tipsify on the grid with its triangles shuffled, reporting the ACMR it gets to
+static void BM_optimize_vertex_cache(benchmark::State &state) {
+    const u32 side = (u32)state.range(0);
+    std::vector<mesh::ForTangentSpaceCalc> vertices;
+    std::vector<mesh::IndexType> grid_indices;
+    make_grid_mesh(side, vertices, grid_indices);
+    std::vector<u32> shuffled(grid_indices.begin(), grid_indices.end());
+    for (u32 t = u32(shuffled.size() / 3) - 1; t > 0; --t) {
+        const u32 other = u32(rng::random_i32(0, i32(t + 1)));
+        std::swap_ranges(&shuffled[t * 3], &shuffled[t * 3 + 3], &shuffled[other * 3]);
+    }
+
+    std::vector<u32> indices;
+    for (auto _ : state) {
+        state.PauseTiming();
+        indices = shuffled;
+        state.ResumeTiming();
+        mesh::optimize_vertex_cache(indices.data(), (u32)indices.size(), (u32)vertices.size(), 16);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * (indices.size() / 3));
+    const auto stats = mesh::simulate_vertex_cache(indices.data(), (u32)indices.size(), (u32)vertices.size(), 16);
+    state.counters["acmr"] = stats.acmr;
+}
+BENCHMARK(BM_optimize_vertex_cache)->Arg(32)->Arg(255)->Unit(benchmark::kMicrosecond);
+
+// The grid as a MeshData pointing into `vertices` and `buffer`, with vertex cache ordered indices
+static mesh::MeshData grid_mesh_data(u32 side,
+                                     std::vector<mesh::ForTangentSpaceCalc> &vertices,
+                                     std::vector<u8> &buffer) {
+    std::vector<mesh::IndexType> indices;
+    make_grid_mesh(side, vertices, indices);
+    mesh::MeshData md{};
+    md.o.num_vertices = (u32)vertices.size();
+    md.o.num_faces = (u32)indices.size() / 3;
+    md.o.packed_attr_size = sizeof(mesh::ForTangentSpaceCalc);
+    md.o.position_offset = offsetof(mesh::ForTangentSpaceCalc, position);
+    md.o.normal_offset = offsetof(mesh::ForTangentSpaceCalc, normal);
+    md.o.tex2d_offset = offsetof(mesh::ForTangentSpaceCalc, st);
+    md.o.tangent_offset = offsetof(mesh::ForTangentSpaceCalc, t_and_h);
+    md.o.num_bones = 0;
+    md.o.bone_data_offset = mesh::ATTRIBUTE_NOT_PRESENT;
+    buffer.resize(md.o.get_vertices_size_in_bytes() + md.o.get_indices_size_in_bytes());
+    md.buffer = buffer.data();
+    memcpy(md.buffer, vertices.data(), md.o.get_vertices_size_in_bytes());
+    memcpy(md.buffer + md.o.get_indices_byte_offset(), indices.data(), md.o.get_indices_size_in_bytes());
+    mesh::optimize_mesh(md);
+    return md;
+}
+
+static void BM_build_meshlets(benchmark::State &state) {
+    std::vector<mesh::ForTangentSpaceCalc> vertices;
+    std::vector<u8> buffer;
+    const mesh::MeshData md = grid_mesh_data((u32)state.range(0), vertices, buffer);
+
+    mesh::MeshletData m;
+    for (auto _ : state) {
+        mesh::build_meshlets(md, memory_globals::default_allocator(), m);
+        benchmark::DoNotOptimize(m.buffer);
+        mesh::free_meshlets(m, memory_globals::default_allocator());
+    }
+    state.SetItemsProcessed(state.iterations() * md.o.num_faces);
+}
+BENCHMARK(BM_build_meshlets)->Arg(32)->Arg(255)->Unit(benchmark::kMicrosecond);
+
+// Meshlets of the grid seen from above at an angle, so the sides of the bumps facing away are culled by their
+// cones
+static void BM_cull_meshlets(benchmark::State &state) {
+    std::vector<mesh::ForTangentSpaceCalc> vertices;
+    std::vector<u8> buffer;
+    const mesh::MeshData md = grid_mesh_data(255, vertices, buffer);
+    mesh::MeshletData m;
+    mesh::build_meshlets(md, memory_globals::default_allocator(), m);
+
+    // Camera at the origin looking down -z
+    const Matrix4x4 world_from_model = translation_matrix(-5.0f, -3.0f, -12.0f);
+    const eng::FrustumPlanes frustum = bench_frustum();
+
+    std::vector<u8> bits(eng::cull_bytes_for(m.o.num_meshlets));
+    for (auto _ : state) {
+        mesh::cull_meshlets(m, world_from_model, frustum, zero_3, nullptr, bits.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * m.o.num_meshlets);
+    std::vector<u32> visible(m.o.num_meshlets);
+    state.counters["visible"] = (double)eng::compact_visible_indices(bits.data(), m.o.num_meshlets, visible.data());
+    state.counters["meshlets"] = (double)m.o.num_meshlets;
+    mesh::free_meshlets(m, memory_globals::default_allocator());
+}
+BENCHMARK(BM_cull_meshlets)->Unit(benchmark::kMicrosecond);
+
+// Vertices per second converted to the quantized format, reporting the bytes per vertex before and after
+static void BM_quantize_mesh(benchmark::State &state) {
+    std::vector<mesh::ForTangentSpaceCalc> vertices;
+    std::vector<u8> buffer;
+    const mesh::MeshData md = grid_mesh_data((u32)state.range(0), vertices, buffer);
+
+    mesh::MeshData quantized;
+    for (auto _ : state) {
+        mesh::quantize_mesh(md, memory_globals::default_allocator(), quantized);
+        benchmark::DoNotOptimize(quantized.buffer);
+        memory_globals::default_allocator().deallocate(quantized.buffer);
+    }
+    state.SetItemsProcessed(state.iterations() * md.o.num_vertices);
+    state.counters["bytes_before"] = (double)md.o.packed_attr_size;
+    state.counters["bytes_after"] = (double)quantized.o.packed_attr_size;
+}
+BENCHMARK(BM_quantize_mesh)->Arg(32)->Arg(255)->Unit(benchmark::kMicrosecond);
+
+int main(int argc, char **argv) {
+    rng::init_rng(0x5eed);
+
+#if defined(__clang__)
+    const char *compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    const char *compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    const char *compiler = "msvc";
+#else
+    const char *compiler = "unknown";
+#endif
+
+    printf("Compiler: %s\nCPU features: %s\n", compiler, cpu_features_string());
+
+    // Default to writing JSON next to the console output
+    bool has_out_flag = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--benchmark_out=", strlen("--benchmark_out=")) == 0) {
+            has_out_flag = true;
+        }
+    }
+
+    std::vector<char *> args(argv, argv + argc);
+    std::string out_flag = "--benchmark_out=logl_math_bench.json";
+    std::string format_flag = "--benchmark_out_format=json";
+    if (!has_out_flag) {
+        args.push_back(&out_flag[0]);
+        args.push_back(&format_flag[0]);
+    }
+
+    int num_args = (int)args.size();
+    benchmark::Initialize(&num_args, args.data());
+    if (benchmark::ReportUnrecognizedArguments(num_args, args.data())) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,117 @@
+// Splits a grid with too many vertices for u16 indices and checks that the parts have u16 indices, no more
+// vertices than asked, and together give back the same triangles in the same order, by their vertex data.
+
+#include <learnogl/mesh.h>
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+using namespace fo;
+using namespace eng;
+
+struct Vertex {
+    Vector3 position;
+    Vector2 uv;
+};
+
+// A grid of `side` * `side` vertices with u32 indices, the vertex data being unique per vertex
+static void make_grid(mesh::MeshData &md, std::vector<u8> &buffer, u32 side) {
+    md = mesh::MeshData{};
+    md.o.num_vertices = side * side;
+    md.o.num_faces = (side - 1) * (side - 1) * 2;
+    md.o.packed_attr_size = sizeof(Vertex);
+    md.o.position_offset = 0;
+    md.o.normal_offset = mesh::ATTRIBUTE_NOT_PRESENT;
+    md.o.tex2d_offset = sizeof(Vector3);
+    md.o.tangent_offset = mesh::ATTRIBUTE_NOT_PRESENT;
+    md.o.num_bones = 0;
+    md.o.bone_data_offset = mesh::ATTRIBUTE_NOT_PRESENT;
+    md.o.index_size = sizeof(mesh::WideIndexType);
+
+    buffer.resize(md.o.get_vertices_size_in_bytes() + md.o.get_indices_size_in_bytes());
+    md.buffer = buffer.data();
+    Vertex *vertices = (Vertex *)md.buffer;
+    for (u32 y = 0; y < side; ++y) {
+        for (u32 x = 0; x < side; ++x) {
+            vertices[y * side + x] = Vertex{ Vector3{ float(x), float(y), 0.0f }, Vector2{ float(x + y), 0.0f } };
+        }
+    }
+
+    std::vector<u32> indices;
+    for (u32 y = 0; y + 1 < side; ++y) {
+        for (u32 x = 0; x + 1 < side; ++x) {
+            const u32 a = y * side + x;
+            indices.insert(indices.end(), { a, a + side, a + 1, a + 1, a + side, a + side + 1 });
+        }
+    }
+    mesh::write_indices(md, indices.data());
+}
+
+static void check_split(const mesh::MeshData &whole, u32 max_vertices) {
+    Array<mesh::MeshData> parts(memory_globals::default_allocator());
+    const u32 num_parts =
+        mesh::split_for_u16_indices(whole, memory_globals::default_allocator(), parts, max_vertices);
+    CHECK_F(num_parts == size(parts) && num_parts > 1, "Split into %u parts", num_parts);
+
+    u32 whole_index = 0;
+    for (const mesh::MeshData &part : parts) {
+        CHECK_F(!part.o.has_wide_indices() && part.o.num_vertices <= max_vertices,
+                "Part with %u vertices, index size %u",
+                part.o.num_vertices,
+                part.o.index_size);
+        CHECK_F(mesh::have_same_attributes(part.o, whole.o), "Attributes of a part");
+
+        for (u32 i = 0; i < part.o.num_faces * 3; ++i, ++whole_index) {
+            const u32 v = mesh::index_at(part, i);
+            CHECK_F(v < part.o.num_vertices, "Index out of range");
+            CHECK_F(memcmp(part.buffer + v * sizeof(Vertex),
+                           whole.buffer + mesh::index_at(whole, whole_index) * sizeof(Vertex),
+                           sizeof(Vertex)) == 0,
+                    "Index %u refers to other vertex data",
+                    whole_index);
+        }
+    }
+    CHECK_F(whole_index == whole.o.num_faces * 3, "Split kept %u of %u indices", whole_index, whole.o.num_faces * 3);
+
+    printf("%u vertices split into %u parts of at most %u\n", whole.o.num_vertices, num_parts, max_vertices);
+    for (mesh::MeshData &part : parts) {
+        memory_globals::default_allocator().deallocate(part.buffer);
+    }
+}
+
+int main() {
+    mesh::MeshData whole;
+    std::vector<u8> buffer;
+    make_grid(whole, buffer, 300);
+    CHECK_F(whole.o.num_vertices > mesh::k_max_vertices_for_u16_indices, "Grid too small");
+
+    // Round trip through both index sizes
+    {
+        std::vector<u32> indices(whole.o.num_faces * 3);
+        mesh::read_indices(whole, indices.data());
+        CHECK_F(mesh::index_at(whole, 5) == indices[5] && indices[5] == 300 + 1, "Wide indices");
+
+        mesh::MeshData narrow = whole;
+        narrow.o.num_vertices = 1000;
+        narrow.o.num_faces = 300;
+        narrow.o.index_size = sizeof(mesh::IndexType);
+        std::vector<u8> narrow_buffer(narrow.o.get_vertices_size_in_bytes() + narrow.o.get_indices_size_in_bytes());
+        narrow.buffer = narrow_buffer.data();
+        mesh::write_indices(narrow, indices.data());
+        CHECK_F(narrow.o.get_indices_size_in_bytes() == 300 * 3 * sizeof(u16), "Narrow indices size");
+
+        std::vector<u32> read_back(narrow.o.num_faces * 3);
+        mesh::read_indices(narrow, read_back.data());
+        CHECK_F(std::equal(read_back.begin(), read_back.end(), indices.begin()), "Narrow indices round trip");
+    }
+
+    check_split(whole, mesh::k_max_vertices_for_u16_indices);
+    check_split(whole, 1000);
+    check_split(whole, 3);
+
+    printf("OK\n");
+}
@@ -0,0 +1,163 @@
+// Shuffles the triangles of a sphere and checks that the vertex cache, overdraw and vertex fetch passes bring the
+// ACMR down while keeping every triangle, with the same winding and the same vertex data.
+
+#include <learnogl/math_ops.h>
+#include <learnogl/mesh_optimize.h>
+#include <learnogl/rng.h>
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <array>
+#include <stdio.h>
+#include <vector>
+
+using namespace fo;
+using namespace eng::math;
+using namespace eng;
+
+struct Vertex {
+    Vector3 position;
+    Vector3 normal;
+    Vector2 uv;
+};
+
+static void make_sphere(u32 rings, u32 segments, std::vector<Vertex> &vertices, std::vector<u32> &indices) {
+    for (u32 r = 0; r <= rings; ++r) {
+        for (u32 s = 0; s <= segments; ++s) {
+            const float theta = pi * r / rings;
+            const float phi = 2.0f * pi * s / segments;
+            const Vector3 p{ std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+            vertices.push_back(Vertex{ p, p, Vector2{ float(s) / segments, float(r) / rings } });
+        }
+    }
+    for (u32 r = 0; r < rings; ++r) {
+        for (u32 s = 0; s < segments; ++s) {
+            const u32 a = r * (segments + 1) + s;
+            const u32 b = a + segments + 1;
+            indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+    }
+
+    // Shuffle the triangles
+    for (u32 t = u32(indices.size() / 3) - 1; t > 0; --t) {
+        const u32 other = u32(rng::random_i32(0, i32(t + 1)));
+        std::swap_ranges(&indices[t * 3], &indices[t * 3 + 3], &indices[other * 3]);
+    }
+}
+
+using Triangle = std::array<u32, 3>;
+
+static std::vector<Triangle> sorted_triangles(const std::vector<u32> &indices) {
+    std::vector<Triangle> triangles;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        triangles.push_back(Triangle{ indices[i], indices[i + 1], indices[i + 2] });
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+int main() {
+    rng::init_rng(0x7195);
+
+    {
+        const u32 one_triangle[] = { 0, 1, 2 };
+        const mesh::VertexCacheStats stats = mesh::simulate_vertex_cache(one_triangle, 3, 3, 16);
+        CHECK_F(stats.acmr == 3.0f && stats.atvr == 1.0f, "One triangle");
+    }
+
+    {
+        Array<u32> cluster_starts(memory_globals::default_allocator());
+        push_back(cluster_starts, 0u);
+        mesh::optimize_vertex_cache(nullptr, 0, 0, 16, &cluster_starts);
+        CHECK_F(size(cluster_starts) == 0, "Clusters of an empty mesh");
+
+        u32 no_triangles[1] = { 0 };
+        mesh::optimize_vertex_cache(no_triangles, 0, 4, 16, &cluster_starts);
+        CHECK_F(size(cluster_starts) == 0, "Clusters of a mesh with no triangles");
+    }
+
+    std::vector<Vertex> vertices;
+    std::vector<u32> indices;
+    make_sphere(64, 64, vertices, indices);
+    const u32 num_vertices = u32(vertices.size());
+    const u32 num_indices = u32(indices.size());
+    const std::vector<Triangle> original_triangles = sorted_triangles(indices);
+
+    const auto cache_stats = [&]() {
+        return mesh::simulate_vertex_cache(indices.data(), num_indices, num_vertices, 16);
+    };
+    const mesh::VertexCacheStats shuffled = cache_stats();
+    CHECK_F(shuffled.acmr > 2.0f, "Shuffled ACMR is %f", shuffled.acmr);
+
+    Array<u32> cluster_starts(memory_globals::default_allocator());
+    mesh::optimize_vertex_cache(indices.data(), num_indices, num_vertices, 16, &cluster_starts);
+    const mesh::VertexCacheStats tipsified = cache_stats();
+    printf("ACMR %f -> %f, ATVR %f -> %f, %u clusters\n",
+           shuffled.acmr,
+           tipsified.acmr,
+           shuffled.atvr,
+           tipsified.atvr,
+           size(cluster_starts));
+    CHECK_F(tipsified.acmr < 0.9f, "Tipsified ACMR is %f", tipsified.acmr);
+    CHECK_F(sorted_triangles(indices) == original_triangles, "Triangles changed by the vertex cache pass");
+
+    CHECK_F(size(cluster_starts) != 0 && cluster_starts[0] == 0, "First cluster");
+    for (u32 c = 1; c < size(cluster_starts); ++c) {
+        CHECK_F(cluster_starts[c] > cluster_starts[c - 1] && cluster_starts[c] % 3 == 0, "Cluster %u start", c);
+    }
+
+    mesh::optimize_overdraw(indices.data(),
+                            num_indices,
+                            &vertices[0].position,
+                            sizeof(Vertex),
+                            data(cluster_starts),
+                            size(cluster_starts));
+    const mesh::VertexCacheStats sorted = cache_stats();
+    CHECK_F(sorted.acmr < tipsified.acmr * 1.1f, "ACMR after the overdraw pass is %f", sorted.acmr);
+    CHECK_F(sorted_triangles(indices) == original_triangles, "Triangles changed by the overdraw pass");
+
+    // Same triangles in the same order, by their vertex data
+    const std::vector<Vertex> vertices_before = vertices;
+    const std::vector<u32> indices_before = indices;
+    mesh::optimize_vertex_fetch(indices.data(), num_indices, (u8 *)vertices.data(), num_vertices, sizeof(Vertex));
+    u32 next_new_vertex = 0;
+    for (u32 i = 0; i < num_indices; ++i) {
+        const Vertex &a = vertices_before[indices_before[i]];
+        const Vertex &b = vertices[indices[i]];
+        CHECK_F(memcmp(&a, &b, sizeof(Vertex)) == 0, "Index %u refers to other vertex data", i);
+        CHECK_F(indices[i] <= next_new_vertex, "Vertex %u used before the ones before it", indices[i]);
+        next_new_vertex = std::max(next_new_vertex, indices[i] + 1);
+    }
+
+    // The whole thing on a MeshData with 16-bit indices
+    {
+        std::vector<Vertex> mesh_vertices;
+        std::vector<u32> mesh_indices;
+        make_sphere(32, 48, mesh_vertices, mesh_indices);
+
+        mesh::MeshData md = {};
+        md.o.num_vertices = u32(mesh_vertices.size());
+        md.o.num_faces = u32(mesh_indices.size() / 3);
+        md.o.packed_attr_size = sizeof(Vertex);
+        md.o.position_offset = 0;
+        md.o.normal_offset = sizeof(Vector3);
+        md.o.tex2d_offset = 2 * sizeof(Vector3);
+        md.o.tangent_offset = mesh::ATTRIBUTE_NOT_PRESENT;
+        md.o.num_bones = 0;
+        md.o.bone_data_offset = mesh::ATTRIBUTE_NOT_PRESENT;
+        std::vector<u8> buffer(md.o.get_vertices_size_in_bytes() + md.o.get_indices_size_in_bytes());
+        md.buffer = buffer.data();
+        memcpy(md.buffer, mesh_vertices.data(), md.o.get_vertices_size_in_bytes());
+        mesh::IndexType *md_indices = (mesh::IndexType *)(md.buffer + md.o.get_indices_byte_offset());
+        std::copy(mesh_indices.begin(), mesh_indices.end(), md_indices);
+
+        const mesh::MeshOptimizeStats stats = mesh::optimize_mesh(md);
+        CHECK_F(stats.after.acmr < 0.9f && stats.before.acmr > 2.0f,
+                "MeshData ACMR %f -> %f",
+                stats.before.acmr,
+                stats.after.acmr);
+    }
+
+    printf("OK\n");
+}
@@ -0,0 +1,189 @@
+// Quantizes a bumpy grid with all the attributes and bone data, and checks the layout, that indices and bone data
+// are kept as they are, and that each attribute decodes to within its bound of the original. Then a flat mesh
+// with only positions, whose box has no extent along one axis.
+
+#include <learnogl/math_ops.h>
+#include <learnogl/mesh.h>
+#include <learnogl/rng.h>
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+using namespace fo;
+using namespace eng::math;
+using namespace eng;
+
+// A (side x side) grid on a bumpy surface with the float attributes of mesh::ForTangentSpaceCalc, `num_bones`
+// bones of random data, and u16 indices
+static void make_grid(u32 side, u32 num_bones, mesh::MeshData &md, std::vector<u8> &buffer) {
+    md = mesh::MeshData{};
+    md.o.num_vertices = side * side;
+    md.o.num_faces = (side - 1) * (side - 1) * 2;
+    md.o.packed_attr_size = sizeof(mesh::ForTangentSpaceCalc);
+    md.o.position_offset = offsetof(mesh::ForTangentSpaceCalc, position);
+    md.o.normal_offset = offsetof(mesh::ForTangentSpaceCalc, normal);
+    md.o.tex2d_offset = offsetof(mesh::ForTangentSpaceCalc, st);
+    md.o.tangent_offset = offsetof(mesh::ForTangentSpaceCalc, t_and_h);
+    md.o.num_bones = num_bones;
+    md.o.bone_data_offset = num_bones == 0 ? mesh::ATTRIBUTE_NOT_PRESENT : md.o.get_bones_byte_offset();
+
+    buffer.resize(md.o.get_vertices_size_in_bytes() + md.o.get_indices_size_in_bytes() +
+                  md.o.get_bone_data_size_in_bytes());
+    md.buffer = buffer.data();
+
+    auto *vertices = (mesh::ForTangentSpaceCalc *)md.buffer;
+    for (u32 y = 0; y < side; ++y) {
+        for (u32 x = 0; x < side; ++x) {
+            const float u = float(x) / (side - 1);
+            const float w = float(y) / (side - 1);
+            auto &v = vertices[y * side + x];
+            v.position = Vector3{ u * 10.0f - 3.0f, std::sin(u * 6.0f) * std::cos(w * 4.0f), w * 7.0f + 1.0f };
+            v.normal = normalize(Vector3{ float(rng::random(-1.0, 1.0)), 1.0f, float(rng::random(-1.0, 1.0)) });
+            v.st = Vector2{ u * 4.0f, 1.0f - w };
+            v.t_and_h = Vector4{ normalize(Vector3{ 1.0f, float(rng::random(-1.0, 1.0)), -0.5f }),
+                                 (x + y) % 2 == 0 ? 1.0f : -1.0f };
+        }
+    }
+
+    std::vector<u32> indices;
+    for (u32 y = 0; y + 1 < side; ++y) {
+        for (u32 x = 0; x + 1 < side; ++x) {
+            const u32 i = y * side + x;
+            indices.insert(indices.end(), { i, i + side, i + 1, i + 1, i + side, i + side + 1 });
+        }
+    }
+    mesh::write_indices(md, indices.data());
+
+    for (u32 b = md.o.get_bones_byte_offset(); b < buffer.size(); ++b) {
+        buffer[b] = u8(rng::random_i32(0, 256));
+    }
+}
+
+// Accurate for small angles too, unlike acos of the dot product
+static float angle_between(const Vector3 &a, const Vector3 &b) {
+    return std::atan2(magnitude(cross(a, b)), dot(a, b));
+}
+
+static void check_grid(u32 num_bones) {
+    mesh::MeshData md;
+    std::vector<u8> buffer;
+    make_grid(64, num_bones, md, buffer);
+
+    Allocator &allocator = memory_globals::default_allocator();
+    mesh::MeshData q;
+    mesh::quantize_mesh(md, allocator, q);
+
+    CHECK_F(q.o.is_quantized() && q.o.packed_attr_size == 24, "Packed size %u", q.o.packed_attr_size);
+    CHECK_F(q.o.position_offset == 0 && q.o.normal_offset == 8 && q.o.tex2d_offset == 12 &&
+                q.o.tangent_offset == 16,
+            "Attribute offsets");
+    CHECK_F(q.o.num_vertices == md.o.num_vertices && q.o.num_faces == md.o.num_faces &&
+                q.o.index_size == md.o.index_size && q.o.num_bones == num_bones,
+            "Counts");
+
+    // Indices and bone data as they were
+    const u32 tail_size = md.o.get_indices_size_in_bytes() + md.o.get_bone_data_size_in_bytes();
+    const u8 *tail = md.buffer + md.o.get_indices_byte_offset();
+    CHECK_F(memcmp(q.buffer + q.o.get_indices_byte_offset(), tail, tail_size) == 0, "Indices and bone data");
+    CHECK_F(q.o.bone_data_offset == (num_bones == 0 ? mesh::ATTRIBUTE_NOT_PRESENT : q.o.get_bones_byte_offset()),
+            "Bone data offset %u",
+            q.o.bone_data_offset);
+
+    std::vector<Vector3> positions(md.o.num_vertices);
+    std::vector<Vector3> original(md.o.num_vertices);
+    mesh::read_positions(q, positions.data());
+    mesh::read_positions(md, original.data());
+
+    const Vector3 &extent = q.o.position_extent;
+    const Matrix4x4 dequantize = mesh::position_dequantize_matrix(mesh::StrippedMeshData(q.o));
+    float max_normal_error = 0.0f;
+    float max_tangent_error = 0.0f;
+    for (u32 i = 0; i < md.o.num_vertices; ++i) {
+        const auto &v = ((const mesh::ForTangentSpaceCalc *)md.buffer)[i];
+        const u8 *qv = q.buffer + i * q.o.packed_attr_size;
+
+        // Within half a step of the original, both through read_positions and the matrix the shader would use
+        const Vector3 d = positions[i] - v.position;
+        CHECK_F(std::abs(d.x) <= extent.x / 131070.0f + 1e-5f && std::abs(d.y) <= extent.y / 131070.0f + 1e-5f &&
+                    std::abs(d.z) <= extent.z / 131070.0f + 1e-5f,
+                "Position %u off by (%f, %f, %f)",
+                i,
+                d.x,
+                d.y,
+                d.z);
+        CHECK_F(magnitude(positions[i] - original[i]) < 1e-3f, "read_positions of the original");
+
+        const u16 *qp = (const u16 *)(qv + q.o.position_offset);
+        CHECK_F(qp[3] == 0xffff, "Position w");
+        const Vector4 normalized{ qp[0] / 65535.0f, qp[1] / 65535.0f, qp[2] / 65535.0f, qp[3] / 65535.0f };
+        const Vector4 p = dequantize * normalized;
+        CHECK_F(magnitude(Vector3(p) - positions[i]) < 1e-5f && p.w == 1.0f, "Dequantize matrix");
+
+        const Vector3 normal = decode_octahedral_snorm16((const i16 *)(qv + q.o.normal_offset));
+        max_normal_error = std::max(max_normal_error, angle_between(normal, v.normal));
+
+        const u16 *uv = (const u16 *)(qv + q.o.tex2d_offset);
+        CHECK_F(std::abs(f16_to_f32(uv[0]) - v.st.x) <= std::abs(v.st.x) / 2048.0f &&
+                    std::abs(f16_to_f32(uv[1]) - v.st.y) <= std::abs(v.st.y) / 2048.0f,
+                "Uv %u",
+                i);
+
+        const i16 *t = (const i16 *)(qv + q.o.tangent_offset);
+        const Vector3 tangent = decode_octahedral_snorm16(t);
+        max_tangent_error = std::max(max_tangent_error, angle_between(tangent, Vector3(v.t_and_h)));
+        CHECK_F(t[2] == (v.t_and_h.w > 0.0f ? 32767 : -32767) && t[3] == 0, "Handedness %u", i);
+    }
+    printf("%u bones: max normal error %.2e rad, max tangent error %.2e rad\n",
+           num_bones,
+           max_normal_error,
+           max_tangent_error);
+    CHECK_F(max_normal_error < 1e-4f && max_tangent_error < 1e-4f, "Directions");
+
+    allocator.deallocate(q.buffer);
+}
+
+int main() {
+    rng::init_rng(0x9a47);
+
+    check_grid(0);
+    check_grid(3);
+
+    // Positions only, flat in z
+    {
+        const Vector3 points[] = { { 0.0f, 0.0f, 2.0f }, { 1.0f, 0.0f, 2.0f }, { 0.25f, 3.0f, 2.0f } };
+        mesh::MeshData md = {};
+        md.o.num_vertices = 3;
+        md.o.num_faces = 1;
+        md.o.packed_attr_size = sizeof(Vector3);
+        md.o.position_offset = 0;
+        md.o.normal_offset = mesh::ATTRIBUTE_NOT_PRESENT;
+        md.o.tex2d_offset = mesh::ATTRIBUTE_NOT_PRESENT;
+        md.o.tangent_offset = mesh::ATTRIBUTE_NOT_PRESENT;
+        md.o.num_bones = 0;
+        md.o.bone_data_offset = mesh::ATTRIBUTE_NOT_PRESENT;
+        std::vector<u8> buffer(md.o.get_vertices_size_in_bytes() + md.o.get_indices_size_in_bytes());
+        md.buffer = buffer.data();
+        memcpy(md.buffer, points, sizeof(points));
+        const u32 indices[] = { 0, 1, 2 };
+        mesh::write_indices(md, indices);
+
+        mesh::MeshData q;
+        mesh::quantize_mesh(md, memory_globals::default_allocator(), q);
+        CHECK_F(q.o.packed_attr_size == 8, "Packed size %u", q.o.packed_attr_size);
+        CHECK_F(q.o.position_extent.z == 0.0f, "Flat box");
+
+        Vector3 positions[3];
+        mesh::read_positions(q, positions);
+        for (u32 i = 0; i < 3; ++i) {
+            CHECK_F(positions[i].z == 2.0f && magnitude(positions[i] - points[i]) < 1e-4f, "Flat position %u", i);
+        }
+        CHECK_F(mesh::index_at(q, 2) == 2, "Indices of the flat mesh");
+        memory_globals::default_allocator().deallocate(q.buffer);
+    }
+
+    printf("OK\n");
+}
@@ -0,0 +1,202 @@
+// Builds the meshlets of a sphere and checks that they keep the mesh's triangles within the size limits, that their
+// spheres hold their vertices, and that the cone test never culls a meshlet with a triangle facing the camera. Then
+// culls them against a frustum, and behind an occluder.
+
+#include <learnogl/math_ops.h>
+#include <learnogl/mesh_optimize.h>
+#include <learnogl/meshlets.h>
+#include <learnogl/rng.h>
+
+#include <loguru.hpp>
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+using namespace fo;
+using namespace eng::math;
+using namespace eng;
+
+struct Vertex {
+    Vector3 position;
+    Vector3 normal;
+};
+
+static void make_sphere(u32 rings, u32 segments, mesh::MeshData &md, std::vector<u8> &buffer) {
+    std::vector<Vertex> vertices;
+    std::vector<u32> indices;
+    for (u32 r = 0; r <= rings; ++r) {
+        for (u32 s = 0; s <= segments; ++s) {
+            const float theta = pi * r / rings;
+            const float phi = 2.0f * pi * s / segments;
+            const Vector3 p{ std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+            vertices.push_back(Vertex{ p, p });
+        }
+    }
+    // Wound counter-clockwise seen from outside
+    for (u32 r = 0; r < rings; ++r) {
+        for (u32 s = 0; s < segments; ++s) {
+            const u32 a = r * (segments + 1) + s;
+            const u32 b = a + segments + 1;
+            indices.insert(indices.end(), { a, a + 1, b, a + 1, b + 1, b });
+        }
+    }
+
+    md = mesh::MeshData{};
+    md.o.num_vertices = u32(vertices.size());
+    md.o.num_faces = u32(indices.size() / 3);
+    md.o.packed_attr_size = sizeof(Vertex);
+    md.o.position_offset = 0;
+    md.o.normal_offset = sizeof(Vector3);
+    md.o.tex2d_offset = mesh::ATTRIBUTE_NOT_PRESENT;
+    md.o.tangent_offset = mesh::ATTRIBUTE_NOT_PRESENT;
+    md.o.num_bones = 0;
+    md.o.bone_data_offset = mesh::ATTRIBUTE_NOT_PRESENT;
+    buffer.resize(md.o.get_vertices_size_in_bytes() + md.o.get_indices_size_in_bytes());
+    md.buffer = buffer.data();
+    memcpy(md.buffer, vertices.data(), md.o.get_vertices_size_in_bytes());
+    mesh::write_indices(md, indices.data());
+}
+
+static const Vector3 &position(const mesh::MeshData &md, u32 v) { return ((const Vertex *)md.buffer)[v].position; }
+
+// True if some triangle of the meshlet faces a camera at `eye`, leaving out the ones with next to no area as the
+// cones do
+static bool has_front_face(const mesh::MeshData &md, const mesh::MeshletData &m, u32 i, const Vector3 &eye) {
+    const mesh::Meshlet &meshlet = mesh::meshlets_begin(m)[i];
+    const float radius = mesh::meshlet_bounds_begin(m)[i].sphere.w;
+    const u32 *vertices = mesh::meshlet_vertex_indices_begin(m) + meshlet.vertex_offset;
+    const u32 *triangles = mesh::meshlet_triangles_begin(m) + meshlet.triangle_offset;
+    for (u32 t = 0; t < meshlet.num_triangles; ++t) {
+        const Vector3 &p0 = position(md, vertices[mesh::meshlet_triangle_corner(triangles[t], 0)]);
+        const Vector3 &p1 = position(md, vertices[mesh::meshlet_triangle_corner(triangles[t], 1)]);
+        const Vector3 &p2 = position(md, vertices[mesh::meshlet_triangle_corner(triangles[t], 2)]);
+        const Vector3 n = cross(p1 - p0, p2 - p0);
+        if (magnitude(n) > 1e-6f * radius * radius && dot(eye - p0, normalize(n)) > 1e-5f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static float random(float start, float end) { return float(rng::random(start, end)); }
+
+static bool is_visible(const u8 *visible_bits, u32 i) { return (visible_bits[i / 8] & (1u << (i % 8))) != 0; }
+
+int main() {
+    rng::init_rng(0x3e5);
+
+    mesh::MeshData md;
+    std::vector<u8> buffer;
+    make_sphere(48, 64, md, buffer);
+    mesh::optimize_mesh(md);
+
+    Allocator &allocator = memory_globals::default_allocator();
+    mesh::MeshletData m;
+    mesh::build_meshlets(md, allocator, m);
+    CHECK_F(uintptr_t(m.buffer) % mesh::k_meshlet_buffer_alignment == 0, "Buffer alignment");
+    CHECK_F(m.o.get_bounds_byte_offset() % mesh::k_meshlet_buffer_alignment == 0 &&
+                m.o.get_vertex_indices_byte_offset() % mesh::k_meshlet_buffer_alignment == 0 &&
+                m.o.get_triangles_byte_offset() % mesh::k_meshlet_buffer_alignment == 0,
+            "Part alignment");
+
+    // Same triangles in the same order, within the limits, inside the bounding spheres
+    std::vector<u32> indices(md.o.num_faces * 3);
+    mesh::read_indices(md, indices.data());
+    u32 index = 0;
+    u32 num_with_cone = 0;
+    for (u32 i = 0; i < m.o.num_meshlets; ++i) {
+        const mesh::Meshlet &meshlet = mesh::meshlets_begin(m)[i];
+        const mesh::MeshletBounds &bounds = mesh::meshlet_bounds_begin(m)[i];
+        CHECK_F(meshlet.num_vertices <= mesh::k_meshlet_max_vertices &&
+                    meshlet.num_triangles <= mesh::k_meshlet_max_triangles && meshlet.num_triangles != 0,
+                "Meshlet %u has %u vertices and %u triangles",
+                i,
+                meshlet.num_vertices,
+                meshlet.num_triangles);
+
+        const u32 *vertices = mesh::meshlet_vertex_indices_begin(m) + meshlet.vertex_offset;
+        const u32 *triangles = mesh::meshlet_triangles_begin(m) + meshlet.triangle_offset;
+        for (u32 t = 0; t < meshlet.num_triangles; ++t) {
+            for (u32 k = 0; k < 3; ++k, ++index) {
+                const u32 corner = mesh::meshlet_triangle_corner(triangles[t], k);
+                CHECK_F(corner < meshlet.num_vertices && vertices[corner] == indices[index], "Index %u", index);
+            }
+        }
+        for (u32 j = 0; j < meshlet.num_vertices; ++j) {
+            CHECK_F(magnitude(position(md, vertices[j]) - Vector3(bounds.sphere)) <= bounds.sphere.w,
+                    "Vertex outside the sphere of meshlet %u",
+                    i);
+        }
+        num_with_cone += bounds.cone.w < 1.0f ? 1 : 0;
+    }
+    CHECK_F(index == indices.size(), "Meshlets hold %u of %u indices", index, u32(indices.size()));
+    printf("%u triangles, %u meshlets, %u with a cone, %u vertex indices for %u vertices\n",
+           md.o.num_faces,
+           m.o.num_meshlets,
+           num_with_cone,
+           m.o.num_vertex_indices,
+           md.o.num_vertices);
+    CHECK_F(num_with_cone >= m.o.num_meshlets * 9 / 10, "Patches of a sphere have cones");
+
+    // The cone test is conservative, from anywhere
+    u32 num_cone_culled = 0;
+    for (u32 trial = 0; trial < 200; ++trial) {
+        const float distance = random(0.0f, 6.0f);
+        const Vector3 eye = Vector3{ random(-1.0f, 1.0f), random(-1.0f, 1.0f), random(-1.0f, 1.0f) } * distance;
+        for (u32 i = 0; i < m.o.num_meshlets; ++i) {
+            const mesh::MeshletBounds &bounds = mesh::meshlet_bounds_begin(m)[i];
+            const Vector3 to_center = Vector3(bounds.sphere) - eye;
+            if (dot(to_center, Vector3(bounds.cone)) >= bounds.cone.w * magnitude(to_center) + bounds.sphere.w) {
+                CHECK_F(!has_front_face(md, m, i, eye), "Meshlet %u culled but faces the camera", i);
+                ++num_cone_culled;
+            }
+        }
+    }
+    CHECK_F(num_cone_culled > 0, "Nothing culled by the cones");
+
+    // A camera at the origin looking down -z at the sphere, scaled by 2 and 6 units away. The far side is culled by
+    // the cones, and nothing facing the camera is.
+    FrustumPlanes frustum;
+    frustum.init_from_projection_matrix(perspective_projection(0.1f, 100.0f, pi / 2.0f, 1.0f));
+    Matrix4x4 world_from_model = identity_matrix;
+    world_from_model.x.x = world_from_model.y.y = world_from_model.z.z = 2.0f;
+    world_from_model.t = Vector4{ 0.0f, 0.0f, -6.0f, 1.0f };
+
+    std::vector<u8> visible_bits(cull_bytes_for(m.o.num_meshlets));
+    std::vector<u32> visible_indices(m.o.num_meshlets);
+    mesh::cull_meshlets(m, world_from_model, frustum, zero_3, nullptr, visible_bits.data());
+    const Vector3 eye_in_model{ 0.0f, 0.0f, 3.0f };
+    u32 num_visible = 0;
+    for (u32 i = 0; i < m.o.num_meshlets; ++i) {
+        CHECK_F(is_visible(visible_bits.data(), i) || !has_front_face(md, m, i, eye_in_model),
+                "Meshlet %u culled but faces the camera",
+                i);
+        num_visible += is_visible(visible_bits.data(), i) ? 1 : 0;
+    }
+    printf("%u of %u meshlets visible\n", num_visible, m.o.num_meshlets);
+    CHECK_F(num_visible < m.o.num_meshlets * 3 / 4, "Too few culled by the cones");
+
+    // Off to the side, out of the frustum
+    world_from_model.t = Vector4{ 100.0f, 0.0f, -6.0f, 1.0f };
+    mesh::cull_meshlets(m, world_from_model, frustum, zero_3, nullptr, visible_bits.data());
+    CHECK_F(compact_visible_indices(visible_bits.data(), m.o.num_meshlets, visible_indices.data()) == 0,
+            "Visible out of the frustum");
+
+    // Behind a wall
+    world_from_model.t = Vector4{ 0.0f, 0.0f, -6.0f, 1.0f };
+    OcclusionBuffer occlusion;
+    init_occlusion_buffer(occlusion, 64, 64);
+    begin_occlusion_frame(occlusion, perspective_projection(0.1f, 100.0f, pi / 2.0f, 1.0f));
+    const Vector3 wall[] = { { -10.0f, -10.0f, -2.0f }, { 10.0f, -10.0f, -2.0f }, { 10.0f, 10.0f, -2.0f },
+                             { -10.0f, 10.0f, -2.0f } };
+    const u32 wall_indices[] = { 0, 1, 2, 0, 2, 3 };
+    add_occluder(occlusion, wall, sizeof(Vector3), wall_indices, 2, identity_matrix);
+    rasterize_occluders(occlusion);
+    mesh::cull_meshlets(m, world_from_model, frustum, zero_3, &occlusion, visible_bits.data());
+    CHECK_F(compact_visible_indices(visible_bits.data(), m.o.num_meshlets, visible_indices.data()) == 0,
+            "Visible behind the wall");
+
+    mesh::free_meshlets(m, allocator);
+    printf("OK\n");
+}
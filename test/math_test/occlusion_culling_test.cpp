@@ -0,0 +1,336 @@
+// Checks the occlusion buffer against a few boxes behind, in front of and around a wall and under a ground plane,
+// the rasterizer kernels against the scalar one and against a double precision rasterization of random triangles,
+// and that rasterizing multithreaded gives the same buffer.
+
+#include "math_kernels.h"
+
+#include <learnogl/cpu_features.h>
+#include <learnogl/frustum.h>
+#include <learnogl/math_ops.h>
+#include <learnogl/mesh.h>
+#include <learnogl/occlusion_culling.h>
+#include <learnogl/rng.h>
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+using namespace fo;
+using namespace eng::math;
+
+namespace kernels = eng::math::kernels;
+
+constexpr u32 k_width = 128;
+constexpr u32 k_height = 64;
+
+static float random_float(float min, float max) { return (float)rng::random(min, max); }
+
+// Looking down -z from the origin, so the view matrix is the identity
+static Matrix4x4 test_projection() {
+    return perspective_projection(0.1f, 100.0f, pi / 2.0f, float(k_width) / float(k_height));
+}
+
+static AABB box_around(const Vector3 &center, const Vector3 &half_extent) {
+    return AABB{ center - half_extent, center + half_extent };
+}
+
+static bool is_visible(const std::vector<u8> &bits, u32 i) { return (bits[i / 8] >> (i % 8)) & 1; }
+
+// A wall in the z = 0 plane of its model space, 8 wide and 6 tall
+static const Vector3 k_wall_positions[] = {
+    { -4.0f, -3.0f, 0.0f }, { 4.0f, -3.0f, 0.0f }, { 4.0f, 3.0f, 0.0f }, { -4.0f, 3.0f, 0.0f }
+};
+static const u32 k_wall_indices[] = { 0, 1, 2, 0, 2, 3 };
+
+static void check_wall(const Matrix4x4 &projection) {
+    eng::OcclusionBuffer buffer;
+    eng::init_occlusion_buffer(buffer, k_width, k_height);
+    eng::begin_occlusion_frame(buffer, projection);
+    eng::add_occluder(buffer, k_wall_positions, sizeof(Vector3), k_wall_indices, 2, translation_matrix(0, 0, -10));
+    eng::rasterize_occluders(buffer);
+
+    // The wall covers the middle of the screen
+    CHECK_F(buffer.depth[(k_height / 2) * k_width + k_width / 2] < 1.0f, "Middle pixel covered");
+    CHECK_F(buffer.depth[0] == eng::k_occlusion_empty_depth, "Corner pixel not covered");
+
+    const AABB boxes[] = {
+        box_around({ 0.0f, 0.0f, -20.0f }, { 1.0f, 1.0f, 1.0f }),  // Behind the wall
+        box_around({ 2.0f, 1.0f, -12.0f }, { 1.0f, 1.0f, 1.0f }),  // Right behind it, still inside its edges
+        box_around({ 0.0f, 0.0f, -20.0f }, { 9.0f, 1.0f, 1.0f }),  // Behind it but wider
+        box_around({ 0.0f, 0.0f, -5.0f }, { 1.0f, 1.0f, 1.0f }),   // In front of it
+        box_around({ 12.0f, 0.0f, -20.0f }, { 1.0f, 1.0f, 1.0f }), // Beside it
+        box_around({ 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f }),    // Crossing the near plane
+        box_around({ 0.0f, 0.0f, 20.0f }, { 1.0f, 1.0f, 1.0f }),   // Behind the camera
+        box_around({ 0.0f, 0.0f, -9.5f }, { 1.0f, 1.0f, 1.0f }),   // Poking through the wall
+    };
+    const bool expected[] = { false, false, true, true, true, true, true, true };
+    const u32 count = sizeof(boxes) / sizeof(boxes[0]);
+
+    for (u32 i = 0; i < count; ++i) {
+        CHECK_F(eng::test_occludee(buffer, boxes[i]) == expected[i], "Box %u", i);
+    }
+
+    // Only the set bits get tested. The last box is visible, but stays culled.
+    std::vector<u8> bits(eng::cull_bytes_for(count), 0xff);
+    bits[0] &= 0x7f;
+    eng::occlusion_cull(buffer, boxes, count, bits.data());
+    for (u32 i = 0; i < count; ++i) {
+        CHECK_F(is_visible(bits, i) == (expected[i] && i != 7), "Culled box %u", i);
+    }
+
+    // Same wall from a mesh with 16 bit indices
+    const u16 indices_16[] = { 0, 1, 2, 0, 2, 3 };
+    std::vector<u8> mesh_buffer(sizeof(k_wall_positions) + sizeof(indices_16));
+    memcpy(mesh_buffer.data(), k_wall_positions, sizeof(k_wall_positions));
+    memcpy(mesh_buffer.data() + sizeof(k_wall_positions), indices_16, sizeof(indices_16));
+
+    eng::mesh::MeshData mesh_data = {};
+    mesh_data.o.num_vertices = 4;
+    mesh_data.o.num_faces = 2;
+    mesh_data.o.packed_attr_size = sizeof(Vector3);
+    mesh_data.o.position_offset = 0;
+    mesh_data.buffer = mesh_buffer.data();
+
+    const std::vector<float> depth(begin(buffer.depth), end(buffer.depth));
+    eng::begin_occlusion_frame(buffer, projection);
+    eng::add_occluder(buffer, mesh_data, translation_matrix(0, 0, -10));
+    eng::rasterize_occluders(buffer);
+    CHECK_F(std::equal(depth.begin(), depth.end(), begin(buffer.depth)), "Same wall from the mesh data");
+}
+
+// A ground plane going from behind the camera to past the far plane, so it gets clipped by the near plane
+static void check_ground() {
+    const Vector3 positions[] = { { -1000.0f, -1.0f, 1000.0f },
+                                  { 1000.0f, -1.0f, 1000.0f },
+                                  { 1000.0f, -1.0f, -1000.0f },
+                                  { -1000.0f, -1.0f, -1000.0f } };
+    const u32 indices[] = { 0, 1, 2, 0, 2, 3 };
+
+    eng::OcclusionBuffer buffer;
+    eng::init_occlusion_buffer(buffer, k_width, k_height);
+    eng::begin_occlusion_frame(buffer, test_projection());
+    eng::add_occluder(buffer, positions, sizeof(Vector3), indices, 2, identity_matrix);
+    eng::rasterize_occluders(buffer);
+
+    // Everything below the horizon is covered, nothing above it
+    for (u32 y = 0; y < k_height; ++y) {
+        for (u32 x = 0; x < k_width; ++x) {
+            const bool covered = buffer.depth[y * k_width + x] != eng::k_occlusion_empty_depth;
+            CHECK_F(covered == (y < k_height / 2), "Pixel (%u, %u) of the ground", x, y);
+        }
+    }
+
+    CHECK_F(!eng::test_occludee(buffer, box_around({ 0.0f, -5.0f, -20.0f }, { 1.0f, 1.0f, 1.0f })),
+            "Box under the ground");
+    CHECK_F(!eng::test_occludee(buffer, box_around({ 30.0f, -3.0f, -50.0f }, { 5.0f, 1.0f, 5.0f })),
+            "Wide box under the ground");
+    CHECK_F(eng::test_occludee(buffer, box_around({ 0.0f, 0.0f, -20.0f }, { 1.0f, 0.5f, 1.0f })),
+            "Box on the ground");
+}
+
+// Random triangles in front of the camera, some of them sticking out of the screen, but none crossing the near
+// plane or the guard band, so they are rasterized as they are
+static std::vector<Vector3> random_triangles(u32 count) {
+    std::vector<Vector3> vertices;
+    for (u32 i = 0; i < count; ++i) {
+        const Vector3 center{ random_float(-12.0f, 12.0f), random_float(-4.0f, 4.0f), random_float(-20.0f, -5.0f) };
+        for (u32 corner = 0; corner < 3; ++corner) {
+            vertices.push_back(center + Vector3{ random_float(-3.0f, 3.0f),
+                                                 random_float(-3.0f, 3.0f),
+                                                 random_float(-1.0f, 1.0f) });
+        }
+    }
+    return vertices;
+}
+
+static eng::OcclusionBuffer random_occluders(const std::vector<Vector3> &vertices) {
+    std::vector<u32> indices(vertices.size());
+    for (u32 i = 0; i < indices.size(); ++i) {
+        indices[i] = i;
+    }
+    eng::OcclusionBuffer buffer;
+    eng::init_occlusion_buffer(buffer, k_width, k_height);
+    eng::begin_occlusion_frame(buffer, test_projection());
+    eng::add_occluder(
+        buffer, vertices.data(), sizeof(Vector3), indices.data(), u32(vertices.size() / 3), identity_matrix);
+    return buffer;
+}
+
+// Rasterizes the triangles again in doubles. Pixels whose centers are too close to an edge to tell are skipped.
+static void check_against_reference(const std::vector<Vector3> &vertices, const eng::OcclusionBuffer &buffer) {
+    const Matrix4x4 projection = test_projection();
+
+    struct Vertex {
+        double x, y, z;
+    };
+    std::vector<Vertex> screen;
+    for (const Vector3 &p : vertices) {
+        const Vector4 clip = projection * Vector4{ p.x, p.y, p.z, 1.0f };
+        CHECK_F(clip.w > 0.1f && std::abs(clip.x) < 2.0f * clip.w && std::abs(clip.y) < 2.0f * clip.w,
+                "Triangle vertex needs clipping");
+        screen.push_back(Vertex{ (double(clip.x) / clip.w * 0.5 + 0.5) * k_width,
+                                 (double(clip.y) / clip.w * 0.5 + 0.5) * k_height,
+                                 double(clip.z) / clip.w });
+    }
+
+    u32 num_checked = 0;
+    u32 num_covered = 0;
+    for (u32 y = 0; y < k_height; ++y) {
+        for (u32 x = 0; x < k_width; ++x) {
+            const double px = x + 0.5;
+            const double py = y + 0.5;
+            double nearest = eng::k_occlusion_empty_depth;
+            bool ambiguous = false;
+
+            for (u32 t = 0; t < screen.size(); t += 3) {
+                const Vertex &a = screen[t];
+                const Vertex &b = screen[t + 1];
+                const Vertex &c = screen[t + 2];
+                const double area2 = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+                if (area2 == 0.0) {
+                    continue;
+                }
+                // Barycentrics, and the distance to the nearest edge in pixels
+                const double wa = ((b.x - px) * (c.y - py) - (c.x - px) * (b.y - py)) / area2;
+                const double wb = ((c.x - px) * (a.y - py) - (a.x - px) * (c.y - py)) / area2;
+                const double wc = 1.0 - wa - wb;
+                const double edge_distance = std::min({ wa * std::abs(area2) / std::hypot(c.x - b.x, c.y - b.y),
+                                                        wb * std::abs(area2) / std::hypot(a.x - c.x, a.y - c.y),
+                                                        wc * std::abs(area2) / std::hypot(b.x - a.x, b.y - a.y) });
+                if (std::abs(edge_distance) < 1e-3) {
+                    ambiguous = true;
+                } else if (edge_distance > 0.0) {
+                    nearest = std::min(nearest, wa * a.z + wb * b.z + wc * c.z);
+                }
+            }
+
+            if (ambiguous) {
+                continue;
+            }
+            const float depth = buffer.depth[y * k_width + x];
+            if (nearest == eng::k_occlusion_empty_depth) {
+                CHECK_F(depth == eng::k_occlusion_empty_depth, "Pixel (%u, %u) shouldn't be covered", x, y);
+            } else {
+                CHECK_F(std::abs(depth - nearest) < 1e-5,
+                        "Pixel (%u, %u) depth %f, expected %f",
+                        x,
+                        y,
+                        depth,
+                        nearest);
+                ++num_covered;
+            }
+            ++num_checked;
+        }
+    }
+    CHECK_F(num_checked > k_width * k_height * 9 / 10, "Only %u pixels could be checked", num_checked);
+    CHECK_F(num_covered != 0, "No pixels covered");
+}
+
+struct NamedOcclusionKernels {
+    const char *name;
+    kernels::OcclusionKernels k;
+};
+
+// The SIMD kernels against the scalar one over bands of rows. They step the edge values and depth along the rows,
+// so they can differ by rounding, and on the odd pixel right on an edge.
+static void check_kernels(const NamedOcclusionKernels &named, const eng::OcclusionBuffer &buffer) {
+    const u32 num_pixels = k_width * k_height;
+    std::vector<float> expected(num_pixels, eng::k_occlusion_empty_depth);
+    std::vector<float> depth(num_pixels, eng::k_occlusion_empty_depth);
+    kernels::rasterize_occluders_scalar(
+        data(buffer.triangles), size(buffer.triangles), expected.data(), k_width, 0, k_height);
+
+    // Bands that don't line up with the tiles, nothing outside them touched
+    for (u32 row_begin = 0; row_begin < k_height; row_begin += 24) {
+        const u32 row_end = std::min(row_begin + 24, k_height);
+        named.k.rasterize(data(buffer.triangles), size(buffer.triangles), depth.data(), k_width, row_begin, row_end);
+        for (u32 i = row_end * k_width; i < num_pixels; ++i) {
+            CHECK_F(depth[i] == eng::k_occlusion_empty_depth, "%s kernel wrote outside its rows", named.name);
+        }
+    }
+
+    u32 num_different = 0;
+    for (u32 i = 0; i < num_pixels; ++i) {
+        if ((depth[i] == eng::k_occlusion_empty_depth) != (expected[i] == eng::k_occlusion_empty_depth) ||
+            std::abs(depth[i] - expected[i]) > 1e-6f) {
+            ++num_different;
+        }
+    }
+    CHECK_F(num_different <= num_pixels / 1000,
+            "%s kernel differs from the scalar one in %u pixels",
+            named.name,
+            num_different);
+}
+
+static void check_multithreaded(const std::vector<Vector3> &vertices) {
+    eng::OcclusionBuffer buffer = random_occluders(vertices);
+    eng::OcclusionBuffer buffer_mt = random_occluders(vertices);
+    eng::rasterize_occluders(buffer);
+    eng::rasterize_occluders(buffer_mt, true);
+    CHECK_F(std::equal(begin(buffer.depth), end(buffer.depth), begin(buffer_mt.depth)), "Multithreaded depth");
+    CHECK_F(std::equal(begin(buffer.tile_depth), end(buffer.tile_depth), begin(buffer_mt.tile_depth)),
+            "Multithreaded tile depth");
+
+    // Tile depths are the farthest of their pixels
+    const u32 tiles_per_row = k_width / eng::k_occlusion_tile_width;
+    for (u32 y = 0; y < k_height; ++y) {
+        for (u32 x = 0; x < k_width; ++x) {
+            const u32 tile = (y / eng::k_occlusion_tile_height) * tiles_per_row + x / eng::k_occlusion_tile_width;
+            CHECK_F(buffer.depth[y * k_width + x] <= buffer.tile_depth[tile], "Tile depth of (%u, %u)", x, y);
+        }
+    }
+
+    // Random boxes, multithreaded or not, against testing each of them by brute force over its pixels
+    std::vector<AABB> boxes;
+    for (u32 i = 0; i < 2000; ++i) {
+        const Vector3 center{ random_float(-20.0f, 20.0f), random_float(-10.0f, 10.0f), random_float(-40.0f, -2.0f) };
+        const float size = random_float(0.1f, 2.0f);
+        boxes.push_back(box_around(center, Vector3{ size, size, size }));
+    }
+    std::vector<u8> bits(eng::cull_bytes_for(u32(boxes.size())), 0xff);
+    std::vector<u8> bits_mt(bits.size(), 0xff);
+    eng::occlusion_cull(buffer, boxes.data(), u32(boxes.size()), bits.data());
+    eng::occlusion_cull(buffer, boxes.data(), u32(boxes.size()), bits_mt.data(), true);
+    CHECK_F(bits == bits_mt, "Multithreaded occlusion culling");
+
+    u32 num_occluded = 0;
+    for (u32 i = 0; i < boxes.size(); ++i) {
+        num_occluded += is_visible(bits, i) ? 0 : 1;
+    }
+    CHECK_F(num_occluded > 0 && num_occluded < boxes.size(), "%u of %zu boxes occluded", num_occluded, boxes.size());
+}
+
+int main() {
+    rng::init_rng(0x0cc1);
+
+    check_wall(test_projection());
+    check_wall(orthographic_projection(0.1f, 100.0f, -8.0f, -4.0f, 8.0f, 4.0f));
+    check_ground();
+
+    std::vector<NamedOcclusionKernels> kernel_sets = { { "sse", { kernels::rasterize_occluders_sse } } };
+
+#if LOGL_HAVE_AVX2_KERNELS
+    const eng::CpuFeatures &cpu = eng::cpu_features();
+    if (cpu.avx2 && cpu.fma) {
+        kernel_sets.push_back(NamedOcclusionKernels{ "avx2", { kernels::rasterize_occluders_avx2 } });
+    }
+#endif
+
+    printf("CPU features: %s\n", eng::cpu_features_string());
+
+    for (const u32 num_triangles : { 1u, 10u, 200u }) {
+        const auto vertices = random_triangles(num_triangles);
+        eng::OcclusionBuffer buffer = random_occluders(vertices);
+        for (const auto &named : kernel_sets) {
+            check_kernels(named, buffer);
+        }
+        eng::rasterize_occluders(buffer);
+        check_against_reference(vertices, buffer);
+        check_multithreaded(vertices);
+    }
+
+    printf("OK\n");
+}
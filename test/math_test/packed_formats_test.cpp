@@ -0,0 +1,318 @@
+// Checks the packed attribute format conversions. The single value functions are checked against their
+// definitions, the kernels against the single value functions, bit for bit, over strided and tightly packed
+// arrays with every component count.
+
+#include "math_kernels.h"
+
+#include <learnogl/cpu_features.h>
+#include <learnogl/math_ops.h>
+#include <learnogl/rng.h>
+
+#include <loguru.hpp>
+
+#include <limits>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+using namespace fo;
+using namespace eng::math;
+
+static u32 float_bits(float f) {
+    u32 u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static float float_from_bits(u32 u) {
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+static bool same_float(float a, float b) {
+    return (std::isnan(a) && std::isnan(b)) || float_bits(a) == float_bits(b);
+}
+
+static bool is_f16_nan(u16 h) { return (h & 0x7c00) == 0x7c00 && (h & 0x03ff) != 0; }
+
+static bool same_f16(u16 a, u16 b) { return (is_f16_nan(a) && is_f16_nan(b)) || a == b; }
+
+// F16C keeps the payload of NaNs, the others don't. Either is fine.
+static bool same_number(u16 a, u16 b) { return same_f16(a, b); }
+static bool same_number(i16 a, i16 b) { return a == b; }
+static bool same_number(u8 a, u8 b) { return a == b; }
+
+static void check_single_value_functions() {
+    // Every half survives the round trip, and decodes to what its bits say
+    for (u32 h = 0; h < 0x10000; ++h) {
+        const float f = f16_to_f32((u16)h);
+        const u32 exponent = (h >> 10) & 0x1f;
+        const u32 mantissa = h & 0x3ff;
+        const double magnitude = exponent == 0 ? std::ldexp((double)mantissa, -24)
+                                               : exponent == 31 ? (mantissa == 0 ? INFINITY : NAN)
+                                                                : std::ldexp(1024.0 + mantissa, (int)exponent - 25);
+        const float expected = float((h & 0x8000) ? -magnitude : magnitude);
+        CHECK_F(same_float(f, expected), "Half %04x decoded to %g", h, f);
+        CHECK_F(same_f16(f32_to_f16(f), (u16)h), "Half %04x doesn't round trip", h);
+    }
+
+    // Halfway between two consecutive halves rounds to the even one, anything past it to the nearer one
+    for (u32 h = 0; h < 0x7bff; ++h) {
+        const float lo = f16_to_f32((u16)h);
+        const float hi = f16_to_f32((u16)(h + 1));
+        const float mid = float(((double)lo + (double)hi) / 2.0);
+        const u16 even = (h & 1) ? (u16)(h + 1) : (u16)h;
+        CHECK_F(f32_to_f16(mid) == even, "Tie between %04x and %04x", h, h + 1);
+        CHECK_F(f32_to_f16(-mid) == (even | 0x8000), "Tie between -%04x and -%04x", h, h + 1);
+        CHECK_F(f32_to_f16(std::nextafter(mid, lo)) == h, "Below the tie after %04x", h);
+        CHECK_F(f32_to_f16(std::nextafter(mid, hi)) == h + 1, "Above the tie after %04x", h);
+    }
+    CHECK_F(f32_to_f16(65520.0f) == 0x7c00, "Rounds up to infinity");
+    CHECK_F(f32_to_f16(65519.99f) == 0x7bff, "Rounds down to the largest half");
+    CHECK_F(f32_to_f16(1e-8f) == 0 && f32_to_f16(-1e-8f) == 0x8000, "Underflows to signed zero");
+
+    CHECK_F(f32_to_snorm16(1.0f) == 32767 && f32_to_snorm16(-1.0f) == -32767, "snorm16 ends");
+    CHECK_F(f32_to_snorm16(2.0f) == 32767 && f32_to_snorm16(-2.0f) == -32767, "snorm16 clamps");
+    CHECK_F(f32_to_snorm16(0.5f / 32767.0f) == 0 && f32_to_snorm16(1.5f / 32767.0f) == 2, "snorm16 ties to even");
+    CHECK_F(f32_to_snorm16(NAN) == -32767, "snorm16 NaN");
+    CHECK_F(f32_to_unorm8(1.0f) == 255 && f32_to_unorm8(-1.0f) == 0 && f32_to_unorm8(7.0f) == 255, "unorm8 ends");
+    CHECK_F(f32_to_unorm8(127.5f / 255.0f) == 128 && f32_to_unorm8(NAN) == 0, "unorm8 rounding");
+}
+
+// A vertex with the attribute being converted between other ones, as in the interleaved vertex buffers of a
+// MeshData.
+struct Vertex {
+    float before;
+    float values[4];
+    float after;
+};
+
+struct PackedVertex {
+    u16 before;
+    u16 values[4];
+    u16 after;
+};
+
+static float random_value(u32 i) {
+    switch (i % 16) {
+    case 0: return (float)rng::random(-70000.0, 70000.0);
+    case 1: return (float)rng::random(-1e-4, 1e-4); // Half subnormals
+    case 2: return float_from_bits((u32)rng::random_i32(0, 0x7fffffff)); // Any positive float, incl. NaNs
+    case 3: return -float_from_bits((u32)rng::random_i32(0, 0x7fffffff));
+    case 4: return f16_to_f32((u16)rng::random_i32(0, 0x10000)); // Exact halves
+    case 5: return std::numeric_limits<float>::infinity();
+    case 6: return (float)rng::random_i32(-32767, 32768) / 32767.0f + 0.5f / 32767.0f; // Near snorm16 ties
+    case 7: return ((float)rng::random_i32(0, 256) + 0.5f) / 255.0f;
+    default: return (float)rng::random(-1.5, 1.5);
+    }
+}
+
+template <typename Dst, typename Kernel>
+static void check_kernel_on_floats(const char *name, Kernel kernel, Kernel reference, u32 count, u32 components) {
+    // One more element than converted in each array, to check nothing gets written past the end
+    std::vector<Vertex> src(count + 1);
+    for (u32 i = 0; i < count; ++i) {
+        for (u32 c = 0; c < 4; ++c) {
+            src[i].values[c] = random_value(i * 4 + c);
+        }
+    }
+
+    // Strided, then tightly packed
+    std::vector<Dst> expected((count + 1) * 4, Dst(0x5a));
+    std::vector<Dst> got((count + 1) * 4, Dst(0x5a));
+    reference(src[0].values, sizeof(Vertex), expected.data(), 4 * sizeof(Dst), count, components);
+    kernel(src[0].values, sizeof(Vertex), got.data(), 4 * sizeof(Dst), count, components);
+    for (size_t i = 0; i < got.size(); ++i) {
+        CHECK_F(same_number(expected[i], got[i]), "%s: strided, %zu of %u components", name, i, components);
+    }
+
+    std::vector<float> packed_src(count * components);
+    for (u32 i = 0; i < count; ++i) {
+        memcpy(&packed_src[i * components], src[i].values, components * sizeof(float));
+    }
+    std::fill(got.begin(), got.end(), Dst(0x5a));
+    kernel(packed_src.data(), components * sizeof(float), got.data(), components * sizeof(Dst), count, components);
+    for (u32 i = 0; i < count; ++i) {
+        for (u32 c = 0; c < components; ++c) {
+            CHECK_F(same_number(expected[i * 4 + c], got[i * components + c]),
+                    "%s: packed, element %u of %u, %u components",
+                    name,
+                    i,
+                    count,
+                    components);
+        }
+    }
+    CHECK_F(got[count * components] == Dst(0x5a), "%s: wrote past the end", name);
+}
+
+static void check_f16_to_f32(const char *name, kernels::F16ToF32Kernel kernel, u32 count, u32 components) {
+    std::vector<PackedVertex> src(count + 1);
+    for (u32 i = 0; i < count; ++i) {
+        for (u32 c = 0; c < 4; ++c) {
+            src[i].values[c] = (u16)rng::random_i32(0, 0x10000);
+        }
+    }
+
+    std::vector<Vertex> got(count + 1);
+    for (Vertex &v : got) {
+        v.before = v.after = 42.0f;
+        std::fill(v.values, v.values + 4, 42.0f);
+    }
+    kernel(src[0].values, sizeof(PackedVertex), got[0].values, sizeof(Vertex), count, components);
+
+    for (u32 i = 0; i < count; ++i) {
+        for (u32 c = 0; c < 4; ++c) {
+            const float expected = c < components ? f16_to_f32(src[i].values[c]) : 42.0f;
+            CHECK_F(same_float(got[i].values[c], expected), "%s: element %u, component %u", name, i, c);
+        }
+        CHECK_F(got[i].before == 42.0f && got[i].after == 42.0f, "%s: wrote outside element %u", name, i);
+    }
+    CHECK_F(got[count].values[0] == 42.0f, "%s: wrote past the end", name);
+
+    // Tightly packed
+    std::vector<u16> packed_src(count * components);
+    for (u32 i = 0; i < count; ++i) {
+        memcpy(&packed_src[i * components], src[i].values, components * sizeof(u16));
+    }
+    std::vector<float> packed_got(count * components + 1, 42.0f);
+    kernel(
+        packed_src.data(), components * sizeof(u16), packed_got.data(), components * sizeof(float), count, components);
+    for (u32 i = 0; i < count * components; ++i) {
+        CHECK_F(same_float(packed_got[i], f16_to_f32(packed_src[i])), "%s: packed number %u", name, i);
+    }
+    CHECK_F(packed_got[count * components] == 42.0f, "%s: wrote past the end", name);
+}
+
+static Vector3 random_direction() {
+    return Vector3{ (float)rng::random(-1.0, 1.0), (float)rng::random(-1.0, 1.0), (float)rng::random(-1.0, 1.0) };
+}
+
+// Angle between unit vectors, accurate for small angles unlike acos
+static double angle_between(const Vector3 &a, const Vector3 &b) {
+    const Vector3 c = cross(a, b);
+    return std::atan2(std::sqrt((double)dot(c, c)), (double)dot(a, b));
+}
+
+struct NamedPackKernels {
+    const char *name;
+    kernels::PackKernels k;
+};
+
+static void check_octahedral(const NamedPackKernels &named, u32 count) {
+    struct NormalVertex {
+        Vector3 position;
+        Vector3 normal;
+    };
+
+    struct PackedNormalVertex {
+        Vector3 position;
+        i16 normal[2];
+    };
+
+    const Vector3 sentinel{ 7, 7, 7 };
+
+    std::vector<NormalVertex> vertices(count + 1);
+    const Vector3 special[] = { unit_x, unit_y, unit_z, -unit_x, -unit_y, -unit_z, zero_3, Vector3{ 1, 1, 1 } };
+    for (u32 i = 0; i < count; ++i) {
+        vertices[i].position = sentinel;
+        vertices[i].normal = i < 8 ? special[i] : normalize(random_direction());
+    }
+
+    std::vector<PackedNormalVertex> packed(count + 1);
+    for (auto &p : packed) {
+        p.position = sentinel;
+    }
+    packed[count].normal[0] = packed[count].normal[1] = 0x5a5a;
+
+    named.k.encode_octahedral(
+        &vertices[0].normal, sizeof(NormalVertex), packed[0].normal, sizeof(PackedNormalVertex), count);
+
+    double max_error = 0.0;
+    for (u32 i = 0; i < count; ++i) {
+        i16 expected[2];
+        encode_octahedral_snorm16(vertices[i].normal, expected);
+        CHECK_F(std::abs(expected[0] - packed[i].normal[0]) <= 1 && std::abs(expected[1] - packed[i].normal[1]) <= 1,
+                "%s: encoded %u differently",
+                named.name,
+                i);
+        CHECK_F(packed[i].position == sentinel, "%s: wrote outside element %u", named.name, i);
+
+        const Vector3 decoded = decode_octahedral_snorm16(expected);
+        if (i != 6) {
+            max_error = std::max(max_error, angle_between(vertices[i].normal, decoded));
+        } else {
+            CHECK_F(decoded == unit_z, "%s: zero vector should decode to +z", named.name);
+        }
+    }
+    CHECK_F(packed[count].normal[0] == 0x5a5a, "%s: wrote past the end", named.name);
+    CHECK_F(max_error < 7e-5, "%s: octahedral round trip is off by %g radians", named.name, max_error);
+
+    std::vector<NormalVertex> decoded(count + 1);
+    decoded[count].normal = sentinel;
+    named.k.decode_octahedral(
+        packed[0].normal, sizeof(PackedNormalVertex), &decoded[0].normal, sizeof(NormalVertex), count);
+    for (u32 i = 0; i < count; ++i) {
+        const Vector3 expected = decode_octahedral_snorm16(packed[i].normal);
+        CHECK_F(magnitude(decoded[i].normal - expected) < 1e-6f, "%s: decoded %u differently", named.name, i);
+    }
+    CHECK_F(decoded[count].normal == sentinel, "%s: wrote past the end", named.name);
+}
+
+int main() {
+    rng::init_rng(0xbadcafe);
+
+    check_single_value_functions();
+
+    std::vector<NamedPackKernels> kernel_sets = {
+        { "sse",
+          { kernels::f32_to_f16_sse,
+            kernels::f16_to_f32_sse,
+            kernels::f32_to_snorm16_sse,
+            kernels::f32_to_unorm8_sse,
+            kernels::encode_octahedral_sse,
+            kernels::decode_octahedral_sse } },
+    };
+
+#if LOGL_HAVE_AVX2_KERNELS
+    const eng::CpuFeatures &cpu = eng::cpu_features();
+    if (cpu.avx2 && cpu.fma && cpu.f16c) {
+        kernel_sets.push_back(NamedPackKernels{ "avx2",
+                                                { kernels::f32_to_f16_avx2,
+                                                  kernels::f16_to_f32_avx2,
+                                                  kernels::f32_to_snorm16_sse,
+                                                  kernels::f32_to_unorm8_sse,
+                                                  kernels::encode_octahedral_avx2,
+                                                  kernels::decode_octahedral_avx2 } });
+    }
+#endif
+
+    // The public functions too, whichever kernels they picked
+    kernel_sets.push_back(NamedPackKernels{ "public",
+                                            { f32_to_f16,
+                                              f16_to_f32,
+                                              f32_to_snorm16,
+                                              f32_to_unorm8,
+                                              encode_octahedral_snorm16,
+                                              decode_octahedral_snorm16 } });
+
+    printf("CPU features: %s\n", eng::cpu_features_string());
+
+    for (const auto &named : kernel_sets) {
+        for (u32 count : { 0u, 1u, 3u, 8u, 9u, 1000u }) {
+            for (u32 components = 1; components <= 4; ++components) {
+                check_kernel_on_floats<u16>(
+                    named.name, named.k.f32_to_f16, kernels::f32_to_f16_scalar, count, components);
+                check_kernel_on_floats<i16>(
+                    named.name, named.k.f32_to_snorm16, kernels::f32_to_snorm16_scalar, count, components);
+                check_kernel_on_floats<u8>(
+                    named.name, named.k.f32_to_unorm8, kernels::f32_to_unorm8_scalar, count, components);
+                check_f16_to_f32(named.name, named.k.f16_to_f32, count, components);
+            }
+            check_octahedral(named, count);
+        }
+        check_octahedral(named, 100000);
+    }
+
+    printf("OK\n");
+}
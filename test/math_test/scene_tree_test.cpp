@@ -0,0 +1,387 @@
+// Checks the scene tree's world matrices against multiplying out each node's ancestors, after building a random
+// hierarchy, changing some of the local transforms and removing some subtrees, and that only the nodes under a
+// change get updated. Then that the multithreaded update gives the same matrices, bit for bit, also with the nodes
+// of several roots interleaved, that handles survive compacting the arrays while the removed nodes' handles go
+// stale, and that the published snapshots match the tree and stay unchanged while read from another thread.
+
+#include <learnogl/math_ops.h>
+#include <learnogl/rng.h>
+#include <learnogl/scene_tree.h>
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+using namespace fo;
+using namespace eng::math;
+
+static Vector3 random_vector(double lo, double hi) {
+    return Vector3{ (float)rng::random(lo, hi), (float)rng::random(lo, hi), (float)rng::random(lo, hi) };
+}
+
+static LocalTransform random_local_transform() {
+    const Vector3 axis = normalize(random_vector(0.1, 1.0));
+    const Quaternion orientation = versor_from_axis_angle(axis, (float)rng::random(-pi, pi));
+    return LocalTransform(random_vector(0.8, 1.25), orientation, random_vector(-2.0, 2.0));
+}
+
+// Multiplied out from the root down, like the tree does. The errors still add up along the way down, differently
+// as the tree computes the local matrices 8 at a time, so the tolerance grows with the depth.
+static Matrix4x4 expected_world_matrix(const eng::SceneTree &tree, u32 node, u32 &depth_out) {
+    std::vector<u32> path;
+    for (u32 p = node; p != eng::SceneTree::k_no_parent; p = tree.parent(p)) {
+        path.push_back(p);
+    }
+    Matrix4x4 m = identity_matrix;
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        m = m * tree.local_transform(*it).get_mat4();
+    }
+    depth_out = u32(path.size());
+    return m;
+}
+
+static void check_world_matrices(const eng::SceneTree &tree) {
+    for (u32 i = 0; i < tree.array_size(); ++i) {
+        if (!tree.is_alive(i)) {
+            continue;
+        }
+        u32 depth;
+        const Matrix4x4 expected = expected_world_matrix(tree, i, depth);
+        const Matrix4x4 &m = tree.world_matrix(i);
+        const float *a = &m.x.x;
+        const float *b = &expected.x.x;
+        for (u32 e = 0; e < 16; ++e) {
+            CHECK_F(std::abs(a[e] - b[e]) <= 1e-5f * depth * (1.0f + std::abs(b[e])),
+                    "Node %u element %u is %f, expected %f",
+                    i,
+                    e,
+                    a[e],
+                    b[e]);
+        }
+    }
+}
+
+static bool is_ancestor_or_self(const eng::SceneTree &tree, u32 ancestor, u32 node) {
+    for (u32 p = node; p != eng::SceneTree::k_no_parent; p = tree.parent(p)) {
+        if (p == ancestor) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A few roots with random nodes under them, and a long chain
+static void build_random_tree(eng::SceneTree &tree, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        eng::SceneNodeHandle parent = {};
+        if (i >= 200 && i < 400) {
+            parent = tree.handle(i - 1);
+        } else if (i != 0 && rng::random() > 0.02) {
+            parent = tree.handle(u32(rng::random_i32(0, i32(i))));
+        }
+        tree.add_node(parent, random_local_transform());
+    }
+}
+
+static std::vector<Matrix4x4> run(bool multithreaded) {
+    rng::init_rng(0x7ee);
+
+    eng::SceneTree tree(100);
+    build_random_tree(tree, 5000);
+    CHECK_F(tree.num_nodes() == 5000, "Number of nodes");
+    tree.update_world_matrices(multithreaded);
+    check_world_matrices(tree);
+    for (u32 i = 0; i < tree.array_size(); ++i) {
+        CHECK_F(tree.world_changed(i), "Every node is new");
+    }
+
+    // Nothing changed, nothing updated
+    tree.update_world_matrices(multithreaded);
+    for (u32 i = 0; i < tree.array_size(); ++i) {
+        CHECK_F(!tree.world_changed(i), "Node %u updated with nothing changed", i);
+    }
+
+    // Only the subtrees under the changed nodes are updated
+    for (u32 round = 0; round < 10; ++round) {
+        std::vector<u32> changed;
+        for (u32 k = 0; k < 20; ++k) {
+            const u32 node = u32(rng::random_i32(0, i32(tree.array_size())));
+            if (tree.is_alive(node)) {
+                tree.set_local_transform(tree.handle(node), random_local_transform());
+                changed.push_back(node);
+            }
+        }
+        tree.update_world_matrices(multithreaded);
+        check_world_matrices(tree);
+
+        for (u32 i = 0; i < tree.array_size(); ++i) {
+            if (!tree.is_alive(i)) {
+                continue;
+            }
+            const bool under_change = std::any_of(
+                changed.begin(), changed.end(), [&](u32 c) { return is_ancestor_or_self(tree, c, i); });
+            CHECK_F(tree.world_changed(i) == under_change, "Node %u updated: %d", i, tree.world_changed(i));
+        }
+
+        // Remove a subtree, and add some more nodes under the ones left
+        u32 removed = u32(rng::random_i32(0, i32(tree.array_size())));
+        while (!tree.is_alive(removed)) {
+            removed = u32(rng::random_i32(0, i32(tree.array_size())));
+        }
+        const u32 num_before = tree.num_nodes();
+        std::vector<bool> was_alive(tree.array_size());
+        for (u32 i = 0; i < tree.array_size(); ++i) {
+            was_alive[i] = tree.is_alive(i);
+        }
+        tree.remove_node(tree.handle(removed));
+
+        u32 num_removed = 0;
+        for (u32 i = 0; i < tree.array_size(); ++i) {
+            const bool expected_alive = was_alive[i] && !is_ancestor_or_self(tree, removed, i);
+            CHECK_F(tree.is_alive(i) == expected_alive, "Node %u after removing %u", i, removed);
+            num_removed += was_alive[i] && !expected_alive ? 1 : 0;
+        }
+        CHECK_F(tree.num_nodes() == num_before - num_removed, "Number of nodes after removing");
+
+        for (u32 k = 0; k < 50; ++k) {
+            const u32 parent = u32(rng::random_i32(0, i32(tree.array_size())));
+            tree.add_node(tree.is_alive(parent) ? tree.handle(parent) : eng::SceneNodeHandle{},
+                          random_local_transform());
+        }
+        tree.update_world_matrices(multithreaded);
+        check_world_matrices(tree);
+    }
+
+    // Every root changes and so every node, enough of them to be split over the threads
+    for (u32 i = 0; i < tree.array_size(); ++i) {
+        if (tree.is_alive(i) && tree.parent(i) == eng::SceneTree::k_no_parent) {
+            tree.set_local_transform(tree.handle(i), random_local_transform());
+        }
+    }
+    tree.update_world_matrices(multithreaded);
+    check_world_matrices(tree);
+
+    return std::vector<Matrix4x4>(tree.world_matrices(), tree.world_matrices() + tree.array_size());
+}
+
+// Two roots whose children were added alternately, so that grouped by root the first batch holds the nodes of
+// both, its indices spanning exactly the batch without being consecutive. Then two larger roots, for enough nodes
+// to update them multithreaded.
+static std::vector<Matrix4x4> run_interleaved_roots(bool multithreaded) {
+    rng::init_rng(0x1ea7);
+
+    eng::SceneTree tree(100);
+    const eng::SceneNodeHandle a = tree.add_node({}, random_local_transform());
+    const eng::SceneNodeHandle b = tree.add_node({}, random_local_transform());
+    for (u32 i = 2; i < 256; ++i) {
+        tree.add_node(i % 2 == 0 ? a : b, random_local_transform());
+    }
+    for (u32 r = 0; r < 2; ++r) {
+        const u32 root = tree.array_size();
+        tree.add_node({}, random_local_transform());
+        for (u32 k = 0; k < 1100; ++k) {
+            tree.add_node(tree.handle(root + u32(rng::random_i32(0, i32(k + 1)))), random_local_transform());
+        }
+    }
+
+    tree.update_world_matrices(multithreaded);
+    check_world_matrices(tree);
+    return std::vector<Matrix4x4>(tree.world_matrices(), tree.world_matrices() + tree.array_size());
+}
+
+static void check_handles_and_compact() {
+    rng::init_rng(0xc0);
+
+    eng::SceneTree tree;
+    build_random_tree(tree, 2000);
+    std::vector<eng::SceneNodeHandle> handles;
+    for (u32 i = 0; i < tree.array_size(); ++i) {
+        handles.push_back(tree.handle(i));
+    }
+
+    for (u32 k = 0; k < 10; ++k) {
+        const eng::SceneNodeHandle node = handles[rng::random_i32(0, i32(handles.size()))];
+        if (tree.is_valid(node)) {
+            tree.remove_node(node);
+        }
+    }
+    std::vector<eng::SceneNodeHandle> stale;
+    std::vector<eng::SceneNodeHandle> alive;
+    for (u32 i = 0; i < handles.size(); ++i) {
+        CHECK_F(tree.is_valid(handles[i]) == tree.is_alive(i), "Handle of node %u", i);
+        (tree.is_alive(i) ? alive : stale).push_back(handles[i]);
+    }
+    CHECK_F(!stale.empty(), "Removed some nodes");
+
+    // New nodes reuse the freed handle slots, with a new generation
+    for (u32 k = 0; k < 100; ++k) {
+        const eng::SceneNodeHandle parent = alive[rng::random_i32(0, i32(alive.size()))];
+        alive.push_back(tree.add_node(parent, random_local_transform()));
+    }
+    for (eng::SceneNodeHandle h : stale) {
+        CHECK_F(!tree.is_valid(h), "Stale handle 0x%x is valid", h.bits);
+    }
+    tree.update_world_matrices();
+
+    std::vector<Matrix4x4> matrices;
+    std::vector<eng::SceneNodeHandle> parents;
+    for (eng::SceneNodeHandle h : alive) {
+        matrices.push_back(tree.world_matrix(h));
+        const u32 parent = tree.parent(tree.node_index(h));
+        parents.push_back(parent == eng::SceneTree::k_no_parent ? eng::SceneNodeHandle{} : tree.handle(parent));
+    }
+
+    const u32 num_nodes = tree.num_nodes();
+    tree.compact();
+    CHECK_F(tree.num_nodes() == num_nodes && tree.array_size() == num_nodes, "No holes left after compacting");
+    for (u32 k = 0; k < alive.size(); ++k) {
+        const eng::SceneNodeHandle h = alive[k];
+        CHECK_F(tree.is_valid(h), "Handle 0x%x invalid after compacting", h.bits);
+        CHECK_F(tree.handle(tree.node_index(h)) == h, "Handle 0x%x maps back to itself", h.bits);
+        CHECK_F(memcmp(&tree.world_matrix(h), &matrices[k], sizeof(Matrix4x4)) == 0, "Matrix moved along");
+        const u32 parent = tree.parent(tree.node_index(h));
+        CHECK_F((parent == eng::SceneTree::k_no_parent ? eng::SceneNodeHandle{} : tree.handle(parent)) == parents[k],
+                "Parent of 0x%x after compacting",
+                h.bits);
+    }
+
+    for (u32 k = 0; k < 50; ++k) {
+        tree.set_local_transform(alive[rng::random_i32(0, i32(alive.size()))], random_local_transform());
+    }
+    tree.update_world_matrices();
+    check_world_matrices(tree);
+}
+
+static void check_snapshot(const eng::SceneTree &tree, eng::SceneSnapshots &snapshots, u64 frame) {
+    const eng::SceneSnapshot *snapshot = snapshots.acquire_latest();
+    CHECK_F(snapshot != nullptr && snapshot->frame == frame, "Snapshot of frame %u", u32(frame));
+    CHECK_F(snapshot->array_size() == tree.array_size(), "Snapshot size");
+    for (u32 i = 0; i < tree.array_size(); ++i) {
+        if (!tree.is_alive(i)) {
+            CHECK_F(!snapshot->is_visible(i) && snapshot->handles[i].is_null(), "Removed node %u in snapshot", i);
+            continue;
+        }
+        CHECK_F(snapshot->handles[i] == tree.handle(i), "Handle of node %u in snapshot", i);
+        CHECK_F(snapshot->is_visible(i) == (i % 3 != 0), "Visibility of node %u in snapshot", i);
+        CHECK_F(memcmp(&snapshot->world_matrices[i], &tree.world_matrix(i), sizeof(Matrix4x4)) == 0,
+                "Matrix of node %u in snapshot of frame %u",
+                i,
+                u32(frame));
+    }
+    snapshots.release();
+}
+
+// Frames that change a few nodes, sometimes none, sometimes with two updates and sometimes adding or removing
+// nodes, so the snapshots are written both by copying everything and by copying what changed.
+static void check_snapshots_match_tree() {
+    rng::init_rng(0x5a);
+
+    eng::SceneTree tree;
+    build_random_tree(tree, 3000);
+    eng::SceneSnapshots snapshots;
+    CHECK_F(snapshots.acquire_latest() == nullptr, "Nothing published yet");
+
+    std::vector<u8> visible_bits;
+    for (u64 frame = 1; frame <= 60; ++frame) {
+        const u32 num_updates = frame % 7 == 0 ? 2 : 1;
+        for (u32 k = 0; k < num_updates; ++k) {
+            const u32 num_changes = frame % 5 == 0 ? 0 : 10;
+            for (u32 c = 0; c < num_changes; ++c) {
+                const u32 node = u32(rng::random_i32(0, i32(tree.array_size())));
+                if (tree.is_alive(node)) {
+                    tree.set_local_transform(tree.handle(node), random_local_transform());
+                }
+            }
+            if (frame % 11 == 0) {
+                const u32 node = u32(rng::random_i32(0, i32(tree.array_size())));
+                if (tree.is_alive(node)) {
+                    tree.remove_node(tree.handle(node));
+                }
+                tree.add_node({}, random_local_transform());
+            }
+            if (frame % 22 == 0) {
+                tree.compact();
+            }
+            tree.update_world_matrices();
+        }
+
+        visible_bits.assign((tree.array_size() + 7) / 8, 0);
+        for (u32 i = 0; i < tree.array_size(); ++i) {
+            visible_bits[i / 8] |= i % 3 != 0 ? u8(1u << (i % 8)) : u8(0);
+        }
+        tree.publish_snapshot(snapshots, visible_bits.data());
+        check_snapshot(tree, snapshots, frame);
+    }
+}
+
+// The simulation thread moves every root to x = frame number, and the render thread checks that each snapshot it
+// gets has all of them at its frame's.
+static void check_snapshots_across_threads() {
+    constexpr u32 num_roots = 1000;
+    constexpr u32 num_frames = 300;
+
+    eng::SceneTree tree;
+    std::vector<eng::SceneNodeHandle> roots;
+    for (u32 i = 0; i < num_roots; ++i) {
+        roots.push_back(tree.add_node());
+    }
+    eng::SceneSnapshots snapshots;
+
+    std::thread render_thread([&]() {
+        u64 last_frame = 0;
+        while (last_frame < num_frames) {
+            const eng::SceneSnapshot *snapshot = snapshots.acquire_latest();
+            if (snapshot == nullptr) {
+                std::this_thread::yield();
+                continue;
+            }
+            CHECK_F(snapshot->frame >= last_frame, "Snapshots in order");
+            for (u32 i = 0; i < num_roots; ++i) {
+                CHECK_F(snapshot->world_matrices[i].t.x == float(snapshot->frame),
+                        "Root %u in snapshot of frame %u",
+                        i,
+                        u32(snapshot->frame));
+            }
+            last_frame = snapshot->frame;
+            snapshots.release();
+        }
+    });
+
+    for (u32 frame = 1; frame <= num_frames; ++frame) {
+        LocalTransform local = LocalTransform::identity();
+        local.position.x = float(frame);
+        for (eng::SceneNodeHandle root : roots) {
+            tree.set_local_transform(root, local);
+        }
+        tree.update_world_matrices();
+        tree.publish_snapshot(snapshots);
+    }
+    render_thread.join();
+}
+
+int main() {
+    const std::vector<Matrix4x4> single = run(false);
+    const std::vector<Matrix4x4> multi = run(true);
+    CHECK_F(single.size() == multi.size(), "Same number of nodes");
+    for (size_t i = 0; i < single.size(); ++i) {
+        CHECK_F(memcmp(&single[i], &multi[i], sizeof(Matrix4x4)) == 0, "Node %zu differs when multithreaded", i);
+    }
+
+    const std::vector<Matrix4x4> interleaved_single = run_interleaved_roots(false);
+    const std::vector<Matrix4x4> interleaved_multi = run_interleaved_roots(true);
+    for (size_t i = 0; i < interleaved_single.size(); ++i) {
+        CHECK_F(memcmp(&interleaved_single[i], &interleaved_multi[i], sizeof(Matrix4x4)) == 0,
+                "Node %zu of the interleaved roots differs when multithreaded",
+                i);
+    }
+
+    check_handles_and_compact();
+    check_snapshots_match_tree();
+    check_snapshots_across_threads();
+
+    printf("OK\n");
+}
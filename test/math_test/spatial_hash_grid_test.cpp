@@ -0,0 +1,222 @@
+// Checks the spatial hash grid's queries and pairs against brute force, over points spread out and bunched up, and
+// that building it multithreaded gives the same grid.
+
+#include <learnogl/math_ops.h>
+#include <learnogl/rng.h>
+#include <learnogl/spatial_hash_grid.h>
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <stdio.h>
+#include <vector>
+
+using namespace fo;
+using namespace eng::math;
+
+static float random_float(float min, float max) { return (float)rng::random(min, max); }
+
+static Vector3 random_vector(float min, float max) {
+    return Vector3{ random_float(min, max), random_float(min, max), random_float(min, max) };
+}
+
+// Positions inside a bigger struct, like particles
+struct Particle {
+    Vector3 position;
+    float radius;
+};
+
+// Half of them spread over a box around the origin, half bunched up in a few blobs
+static std::vector<Particle> random_particles(u32 count, float world_size) {
+    std::vector<Particle> particles(count);
+    Vector3 blobs[4];
+    for (Vector3 &blob : blobs) {
+        blob = random_vector(-world_size, world_size);
+    }
+    for (u32 i = 0; i < count; ++i) {
+        const Vector3 p = i % 2 == 0 ? random_vector(-world_size, world_size)
+                                     : blobs[i % 4] + random_vector(-world_size, world_size) * 0.05f;
+        particles[i] = Particle{ p, random_float(0.05f, 0.5f) };
+    }
+    return particles;
+}
+
+namespace eng {
+
+static bool operator==(const PointPair &a, const PointPair &b) { return a.a == b.a && a.b == b.b; }
+static bool operator<(const PointPair &a, const PointPair &b) { return a.a < b.a || (a.a == b.a && a.b < b.b); }
+
+} // namespace eng
+
+static std::vector<eng::PointPair> sorted(const Array<eng::PointPair> &pairs) {
+    std::vector<eng::PointPair> v(begin(pairs), end(pairs));
+    std::sort(v.begin(), v.end());
+    return v;
+}
+
+static void build(eng::SpatialHashGrid &grid, const std::vector<Particle> &particles, float cell_size, bool mt) {
+    const Vector3 *positions = particles.empty() ? nullptr : &particles[0].position;
+    eng::build_spatial_hash_grid(grid, positions, sizeof(Particle), u32(particles.size()), cell_size, mt);
+}
+
+static void check_structure(const eng::SpatialHashGrid &grid, const std::vector<Particle> &particles) {
+    const u32 n = u32(particles.size());
+    CHECK_F(size(grid.bucket_starts) == grid.num_buckets + 1, "Bucket starts");
+    CHECK_F(grid.bucket_starts[0] == 0 && grid.bucket_starts[grid.num_buckets] == n, "Bucket starts cover it all");
+
+    std::vector<bool> seen(n, false);
+    for (u32 b = 0; b < grid.num_buckets; ++b) {
+        CHECK_F(grid.bucket_starts[b] <= grid.bucket_starts[b + 1], "Bucket starts not sorted");
+        for (u32 s = grid.bucket_starts[b]; s < grid.bucket_starts[b + 1]; ++s) {
+            const u32 index = grid.sorted_indices[s];
+            CHECK_F(index < n && !seen[index], "Point %u twice", index);
+            seen[index] = true;
+            CHECK_F(eng::spatial_hash_bucket(grid, particles[index].position) == b,
+                    "Point %u in the wrong bucket",
+                    index);
+            CHECK_F(eng::spatial_hash_distance_squared(grid.sorted_positions[s], particles[index].position) == 0.0f,
+                    "Sorted position of %u",
+                    index);
+        }
+    }
+}
+
+static void check_same_grid(const eng::SpatialHashGrid &a, const eng::SpatialHashGrid &b) {
+    CHECK_F(a.num_buckets == b.num_buckets, "Different number of buckets");
+    CHECK_F(std::equal(begin(a.bucket_starts), end(a.bucket_starts), begin(b.bucket_starts)), "Bucket starts differ");
+    CHECK_F(std::equal(begin(a.sorted_indices), end(a.sorted_indices), begin(b.sorted_indices)), "Order differs");
+}
+
+static void check_queries(const eng::SpatialHashGrid &grid,
+                          const std::vector<Particle> &particles,
+                          float radius,
+                          float world_size,
+                          u32 num_queries) {
+    for (u32 q = 0; q < num_queries; ++q) {
+        // Around a point of the grid half the time
+        const Vector3 p = q % 2 == 0 ? random_vector(-world_size, world_size)
+                                     : particles[rng::random_i32(0, i32(particles.size()))].position;
+        std::vector<u32> found;
+        eng::for_each_neighbour(grid, p, radius, [&](u32 index, float distance_squared) {
+            CHECK_F(std::abs(distance_squared - square_magnitude(particles[index].position - p)) < 1e-4f,
+                    "Distance to %u",
+                    index);
+            found.push_back(index);
+        });
+        std::sort(found.begin(), found.end());
+
+        std::vector<u32> expected;
+        for (u32 i = 0; i < particles.size(); ++i) {
+            if (eng::spatial_hash_distance_squared(particles[i].position, p) <= radius * radius) {
+                expected.push_back(i);
+            }
+        }
+        CHECK_F(found == expected, "Query found %zu, expected %zu", found.size(), expected.size());
+    }
+}
+
+static void check_pairs(const eng::SpatialHashGrid &grid, const std::vector<Particle> &particles, float radius) {
+    std::vector<eng::PointPair> expected;
+    std::vector<eng::PointPair> expected_spheres;
+    for (u32 i = 0; i < particles.size(); ++i) {
+        for (u32 j = i + 1; j < particles.size(); ++j) {
+            const Particle &a = particles[i];
+            const Particle &b = particles[j];
+            if (eng::spatial_hash_distance_squared(a.position, b.position) <= radius * radius) {
+                expected.push_back(eng::PointPair{ i, j });
+            }
+            if (eng::test_sphere_sphere(a.position, a.radius, b.position, b.radius)) {
+                expected_spheres.push_back(eng::PointPair{ i, j });
+            }
+        }
+    }
+
+    Array<eng::PointPair> pairs(memory_globals::default_allocator());
+    Array<eng::PointPair> pairs_mt(memory_globals::default_allocator());
+    eng::find_neighbour_pairs(grid, radius, pairs);
+    eng::find_neighbour_pairs(grid, radius, pairs_mt, true);
+    CHECK_F(sorted(pairs) == expected, "%u pairs, expected %zu", size(pairs), expected.size());
+    CHECK_F(std::equal(begin(pairs), end(pairs), begin(pairs_mt), end(pairs_mt)), "Multithreaded pairs differ");
+
+    std::vector<float> radii;
+    for (const Particle &particle : particles) {
+        radii.push_back(particle.radius);
+    }
+    eng::find_overlapping_spheres(grid, radii.data(), pairs, true);
+    CHECK_F(sorted(pairs) == expected_spheres,
+            "%u spheres overlap, expected %zu",
+            size(pairs),
+            expected_spheres.size());
+
+    // Every pair from both ends, each point's from a single thread
+    std::vector<u32> neighbour_counts(particles.size(), 0);
+    eng::for_each_neighbour_of_each_point(
+        grid, radius, [&](u32 index, u32, float) { ++neighbour_counts[index]; }, true);
+    std::vector<u32> expected_counts(particles.size(), 0);
+    for (const eng::PointPair &pair : expected) {
+        ++expected_counts[pair.a];
+        ++expected_counts[pair.b];
+    }
+    CHECK_F(neighbour_counts == expected_counts, "Neighbour counts");
+}
+
+int main() {
+    rng::init_rng(0x6a1d);
+
+    // Small enough for brute force pairs, one radix pass
+    {
+        const auto particles = random_particles(3000, 10.0f);
+        eng::SpatialHashGrid grid;
+        eng::SpatialHashGrid grid_mt;
+        for (const float cell_size : { 1.0f, 1.5f }) {
+            build(grid, particles, cell_size, false);
+            build(grid_mt, particles, cell_size, true);
+            check_structure(grid, particles);
+            check_same_grid(grid, grid_mt);
+            check_queries(grid, particles, cell_size * 0.5f, 10.0f, 200);
+            check_queries(grid, particles, cell_size, 10.0f, 200);
+            check_pairs(grid, particles, cell_size);
+        }
+    }
+
+    // Enough buckets for two passes, with the grid reused
+    {
+        eng::SpatialHashGrid grid;
+        eng::SpatialHashGrid grid_mt;
+        for (const u32 count : { 300000u, 20000u, 0u, 1u }) {
+            const auto particles = random_particles(count, 50.0f);
+            build(grid, particles, 1.0f, false);
+            build(grid_mt, particles, 1.0f, true);
+            check_structure(grid, particles);
+            check_same_grid(grid, grid_mt);
+            if (count != 0) {
+                check_queries(grid, particles, 1.0f, 50.0f, 50);
+            }
+        }
+    }
+
+    // Radius the same as the cell size, at points where the floors round to 4 cells apart on every axis
+    {
+        std::vector<Particle> particles;
+        for (u32 i = 0; i < 40; ++i) {
+            for (u32 j = 0; j < 40; ++j) {
+                particles.push_back(Particle{ Vector3{ i * 0.01f, j * 0.01f, (i + j) * 0.01f }, 0.045f });
+            }
+        }
+        eng::SpatialHashGrid grid;
+        build(grid, particles, 0.09f, false);
+        for (const float x : { 0.09f, 0.63f, 0.9f }) {
+            const Vector3 p{ x, x, x };
+            u32 found = 0;
+            eng::for_each_neighbour(grid, p, 0.09f, [&](u32, float) { ++found; });
+            u32 expected = 0;
+            for (const Particle &particle : particles) {
+                expected += eng::spatial_hash_distance_squared(particle.position, p) <= 0.09f * 0.09f;
+            }
+            CHECK_F(found == expected, "Query at %f found %u, expected %u", x, found, expected);
+        }
+        check_pairs(grid, particles, 0.09f);
+    }
+
+    printf("OK\n");
+}
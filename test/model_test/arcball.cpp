@@ -9,6 +9,7 @@
 #include <learnogl/eng>
 #include <learnogl/math_ops.h>
 #include <learnogl/mesh.h>
+#include <learnogl/typed_gl_resources.h>
 #include <learnogl/kitchen_sink.h>
 #include <learnogl/rng.h>
 #include <learnogl/stb_image.h>
@@ -117,6 +118,7 @@ struct App {
     unsigned num_meshes;
     GLuint model_vaos[MAX_MESHES_IN_MODEL];          // vao for each mesh
     unsigned model_num_indices[MAX_MESHES_IN_MODEL]; // num vertices in each mesh
+    GLenum model_index_types[MAX_MESHES_IN_MODEL];
     GLuint sphere_vao;
     unsigned num_sphere_indices;
 
@@ -362,6 +364,7 @@ template <> void init<App>(App &app) {
     debug("Num meshes: %u", app.num_meshes);
     for (unsigned i = 0; i < app.num_meshes; ++i) {
         app.model_num_indices[i] = num_indices(model._mesh_array[i]);
+        app.model_index_types[i] = eng::gl_index_type(mesh::StrippedMeshData(model._mesh_array[i].o));
     }
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -434,7 +437,7 @@ template <> void render<App>(App &app) {
     for (unsigned i = 0; i < app.num_meshes; ++i) {
         glBindVertexArray(app.model_vaos[i]);
         // glDrawArrays(GL_TRIANGLES, 0, app.model_num_vertices[i]);
-        glDrawElements(GL_TRIANGLES, app.model_num_indices[i], GL_UNSIGNED_SHORT, 0);
+        glDrawElements(GL_TRIANGLES, app.model_num_indices[i], app.model_index_types[i], 0);
         glBindVertexArray(0);
     }
 
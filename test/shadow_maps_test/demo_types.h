@@ -161,6 +161,7 @@ struct RenderableData {
 
     u32 packed_attr_size = 0;
     u32 num_indices = 0;
+    GLenum index_type = GL_UNSIGNED_SHORT;
 
     // per object uniform data
     uniform_formats::PerObject uniforms = { identity_matrix, identity_matrix, {} };
@@ -250,7 +250,7 @@ inline void upload_camera_transform(const eng::CameraTransformUB &camera_transfo
 // Stores the data associated with each entity in arrays.
 struct EntityStore {
     fo::Vector<Geometry> geometries;
-    fo::OrderedMap<eng::StringSymbol, eng::SceneTree::Node *> name_to_node;
+    fo::OrderedMap<eng::StringSymbol, eng::SceneNodeHandle> name_to_node;
 };
 
 struct App {
@@ -658,6 +658,7 @@ void build_geometry_buffers_and_bounding_sphere(App &app)
                 rd.uniforms.inv_world_from_local_xform = inverse(rd.uniforms.world_from_local_xform);
                 rd.packed_attr_size = app.stripped_meshes.sphere.packed_attr_size;
                 rd.num_indices = app.stripped_meshes.sphere.num_faces * 3;
+                rd.index_type = gl_index_type(app.stripped_meshes.sphere);
                 rd.vbo = app.vbos.sphere;
                 rd.ebo = app.ebos.sphere;
 
@@ -687,6 +688,7 @@ void build_geometry_buffers_and_bounding_sphere(App &app)
                 rd.vao = app.vao_pos_normal_st;
                 rd.packed_attr_size = app.stripped_meshes.cube.packed_attr_size;
                 rd.num_indices = app.stripped_meshes.cube.num_faces * 3;
+                rd.index_type = gl_index_type(app.stripped_meshes.cube);
                 rd.uniforms.inv_world_from_local_xform = inverse(rd.uniforms.world_from_local_xform);
                 rd.vbo = app.vbos.cube;
                 rd.ebo = app.ebos.cube;
@@ -751,6 +753,7 @@ void build_geometry_buffers_and_bounding_sphere(App &app)
                 rd.packed_attr_size = mesh_data.packed_attr_size;
                 rd.vao = app.vao_pos_normal_st;
                 rd.num_indices = num_indices(mesh_data);
+                rd.index_type = gl_index_type(mesh::StrippedMeshData(mesh_data.o));
             }
             break;
 
@@ -773,6 +776,7 @@ void build_geometry_buffers_and_bounding_sphere(App &app)
         rd.vao = app.vao_pos_normal_st;
         rd.packed_attr_size = app.stripped_meshes.sphere.packed_attr_size;
         rd.num_indices = app.stripped_meshes.sphere.num_faces * 3;
+        rd.index_type = gl_index_type(app.stripped_meshes.sphere);
         rd.vbo = app.vbos.sphere;
         rd.ebo = app.ebos.sphere;
     }
@@ -915,6 +919,7 @@ void set_up_lights(App &app)
         rd.uniforms.inv_world_from_local_xform = translation_matrix(-position_store[i]);
         rd.packed_attr_size = app.stripped_meshes.cube.packed_attr_size;
         rd.num_indices = app.stripped_meshes.cube.num_faces * 3;
+        rd.index_type = gl_index_type(app.stripped_meshes.cube);
         rd.uniforms.material = LIGHT_GIZMO_MATERIAL;
     }
 
@@ -942,6 +947,7 @@ void set_up_casting_light_gizmo(App &app)
     rd.vao = app.vao_pos;
     rd.packed_attr_size = m[0].packed_attr_size;
     rd.num_indices = mesh::num_indices(m[0]);
+    rd.index_type = gl_index_type(mesh::StrippedMeshData(m[0].o));
     rd.uniforms.material = PINK_MATERIAL;
     rd.uniforms.world_from_local_xform = inverse_rotation_translation(light_from_world_xform(app.shadow_map));
 }
@@ -1013,6 +1019,7 @@ void init_shadow_map(App &app)
         rd.uniforms.inv_world_from_local_xform = inverse(rd.uniforms.world_from_local_xform);
         rd.uniforms.material = PINK_MATERIAL;
         rd.num_indices = app.stripped_meshes.cube.num_faces * 3;
+        rd.index_type = gl_index_type(app.stripped_meshes.cube);
         rd.packed_attr_size = app.stripped_meshes.cube.packed_attr_size;
     }
 }
@@ -1052,7 +1059,7 @@ void render_to_depth_map(App &app)
         // glBindVertexArray(rd.vao);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rd.ebo);
         glBindVertexBuffer(0, rd.vbo, 0, rd.packed_attr_size);
-        glDrawElements(GL_TRIANGLES, rd.num_indices, GL_UNSIGNED_SHORT, 0);
+        glDrawElements(GL_TRIANGLES, rd.num_indices, rd.index_type, 0);
     }
     }
 #else
@@ -1065,7 +1072,7 @@ void render_to_depth_map(App &app)
         for (size_t i = range.first; i < range.second; ++i) {
             auto &rd = app.opaque_renderables[i];
             source_per_object_uniforms(app, rd);
-            glDrawElements(GL_TRIANGLES, rd.num_indices, GL_UNSIGNED_SHORT, 0);
+            glDrawElements(GL_TRIANGLES, rd.num_indices, rd.index_type, 0);
         }
     }
 
@@ -1144,7 +1151,7 @@ void render_second_pass(App &app)
         source_per_object_uniforms(app, rd);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rd.ebo);
         glBindVertexBuffer(0, rd.vbo, 0, rd.packed_attr_size);
-        glDrawElements(GL_TRIANGLES, rd.num_indices, GL_UNSIGNED_SHORT, 0);
+        glDrawElements(GL_TRIANGLES, rd.num_indices, rd.index_type, 0);
     }
 #else
 
@@ -1156,7 +1163,7 @@ void render_second_pass(App &app)
             for (size_t i = range.first; i < range.second; ++i) {
                 auto &rd = app.opaque_renderables[i];
                 source_per_object_uniforms(app, rd);
-                glDrawElements(GL_TRIANGLES, rd.num_indices, GL_UNSIGNED_SHORT, 0);
+                glDrawElements(GL_TRIANGLES, rd.num_indices, rd.index_type, 0);
             }
         }
 
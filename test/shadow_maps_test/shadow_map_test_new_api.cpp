@@ -289,6 +289,7 @@ struct RenderableData {
 
     u32 packed_attr_size = 0;
     u32 num_indices = 0;
+    GLenum index_type = GL_UNSIGNED_SHORT;
 
     // per object uniform data
     PerObjectData uniform_data = { eng::math::identity_matrix, eng::math::identity_matrix, {} };
@@ -904,6 +905,7 @@ void build_geometry_buffers_and_bounding_sphere(App &app)
                 rd.uniform_data.world_from_local_inv = inverse(rd.uniform_data.world_from_local);
                 rd.packed_attr_size = app.stripped_meshes.sphere.packed_attr_size;
                 rd.num_indices = app.stripped_meshes.sphere.num_faces * 3;
+                rd.index_type = gl_index_type(app.stripped_meshes.sphere);
                 rd.vbo_handle = app.vbos.sphere;
                 rd.ebo_handle = app.ebos.sphere;
 
@@ -935,6 +937,7 @@ void build_geometry_buffers_and_bounding_sphere(App &app)
                 translate_update(rd.uniform_data.world_from_local, cube.center);
                 rd.packed_attr_size = app.stripped_meshes.cube.packed_attr_size;
                 rd.num_indices = app.stripped_meshes.cube.num_faces * 3;
+                rd.index_type = gl_index_type(app.stripped_meshes.cube);
                 rd.uniform_data.world_from_local_inv = inverse(rd.uniform_data.world_from_local);
                 rd.vbo_handle = app.vbos.cube;
                 rd.ebo_handle = app.ebos.cube;
@@ -978,6 +981,7 @@ void build_geometry_buffers_and_bounding_sphere(App &app)
         rd.uniform_data.material = GIZMO_MATERIAL;
         rd.packed_attr_size = app.stripped_meshes.sphere.packed_attr_size;
         rd.num_indices = app.stripped_meshes.sphere.num_faces * 3;
+        rd.index_type = gl_index_type(app.stripped_meshes.sphere);
         rd.vbo_handle = app.vbos.sphere;
         rd.ebo_handle = app.ebos.sphere;
         rd.vao_handle = app.vao_pos;
@@ -994,6 +998,7 @@ void build_geometry_buffers_and_bounding_sphere(App &app)
         rd.vbo_handle = p.first;
         rd.ebo_handle = p.second;
         rd.num_indices = m[0].o.num_faces * 3;
+        rd.index_type = gl_index_type(mesh::StrippedMeshData(m[0].o));
         rd.packed_attr_size = m[0].o.packed_attr_size;
         rd.vao_handle = app.vao_opaque_shapes;
         rd.uniform_data.world_from_local = identity_matrix;
@@ -1118,6 +1123,7 @@ void set_up_lights(App &app)
         rd.packed_attr_size = app.stripped_meshes.cube.packed_attr_size;
         rd.uniform_data.material = LIGHT_GIZMO_MATERIAL;
         rd.num_indices = app.stripped_meshes.cube.num_faces * 3;
+        rd.index_type = gl_index_type(app.stripped_meshes.cube);
     }
 
 #endif
@@ -1153,6 +1159,7 @@ void set_up_casting_light_gizmo(App &app)
 
     rd.packed_attr_size = m[0].o.packed_attr_size;
     rd.num_indices = m[0].o.num_faces * 3;
+    rd.index_type = gl_index_type(mesh::StrippedMeshData(m[0].o));
     rd.uniform_data.material = PINK_MATERIAL;
     rd.uniform_data.world_from_local = inverse_rotation_translation(lightview_from_world(app.shadow_map));
 
@@ -1271,6 +1278,7 @@ void init_shadow_map(App &app)
         rd.uniform_data.world_from_local_inv = inverse(rd.uniform_data.world_from_local);
         rd.uniform_data.material = PINK_MATERIAL;
         rd.num_indices = app.stripped_meshes.cube.num_faces * 3;
+        rd.index_type = gl_index_type(app.stripped_meshes.cube);
         rd.packed_attr_size = app.stripped_meshes.cube.packed_attr_size;
     }
 #endif
@@ -1283,7 +1291,7 @@ void draw_plane_mesh(App &app)
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eng::gluint_from_globjecthandle(rd0.ebo_handle));
     glBindVertexBuffer(0, eng::gluint_from_globjecthandle(rd0.vbo_handle), 0, rd0.packed_attr_size);
     source_per_object_uniforms(app, rd0);
-    glDrawElements(GL_TRIANGLES, rd0.num_indices, GL_UNSIGNED_SHORT, 0);
+    glDrawElements(GL_TRIANGLES, rd0.num_indices, rd0.index_type, 0);
 }
 
 void draw_opaque_renderables(App &app, bool is_depth_pass)
@@ -1306,7 +1314,7 @@ void draw_opaque_renderables(App &app, bool is_depth_pass)
             auto &rd = app.opaque_renderables[i];
             source_per_object_uniforms(app, rd);
 
-            glDrawElements(GL_TRIANGLES, rd.num_indices, GL_UNSIGNED_SHORT, 0);
+            glDrawElements(GL_TRIANGLES, rd.num_indices, rd.index_type, 0);
         }
     }
 }
@@ -505,6 +505,7 @@ void build_geometry_buffers_and_bounding_sphere(App &app) {
             rd.uniforms.inv_world_from_local_xform = inverse(rd.uniforms.world_from_local_xform);
             rd.packed_attr_size = app.stripped_meshes.sphere.packed_attr_size;
             rd.num_indices = app.stripped_meshes.sphere.num_faces * 3;
+            rd.index_type = gl_index_type(app.stripped_meshes.sphere);
             rd.vbo = app.vbos.sphere;
             rd.ebo = app.ebos.sphere;
 
@@ -531,6 +532,7 @@ void build_geometry_buffers_and_bounding_sphere(App &app) {
             rd.vao = app.vao_pos_normal_st;
             rd.packed_attr_size = app.stripped_meshes.cube.packed_attr_size;
             rd.num_indices = app.stripped_meshes.cube.num_faces * 3;
+            rd.index_type = gl_index_type(app.stripped_meshes.cube);
             rd.uniforms.inv_world_from_local_xform = inverse(rd.uniforms.world_from_local_xform);
             rd.vbo = app.vbos.cube;
             rd.ebo = app.ebos.cube;
@@ -591,6 +593,7 @@ void build_geometry_buffers_and_bounding_sphere(App &app) {
             rd.packed_attr_size = mesh_data.packed_attr_size;
             rd.vao = app.vao_pos_normal_st;
             rd.num_indices = num_indices(mesh_data);
+            rd.index_type = gl_index_type(mesh::StrippedMeshData(mesh_data.o));
         } break;
 
         default:
@@ -612,6 +615,7 @@ void build_geometry_buffers_and_bounding_sphere(App &app) {
         rd.vao = app.vao_pos_normal_st;
         rd.packed_attr_size = app.stripped_meshes.sphere.packed_attr_size;
         rd.num_indices = app.stripped_meshes.sphere.num_faces * 3;
+        rd.index_type = gl_index_type(app.stripped_meshes.sphere);
         rd.vbo = app.vbos.sphere;
         rd.ebo = app.ebos.sphere;
     }
@@ -745,6 +749,7 @@ Fn set_up_casting_light_gizmo(App &app) {
     rd.vao = app.vao_pos;
     rd.packed_attr_size = m[0].packed_attr_size;
     rd.num_indices = mesh::num_indices(m[0]);
+    rd.index_type = gl_index_type(mesh::StrippedMeshData(m[0].o));
     rd.uniforms.material = PINK_MATERIAL;
     rd.uniforms.world_from_local_xform = inverse_rotation_translation(light_from_world_xform(app.shadow_map));
 }
@@ -803,7 +808,7 @@ Fn render_no_shadow(App &app) {
             glBindBuffer(GL_ARRAY_BUFFER, rd.vbo);
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rd.ebo);
             glBindVertexBuffer(0, rd.vbo, 0, rd.packed_attr_size);
-            glDrawElements(GL_TRIANGLES, rd.num_indices, GL_UNSIGNED_SHORT, 0);
+            glDrawElements(GL_TRIANGLES, rd.num_indices, rd.index_type, 0);
         }
     }
 
@@ -820,7 +825,7 @@ Fn render_no_shadow(App &app) {
             glBindBuffer(GL_ARRAY_BUFFER, rd.vbo);
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rd.ebo);
             glBindVertexBuffer(0, rd.vbo, 0, rd.packed_attr_size);
-            glDrawElements(GL_TRIANGLES, rd.num_indices, GL_UNSIGNED_SHORT, 0);
+            glDrawElements(GL_TRIANGLES, rd.num_indices, rd.index_type, 0);
         }
     }
 
@@ -834,7 +839,7 @@ Fn render_no_shadow(App &app) {
         glBindBuffer(GL_ARRAY_BUFFER, rd.vbo);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rd.ebo);
         glBindVertexBuffer(0, rd.vbo, 0, rd.packed_attr_size);
-        glDrawElements(GL_TRIANGLES, rd.num_indices, GL_UNSIGNED_SHORT, 0);
+        glDrawElements(GL_TRIANGLES, rd.num_indices, rd.index_type, 0);
     };
 
     // Draw casting light gizmo
@@ -845,7 +850,7 @@ Fn render_no_shadow(App &app) {
         glBindBuffer(GL_ARRAY_BUFFER, rd.vbo);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rd.ebo);
         glBindVertexBuffer(0, rd.vbo, 0, rd.packed_attr_size);
-        glDrawElements(GL_TRIANGLES, rd.num_indices, GL_UNSIGNED_SHORT, 0);
+        glDrawElements(GL_TRIANGLES, rd.num_indices, rd.index_type, 0);
         glLineWidth(1.0f);
     }
 
@@ -927,6 +932,7 @@ void init_shadow_map(App &app) {
         rd.uniforms.inv_world_from_local_xform = inverse(rd.uniforms.world_from_local_xform);
         rd.uniforms.material = PINK_MATERIAL;
         rd.num_indices = app.stripped_meshes.cube.num_faces * 3;
+        rd.index_type = gl_index_type(app.stripped_meshes.cube);
         rd.packed_attr_size = app.stripped_meshes.cube.packed_attr_size;
     }
 
@@ -972,7 +978,7 @@ void render_to_depth_map(App &app) {
             glBindBuffer(GL_ARRAY_BUFFER, rd.vbo);
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rd.ebo);
             glBindVertexBuffer(0, rd.vbo, 0, rd.packed_attr_size);
-            glDrawElements(GL_TRIANGLES, rd.num_indices, GL_UNSIGNED_SHORT, 0);
+            glDrawElements(GL_TRIANGLES, rd.num_indices, rd.index_type, 0);
         }
     }
 
@@ -1034,7 +1040,7 @@ Fn render_second_pass(App &app) {
             glBindVertexArray(rd.vao);
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rd.ebo);
             glBindVertexBuffer(0, rd.vbo, 0, rd.packed_attr_size);
-            glDrawElements(GL_TRIANGLES, rd.num_indices, GL_UNSIGNED_SHORT, 0);
+            glDrawElements(GL_TRIANGLES, rd.num_indices, rd.index_type, 0);
         }
     }
 }
@@ -0,0 +1,64 @@
+// Loads a model with Assimp and writes it as a cooked model file, which mesh::load then maps in memory without
+// going through the importer.
+//
+// Usage: mesh_cooker [--tangents] [--gen-uv] [--ignore-bones] [--optimize] [--split] [--quantize]
+//                    <model file> <cooked file>
+//
+// --optimize reorders the triangles and vertices for the GPU, see mesh_optimize.h. --split splits meshes with too
+// many vertices for u16 indices instead of giving them u32 indices. --quantize stores the vertices in
+// mesh::VERTEX_FORMAT_QUANTIZED.
+
+#include <learnogl/mesh.h>
+#include <loguru.hpp>
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace eng;
+
+static int usage() {
+    fprintf(stderr, "Usage: mesh_cooker [--tangents] [--gen-uv] [--ignore-bones] [--optimize] [--split]");
+    fprintf(stderr, " [--quantize] <model file> <cooked file>\n");
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    u32 model_load_flags = mesh::ModelLoadFlagBits::TRIANGULATE | mesh::ModelLoadFlagBits::CALC_NORMALS;
+    const char *paths[2] = {};
+    u32 num_paths = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--tangents") == 0) {
+            model_load_flags |= mesh::ModelLoadFlagBits::CALC_TANGENTS;
+        } else if (strcmp(argv[i], "--gen-uv") == 0) {
+            model_load_flags |= mesh::ModelLoadFlagBits::GEN_UV_COORDS;
+        } else if (strcmp(argv[i], "--ignore-bones") == 0) {
+            model_load_flags |= mesh::ModelLoadFlagBits::IGNORE_BONES;
+        } else if (strcmp(argv[i], "--optimize") == 0) {
+            model_load_flags |= mesh::ModelLoadFlagBits::OPTIMIZE_VERTEX_ORDER;
+        } else if (strcmp(argv[i], "--split") == 0) {
+            model_load_flags |= mesh::ModelLoadFlagBits::SPLIT_FOR_U16_INDICES;
+        } else if (strcmp(argv[i], "--quantize") == 0) {
+            model_load_flags |= mesh::ModelLoadFlagBits::QUANTIZE_VERTICES;
+        } else if (argv[i][0] == '-' || num_paths == 2) {
+            return usage();
+        } else {
+            paths[num_paths++] = argv[i];
+        }
+    }
+    if (num_paths != 2) {
+        return usage();
+    }
+
+    mesh::Model model;
+    if (!mesh::load(model, paths[0], {}, model_load_flags)) {
+        LOG_F(ERROR, "Failed to load model %s", paths[0]);
+        return 1;
+    }
+    if (!mesh::write_cooked_model(model, paths[1], model_load_flags)) {
+        return 1;
+    }
+
+    LOG_F(INFO, "Cooked %s into %s, meshes=%u", paths[0], paths[1], mesh::num_meshes(model));
+    return 0;
+}